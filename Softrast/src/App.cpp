@@ -5,6 +5,7 @@
 
 #include "SoftwareRasterizer\BarebonesMath\include\bbm.h"
 #include "SoftwareRasterizer\softrast.h"
+#include "SoftwareRasterizer\texture_compression.h"
 #include "movement\CameraMovement.h"
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
@@ -58,6 +59,12 @@ extern "C" {
 static const std::string SceneRoot = "assets/";
 std::vector<std::string> Scenes;
 static int SceneIndex = -1;
+static softrast_frame_stats FrameStats;	// Of the frame presented last
+static float RenderScale     = 1.0f;
+static float FrameTimeBudget = 0.0f;	// In milliseconds, 0 renders at RenderScale
+static bool FoveatedShading  = false;
+static uint8_t FoveatedShadingRates[16*16];
+static const DXGI_FORMAT TextureDXGIFormats[] = { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC7_UNORM };	// softrast_texture_format
 struct
 {
 	uint32_t totalVertCount;
@@ -81,6 +88,7 @@ App::App ( ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11Rende
 	// Initialize softrast
 	//--------------------------------
 	softrast_initialize ( &alloc );
+	softrast_set_render_ahead ( 2 );	// Queues the next frame while the last one is still rasterizing; Tick double-buffers the color buffers for it
 
 	//--------------------------------
 	// DEBUG: DEFAULT SETTINGS
@@ -90,6 +98,7 @@ App::App ( ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11Rende
 	Debug.textureAddressingMode = TEXTURE_ADDRESSING_LINEAR;
 	Debug.textureFilteringMode  = TEXTURE_FILTERING_BILINEAR;
 	Debug.textureMipmapMode     = TEXTURE_MIPMAP_LINEAR;
+	Debug.textureFormat         = SOFTRAST_TEXTURE_FORMAT_RGBA8;
 	Debug.lodBias               = 0.0f;
 	Debug.lodScale              = 0.75f;
 	Debug.clipBorderDist        = 1.0f;
@@ -119,6 +128,9 @@ App::App ( ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11Rende
 
 App::~App ( )
 {
+	softrast_finish ( );
+	delete[] m_FrameBuffers[0];
+	delete[] m_FrameBuffers[1];
 	delete m_IntermediateRenderTarget;
 }
 
@@ -157,7 +169,7 @@ bool App::LoadModel ( const char* path )
 		desc.Height = model.textures[i].height;
 		desc.MipLevels = model.textures[i].mipLevels;
 		desc.ArraySize = 1;
-		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.Format = TextureDXGIFormats[model.textures[i].format];
 		desc.SampleDesc.Count = 1;
 		desc.Usage = D3D11_USAGE_DEFAULT;
 		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
@@ -168,7 +180,7 @@ bool App::LoadModel ( const char* path )
 		for ( uint32_t j = 0; j < model.textures[i].mipLevels; j++ )
 		{
 			mipPtr[j].pSysMem          = model.textures[i].mipData[j];
-			mipPtr[j].SysMemPitch      = (desc.Width * 4) >> j;
+			mipPtr[j].SysMemPitch      = model.textures[i].format == SOFTRAST_TEXTURE_FORMAT_RGBA8 ? (desc.Width * 4) >> j : (((desc.Width >> j) + 3) / 4) * softrast_texture_block_bytes ( model.textures[i].format );
 			mipPtr[j].SysMemSlicePitch = 0;
 		}
 
@@ -182,7 +194,7 @@ bool App::LoadModel ( const char* path )
 		// Create texture view
 		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
 		ZeroMemory(&srvDesc, sizeof(srvDesc));
-		srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		srvDesc.Format = desc.Format;
 		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
 		srvDesc.Texture2D.MipLevels = desc.MipLevels;
 		srvDesc.Texture2D.MostDetailedMip = 0;
@@ -208,6 +220,24 @@ void UpdateProjectionMatrix ( uint32_t width, uint32_t height )
 	softrast_set_projection_matrix ( &bbmProjMat );
 }
 
+void SetFoveatedShading ( bool enabled )
+{
+	//--------------------------------
+	// Full rate in the middle of the screen, coarser towards the edges
+	//--------------------------------
+	for ( uint32_t y = 0; y < 16; y++ )
+	{
+		for ( uint32_t x = 0; x < 16; x++ )
+		{
+			const float dx = (x + 0.5f) / 8.0f - 1.0f, dy = (y + 0.5f) / 8.0f - 1.0f;
+			const float distance = sqrtf ( dx * dx + dy * dy );
+			FoveatedShadingRates[y * 16 + x] = distance > 0.9f ? SOFTRAST_SHADING_RATE_4X4 : (distance > 0.5f ? SOFTRAST_SHADING_RATE_2X2 : SOFTRAST_SHADING_RATE_1X1);
+		}
+	}
+
+	softrast_set_shading_rate_image ( enabled ? FoveatedShadingRates : NULL, 16, 16 );
+}
+
 void App::OnResize ( uint32_t width, uint32_t height )
 {
 	//--------------------------------
@@ -217,6 +247,16 @@ void App::OnResize ( uint32_t width, uint32_t height )
 	m_IntermediateRenderTarget = RenderTarget::Create ( width, height );
 	m_ScreenWidth = width, m_ScreenHeight = height;
 
+	//--------------------------------
+	// Create new frame buffers, once softrast is done with the old ones
+	//--------------------------------
+	softrast_finish ( );
+	for ( uint32_t i = 0; i < 2; i++ )
+	{
+		delete[] m_FrameBuffers[i];
+		m_FrameBuffers[i] = new uint32_t[width * height] ( );
+	}
+
 	//--------------------------------
 	// Set projection matrix
 	//--------------------------------
@@ -249,6 +289,15 @@ void App::GUITick ( float cpuDeltaTimeSeconds, float gpuDeltaTimeSeconds )
 				ImGui::Text ( "Avg frame count:" );
 				ImGui::SameLine ( offset );
 				ImGui::Text ( "%u", totalFrameCount );
+				ImGui::Text ( "Pixels shaded:" );
+				ImGui::SameLine ( offset );
+				ImGui::Text ( "%llu", (unsigned long long)FrameStats.shadedPixels );
+				ImGui::Text ( "Depth rejected:" );
+				ImGui::SameLine ( offset );
+				ImGui::Text ( "%llu (%.01f%%)", (unsigned long long)(FrameStats.testedPixels - FrameStats.shadedPixels), FrameStats.testedPixels ? 100.0 * (FrameStats.testedPixels - FrameStats.shadedPixels) / FrameStats.testedPixels : 0.0 );
+				ImGui::Text ( "Render scale:" );
+				ImGui::SameLine ( offset );
+				ImGui::Text ( "%.02f (%.02f ms)", FrameStats.renderScale, FrameStats.milliseconds );
 				if ( ImGui::Button ( "Reset averages" ) )
 					totalDTSeconds = 0.0f, totalFrameCount = 0;
 			ImGui::TreePop ( );
@@ -257,6 +306,12 @@ void App::GUITick ( float cpuDeltaTimeSeconds, float gpuDeltaTimeSeconds )
 		{
 			ImGui::Indent ( );
 				ImGui::CheckboxFlags ( "AABB frustum culling",      &Debug.flags, FLAG_AABB_FRUSTUM_CHECK        );
+				ImGui::CheckboxFlags ( "Occlusion culling",         &Debug.flags, FLAG_OCCLUSION_CULLING         );
+				ImGui::CheckboxFlags ( "Front to back",             &Debug.flags, FLAG_FRONT_TO_BACK             );
+				if ( ImGui::SliderFloat ( "Frame time budget", &FrameTimeBudget, 0.0f, 50.0f, FrameTimeBudget > 0.0f ? "%.1f ms" : "Off" ) )
+					softrast_set_frame_time_budget ( FrameTimeBudget, 0.25f );
+				if ( FrameTimeBudget == 0.0f && ImGui::SliderFloat ( "Render scale", &RenderScale, 0.25f, 1.0f, "%.2f" ) )
+					softrast_set_render_scale ( RenderScale );
 				ImGui::CheckboxFlags ( "Fill outlines",             &Debug.flags, FLAG_FILL_OUTLINES        );
 
 				if ( Debug.flags & FLAG_FILL_OUTLINES )
@@ -270,27 +325,59 @@ void App::GUITick ( float cpuDeltaTimeSeconds, float gpuDeltaTimeSeconds )
 						ImGui::Unindent ( );
 					}
 					ImGui::CheckboxFlags ( "Depth buffer enabled",      &Debug.flags, FLAG_DEPTH_TESTING             );
+					if ( Debug.flags & FLAG_DEPTH_TESTING )
+					{
+						ImGui::Indent ( );
+						ImGui::CheckboxFlags ( "Depth pre-pass",            &Debug.flags, FLAG_DEPTH_PRE_PASS            );
+						ImGui::Unindent ( );
+					}
 				
 					ImGui::CheckboxFlags ( "W clip enabled",            &Debug.flags, FLAG_CLIP_W                    );
 					ImGui::CheckboxFlags ( "Frustum clip enabled",      &Debug.flags, FLAG_CLIP_FRUSTUM              );
 					if ( Debug.flags & FLAG_CLIP_FRUSTUM )
 					{
 						ImGui::Indent ( );
-						ImGui::SliderFloat ( "Border", &Debug.clipBorderDist, 1.0f, 30.0f, "%.2f px" );
+						ImGui::CheckboxFlags ( "Guard band", &Debug.flags, FLAG_GUARD_BAND_CLIPPING );
+						if ( !(Debug.flags & FLAG_GUARD_BAND_CLIPPING) )
+							ImGui::SliderFloat ( "Border", &Debug.clipBorderDist, 1.0f, 30.0f, "%.2f px" );
 						ImGui::Unindent ( );
 					}
+					ImGui::CheckboxFlags ( "Batched triangle culling (AVX2, 8 wide)", &Debug.flags, FLAG_BATCHED_TRIANGLE_CULLING );
 					ImGui::CheckboxFlags ( "Rasterize",      &Debug.flags, FLAG_RASTERIZE              );
 					if ( Debug.flags & FLAG_RASTERIZE )
 					{
 						ImGui::Indent ( );
+						ImGui::CheckboxFlags ( "Tiled (multithreaded)", &Debug.flags, FLAG_TILED_RASTERIZATION );
+						ImGui::CheckboxFlags ( "Visibility buffer (deferred texturing)", &Debug.flags, FLAG_VISIBILITY_BUFFER );
 						ImGui::CheckboxFlags ( "Enable quad rasterization", &Debug.flags, FLAG_ENABLE_QUAD_RASTERIZATION );
 						if ( Debug.flags & FLAG_ENABLE_QUAD_RASTERIZATION )
 						{
 							ImGui::Indent ( );
 							ImGui::CheckboxFlags ( "SSE", &Debug.flags, FLAG_QUAD_RASTERIZATION_SIMD );
+							ImGui::CheckboxFlags ( "AVX2 (2x4 blocks)", &Debug.flags, FLAG_QUAD_RASTERIZATION_AVX2 );
+							ImGui::CheckboxFlags ( "AVX-512 (4x4 blocks, if supported)", &Debug.flags, FLAG_QUAD_RASTERIZATION_AVX512 );
+							ImGui::CheckboxFlags ( "Small triangle fast path", &Debug.flags, FLAG_SMALL_TRIANGLES );
+							ImGui::Unindent ( );
+						}
+						ImGui::CheckboxFlags ( "Enable half-space rasterization", &Debug.flags, FLAG_HALF_SPACE_RASTERIZATION );
+						if ( Debug.flags & FLAG_HALF_SPACE_RASTERIZATION )
+						{
+							ImGui::Indent ( );
+							ImGui::CheckboxFlags ( "AVX2 (8x8 blocks)", &Debug.flags, FLAG_HALF_SPACE_AVX );
+							ImGui::CheckboxFlags ( "SSE shading", &Debug.flags, FLAG_QUAD_RASTERIZATION_SIMD );
+							ImGui::CheckboxFlags ( "AVX2 shading", &Debug.flags, FLAG_QUAD_RASTERIZATION_AVX2 );
+							ImGui::CheckboxFlags ( "AVX-512 shading", &Debug.flags, FLAG_QUAD_RASTERIZATION_AVX512 );
+							ImGui::CheckboxFlags ( "Hierarchical Z (8x8 tiles)", &Debug.flags, FLAG_HIZ );
 							ImGui::Unindent ( );
 						}
 
+						if ( Debug.flags & (FLAG_ENABLE_QUAD_RASTERIZATION | FLAG_HALF_SPACE_RASTERIZATION) )
+							ImGui::CheckboxFlags ( "Checkerboard (temporal reconstruction)", &Debug.flags, FLAG_CHECKERBOARD );
+
+						int simdLevel = (int)softrast_get_simd_level ( );
+						if ( ImGui::Combo ( "SIMD level", &simdLevel, SimdLevels, (int)softrast_get_supported_simd_level ( ) + 1 ) )
+							softrast_set_simd_level ( (softrast_simd_level)simdLevel );
+
 						//ImGui::CheckboxFlags ( "Temp derp", &Debug.flags, FLAG_DERP );
 						//ImGui::CheckboxFlags ( "Temp derp 2", &Debug.flags, FLAG_DERP2 );
 						//ImGui::CheckboxFlags ( "Temp derp 3", &Debug.flags, FLAG_DERP3 );
@@ -312,6 +399,10 @@ void App::GUITick ( float cpuDeltaTimeSeconds, float gpuDeltaTimeSeconds )
 								ImGui::CheckboxFlags ( "Use lookup table (LUT)", &Debug.flags, FLAG_FILTER_LUT );
 								ImGui::Unindent ( );
 							}
+							if ( ImGui::Combo ( "Texture format", &Debug.textureFormat, TextureFormats, sizeof ( TextureFormats ) / sizeof ( TextureFormats[0] ) ) )
+							{
+								LoadModel ( (SceneRoot + Scenes[SceneIndex]).c_str ( ) );
+							}
 
 							ImGui::Combo ( "Texture filtering", &Debug.textureFilteringMode, TextureFilteringModes, sizeof ( TextureFilteringModes ) / sizeof ( TextureFilteringModes[0] ) );
 
@@ -325,6 +416,10 @@ void App::GUITick ( float cpuDeltaTimeSeconds, float gpuDeltaTimeSeconds )
 									ImGui::InputFloat ( "LOD scale", &Debug.lodScale );
 									ImGui::Unindent ( );
 								}
+
+								ImGui::Combo ( "Shading rate", &Debug.shadingRate, ShadingRates, sizeof ( ShadingRates ) / sizeof ( ShadingRates[0] ) );
+								if ( ImGui::Checkbox ( "Foveated shading rate", &FoveatedShading ) )
+									SetFoveatedShading ( FoveatedShading );
 							}
 							ImGui::Unindent ( );
 						}
@@ -480,15 +575,24 @@ void App::Tick ( float cpuDeltaTimeSeconds, float gpuDeltaTimeSeconds )
 	///////////////////////////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////
 
+	//--------------------------------
+	// Queue this frame, and present the previous one while it renders
+	//--------------------------------
+	softrast_set_render_target ( m_ScreenWidth, m_ScreenHeight, m_FrameBuffers[m_FrameIndex], m_ScreenWidth * sizeof ( uint32_t ) );
+	softrast_clear_render_target ( );
+	softrast_clear_depth_render_target ( );
+	m_FrameFences[m_FrameIndex] = softrast_render_async ( &model );
+
+	m_FrameIndex ^= 1;
+	softrast_fence_wait ( m_FrameFences[m_FrameIndex] );
+	softrast_get_frame_stats ( m_FrameFences[m_FrameIndex], &FrameStats );
+
 	D3D11_MAPPED_SUBRESOURCE msr;
 	HRESULT res = m_DeviceContext->Map ( m_IntermediateRenderTarget->GetTexture ( ), 0, D3D11_MAP_WRITE_DISCARD, 0, &msr );
 	assert ( SUCCEEDED ( res ) );
-	//assert ( msr.RowPitch == m_ScreenWidth * sizeof ( uint32_t ) );
 
-	softrast_set_render_target ( m_ScreenWidth, m_ScreenHeight, (uint32_t*)msr.pData, msr.RowPitch );
-	softrast_clear_render_target ( );
-	softrast_clear_depth_render_target ( );
-	softrast_render ( &model );
+	for ( uint32_t y = 0; y < m_ScreenHeight; y++ )
+		memcpy ( (uint8_t*)msr.pData + y * msr.RowPitch, m_FrameBuffers[m_FrameIndex] + y * m_ScreenWidth, m_ScreenWidth * sizeof ( uint32_t ) );
 
 	m_DeviceContext->Unmap ( m_IntermediateRenderTarget->GetTexture ( ), 0 );
 	m_DeviceContext->CopyResource ( *m_BackBufferTexture, m_IntermediateRenderTarget->GetTexture ( ) );
@@ -30,6 +30,9 @@ private:
 	ID3D11Buffer*		m_IndexBuffer;
 
 	RenderTarget*	m_IntermediateRenderTarget = nullptr;
+	uint32_t*		m_FrameBuffers[2] = { nullptr, nullptr };	// Softrast renders into one while the other is presented
+	uint64_t		m_FrameFences[2]  = { 0, 0 };
+	uint32_t		m_FrameIndex      = 0;
 	DepthRenderTarget*	m_DepthRenderTarget;
 	uint32_t m_ScreenWidth, m_ScreenHeight;
 };
\ No newline at end of file
@@ -26,6 +26,14 @@ extern "C" {
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Selects the BAREBONES_MATH_VECTOR_INSTR_SET_* the SoA functions run with; starts out as NONE.
+// Returns -1 when the set isn't compiled in. Checking that the CPU supports it is up to the caller.
+uint32_t bbm_set_vector_instr_set ( uint32_t instrSet );
+uint32_t bbm_get_vector_instr_set ( );
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void bbm_soa_vec2_init ( bbm_soa_vec2* v, float* x, float* y, uint32_t vecCount );
 void bbm_soa_vec3_init ( bbm_soa_vec3* v, float* x, float* y, float* z, uint32_t vecCount );
 void bbm_soa_vec4_init ( bbm_soa_vec4* v, float* x, float* y, float* z, float* w, uint32_t vecCount );
@@ -20,24 +20,21 @@
 ///////////////////////////////////////////////////////////////////////////////
 // Options
 
-#define BAREBONES_MATH_VECTOR_INSTR_SET_NONE 0
-#define BAREBONES_MATH_VECTOR_INSTR_SET_SSE  1
-#define BAREBONES_MATH_VECTOR_INSTR_SET_AVX  2
+#define BAREBONES_MATH_VECTOR_INSTR_SET_NONE    0
+#define BAREBONES_MATH_VECTOR_INSTR_SET_SSE     1
+#define BAREBONES_MATH_VECTOR_INSTR_SET_AVX     2
+#define BAREBONES_MATH_VECTOR_INSTR_SET_AVX512  3
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 // User config
 
-#define BAREBONES_MATH_VECTOR_INSTR_SET BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+// Highest instruction set compiled in. Which one actually runs is picked at runtime with bbm_set_vector_instr_set.
+#define BAREBONES_MATH_MAX_VECTOR_INSTR_SET BAREBONES_MATH_VECTOR_INSTR_SET_AVX512
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 // End of user config
 
-#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
-	#define BAREBONES_MATH_VECTOR_WIDTH 4
-#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_AVX
-	#define BAREBONES_MATH_VECTOR_WIDTH 8
-#else
-	#define BAREBONES_MATH_VECTOR_WIDTH 1
-#endif
\ No newline at end of file
+// SoA arrays must be 16-byte aligned and padded to a multiple of this, as the SSE path always processes whole vectors
+#define BAREBONES_MATH_VECTOR_WIDTH 4
\ No newline at end of file
@@ -0,0 +1,1128 @@
+/*
+	BareBones Math, by Rick van Miltenburg
+
+	Custom math library meant to provide the exact functions I want and the way I want to use them.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// SoA functions, included by bbm.c once per instruction set with BAREBONES_MATH_VECTOR_INSTR_SET and BBM_IMPL
+// defined, so every instruction set gets its own copy that the public entry points dispatch to. No include guard on purpose.
+//
+// The AVX and AVX-512 paths share their code through the WIDE_ macros. They use unaligned loads, and mask off
+// everything past vectorCount, so unlike the SSE path they don't rely on the arrays being padded to the vector width.
+
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	#define WIDE       __m256
+	#define WIDE_WIDTH 8
+
+	#define WIDE_SET1(f)         _mm256_set1_ps ( f )
+	#define WIDE_ADD(a,b)        _mm256_add_ps ( a, b )
+	#define WIDE_MUL(a,b)        _mm256_mul_ps ( a, b )
+	#define WIDE_DIV(a,b)        _mm256_div_ps ( a, b )
+	#define WIDE_MIN(a,b)        _mm256_min_ps ( a, b )
+	#define WIDE_MAX(a,b)        _mm256_max_ps ( a, b )
+	#define WIDE_LOAD(p,n)       __bbm_avx_load ( p, n )
+	#define WIDE_LOAD_OR(p,n,f)  __bbm_avx_load_or ( p, n, f )
+	#define WIDE_STORE(p,v,n)    __bbm_avx_store ( p, v, n )
+	#define WIDE_REDUCE_MIN(v)   __bbm_avx_reduce_min ( v )
+	#define WIDE_REDUCE_MAX(v)   __bbm_avx_reduce_max ( v )
+
+static __forceinline __m256i __bbm_avx_mask ( uint32_t remaining )
+{
+	// Sliding window over the table gives the first 'remaining' lanes set (AVX1 has no integer compares)
+	static const int32_t maskTable[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+	return _mm256_loadu_si256 ( (const __m256i*)( maskTable + 8 - remaining ) );
+}
+
+static __forceinline __m256 __bbm_avx_load ( const float* p, uint32_t remaining )
+{
+	if ( remaining >= 8 )
+		return _mm256_loadu_ps ( p );
+	return _mm256_maskload_ps ( p, __bbm_avx_mask ( remaining ) );
+}
+
+static __forceinline __m256 __bbm_avx_load_or ( const float* p, uint32_t remaining, float fill )
+{
+	if ( remaining >= 8 )
+		return _mm256_loadu_ps ( p );
+	__m256i mask = __bbm_avx_mask ( remaining );
+	return _mm256_blendv_ps ( _mm256_set1_ps ( fill ), _mm256_maskload_ps ( p, mask ), _mm256_castsi256_ps ( mask ) );
+}
+
+static __forceinline void __bbm_avx_store ( float* p, __m256 v, uint32_t remaining )
+{
+	if ( remaining >= 8 )
+		_mm256_storeu_ps ( p, v );
+	else
+		_mm256_maskstore_ps ( p, __bbm_avx_mask ( remaining ), v );
+}
+
+static __forceinline float __bbm_avx_reduce_min ( __m256 v )
+{
+	__m128 r = _mm_min_ps ( _mm256_castps256_ps128 ( v ), _mm256_extractf128_ps ( v, 1 ) );
+	r = _mm_min_ps ( r, _mm_shuffle_ps ( r, r, _MM_SHUFFLE(0,1,2,3) ) );
+	r = _mm_min_ps ( r, _mm_shuffle_ps ( r, r, _MM_SHUFFLE(2,3,0,1) ) );
+	return _mm_cvtss_f32 ( r );
+}
+
+static __forceinline float __bbm_avx_reduce_max ( __m256 v )
+{
+	__m128 r = _mm_max_ps ( _mm256_castps256_ps128 ( v ), _mm256_extractf128_ps ( v, 1 ) );
+	r = _mm_max_ps ( r, _mm_shuffle_ps ( r, r, _MM_SHUFFLE(0,1,2,3) ) );
+	r = _mm_max_ps ( r, _mm_shuffle_ps ( r, r, _MM_SHUFFLE(2,3,0,1) ) );
+	return _mm_cvtss_f32 ( r );
+}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_AVX512
+	#define WIDE       __m512
+	#define WIDE_WIDTH 16
+
+	#define WIDE_SET1(f)         _mm512_set1_ps ( f )
+	#define WIDE_ADD(a,b)        _mm512_add_ps ( a, b )
+	#define WIDE_MUL(a,b)        _mm512_mul_ps ( a, b )
+	#define WIDE_DIV(a,b)        _mm512_div_ps ( a, b )
+	#define WIDE_MIN(a,b)        _mm512_min_ps ( a, b )
+	#define WIDE_MAX(a,b)        _mm512_max_ps ( a, b )
+	#define WIDE_LOAD(p,n)       _mm512_maskz_loadu_ps ( __bbm_avx512_mask ( n ), p )
+	#define WIDE_LOAD_OR(p,n,f)  _mm512_mask_loadu_ps ( _mm512_set1_ps ( f ), __bbm_avx512_mask ( n ), p )
+	#define WIDE_STORE(p,v,n)    _mm512_mask_storeu_ps ( p, __bbm_avx512_mask ( n ), v )
+	#define WIDE_REDUCE_MIN(v)   _mm512_reduce_min_ps ( v )
+	#define WIDE_REDUCE_MAX(v)   _mm512_reduce_max_ps ( v )
+
+static __forceinline __mmask16 __bbm_avx512_mask ( uint32_t remaining )
+{
+	return (__mmask16)( remaining >= 16 ? 0xFFFF : ( 1u << remaining ) - 1 );
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void BBM_IMPL ( bbm_soa_vec2_overwrite_add_xy_float ) ( bbm_soa_vec2* v, const float add )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++, y++ )
+	{
+		*(x) = *(x) + add;
+		*(y) = *(y) + add;
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 a = _mm_set1_ps ( add );
+	__m128 *x = (__m128*)v->x, *y = (__m128*)v->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_add_ps ( *x, a );
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_add_ps ( *y, a );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE a = WIDE_SET1 ( add );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( v->x + i, WIDE_ADD ( WIDE_LOAD ( v->x + i, n ), a ), n );
+		WIDE_STORE ( v->y + i, WIDE_ADD ( WIDE_LOAD ( v->y + i, n ), a ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec2_overwrite_mul_soa_vec4_w ) ( bbm_soa_vec2* o, const bbm_soa_vec4* v )
+{
+	assert ( o->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *w = v->w;
+	float *ox = o->x, *oy = o->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, ox++, oy++, w++ )
+	{
+		*(ox) = *(ox) * *(w);
+		*(oy) = *(oy) * *(w);
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 *w  = (__m128*)v->w;
+	__m128 *ox = (__m128*)o->x, *oy = (__m128*)o->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, ox++, w++ )
+		*(ox) = _mm_mul_ps ( *ox, *w );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, oy++, w++ )
+		*(oy) = _mm_mul_ps ( *oy, *w );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		const WIDE w = WIDE_LOAD ( v->w + i, n );
+		WIDE_STORE ( o->x + i, WIDE_MUL ( WIDE_LOAD ( o->x + i, n ), w ), n );
+		WIDE_STORE ( o->y + i, WIDE_MUL ( WIDE_LOAD ( o->y + i, n ), w ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_mul_x_float ) ( bbm_soa_vec1* out, const bbm_soa_vec4* v, float f )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x;
+	float *ox = out->x;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(ox++) = *(x++) * f;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 fv  = _mm_set1_ps ( f );
+	__m128 *x  = (__m128*)v->x;
+	__m128 *ox = (__m128*)out->x;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(ox++) = _mm_mul_ps ( *(x++), fv );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE fv = WIDE_SET1 ( f );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( out->x + i, WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), fv ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_mul_y_float ) ( bbm_soa_vec1* out, const bbm_soa_vec4* v, float f )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *y = v->y;
+	float *oy = out->x;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(oy++) = *(y++) * f;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 fv  = _mm_set1_ps ( f );
+	__m128 *y  = (__m128*)v->y;
+	__m128 *oy = (__m128*)out->x;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(oy++) = _mm_mul_ps ( *(y++), fv );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE fv = WIDE_SET1 ( f );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( out->x + i, WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), fv ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_mul_xy_float ) ( bbm_soa_vec2* out, const bbm_soa_vec4* v, float f )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y;
+	float *ox = out->x, *oy = out->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(ox++) = *(x++) * f;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(oy++) = *(y++) * f;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 fv  = _mm_set1_ps ( f );
+	__m128 *x  = (__m128*)v->x,   *y  = (__m128*)v->y;
+	__m128 *ox = (__m128*)out->x, *oy = (__m128*)out->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(ox++) = _mm_mul_ps ( *(x++), fv );
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(oy++) = _mm_mul_ps ( *(y++), fv );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE fv = WIDE_SET1 ( f );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( out->x + i, WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), fv ), n );
+		WIDE_STORE ( out->y + i, WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), fv ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_mad_x ) ( bbm_soa_vec1* out, const bbm_soa_vec4* v, float multiply, float add )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x;
+	float *ox = out->x;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(ox++) = *(x++) * multiply + add;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 mv  = _mm_set1_ps ( multiply ), av = _mm_set1_ps ( add );
+	__m128 *x  = (__m128*)v->x;
+	__m128 *ox = (__m128*)out->x;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(ox++) = _mm_add_ps ( _mm_mul_ps ( *(x++), mv ), av );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE mv = WIDE_SET1 ( multiply ), av = WIDE_SET1 ( add );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( out->x + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), mv ), av ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_mad_y ) ( bbm_soa_vec1* out, const bbm_soa_vec4* v, float multiply, float add )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *y = v->y;
+	float *oy = out->x;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(oy++) = *(y++) * multiply + add;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 mv  = _mm_set1_ps ( multiply ), av = _mm_set1_ps ( add );
+	__m128 *y  = (__m128*)v->y;
+	__m128 *oy = (__m128*)out->x;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(oy++) = _mm_add_ps ( _mm_mul_ps ( *(y++), mv ), av );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE mv = WIDE_SET1 ( multiply ), av = WIDE_SET1 ( add );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( out->x + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), mv ), av ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_mad_xy ) ( bbm_soa_vec2* out, const bbm_soa_vec4* v, float multiply, float add )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y;
+	float *ox = out->x, *oy = out->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(ox++) = *(x++) * multiply + add;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(oy++) = *(y++) * multiply + add;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 mv  = _mm_set1_ps ( multiply ), av = _mm_set1_ps ( add );
+	__m128 *x  = (__m128*)v->x,   *y  = (__m128*)v->y;
+	__m128 *ox = (__m128*)out->x, *oy = (__m128*)out->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(ox++) = _mm_add_ps ( _mm_mul_ps ( *(x++), mv ), av );
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(oy++) = _mm_add_ps ( _mm_mul_ps ( *(y++), mv ), av );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE mv = WIDE_SET1 ( multiply ), av = WIDE_SET1 ( add );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( out->x + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), mv ), av ), n );
+		WIDE_STORE ( out->y + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), mv ), av ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mul_x_float ) ( bbm_soa_vec4* v, float f )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) * f;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 fv  = _mm_set1_ps ( f );
+	__m128 *x  = (__m128*)v->x;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_mul_ps ( *(x), fv );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE fv = WIDE_SET1 ( f );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( v->x + i, WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), fv ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mul_y_float ) ( bbm_soa_vec4* v, float f )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *y = v->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) * f;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 fv  = _mm_set1_ps ( f );
+	__m128 *y  = (__m128*)v->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_mul_ps ( *(y), fv );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE fv = WIDE_SET1 ( f );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( v->y + i, WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), fv ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mul_xy_float ) ( bbm_soa_vec4* v, float f )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) * f;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) * f;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 fv  = _mm_set1_ps ( f );
+	__m128 *x  = (__m128*)v->x, *y  = (__m128*)v->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_mul_ps ( *(x), fv );
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_mul_ps ( *(y), fv );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE fv = WIDE_SET1 ( f );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( v->x + i, WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), fv ), n );
+		WIDE_STORE ( v->y + i, WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), fv ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mad_x ) ( bbm_soa_vec4* v, float multiply, float add )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) * multiply + add;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 mv  = _mm_set1_ps ( multiply ), av = _mm_set1_ps ( add );
+	__m128 *x  = (__m128*)v->x;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_add_ps ( _mm_mul_ps ( *(x), mv ), av );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE mv = WIDE_SET1 ( multiply ), av = WIDE_SET1 ( add );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( v->x + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), mv ), av ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mad_y ) ( bbm_soa_vec4* v, float multiply, float add )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *y = v->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) * multiply + add;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 mv  = _mm_set1_ps ( multiply ), av = _mm_set1_ps ( add );
+	__m128 *y  = (__m128*)v->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_add_ps ( _mm_mul_ps ( *(y), mv ), av );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE mv = WIDE_SET1 ( multiply ), av = WIDE_SET1 ( add );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( v->y + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), mv ), av ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mad_xy ) ( bbm_soa_vec4* v, float multiply, float add )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) * multiply + add;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) * multiply + add;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 mv  = _mm_set1_ps ( multiply ), av = _mm_set1_ps ( add );
+	__m128 *x  = (__m128*)v->x, *y  = (__m128*)v->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_add_ps ( _mm_mul_ps ( *(x), mv ), av );
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_add_ps ( _mm_mul_ps ( *(y), mv ), av );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE mv = WIDE_SET1 ( multiply ), av = WIDE_SET1 ( add );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		WIDE_STORE ( v->x + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), mv ), av ), n );
+		WIDE_STORE ( v->y + i, WIDE_ADD ( WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), mv ), av ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_div_xy_w ) ( bbm_soa_vec2* out, const bbm_soa_vec4* v )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y, *w = v->w;
+	float *ox = out->x, *oy = out->y;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(ox++) = *(x++) / *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(oy++) = *(y++) / *(w++);
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 *x  = (__m128*)v->x,   *y  = (__m128*)v->y, *w = (__m128*)v->w;
+	__m128 *ox = (__m128*)out->x, *oy = (__m128*)out->y;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(ox++) = _mm_div_ps ( *(x++), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(oy++) = _mm_div_ps ( *(y++), *(w++) );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		const WIDE w = WIDE_LOAD ( v->w + i, n );
+		WIDE_STORE ( out->x + i, WIDE_DIV ( WIDE_LOAD ( v->x + i, n ), w ), n );
+		WIDE_STORE ( out->y + i, WIDE_DIV ( WIDE_LOAD ( v->y + i, n ), w ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_div_xyz_w ) ( bbm_soa_vec3* out, const bbm_soa_vec4* v )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y, *z = v->z, *w = v->w;
+	float *ox = out->x, *oy = out->y, *oz = out->z;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(ox++) = *(x++) / *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(oy++) = *(y++) / *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++ )
+		*(oz++) = *(z++) / *(w++);
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 *x  = (__m128*)v->x,   *y  = (__m128*)v->y,   *z  = (__m128*)v->z, *w = (__m128*)v->w;
+	__m128 *ox = (__m128*)out->x, *oy = (__m128*)out->y, *oz = (__m128*)out->z;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(ox++) = _mm_div_ps ( *(x++), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(oy++) = _mm_div_ps ( *(y++), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++ )
+		*(oz++) = _mm_div_ps ( *(z++), *(w++) );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		const WIDE w = WIDE_LOAD ( v->w + i, n );
+		WIDE_STORE ( out->x + i, WIDE_DIV ( WIDE_LOAD ( v->x + i, n ), w ), n );
+		WIDE_STORE ( out->y + i, WIDE_DIV ( WIDE_LOAD ( v->y + i, n ), w ), n );
+		WIDE_STORE ( out->z + i, WIDE_DIV ( WIDE_LOAD ( v->z + i, n ), w ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mul_xy_w ) ( bbm_soa_vec4* v )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y, *w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) * *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) * *(w++);
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 *x = (__m128*)v->x, *y = (__m128*)v->y, *w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_mul_ps ( *(x), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_mul_ps ( *(y), *(w++) );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		const WIDE w = WIDE_LOAD ( v->w + i, n );
+		WIDE_STORE ( v->x + i, WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), w ), n );
+		WIDE_STORE ( v->y + i, WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), w ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_mul_xyz_w ) ( bbm_soa_vec4* v )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y, *z = v->z, *w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) * *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) * *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, z++ )
+		*(z) = *(z) * *(w++);
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 *x = (__m128*)v->x, *y = (__m128*)v->y, *z = (__m128*)v->z, *w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_mul_ps ( *(x), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_mul_ps ( *(y), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, z++ )
+		*(z) = _mm_mul_ps ( *(z), *(w++) );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		const WIDE w = WIDE_LOAD ( v->w + i, n );
+		WIDE_STORE ( v->x + i, WIDE_MUL ( WIDE_LOAD ( v->x + i, n ), w ), n );
+		WIDE_STORE ( v->y + i, WIDE_MUL ( WIDE_LOAD ( v->y + i, n ), w ), n );
+		WIDE_STORE ( v->z + i, WIDE_MUL ( WIDE_LOAD ( v->z + i, n ), w ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_div_xy_w ) ( bbm_soa_vec4* v )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y, *w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) / *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) / *(w++);
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 *x = (__m128*)v->x, *y = (__m128*)v->y, *w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_div_ps ( *(x), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_div_ps ( *(y), *(w++) );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		const WIDE w = WIDE_LOAD ( v->w + i, n );
+		WIDE_STORE ( v->x + i, WIDE_DIV ( WIDE_LOAD ( v->x + i, n ), w ), n );
+		WIDE_STORE ( v->y + i, WIDE_DIV ( WIDE_LOAD ( v->y + i, n ), w ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_div_xyz_w ) ( bbm_soa_vec4* v )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *x = v->x, *y = v->y, *z = v->z, *w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, x++ )
+		*(x) = *(x) / *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, y++ )
+		*(y) = *(y) / *(w++);
+	w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, z++ )
+		*(z) = *(z) / *(w++);
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 *x = (__m128*)v->x, *y = (__m128*)v->y, *z = (__m128*)v->z, *w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, x++ )
+		*(x) = _mm_div_ps ( *(x), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, y++ )
+		*(y) = _mm_div_ps ( *(y), *(w++) );
+	w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, z++ )
+		*(z) = _mm_div_ps ( *(z), *(w++) );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		const WIDE w = WIDE_LOAD ( v->w + i, n );
+		WIDE_STORE ( v->x + i, WIDE_DIV ( WIDE_LOAD ( v->x + i, n ), w ), n );
+		WIDE_STORE ( v->y + i, WIDE_DIV ( WIDE_LOAD ( v->y + i, n ), w ), n );
+		WIDE_STORE ( v->z + i, WIDE_DIV ( WIDE_LOAD ( v->z + i, n ), w ), n );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec4_overwrite_rcp_w ) ( bbm_soa_vec4* v )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float *w = v->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, w++ )
+		*(w) = 1.0f / *(w);
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	__m128 one = _mm_set1_ps ( 1.0f );
+	__m128 *w = (__m128*)v->w;
+	for ( uint32_t i = 0; i < (v->vectorCount+3)/4; i++, w++ )
+		// _mm_rcp_ps has problems with precision!
+		*(w) = _mm_div_ps ( one, *w ); ;//_mm_rcp_ps ( *(w) );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	const WIDE one = WIDE_SET1 ( 1.0f );
+	for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+	{
+		const uint32_t n = v->vectorCount - i;
+		// Same as SSE, no rcp approximation
+		WIDE_STORE ( v->w + i, WIDE_DIV ( one, WIDE_LOAD ( v->w + i, n ) ), n );
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static float BBM_IMPL ( bbm_aos_mat4_max ) ( const bbm_aos_mat4* m )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float max = -FLT_MAX;
+	const float* c = m->cells;
+	for ( uint32_t i = 0; i < 16; i++, c++ )
+	{
+		if ( *c > max )
+			max = *c;
+	}
+	return max;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	//1 6 5 2 | min: 1
+	//8 2 5 1 | max: 8
+	//7 4 3 8 |
+	//1 5 6 3 |
+	//
+	//1 6 5 2     7 4 3 8
+	//8 2 5 1     1 5 6 3 
+	//------- m   ------- m
+	//8 6 5 2     7 5 6 8
+	//7 5 6 8 <-
+	//------- m
+	//8 6 6 8
+	//8 6 6 8 s(wzyx)
+	//------- m
+	//8 6 6 8 // w == x, z == y
+	//6 8 8 6 s(yxwz)
+	//------- m
+	//8 8 8 8 // x == y, x == z, x == w
+	//
+	//5 min/max, 2 shuffle
+
+	__m128 r0 = _mm_loadu_ps ( m->cells );
+	__m128 r1 = _mm_loadu_ps ( m->cells + 4 );
+	__m128 r2 = _mm_loadu_ps ( m->cells + 8 );
+	__m128 r3 = _mm_loadu_ps ( m->cells + 12 );
+
+	r0 = _mm_max_ps ( r0, r1 );
+	r1 = _mm_max_ps ( r2, r3 );
+
+	r0 = _mm_max_ps ( r0, r1 );
+	r1 = _mm_shuffle_ps ( r0, r0, _MM_SHUFFLE(0,1,2,3) );
+
+	r0 = _mm_max_ps ( r0, r1 );
+	r1 = _mm_shuffle_ps ( r0, r0, _MM_SHUFFLE(2,3,0,1) );
+
+	r0 = _mm_max_ps ( r0, r1 );
+	return _mm_cvtss_f32 ( r0 );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	WIDE r = WIDE_SET1 ( -FLT_MAX );
+	for ( uint32_t i = 0; i < 16; i += WIDE_WIDTH )
+		r = WIDE_MAX ( r, WIDE_LOAD ( m->cells + i, 16 - i ) );
+	return WIDE_REDUCE_MAX ( r );
+#endif
+}
+
+static float BBM_IMPL ( bbm_aos_mat4_min ) ( const bbm_aos_mat4* m )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float min = FLT_MAX;
+	const float* c = m->cells;
+	for ( uint32_t i = 0; i < 16; i++, c++ )
+	{
+		if ( *c < min )
+			min = *c;
+	}
+	return min;
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	//1 6 5 2 | min: 1
+	//8 2 5 1 | max: 8
+	//7 4 3 8 |
+	//1 5 6 3 |
+	//
+	//1 6 5 2     7 4 3 8
+	//8 2 5 1     1 5 6 3 
+	//------- m   ------- m
+	//8 6 5 2     7 5 6 8
+	//7 5 6 8 <-
+	//------- m
+	//8 6 6 8
+	//8 6 6 8 s(wzyx)
+	//------- m
+	//8 6 6 8 // w == x, z == y
+	//6 8 8 6 s(yxwz)
+	//------- m
+	//8 8 8 8 // x == y, x == z, x == w
+	//
+	//5 min/max, 2 shuffle
+
+	__m128 r0 = _mm_loadu_ps ( m->cells );
+	__m128 r1 = _mm_loadu_ps ( m->cells + 4 );
+	__m128 r2 = _mm_loadu_ps ( m->cells + 8 );
+	__m128 r3 = _mm_loadu_ps ( m->cells + 12 );
+
+	r0 = _mm_min_ps ( r0, r1 );
+	r1 = _mm_min_ps ( r2, r3 );
+
+	r0 = _mm_min_ps ( r0, r1 );
+	r1 = _mm_shuffle_ps ( r0, r0, _MM_SHUFFLE(0,1,2,3) );
+
+	r0 = _mm_min_ps ( r0, r1 );
+	r1 = _mm_shuffle_ps ( r0, r0, _MM_SHUFFLE(2,3,0,1) );
+
+	r0 = _mm_min_ps ( r0, r1 );
+	return _mm_cvtss_f32 ( r0 );
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	WIDE r = WIDE_SET1 ( FLT_MAX );
+	for ( uint32_t i = 0; i < 16; i += WIDE_WIDTH )
+		r = WIDE_MIN ( r, WIDE_LOAD ( m->cells + i, 16 - i ) );
+	return WIDE_REDUCE_MIN ( r );
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec3_min_xyz ) ( bbm_aos_vec3* out, const bbm_soa_vec3* v )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		float* co = &(out->cells[cell]);
+		float* ci = v->cells[cell];
+		*co = FLT_MAX;
+		for ( uint32_t i = 0; i < v->vectorCount; i++, ci++ )
+		{
+			if ( *ci < *co )
+				*co = *ci;
+		}
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	const uint32_t passCount  = (v->vectorCount)/4;
+	const uint32_t undefCount = v->vectorCount - 4 * passCount;
+	const __m128 undefMask = _mm_cmplt_ps ( _mm_set_ps ( 3, 2, 1, 0 ), _mm_set1_ps ( undefCount - 0.1f ) );
+	float* o = &(out->x);
+	for ( uint32_t cell = 0; cell < 3; cell++, o++ )
+	{
+		__m128 min = _mm_set1_ps ( FLT_MAX );
+		__m128* ci = (__m128*)v->cells[cell];
+		
+		for ( uint32_t i = 0; i < passCount; i++, ci++ )
+		{
+			min = _mm_min_ps ( min, *ci );
+		}
+
+		// If N is not aligned by 4, the (up to) 3 last floats for each cell can be undefined
+		if ( undefCount )
+		{
+			__m128 undef = _mm_or_ps ( _mm_and_ps ( undefMask, *ci ), _mm_andnot_ps ( undefMask, _mm_set1_ps ( FLT_MAX ) ) );
+			min = _mm_min_ps ( min, undef );
+		}
+
+		min = _mm_min_ps ( min, _mm_shuffle_ps ( min, min, _MM_SHUFFLE(0,1,2,3) ) );
+		min = _mm_min_ps ( min, _mm_shuffle_ps ( min, min, _MM_SHUFFLE(2,3,0,1) ) );
+
+		*o = _mm_cvtss_f32 ( min );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	float* o = &(out->x);
+	for ( uint32_t cell = 0; cell < 3; cell++, o++ )
+	{
+		const float* ci = v->cells[cell];
+		WIDE r = WIDE_SET1 ( FLT_MAX );
+		for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+			r = WIDE_MIN ( r, WIDE_LOAD_OR ( ci + i, v->vectorCount - i, FLT_MAX ) );
+		*o = WIDE_REDUCE_MIN ( r );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_soa_vec3_max_xyz ) ( bbm_aos_vec3* out, const bbm_soa_vec3* v )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		float* co = &(out->cells[cell]);
+		float* ci = v->cells[cell];
+		*co = -FLT_MAX;
+		for ( uint32_t i = 0; i < v->vectorCount; i++, ci++ )
+		{
+			if ( *ci > *co )
+				*co = *ci;
+		}
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	const uint32_t passCount  = (v->vectorCount)/4;
+	const uint32_t undefCount = v->vectorCount - 4 * passCount;
+	const __m128 undefMask = _mm_cmplt_ps ( _mm_set_ps ( 3, 2, 1, 0 ), _mm_set1_ps ( undefCount - 0.1f ) );
+	float* o = &(out->x);
+	for ( uint32_t cell = 0; cell < 3; cell++, o++ )
+	{
+		__m128 max = _mm_set1_ps ( -FLT_MAX );
+		__m128* ci = (__m128*)v->cells[cell];
+		
+		for ( uint32_t i = 0; i < passCount; i++, ci++ )
+		{
+			max = _mm_max_ps ( max, *ci );
+		}
+
+		// If N is not aligned by 4, the (up to) 3 last floats for each cell can be undefined
+		if ( undefCount )
+		{
+			__m128 undef = _mm_or_ps ( _mm_and_ps ( undefMask, *ci ), _mm_andnot_ps ( undefMask, _mm_set1_ps ( -FLT_MAX ) ) );
+			max = _mm_max_ps ( max, undef );
+		}
+
+		max = _mm_max_ps ( max, _mm_shuffle_ps ( max, max, _MM_SHUFFLE(0,1,2,3) ) );
+		max = _mm_max_ps ( max, _mm_shuffle_ps ( max, max, _MM_SHUFFLE(2,3,0,1) ) );
+
+		*o = _mm_cvtss_f32 ( max );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	float* o = &(out->x);
+	for ( uint32_t cell = 0; cell < 3; cell++, o++ )
+	{
+		const float* ci = v->cells[cell];
+		WIDE r = WIDE_SET1 ( -FLT_MAX );
+		for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+			r = WIDE_MAX ( r, WIDE_LOAD_OR ( ci + i, v->vectorCount - i, -FLT_MAX ) );
+		*o = WIDE_REDUCE_MAX ( r );
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_aos_mat4_mul_soa_mat4 ) ( bbm_soa_mat4* out, const bbm_aos_mat4* m1, const bbm_soa_mat4* m2 )
+{
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	assert ( out->matrixCount == m2->matrixCount );
+	float celldata1[4], *cellptr2[4], *outptr;
+
+	for ( uint32_t r = 0; r < 4; r++ )
+	{
+		for ( uint32_t c = 0; c < 4; c++ )
+		{
+			outptr = out->rows[r][c];
+			for ( uint32_t i = 0; i < 4; i++ )
+				celldata1[i] = m1->rows[i][c];
+			for ( uint32_t i = 0; i < 4; i++ )
+				cellptr2[i] = m2->rows[r][i];
+			for ( uint32_t i = 0; i < m2->matrixCount; i++ )
+				*(outptr++) = (celldata1[0]) * *(cellptr2[0]++) + (celldata1[1]) * *(cellptr2[1]++) + (celldata1[2]) * *(cellptr2[2]++) + (celldata1[3]) * *(cellptr2[3]++);
+		}
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	assert ( out->matrixCount == m2->matrixCount );
+
+	__m128 celldata1[4], *cellptr2[4], *outptr;
+
+	for ( uint32_t r = 0; r < 4; r++ )
+	{
+		for ( uint32_t c = 0; c < 4; c++ )
+		{
+			outptr = (__m128*)( out->rows[r][c] );
+			for ( uint32_t i = 0; i < 4; i++ )
+				celldata1[i] = _mm_set1_ps ( m1->rows[i][c] );
+			for ( uint32_t i = 0; i < 4; i++ )
+				cellptr2[i] = (__m128*) ( m2->rows[r][i] );
+			for ( uint32_t i = 0; i < (m2->matrixCount + 3) / 4; i++ )
+				*(outptr++) = _mm_add_ps ( _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( (celldata1[0]), *(cellptr2[0]++) ), _mm_mul_ps ( (celldata1[1]), *(cellptr2[1]++) ) ), _mm_mul_ps ( (celldata1[2]), *(cellptr2[2]++) ) ), _mm_mul_ps ( (celldata1[3]), *(cellptr2[3]++) ) );
+		}
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	assert ( out->matrixCount == m2->matrixCount );
+
+	for ( uint32_t r = 0; r < 4; r++ )
+	{
+		for ( uint32_t c = 0; c < 4; c++ )
+		{
+			float* outptr = out->rows[r][c];
+			float* const* cellptr2 = m2->rows[r];
+			const WIDE celldata1[4] = { WIDE_SET1 ( m1->rows[0][c] ), WIDE_SET1 ( m1->rows[1][c] ), WIDE_SET1 ( m1->rows[2][c] ), WIDE_SET1 ( m1->rows[3][c] ) };
+			for ( uint32_t i = 0; i < m2->matrixCount; i += WIDE_WIDTH )
+			{
+				const uint32_t n = m2->matrixCount - i;
+				// Same summation order as the scalar path, so the results match bit for bit
+				WIDE sum = WIDE_MUL ( celldata1[0], WIDE_LOAD ( cellptr2[0] + i, n ) );
+				sum = WIDE_ADD ( sum, WIDE_MUL ( celldata1[1], WIDE_LOAD ( cellptr2[1] + i, n ) ) );
+				sum = WIDE_ADD ( sum, WIDE_MUL ( celldata1[2], WIDE_LOAD ( cellptr2[2] + i, n ) ) );
+				sum = WIDE_ADD ( sum, WIDE_MUL ( celldata1[3], WIDE_LOAD ( cellptr2[3] + i, n ) ) );
+				WIDE_STORE ( outptr + i, sum, n );
+			}
+		}
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_aos_mat4_mul_soa_vec3w0 ) ( bbm_soa_vec3* out, const bbm_aos_mat4* m, const bbm_soa_vec3* v )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		float *ix = v->cells[0], *iy = v->cells[1], *iz = v->cells[2];
+		float* o = out->cells[cell];
+		float md[3] = { m->rows[0][cell], m->rows[1][cell], m->rows[2][cell] };
+		for ( uint32_t vec = 0; vec < v->vectorCount; vec++, ix++, iy++, iz++, o++ )
+			*o = ( md[0] * *ix ) + ( ( md[1] * *iy ) + ( md[2] * *iz ) );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		__m128 *ix = (__m128*)v->cells[0], *iy = (__m128*)v->cells[1], *iz = (__m128*)v->cells[2];
+		__m128* o = (__m128*)out->cells[cell];
+		__m128 md[3] = { _mm_set1_ps ( m->rows[0][cell] ), _mm_set1_ps ( m->rows[1][cell] ), _mm_set1_ps ( m->rows[2][cell] ) };
+		for ( uint32_t vec = 0; vec < (v->vectorCount+3)/4; vec++, ix++, iy++, iz++, o++ )
+			*o = _mm_add_ps ( _mm_mul_ps ( md[0], *ix ), _mm_add_ps ( _mm_mul_ps ( md[1], *iy ), _mm_mul_ps ( md[2], *iz ) ) );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		const float *ix = v->cells[0], *iy = v->cells[1], *iz = v->cells[2];
+		float* o = out->cells[cell];
+		const WIDE md[3] = { WIDE_SET1 ( m->rows[0][cell] ), WIDE_SET1 ( m->rows[1][cell] ), WIDE_SET1 ( m->rows[2][cell] ) };
+		for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+		{
+			const uint32_t n = v->vectorCount - i;
+			const WIDE x = WIDE_LOAD ( ix + i, n ), y = WIDE_LOAD ( iy + i, n ), z = WIDE_LOAD ( iz + i, n );
+			WIDE_STORE ( o + i, WIDE_ADD ( WIDE_MUL ( md[0], x ), WIDE_ADD ( WIDE_MUL ( md[1], y ), WIDE_MUL ( md[2], z ) ) ), n );
+		}
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_aos_mat4_mul_soa_vec3w1 ) ( bbm_soa_vec3* out, const bbm_aos_mat4* m, const bbm_soa_vec3* v )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		float *ix = v->cells[0], *iy = v->cells[1], *iz = v->cells[2];
+		float* o = out->cells[cell];
+		float md[4] = { m->rows[0][cell], m->rows[1][cell], m->rows[2][cell], m->rows[3][cell] };
+		for ( uint32_t vec = 0; vec < v->vectorCount; vec++, ix++, iy++, iz++, o++ )
+			*o = ( ( md[0] * *ix ) + ( md[1] * *iy ) ) + ( ( md[2] * *iz ) + md[3] );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		__m128 *ix = (__m128*)v->cells[0], *iy = (__m128*)v->cells[1], *iz = (__m128*)v->cells[2];
+		__m128* o = (__m128*)out->cells[cell];
+		__m128 md[4] = { _mm_set1_ps ( m->rows[0][cell] ), _mm_set1_ps ( m->rows[1][cell] ), _mm_set1_ps ( m->rows[2][cell] ), _mm_set1_ps ( m->rows[3][cell] ) };
+		for ( uint32_t vec = 0; vec < (v->vectorCount+3)/4; vec++, ix++, iy++, iz++, o++ )
+			*o = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( md[0], *ix ), _mm_mul_ps ( md[1], *iy ) ), _mm_add_ps ( _mm_mul_ps ( md[2], *iz ), md[3] ) );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t cell = 0; cell < 3; cell++ )
+	{
+		const float *ix = v->cells[0], *iy = v->cells[1], *iz = v->cells[2];
+		float* o = out->cells[cell];
+		const WIDE md[4] = { WIDE_SET1 ( m->rows[0][cell] ), WIDE_SET1 ( m->rows[1][cell] ), WIDE_SET1 ( m->rows[2][cell] ), WIDE_SET1 ( m->rows[3][cell] ) };
+		for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+		{
+			const uint32_t n = v->vectorCount - i;
+			const WIDE x = WIDE_LOAD ( ix + i, n ), y = WIDE_LOAD ( iy + i, n ), z = WIDE_LOAD ( iz + i, n );
+			WIDE_STORE ( o + i, WIDE_ADD ( WIDE_ADD ( WIDE_MUL ( md[0], x ), WIDE_MUL ( md[1], y ) ), WIDE_ADD ( WIDE_MUL ( md[2], z ), md[3] ) ), n );
+		}
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_aos_mat4_mul_soa_vec3w1_out_vec4 ) ( bbm_soa_vec4* out, const bbm_aos_mat4* m, const bbm_soa_vec3* v )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	for ( uint32_t cell = 0; cell < 4; cell++ )
+	{
+		float *ix = v->cells[0], *iy = v->cells[1], *iz = v->cells[2];
+		float* o = out->cells[cell];
+		float md[4] = { m->rows[0][cell], m->rows[1][cell], m->rows[2][cell], m->rows[3][cell] };
+		for ( uint32_t vec = 0; vec < v->vectorCount; vec++, ix++, iy++, iz++, o++ )
+			*o = ( ( md[0] * *ix ) + ( md[1] * *iy ) ) + ( ( md[2] * *iz ) + md[3] );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	for ( uint32_t cell = 0; cell < 4; cell++ )
+	{
+		__m128 *ix = (__m128*)v->cells[0], *iy = (__m128*)v->cells[1], *iz = (__m128*)v->cells[2];
+		__m128* o = (__m128*)out->cells[cell];
+		__m128 md[4] = { _mm_set1_ps ( m->rows[0][cell] ), _mm_set1_ps ( m->rows[1][cell] ), _mm_set1_ps ( m->rows[2][cell] ), _mm_set1_ps ( m->rows[3][cell] ) };
+		for ( uint32_t vec = 0; vec < (v->vectorCount+3)/4; vec++, ix++, iy++, iz++, o++ )
+			*o = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( md[0], *ix ), _mm_mul_ps ( md[1], *iy ) ), _mm_add_ps ( _mm_mul_ps ( md[2], *iz ), md[3] ) );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t cell = 0; cell < 4; cell++ )
+	{
+		const float *ix = v->cells[0], *iy = v->cells[1], *iz = v->cells[2];
+		float* o = out->cells[cell];
+		const WIDE md[4] = { WIDE_SET1 ( m->rows[0][cell] ), WIDE_SET1 ( m->rows[1][cell] ), WIDE_SET1 ( m->rows[2][cell] ), WIDE_SET1 ( m->rows[3][cell] ) };
+		for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+		{
+			const uint32_t n = v->vectorCount - i;
+			const WIDE x = WIDE_LOAD ( ix + i, n ), y = WIDE_LOAD ( iy + i, n ), z = WIDE_LOAD ( iz + i, n );
+			WIDE_STORE ( o + i, WIDE_ADD ( WIDE_ADD ( WIDE_MUL ( md[0], x ), WIDE_MUL ( md[1], y ) ), WIDE_ADD ( WIDE_MUL ( md[2], z ), md[3] ) ), n );
+		}
+	}
+#endif
+}
+
+static void BBM_IMPL ( bbm_aos_mat4_mul_soa_vec4 ) ( bbm_soa_vec4* out, const bbm_aos_mat4* m, const bbm_soa_vec4* v )
+{
+	assert ( out->vectorCount >= v->vectorCount );
+#if BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_NONE
+	float* xptr = v->x, *yptr = v->y, *zptr = v->z, *wptr = v->w;
+	float* xptro = out->x, *yptro = out->y, *zptro = out->z, *wptro = out->w;
+	for ( uint32_t i = 0; i < v->vectorCount; i++, xptr++, yptr++, zptr++, wptr++, xptro++, yptro++, zptro++, wptro++ )
+	{
+		*xptro = m->rows[0][0] * (*xptr) + m->rows[1][0] * (*yptr) + m->rows[2][0] * (*zptr) + m->rows[3][0] * (*wptr);
+		*yptro = m->rows[0][1] * (*xptr) + m->rows[1][1] * (*yptr) + m->rows[2][1] * (*zptr) + m->rows[3][1] * (*wptr);
+		*zptro = m->rows[0][2] * (*xptr) + m->rows[1][2] * (*yptr) + m->rows[2][2] * (*zptr) + m->rows[3][2] * (*wptr);
+		*wptro = m->rows[0][3] * (*xptr) + m->rows[1][3] * (*yptr) + m->rows[2][3] * (*zptr) + m->rows[3][3] * (*wptr);
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET == BAREBONES_MATH_VECTOR_INSTR_SET_SSE
+	for ( uint32_t cell = 0; cell < 4; cell++ )
+	{
+		__m128 *ix = (__m128*)v->cells[0], *iy = (__m128*)v->cells[1], *iz = (__m128*)v->cells[2], *iw = (__m128*)v->cells[3];
+		__m128* o = (__m128*)out->cells[cell];
+		__m128 md[4] = { _mm_set1_ps ( m->rows[0][cell] ), _mm_set1_ps ( m->rows[1][cell] ), _mm_set1_ps ( m->rows[2][cell] ), _mm_set1_ps ( m->rows[3][cell] ) };
+		for ( uint32_t vec = 0; vec < (v->vectorCount+3)/4; vec++, ix++, iy++, iz++, iw++, o++ )
+			*o = _mm_add_ps ( _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( md[0], *ix ), _mm_mul_ps ( md[1], *iy ) ), _mm_mul_ps ( md[2], *iz ) ), _mm_mul_ps ( md[3], *iw ) );
+	}
+#elif BAREBONES_MATH_VECTOR_INSTR_SET >= BAREBONES_MATH_VECTOR_INSTR_SET_AVX
+	for ( uint32_t cell = 0; cell < 4; cell++ )
+	{
+		const float *ix = v->cells[0], *iy = v->cells[1], *iz = v->cells[2], *iw = v->cells[3];
+		float* o = out->cells[cell];
+		const WIDE md[4] = { WIDE_SET1 ( m->rows[0][cell] ), WIDE_SET1 ( m->rows[1][cell] ), WIDE_SET1 ( m->rows[2][cell] ), WIDE_SET1 ( m->rows[3][cell] ) };
+		for ( uint32_t i = 0; i < v->vectorCount; i += WIDE_WIDTH )
+		{
+			const uint32_t n = v->vectorCount - i;
+			const WIDE x = WIDE_LOAD ( ix + i, n ), y = WIDE_LOAD ( iy + i, n ), z = WIDE_LOAD ( iz + i, n );
+			const WIDE w = WIDE_LOAD ( iw + i, n );
+			WIDE_STORE ( o + i, WIDE_ADD ( WIDE_ADD ( WIDE_ADD ( WIDE_MUL ( md[0], x ), WIDE_MUL ( md[1], y ) ), WIDE_MUL ( md[2], z ) ), WIDE_MUL ( md[3], w ) ), n );
+		}
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const bbm_dispatch_table BBM_IMPL ( bbm_dispatch ) = {
+#define BBM_TABLE_ENTRY(ret,name,params,args,retkw) BBM_IMPL ( name ),
+	BBM_DISPATCHED_FUNCTIONS ( BBM_TABLE_ENTRY )
+#undef BBM_TABLE_ENTRY
+};
+
+#ifdef WIDE
+	#undef WIDE
+	#undef WIDE_WIDTH
+	#undef WIDE_SET1
+	#undef WIDE_ADD
+	#undef WIDE_MUL
+	#undef WIDE_DIV
+	#undef WIDE_MIN
+	#undef WIDE_MAX
+	#undef WIDE_LOAD
+	#undef WIDE_LOAD_OR
+	#undef WIDE_STORE
+	#undef WIDE_REDUCE_MIN
+	#undef WIDE_REDUCE_MAX
+#endif
@@ -0,0 +1,85 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "softrast.h"
+
+#include <stddef.h>
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static softrast_command* __softrast_command_list_append ( softrast_command_list* list, softrast_command_type type )
+{
+	if ( list->count == list->capacity )
+		return NULL;
+
+	softrast_command* command = list->commands + list->count++;
+	command->type = type;
+	return command;
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+void softrast_command_list_init ( softrast_command_list* list, softrast_command* storage, uint32_t capacity )
+{
+	list->commands = storage;
+	list->capacity = capacity;
+	list->count    = 0;
+}
+
+void softrast_command_list_reset ( softrast_command_list* list )
+{
+	list->count = 0;
+}
+
+uint32_t softrast_command_set_view_matrix ( softrast_command_list* list, const bbm_aos_mat4* viewMat )
+{
+	softrast_command* command = __softrast_command_list_append ( list, SOFTRAST_COMMAND_SET_VIEW_MATRIX );
+	if ( !command )
+		return -1;
+	command->matrix = *viewMat;
+	return 0;
+}
+
+uint32_t softrast_command_set_projection_matrix ( softrast_command_list* list, const bbm_aos_mat4* projMat )
+{
+	softrast_command* command = __softrast_command_list_append ( list, SOFTRAST_COMMAND_SET_PROJECTION_MATRIX );
+	if ( !command )
+		return -1;
+	command->matrix = *projMat;
+	return 0;
+}
+
+uint32_t softrast_command_draw_mesh ( softrast_command_list* list, softrast_mesh* mesh )
+{
+	softrast_command* command = __softrast_command_list_append ( list, SOFTRAST_COMMAND_DRAW_MESH );
+	if ( !command )
+		return -1;
+	command->draw.mesh    = mesh;
+	command->draw.submesh = NULL;
+	return 0;
+}
+
+uint32_t softrast_command_draw_submesh ( softrast_command_list* list, softrast_mesh* mesh, softrast_submesh* submesh )
+{
+	softrast_command* command = __softrast_command_list_append ( list, SOFTRAST_COMMAND_DRAW_SUBMESH );
+	if ( !command )
+		return -1;
+	command->draw.mesh    = mesh;
+	command->draw.submesh = submesh;
+	return 0;
+}
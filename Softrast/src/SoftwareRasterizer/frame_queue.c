@@ -0,0 +1,229 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "frame_queue.h"
+#include "thread_platform.h"
+
+#include <stddef.h>
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+	static double __softrast_frame_queue_clock ( )
+	{
+		LARGE_INTEGER frequency, counter;
+		QueryPerformanceFrequency ( &frequency );
+		QueryPerformanceCounter ( &counter );
+		return (double)counter.QuadPart / (double)frequency.QuadPart;
+	}
+#else
+	#include <time.h>
+
+	static double __softrast_frame_queue_clock ( )
+	{
+		struct timespec now;
+		clock_gettime ( CLOCK_MONOTONIC, &now );
+		return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+	}
+#endif
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static struct
+{
+	thread_handle thread;
+	uint32_t running;
+	uint32_t shutdown;
+
+	thread_mutex lock;
+	thread_cond frameQueued;
+	thread_cond frameDone;
+
+	softrast_frame_func func;
+	softrast_frame_flush_func flush;
+	uint32_t limit;
+
+	softrast_fence submitted;
+	softrast_fence started;			// Handed to func so far
+	volatile softrast_fence completed;
+} queue = { .limit = 1 };
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static THREAD_FUNC ( __softrast_frame_queue_worker )
+{
+	(void)param;
+
+	MUTEX_LOCK ( &queue.lock );
+	for ( ;; )
+	{
+		//--------------------------------
+		// With nothing left to start, complete the frames that are still being finished rather than leave their waiters waiting on the next one
+		//--------------------------------
+		if ( queue.started == queue.submitted && queue.completed != queue.started )
+		{
+			MUTEX_UNLOCK ( &queue.lock );
+			queue.flush ( );
+			MUTEX_LOCK ( &queue.lock );
+			continue;
+		}
+
+		//--------------------------------
+		// Sleep until a frame is queued; frames still queued are rendered before quitting
+		//--------------------------------
+		while ( !queue.shutdown && queue.started == queue.submitted )
+			COND_WAIT ( &queue.frameQueued, &queue.lock );
+
+		if ( queue.started == queue.submitted )
+			break;
+
+		//--------------------------------
+		// Render the oldest frame, with the lock released so the next one can be queued meanwhile
+		//--------------------------------
+		const softrast_fence fence = ++queue.started;
+		MUTEX_UNLOCK ( &queue.lock );
+
+		queue.func ( fence );
+
+		MUTEX_LOCK ( &queue.lock );
+	}
+	MUTEX_UNLOCK ( &queue.lock );
+
+	THREAD_RETURN;
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+uint32_t softrast_frame_queue_initialize ( softrast_frame_func func, softrast_frame_flush_func flush )
+{
+	if ( queue.func )
+		return -1;	// Already initialized
+
+	MUTEX_INIT ( &queue.lock );
+	COND_INIT ( &queue.frameQueued );
+	COND_INIT ( &queue.frameDone );
+	queue.func      = func;
+	queue.flush     = flush;
+	queue.shutdown  = 0;
+	queue.submitted = queue.started = queue.completed = 0;
+
+	//--------------------------------
+	// Without a thread of its own, frames are rendered as they're submitted
+	//--------------------------------
+	queue.running = THREAD_CREATE ( &queue.thread, __softrast_frame_queue_worker, NULL );
+	return 0;
+}
+
+void softrast_frame_queue_shutdown ( )
+{
+	if ( !queue.func )
+		return;
+
+	if ( queue.running )
+	{
+		MUTEX_LOCK ( &queue.lock );
+		queue.shutdown = 1;
+		COND_BROADCAST ( &queue.frameQueued );
+		MUTEX_UNLOCK ( &queue.lock );
+
+		THREAD_JOIN ( queue.thread );
+		queue.running = 0;
+	}
+
+	COND_DESTROY ( &queue.frameDone );
+	COND_DESTROY ( &queue.frameQueued );
+	MUTEX_DESTROY ( &queue.lock );
+	queue.func = NULL;
+}
+
+uint32_t softrast_frame_queue_set_limit ( uint32_t frameCount )
+{
+	if ( frameCount == 0 || frameCount > SOFTRAST_MAX_FRAMES_IN_FLIGHT )
+		return -1;
+	queue.limit = frameCount;
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+softrast_fence softrast_frame_queue_reserve ( )
+{
+	MUTEX_LOCK ( &queue.lock );
+	while ( queue.submitted - queue.completed >= queue.limit )
+		COND_WAIT ( &queue.frameDone, &queue.lock );
+	const softrast_fence fence = queue.submitted + 1;
+	MUTEX_UNLOCK ( &queue.lock );
+
+	return fence;
+}
+
+void softrast_frame_queue_submit ( )
+{
+	if ( !queue.running )
+	{
+		queue.started = ++queue.submitted;
+		queue.func ( queue.started );
+		queue.flush ( );
+		return;
+	}
+
+	MUTEX_LOCK ( &queue.lock );
+	queue.submitted++;
+	COND_BROADCAST ( &queue.frameQueued );
+	MUTEX_UNLOCK ( &queue.lock );
+}
+
+void softrast_frame_queue_complete ( softrast_fence fence )
+{
+	MUTEX_LOCK ( &queue.lock );
+	queue.completed = fence;
+	COND_BROADCAST ( &queue.frameDone );
+	MUTEX_UNLOCK ( &queue.lock );
+}
+
+uint32_t softrast_frame_queue_is_done ( softrast_fence fence )
+{
+	return queue.completed >= fence;
+}
+
+void softrast_frame_queue_wait ( softrast_fence fence )
+{
+	if ( queue.completed >= fence )
+		return;
+
+	MUTEX_LOCK ( &queue.lock );
+	while ( queue.completed < fence )
+		COND_WAIT ( &queue.frameDone, &queue.lock );
+	MUTEX_UNLOCK ( &queue.lock );
+}
+
+void softrast_frame_queue_finish ( )
+{
+	MUTEX_LOCK ( &queue.lock );
+	while ( queue.completed != queue.submitted )
+		COND_WAIT ( &queue.frameDone, &queue.lock );
+	MUTEX_UNLOCK ( &queue.lock );
+}
+
+double softrast_frame_queue_clock ( )
+{
+	return __softrast_frame_queue_clock ( );
+}
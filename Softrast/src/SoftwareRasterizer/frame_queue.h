@@ -0,0 +1,48 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "softrast.h"
+
+// Renders the frame with the given fence; fences count up from 1, in submission order. It may return before the frame is done, which is then completed
+// through softrast_frame_queue_complete, in order, once it is. The flush function completes whatever is left, and is called when no other frame is queued
+typedef void ( *softrast_frame_func ) ( softrast_fence fence );
+typedef void ( *softrast_frame_flush_func ) ( );
+
+uint32_t       softrast_frame_queue_initialize ( softrast_frame_func func, softrast_frame_flush_func flush );
+void           softrast_frame_queue_shutdown ( );
+uint32_t       softrast_frame_queue_set_limit ( uint32_t frameCount );
+
+// Waits until fewer frames than the limit are in flight, and returns the fence the next submitted frame gets. Only one thread may submit
+softrast_fence softrast_frame_queue_reserve ( );
+void           softrast_frame_queue_submit ( );
+void           softrast_frame_queue_complete ( softrast_fence fence );
+
+uint32_t       softrast_frame_queue_is_done ( softrast_fence fence );
+void           softrast_frame_queue_wait ( softrast_fence fence );
+void           softrast_frame_queue_finish ( );
+
+// Seconds on a monotonic clock, for timing frames
+double         softrast_frame_queue_clock ( );
+
+#ifdef __cplusplus
+};
+#endif
@@ -276,9 +276,10 @@ static void _LoadOGEXGeometryNode ( OGEXData* data, const OGEX::GeometryNodeStru
 							assert ( indexData->GetArraySize ( ) == 3 );
 
 							softrast_submesh* submesh = data->submesh++;
-							submesh->texture    = nullptr;
-							submesh->indexCount = indexData->GetDataElementCount ( );
-							submesh->indices    = data->indices;
+							submesh->texture     = nullptr;
+							submesh->indexCount  = indexData->GetDataElementCount ( );
+							submesh->indices     = data->indices;
+							submesh->shadingRate = SOFTRAST_SHADING_RATE_1X1;
 							memcpy ( submesh->indices, indexData->GetArrayDataElement ( 0 ), submesh->indexCount * sizeof ( uint32_t ) );
 							data->indices += submesh->indexCount;
 							mesh->submeshCount++;
@@ -501,6 +502,7 @@ extern "C" {
 			tex->mipData   = nullptr;
 			tex->path      = nullptr;
 			tex->mipLevels = 0;
+			tex->format    = SOFTRAST_TEXTURE_FORMAT_RGBA8;
 			tex->width     = 0;
 			tex->height    = 0;
 			model->textureCount--;
@@ -536,6 +538,11 @@ extern "C" {
 
 	uint32_t softrast_model_free ( softrast_model* model )
 	{
+		//--------------------------------
+		// Frames in flight may still be rendering the model
+		//--------------------------------
+		softrast_finish ( );
+
 		uint32_t ret = 0;
 		for ( uint32_t i = 0; i < model->textureCount; i++ )
 		{
@@ -15,13 +15,23 @@
 */
 
 #include "softrast.h"
+#include "softrast_kernels.h"
+#include "thread_pool.h"
+#include "frame_queue.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <math.h>
 #include <immintrin.h>
 #include <float.h>
 
+#ifdef _MSC_VER
+	#include <intrin.h>
+#else
+	#include <cpuid.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////
 
@@ -30,13 +40,57 @@ buddy_allocator* _softrastAllocator;
 ////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////
 
+#define MIN(x,y) (((x) < (y)) ? (x) : (y))
+#define MAX(x,y) (((x) > (y)) ? (x) : (y))
+#define CLAMP(x,min,max) (MIN((max),MAX((min),(x))))
+
+#define SOFTRAST_MAX_POLYGON_VERTICES 9		// A triangle gains at most one vertex per clip plane (W + 5 frustum planes)
+
+#define SOFTRAST_GUARD_BAND           4.0f	// Extent of the guard band in NDC; only polygons reaching past it get clipped in X and Y, the rest is scissored by the rasterizers
+
+#define SOFTRAST_SUBPIXEL_BITS        4		// Half-space rasterizers snap vertices to 28.4 fixed point
+#define SOFTRAST_HALF_SPACE_CLAMP     (1 << 30)	// Edge values at a block corner are clamped to this; steps within a block are far smaller, so signs never flip
+#define SOFTRAST_COARSE_BLOCK_SIZE    16		// Half-space blocks are classified as a group first; must be a multiple of the block sizes
+
+#define SOFTRAST_TILE_SIZE            64	// Must be a multiple of 2, so 2x2 quads never straddle tiles
+#define SOFTRAST_TILE_BIN_CAPACITY    4096
+#define SOFTRAST_TILE_MAX_POLYGONS    16384	// Binned polygons are referenced by 16-bit index
+
+#define SOFTRAST_HIZ_TILE_SIZE        8		// Must be a multiple of the half-space block sizes
+#define SOFTRAST_HIZ_EPSILON          (1.0f / 65536.0f)	// Relative slack between interpolated depth and the values that end up in the depth buffer
+
+#define SOFTRAST_OCCLUSION_SCALE      4		// Every occlusion buffer pixel spans SCALE x SCALE render target pixels, rasterized as one 4x4 half-space block
+#define SOFTRAST_OCCLUSION_FULL_MASK  0xFFFF
+#define SOFTRAST_MAX_OCCLUDERS        8
+#define SOFTRAST_MIN_OCCLUDER_AREA    (1.0f / 64.0f)	// Fraction of the screen a mesh's bounds must cover to be considered as an occluder
+
+#define SOFTRAST_TRANSFORM_JOB_VERTICES 16384	// Vertices per transform job; a multiple of 16, so every range starts aligned for the SIMD paths
+#define SOFTRAST_MAX_TRANSFORM_JOBS     4096	// Also the most draws queued at once; the rest are culled and transformed once those are rasterized
+#define SOFTRAST_MESH_LOOKUP_SIZE       (2 * SOFTRAST_MAX_TRANSFORM_JOBS)	// Power of 2, so it never fills up
+
+#define SOFTRAST_MAX_VIEWS               64	// View and projection pairs per frame, one more than the matrix commands in it
+#define SOFTRAST_SORT_KEY_VIEW_SHIFT     58	// Draw sort keys hold, from the top: view (6 bits), pipeline (2), texture (32) and depth (24)
+#define SOFTRAST_SORT_KEY_PIPELINE_SHIFT 56
+#define SOFTRAST_SORT_KEY_TEXTURE_SHIFT  24
+
+#define SOFTRAST_VISIBILITY_TRIANGLE_BITS 20	// Visibility buffer IDs pack the draw (mesh and submesh) above the triangle index
+#define SOFTRAST_VISIBILITY_TRIANGLE_MASK ((1u << SOFTRAST_VISIBILITY_TRIANGLE_BITS) - 1)
+#define SOFTRAST_MAX_VISIBILITY_DRAWS     ((1u << (32 - SOFTRAST_VISIBILITY_TRIANGLE_BITS)) - 1)	// Draw 0 is reserved for empty pixels
+#define SOFTRAST_VISIBILITY_CACHE_SIZE    16	// Triangle setups remembered while resolving, must be a power of 2
+
+#define SOFTRAST_UPSCALE_BAND_ROWS      32		// Output rows per upscale job
+#define SOFTRAST_RENDER_SCALE_DAMPING   0.5f	// Fraction of the way a frame time budget moves the render scale towards the one that would have met it last frame
+
+#define SOFTRAST_CHECKERBOARD_BAND_ROWS       32		// Rows per reconstruction job
+#define SOFTRAST_CHECKERBOARD_DEPTH_TOLERANCE 0.05f		// Relative difference between a reprojected pixel's depth and the history's up to which the history is used
+
 enum
 {
 	VIEW_PROJECTION_DIRTY_BIT = (1<<0),
+	CLEAR_COLOR_BIT           = (1<<1),
+	CLEAR_DEPTH_BIT           = (1<<2),
 };
 
-#define AOS_OUTLINE_TABLE 1
-#if AOS_OUTLINE_TABLE
 typedef struct
 {
 	uint32_t flags, padding;
@@ -51,30 +105,285 @@ typedef struct
 	float minNY, maxNY;
 	float minNZ, maxNZ;
 } outline_table_entry;
-#endif
+
+typedef struct
+{
+	struct
+	{
+		union
+		{
+			struct { float x, y, z, w; };
+			float cell[4];
+		};
+	} position;
+	float u, v;
+} vertex;
+
+typedef struct
+{
+	outline_table_entry* outlineTable;
+	int32_t minX, minY, maxX, maxY;		// Inclusive pixel bounds to rasterize into
+} raster_region;
+
+typedef struct
+{
+	raster_quad quads[SOFTRAST_MAX_BATCH_QUADS];
+	uint32_t quadCount;
+} raster_quad_batch;
+
+typedef void ( *shade_quad_func ) ( const raster_quad* quad, const softrast_submesh* submesh );
+
+typedef struct
+{
+	int32_t a[3], b[3];				// Edge function E(x,y) = a * (x - ox) + b * (y - oy) in sub-pixel fixed point, positive on the inside
+	int32_t ox[3], oy[3];			// Snapped edge origin
+	int32_t bias[3];				// Top-left fill rule: 0 for edges that own the samples lying exactly on them, -1 for the others
+	int32_t minX, minY, maxX, maxY;	// Pixel bounds of the snapped triangle
+
+	float fa[3], fb[3];				// Unsnapped a and b, which the attribute gradients are derived from
+	float area;						// Unsnapped (doubled, signed) area
+} half_space_edges;
+
+// Screen space planes of a triangle's attributes, attribute(x, y) = a0 + dadx * (x - x0) + dady * (y - y0)
+typedef struct
+{
+	float x0, y0;
+	float z0, u0, v0;
+	float dzdx, dzdy, dudx, dudy, dvdx, dvdy;
+} attribute_planes;
+
+typedef enum
+{
+	BLOCK_OUTSIDE,
+	BLOCK_PARTIAL,
+	BLOCK_INSIDE,
+} block_coverage;
+
+typedef struct
+{
+	vertex verts[SOFTRAST_MAX_POLYGON_VERTICES];
+	const softrast_submesh* submesh;
+	uint32_t vectorCount;
+	uint32_t visibilityID;			// Non-zero when the polygon goes into the visibility buffer instead of being shaded
+} binned_polygon;
+
+typedef struct
+{
+	binned_polygon* polygons;
+	uint16_t* bins;
+	uint32_t* binCounts;
+	uint32_t polygonCount;
+} tile_bins;
+
+typedef enum
+{
+	AABB_FRUSTUM_INSIDE,
+	AABB_FRUSTUM_OUTSIDE,
+	AABB_FRUSTUM_INTERSECT,
+} aabb_frustum_result;
+
+typedef struct
+{
+	softrast_mesh* mesh;
+	aabb_frustum_result res;
+	volatile long pendingJobs;		// Transform jobs that haven't finished yet; the mesh can be rasterized once this hits 0
+} queued_mesh;
+
+typedef struct
+{
+	queued_mesh* mesh;
+	uint32_t firstVertex, vertexCount;
+} transform_job;
+
+typedef struct
+{
+	queued_mesh* mesh;
+	softrast_submesh* submesh;		// NULL draws all of the mesh's submeshes
+} queued_draw;
+
+// Meshes seen so far in a round of queued draws, so draws sharing a mesh are culled and transformed once
+typedef struct
+{
+	const softrast_mesh* mesh;
+	queued_mesh* queued;			// NULL when the mesh was culled
+} mesh_lookup_entry;
+
+typedef struct
+{
+	uint64_t key;
+	softrast_mesh* mesh;
+	softrast_submesh* submesh;		// NULL draws all of the mesh's submeshes
+	uint32_t order;					// Submission order, which breaks ties so draws with equal keys keep it
+} frame_draw;
+
+typedef struct
+{
+	bbm_aos_mat4 viewProjectionMatrix;
+	float nearClip, farClip;
+} frame_view;
+
+typedef struct
+{
+	const softrast_mesh* mesh;
+	const softrast_submesh* submesh;
+	aabb_frustum_result res;		// Clipping the triangles were set up with, so resolving sets them up identically
+} visibility_draw;
+
+typedef struct
+{
+	const uint8_t* rates;			// Row-major, row 0 at the top of the render target
+	uint32_t width, height;
+	float scaleX, scaleY;			// Cells per render target pixel, at the size the frame rasterizes at
+} shading_rate_image;
+
+// Render scale settings, as set through the API
+typedef struct
+{
+	float scale;					// Used as is without a budget
+	float budget;					// Frame time budget in milliseconds, 0 when disabled
+	float minScale;
+} render_scaling;
+
+typedef struct
+{
+	uint16_t x;						// Left one of the two source pixels blended
+	uint16_t weight;				// Of the right one, out of 256
+} upscale_tap;
+
+typedef struct
+{
+	const uint32_t* src;
+	uint32_t srcWidth, srcHeight, srcPitch;
+	uint32_t* dst;
+	uint32_t dstWidth, dstHeight, dstPitch;
+} upscale_job;
+
+typedef struct
+{
+	// Affine in the pixel's column and color buffer row: 1/w at two points along the pixel's view ray, then the previous frame's clip x, y and w of either
+	float base[8], stepX[8], stepY[8];
+	uint32_t historyValid;
+} checkerboard_job;
+
+// Everything a frame renders with, copied when it's submitted so the caller can move on to the next one
+typedef struct
+{
+	frame_draw* draws;				// Grows as needed, and is kept for the next frame using the slot
+	uint32_t drawCount, drawCapacity;
+	uint32_t sorted;
+	frame_view views[SOFTRAST_MAX_VIEWS];
+	uint32_t* colorBuffer;
+	uint32_t pitch;
+	uint32_t clearFlags;
+	render_scaling scaling;
+	shading_rate_image shadingRateImage;
+	DEBUG_SETTINGS debug;
+	softrast_fence fence;			// Frame the slot was last reserved for
+	softrast_frame_stats stats;		// Filled in as the frame completes
+} queued_frame;
+
+// A frame on the frame thread. Its front-end can run while the frame before it is still finishing, but it only takes over the render target, and the
+// state rasterizing reads, once that one is done
+typedef struct
+{
+	queued_frame* frame;
+	double startTime;
+	float scale;
+	uint32_t width, height;			// It rasterizes at
+	uint32_t scaled;
+	uint32_t acquired;				// Set once it has taken over the render target
+} frame_progress;
+
+// Screen space planes of a visibility buffer triangle's attributes
+typedef struct
+{
+	uint32_t id;
+	const softrast_submesh* submesh;
+	float x0, y0;
+	float z0, u0, v0;
+	float dzdx, dzdy, dudx, dudy, dvdx, dvdy;
+} visibility_setup;
 
 struct
 {
-	bbm_aos_mat4 projectionMatrix, viewMatrix, viewProjectionMatrix;
+	//--------------------------------
+	// State set through the API, which the next submitted frame copies
+	//--------------------------------
+	struct
+	{
+		bbm_aos_mat4 projectionMatrix, viewMatrix, viewProjectionMatrix;
+		float nearClip, farClip;
+		uint32_t* colorBuffer;
+		uint32_t pitch;
+		uint32_t flags;
+		render_scaling scaling;
+		shading_rate_image shadingRateImage;
+	} next;
+	queued_frame frames[SOFTRAST_MAX_FRAMES_IN_FLIGHT];
+	frame_progress rendering;		// Frame the frame thread sets up
+	frame_progress finishing;		// Frame before it, whose last tiles may still be rasterized; NULL frame when there's none
+
+	bbm_aos_mat4 viewProjectionMatrix;
 	float nearClip, farClip;
-	uint32_t flags;
+	softrast_simd_level simdLevel, supportedSimdLevel;
+	uint32_t kernelFlags;			// FrameDebug.flags, with the kernels the SIMD level can't run swapped for the next best ones
+	shade_quad_func shadeQuad;		// Pixel pipeline specialized for the render settings of the current softrast_render call
+	shade_quad_func shadeQuadUntextured;	// Same, for submeshes without a texture
+	softrast_shade_quads_func shadeQuads;	// Same, for the wide AVX2 or AVX-512 pipeline
+	raster_shade_target shadeTarget;	// What the pixel pipelines write to, with the clip distances of the view being rasterized
+	uint32_t depthPrePass;			// Set while the depth pre-pass runs; pixels then only test and write depth
+	shading_rate_image shadingRateImage;	// Of the frame being rendered
 
-#if AOS_OUTLINE_TABLE
 	outline_table_entry* outlineTable;
-#else
+
 	struct
 	{
-		float *minX, *maxX;
-		float *minZ, *maxZ;
+		float offset[3];
+		float bias[3];
+		float epsilon[3];
+	} viewport;
 
-		float *minU, *maxU;
-		float *minV, *maxV;
+	struct
+	{
+		tile_bins sets[2];
+		tile_bins* binning;				// Set the frame being set up bins into
+		tile_bins* rasterizing;			// Set the finishing frame's last tiles are rasterized from, NULL when it has none
+		softrast_job_batch batch;		// Rasterizing those
+		uint32_t tileCountX, tileCountY;
+		uint32_t outlineTableStride;
+	} tiles;
 
-		float *minNX, *maxNX;
-		float *minNY, *maxNY;
-		float *minNZ, *maxNZ;
-	} outlineTable;
-#endif
+	struct
+	{
+		float* minDepth;				// Per tile lower bound of the depth buffer, so 1/w of the farthest pixel
+		uint32_t tileCountX, tileCountY;
+	} hiz;
+
+	struct
+	{
+		float* depth;					// Low resolution, row-major; a pixel holds a depth every render target pixel it spans is known to reach
+		float* pendingDepth;			// Nearest depth of the triangles partially covering a pixel so far
+		uint16_t* pendingMask;			// Samples covered by those triangles
+		uint32_t width, height;
+	} occlusion;
+
+	struct
+	{
+		queued_mesh meshes[SOFTRAST_MAX_TRANSFORM_JOBS];
+		transform_job jobs[SOFTRAST_MAX_TRANSFORM_JOBS];
+		queued_draw draws[SOFTRAST_MAX_TRANSFORM_JOBS];
+		mesh_lookup_entry lookup[SOFTRAST_MESH_LOOKUP_SIZE];
+		uint32_t meshCount, jobCount, drawCount;
+	} transform;
+
+	pixel_stats threadPixelStats[SOFTRAST_MAX_THREADS];	// Gathered from the pool's threads as their jobs finish, indexed by thread index
+
+	struct
+	{
+		uint32_t* ids;					// Row-major, 0 where nothing was drawn
+		visibility_draw draws[SOFTRAST_MAX_VISIBILITY_DRAWS];
+		uint32_t drawCount;
+	} visibility;
 
 	struct
 	{
@@ -85,24 +394,300 @@ struct
 		uint32_t height;
 		uint32_t pitch;
 	} renderTarget;
+
+	struct
+	{
+		uint32_t width, height;			// Of the render target as set; renderTarget holds the size frames rasterize at
+		uint32_t* colorBuffer;			// Scaled frames rasterize into its top left part, with a pitch of the full width
+		uint32_t* rows;					// Per thread, a row of vertically blended pixels with the last one repeated
+		upscale_tap* taps;				// Per output column
+		float scale;					// Of the frame rendered last
+		float milliseconds;				// Time it took
+	} scaling;
+
+	struct
+	{
+		uint64_t blockMasks[2][2];		// Quads a 4x4 or 8x8 block keeps, for blocks starting at a kept and at a skipped quad
+		uint32_t active, parity;		// Quad (x, y) is skipped when (x / 2 + y / 2 + parity) is odd
+		uint32_t* historyColor[2];		// Reconstructed frames, row-major like the color buffer; the one at index history is the latest
+		float* historyDepth[2];
+		uint32_t history;
+		uint32_t historyValid;
+		bbm_aos_mat4 viewProjectionMatrix;	// Of the latest history frame
+	} checkerboard;
+
+	uint32_t failedFeatureBuffers;	// FEATURE_BUFFER_* that couldn't be allocated for the current render target, which aren't retried until it changes
 } globalData;
 
 //#ifdef _DEBUG
 	DEBUG_SETTINGS Debug;
+	DEBUG_SETTINGS FrameDebug;
 //#endif
 
+SOFTRAST_THREAD_LOCAL pixel_stats ThreadPixelStats;
+
 ////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////
 
+// Highest level both the CPU and the OS support; AVX2 and AVX-512 also need the OS to save the YMM, opmask and ZMM state
+static softrast_simd_level __softrast_cpu_simd_level ( )
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid ( info, 0 );
+	const int maxLeaf = info[0];
+
+	__cpuid ( info, 1 );
+	const uint32_t features1 = (uint32_t)info[2];
+
+	uint32_t features7 = 0;
+	if ( maxLeaf >= 7 )
+	{
+		__cpuidex ( info, 7, 0 );
+		features7 = (uint32_t)info[1];
+	}
+#else
+	uint32_t eax, ebx, ecx, edx;
+	const uint32_t maxLeaf = __get_cpuid_max ( 0, NULL );
+
+	__cpuid ( 1, eax, ebx, ecx, edx );
+	const uint32_t features1 = ecx;
+
+	uint32_t features7 = 0;
+	if ( maxLeaf >= 7 )
+	{
+		__cpuid_count ( 7, 0, eax, ebx, ecx, edx );
+		features7 = ebx;
+	}
+#endif
+
+	if ( !(features1 & (1u << 19)) )								// SSE4.1
+		return SOFTRAST_SIMD_SCALAR;
+	if ( !(features1 & (1u << 27)) || !(features1 & (1u << 28)) )	// OSXSAVE, AVX
+		return SOFTRAST_SIMD_SSE4;
+
+#ifdef _MSC_VER
+	const uint64_t xcr0 = _xgetbv ( 0 );
+#else
+	uint32_t xcr0lo, xcr0hi;
+	__asm__ ( "xgetbv" : "=a" ( xcr0lo ), "=d" ( xcr0hi ) : "c" ( 0 ) );
+	const uint64_t xcr0 = ((uint64_t)xcr0hi << 32) | xcr0lo;
+#endif
+
+	if ( (xcr0 & 0x06) != 0x06 || !(features7 & (1u << 5)) )										// YMM state, AVX2
+		return SOFTRAST_SIMD_SSE4;
+	if ( (xcr0 & 0xE6) != 0xE6 || !(features7 & (1u << 16)) || !(features7 & (1u << 31)) )		// Opmask and ZMM state, AVX-512 F and VL
+		return SOFTRAST_SIMD_AVX2;
+	return SOFTRAST_SIMD_AVX512;
+}
+
+// Kernels the current SIMD level can't run fall back to the next best one it can
+static uint32_t __softrast_kernel_flags ( uint32_t flags )
+{
+	if ( globalData.simdLevel < SOFTRAST_SIMD_AVX512 && (flags & FLAG_QUAD_RASTERIZATION_AVX512) )
+		flags = (flags & ~FLAG_QUAD_RASTERIZATION_AVX512) | FLAG_QUAD_RASTERIZATION_AVX2;
+	if ( globalData.simdLevel < SOFTRAST_SIMD_AVX2 )
+	{
+		if ( flags & FLAG_QUAD_RASTERIZATION_AVX2 )
+			flags = (flags & ~FLAG_QUAD_RASTERIZATION_AVX2) | FLAG_QUAD_RASTERIZATION_SIMD;
+		flags &= ~(FLAG_HALF_SPACE_AVX | FLAG_BATCHED_TRIANGLE_CULLING);
+	}
+	if ( globalData.simdLevel < SOFTRAST_SIMD_SSE4 )
+		flags &= ~FLAG_QUAD_RASTERIZATION_SIMD;
+	return flags;
+}
+
+static void __softrast_render_frame ( softrast_fence fence );
+static void __softrast_finish_frame ( );
+
 uint32_t softrast_initialize ( buddy_allocator* allocator )
 {
 	_softrastAllocator = allocator;
+	softrast_thread_pool_initialize ( 0 );
+	softrast_frame_queue_initialize ( __softrast_render_frame, __softrast_finish_frame );
+
+	globalData.next.scaling.scale = globalData.next.scaling.minScale = globalData.scaling.scale = 1.0f;
+
+	for ( uint32_t size = 0; size < 2; size++ )
+	{
+		const int32_t blockSize = 4 << size;
+		for ( int32_t r = 0; r < blockSize; r++ )
+		{
+			for ( int32_t c = 0; c < blockSize; c++ )
+			{
+				const uint32_t parity = ((c >> 1) + (r >> 1)) & 1;
+				globalData.checkerboard.blockMasks[size][parity] |= 1ull << (r * blockSize + c);
+			}
+		}
+	}
+
+	//--------------------------------
+	// AVX-512 also needs the kernel to be compiled in
+	//--------------------------------
+	globalData.supportedSimdLevel = __softrast_cpu_simd_level ( );
+	if ( globalData.supportedSimdLevel == SOFTRAST_SIMD_AVX512 && !softrast_select_shade_quads_avx512 ( &Debug ) )
+		globalData.supportedSimdLevel = SOFTRAST_SIMD_AVX2;
+
+	softrast_set_simd_level ( globalData.supportedSimdLevel );
+	return 0;
+}
+
+uint32_t softrast_set_simd_level ( softrast_simd_level level )
+{
+	if ( level > globalData.supportedSimdLevel )
+		return -1;	// Not supported by this CPU
+
+	softrast_finish ( );
+	globalData.simdLevel = level;
+
+	//--------------------------------
+	// BarebonesMath goes along, with the best instruction set it was built with that doesn't exceed the level
+	//--------------------------------
+	static const uint32_t instrSets[] = { BAREBONES_MATH_VECTOR_INSTR_SET_NONE, BAREBONES_MATH_VECTOR_INSTR_SET_SSE, BAREBONES_MATH_VECTOR_INSTR_SET_AVX, BAREBONES_MATH_VECTOR_INSTR_SET_AVX512 };
+	for ( int32_t i = (int32_t)level; bbm_set_vector_instr_set ( instrSets[i] ) != 0; i-- )
+		;	// NONE is always compiled in
 	return 0;
 }
 
+softrast_simd_level softrast_get_simd_level ( )
+{
+	return globalData.simdLevel;
+}
+
+softrast_simd_level softrast_get_supported_simd_level ( )
+{
+	return globalData.supportedSimdLevel;
+}
+
 ////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////
 
+// Lays out the tiles, HiZ and occlusion buffer for rasterizing at the given size, within the buffers allocated for the render target's
+static void __softrast_set_render_size ( uint32_t width, uint32_t height )
+{
+	globalData.renderTarget.width  = width;
+	globalData.renderTarget.height = height;
+	globalData.renderTarget.depthBufferQuadFloatStride = 2 * ((width + 1) & (~1));
+
+	globalData.tiles.tileCountX = (width  + SOFTRAST_TILE_SIZE - 1) / SOFTRAST_TILE_SIZE;
+	globalData.tiles.tileCountY = (height + SOFTRAST_TILE_SIZE - 1) / SOFTRAST_TILE_SIZE;
+	for ( uint32_t i = 0; i < 2; i++ )
+		memset ( globalData.tiles.sets[i].binCounts, 0, globalData.tiles.tileCountX * globalData.tiles.tileCountY * sizeof ( uint32_t ) );
+
+	globalData.hiz.tileCountX = (width  + SOFTRAST_HIZ_TILE_SIZE - 1) / SOFTRAST_HIZ_TILE_SIZE;
+	globalData.hiz.tileCountY = (height + SOFTRAST_HIZ_TILE_SIZE - 1) / SOFTRAST_HIZ_TILE_SIZE;
+	memset ( globalData.hiz.minDepth, 0, globalData.hiz.tileCountX * globalData.hiz.tileCountY * sizeof ( float ) );
+
+	globalData.occlusion.width  = (width  + SOFTRAST_OCCLUSION_SCALE - 1) / SOFTRAST_OCCLUSION_SCALE;
+	globalData.occlusion.height = (height + SOFTRAST_OCCLUSION_SCALE - 1) / SOFTRAST_OCCLUSION_SCALE;
+
+	globalData.checkerboard.historyValid = 0;	// Laid out for another size
+
+	//--------------------------------
+	// Prepare outline table default values where required
+	//--------------------------------
+	outline_table_entry* outlineTables = globalData.outlineTable - 1;
+	for ( uint32_t i = 0; i < softrast_thread_pool_thread_count ( ) * globalData.tiles.outlineTableStride; i++ )
+	{
+		outlineTables[i].flags = 0;
+		outlineTables[i].minX = (float)width, outlineTables[i].maxX = 0;
+	}
+}
+
+#define FEATURE_BUFFER_VISIBILITY   0x1
+#define FEATURE_BUFFER_SCALING      0x2
+#define FEATURE_BUFFER_CHECKERBOARD 0x4
+
+// Frees the buffers of the render target that only some features use
+static void __softrast_free_feature_buffers ( )
+{
+	if ( globalData.visibility.ids )
+		miltyalloc_buddy_allocator_free ( _softrastAllocator, globalData.visibility.ids );
+	if ( globalData.scaling.colorBuffer )
+		miltyalloc_buddy_allocator_free ( _softrastAllocator, globalData.scaling.colorBuffer );
+	if ( globalData.checkerboard.historyColor[0] )
+		miltyalloc_buddy_allocator_free ( _softrastAllocator, globalData.checkerboard.historyColor[0] );
+
+	globalData.visibility.ids      = NULL;
+	globalData.scaling.colorBuffer = NULL;
+	globalData.scaling.rows        = NULL;
+	globalData.scaling.taps        = NULL;
+	memset ( globalData.checkerboard.historyColor, 0, sizeof ( globalData.checkerboard.historyColor ) );
+	memset ( globalData.checkerboard.historyDepth, 0, sizeof ( globalData.checkerboard.historyDepth ) );
+	globalData.failedFeatureBuffers = 0;
+}
+
+// Allocates the buffers a feature needs the first time a frame enables it, so render targets only pay for the features in use. Frames
+// in flight read these pointers, so they're waited for first; that only happens once per feature and render target
+static void __softrast_allocate_feature_buffers ( )
+{
+	if ( !globalData.renderTarget.depthBuffer )
+		return;
+
+	uint32_t wanted = 0;
+	if ( (Debug.flags & FLAG_VISIBILITY_BUFFER) && !globalData.visibility.ids )
+		wanted |= FEATURE_BUFFER_VISIBILITY;
+	if ( (globalData.next.scaling.scale < 1.0f || globalData.next.scaling.budget > 0.0f) && !globalData.scaling.colorBuffer )
+		wanted |= FEATURE_BUFFER_SCALING;
+	if ( (Debug.flags & FLAG_CHECKERBOARD) && !globalData.checkerboard.historyColor[0] )
+		wanted |= FEATURE_BUFFER_CHECKERBOARD;
+	wanted &= ~globalData.failedFeatureBuffers;
+	if ( !wanted )
+		return;
+
+	softrast_finish ( );
+
+	const uint32_t width = globalData.scaling.width, height = globalData.scaling.height;
+	if ( wanted & FEATURE_BUFFER_VISIBILITY )
+	{
+		globalData.visibility.ids = (uint32_t*)miltyalloc_buddy_allocator_alloc ( _softrastAllocator, width * height * sizeof ( uint32_t ) );
+		if ( !globalData.visibility.ids )
+			globalData.failedFeatureBuffers |= FEATURE_BUFFER_VISIBILITY;
+	}
+
+	//--------------------------------
+	// Scaled frames rasterize into a color buffer of their own, and upscale from it a row at a time
+	//--------------------------------
+	if ( wanted & FEATURE_BUFFER_SCALING )
+	{
+		const uint32_t scaledColorSize = width * height * sizeof ( uint32_t );
+		const uint32_t upscaleRowsSize = softrast_thread_pool_thread_count ( ) * (width + 1) * sizeof ( uint32_t );
+		const uint32_t upscaleTapsSize = width * sizeof ( upscale_tap );
+
+		uint8_t* ptr = (uint8_t*)miltyalloc_buddy_allocator_alloc ( _softrastAllocator, scaledColorSize + upscaleRowsSize + upscaleTapsSize );
+		if ( ptr )
+		{
+			globalData.scaling.colorBuffer = (uint32_t*)ptr,    ptr += scaledColorSize;
+			globalData.scaling.rows        = (uint32_t*)ptr,    ptr += upscaleRowsSize;
+			globalData.scaling.taps        = (upscale_tap*)ptr;
+		}
+		else
+			globalData.failedFeatureBuffers |= FEATURE_BUFFER_SCALING;
+	}
+
+	//--------------------------------
+	// Checkerboard rendering reconstructs every frame from the previous one, writing the next while reading it
+	//--------------------------------
+	if ( wanted & FEATURE_BUFFER_CHECKERBOARD )
+	{
+		const uint32_t historyColorSize = width * height * sizeof ( uint32_t );
+		const uint32_t historyDepthSize = width * height * sizeof ( float );
+
+		uint8_t* ptr = (uint8_t*)miltyalloc_buddy_allocator_alloc ( _softrastAllocator, 2 * (historyColorSize + historyDepthSize) );
+		if ( ptr )
+		{
+			for ( uint32_t i = 0; i < 2; i++ )
+			{
+				globalData.checkerboard.historyColor[i] = (uint32_t*)ptr, ptr += historyColorSize;
+				globalData.checkerboard.historyDepth[i] = (float*)ptr,    ptr += historyDepthSize;
+			}
+			globalData.checkerboard.historyValid = 0;
+		}
+		else
+			globalData.failedFeatureBuffers |= FEATURE_BUFFER_CHECKERBOARD;
+	}
+}
+
 uint32_t softrast_set_render_target ( uint32_t width, uint32_t height, uint32_t* colorBuffer, uint32_t pitchInBytes )
 {
 	//--------------------------------
@@ -114,13 +699,20 @@ uint32_t softrast_set_render_target ( uint32_t width, uint32_t height, uint32_t*
 	//--------------------------------
 	// Check whether or not we need to reallocate outline tables and the such
 	//--------------------------------
-	if ( width != globalData.renderTarget.width || height != globalData.renderTarget.height )
+	if ( width != globalData.scaling.width || height != globalData.scaling.height )
 	{
 		//--------------------------------
-		// Free internally allocated memory (all allocated in one row, so deallocating the depth buffer deallocates everything)
+		// Frames in flight still render into the current buffers
+		//--------------------------------
+		softrast_finish ( );
+
+		//--------------------------------
+		// Free internally allocated memory (all allocated in one row, so deallocating the depth buffer deallocates everything but the
+		// feature buffers, which are allocated again once a frame uses them)
 		//--------------------------------
 		if ( globalData.renderTarget.depthBuffer )
 			miltyalloc_buddy_allocator_free ( _softrastAllocator, globalData.renderTarget.depthBuffer );
+		__softrast_free_feature_buffers ( );
 
 		//--------------------------------
 		// Allocate new internal memory
@@ -128,97 +720,142 @@ uint32_t softrast_set_render_target ( uint32_t width, uint32_t height, uint32_t*
 		uint32_t alignedWidth  = (width  + 1) & (~1);
 		uint32_t alignedHeight = (height + 1) & (~1);
 
-		uint32_t outlineTableSize;
-#if AOS_OUTLINE_TABLE
-		outlineTableSize = alignedHeight * sizeof ( outline_table_entry );
-#else
-		outlineTableSize = 2 * 7 * alignedHeight * sizeof ( float );
-#endif
+		// One outline table per thread (the first doubling as the table for non-tiled rasterization), each with a guard entry above and below
+		uint32_t threadCount        = softrast_thread_pool_thread_count ( );
+		uint32_t outlineTableStride = alignedHeight + 2;
+
+		uint32_t tileCountX = (width  + SOFTRAST_TILE_SIZE - 1) / SOFTRAST_TILE_SIZE;
+		uint32_t tileCountY = (height + SOFTRAST_TILE_SIZE - 1) / SOFTRAST_TILE_SIZE;
+
+		uint32_t depthBufferSize  = alignedWidth * alignedHeight * sizeof ( float );
+		uint32_t outlineTableSize = threadCount * outlineTableStride * sizeof ( outline_table_entry );
+		uint32_t polygonsSize     = SOFTRAST_TILE_MAX_POLYGONS * sizeof ( binned_polygon );
+		uint32_t binCountsSize    = tileCountX * tileCountY * sizeof ( uint32_t );
+		uint32_t binsSize         = tileCountX * tileCountY * SOFTRAST_TILE_BIN_CAPACITY * sizeof ( uint16_t );
+		uint32_t tileBinsSize     = polygonsSize + binCountsSize + binsSize;
 
-		uint32_t allocSize = alignedWidth * alignedHeight * sizeof ( float ) + outlineTableSize;
+		uint32_t hizTileCountX = (width  + SOFTRAST_HIZ_TILE_SIZE - 1) / SOFTRAST_HIZ_TILE_SIZE;
+		uint32_t hizTileCountY = (height + SOFTRAST_HIZ_TILE_SIZE - 1) / SOFTRAST_HIZ_TILE_SIZE;
+		uint32_t hizSize       = hizTileCountX * hizTileCountY * sizeof ( float );
+
+		uint32_t occlusionWidth  = (width  + SOFTRAST_OCCLUSION_SCALE - 1) / SOFTRAST_OCCLUSION_SCALE;
+		uint32_t occlusionHeight = (height + SOFTRAST_OCCLUSION_SCALE - 1) / SOFTRAST_OCCLUSION_SCALE;
+		uint32_t occlusionSize   = occlusionWidth * occlusionHeight * (2 * sizeof ( float ) + sizeof ( uint16_t ));
+
+		uint32_t allocSize = depthBufferSize + outlineTableSize + 2 * tileBinsSize + hizSize + occlusionSize;	// Two sets of tile bins, so a frame can bin while the last one's tiles are rasterized
 		void* memory = miltyalloc_buddy_allocator_alloc ( _softrastAllocator, allocSize );
 		if ( memory == NULL )
 		{
 			memset ( &globalData.outlineTable, 0, sizeof ( globalData.outlineTable ) );
+			memset ( &globalData.tiles, 0, sizeof ( globalData.tiles ) );
+			memset ( &globalData.hiz, 0, sizeof ( globalData.hiz ) );
+			memset ( &globalData.occlusion, 0, sizeof ( globalData.occlusion ) );
 			memset ( &globalData.renderTarget, 0, sizeof ( globalData.renderTarget ) );
+			memset ( &globalData.scaling, 0, sizeof ( globalData.scaling ) );
+			globalData.scaling.scale    = 1.0f;
+			globalData.next.colorBuffer = NULL;
 			return -2;	// Could not allocate (enough) memory
 		}
 
 		globalData.renderTarget.depthBuffer = (float*)memory;
 	
 		//--------------------------------
-		// Prepare outline table pointers
+		// Prepare outline table and tile bin pointers
 		//--------------------------------
-		float* outlinePtr = globalData.renderTarget.depthBuffer + alignedWidth * alignedHeight;
-		globalData.renderTarget.depthBufferQuadFloatStride = 2 * alignedWidth;
-
-#if AOS_OUTLINE_TABLE
-		globalData.outlineTable = (outline_table_entry*)outlinePtr;
-#else
-		globalData.outlineTable.minX = outlinePtr + 0 * alignedHeight, globalData.outlineTable.maxX = outlinePtr + 1 * alignedHeight;
-		globalData.outlineTable.minZ = outlinePtr + 2 * alignedHeight, globalData.outlineTable.maxZ = outlinePtr + 3 * alignedHeight;
+		uint8_t* ptr = (uint8_t*)memory + depthBufferSize;
 
-		globalData.outlineTable.minU = outlinePtr + 4 * alignedHeight, globalData.outlineTable.maxU = outlinePtr + 5 * alignedHeight;
-		globalData.outlineTable.minV = outlinePtr + 6 * alignedHeight, globalData.outlineTable.maxV = outlinePtr + 7 * alignedHeight;
+		globalData.outlineTable = (outline_table_entry*)ptr + 1;
+		ptr += outlineTableSize;
 
-		globalData.outlineTable.minNX = outlinePtr + 8  * alignedHeight, globalData.outlineTable.maxNX = outlinePtr + 9  * alignedHeight;
-		globalData.outlineTable.minNY = outlinePtr + 10 * alignedHeight, globalData.outlineTable.maxNY = outlinePtr + 11 * alignedHeight;
-		globalData.outlineTable.minNZ = outlinePtr + 12 * alignedHeight, globalData.outlineTable.maxNZ = outlinePtr + 13 * alignedHeight;
-#endif
-
-		//--------------------------------
-		// Prepare outline table default values where required
-		//--------------------------------
-#if AOS_OUTLINE_TABLE
-		for ( uint32_t i = 0; i < alignedHeight; i++ )
+		for ( uint32_t i = 0; i < 2; i++ )
 		{
-			globalData.outlineTable[i].flags = 0;
-			globalData.outlineTable[i].minX = (float)width, globalData.outlineTable[i].maxX = 0;
+			globalData.tiles.sets[i].polygons     = (binned_polygon*)ptr, ptr += polygonsSize;
+			globalData.tiles.sets[i].binCounts    = (uint32_t*)ptr,       ptr += binCountsSize;
+			globalData.tiles.sets[i].bins         = (uint16_t*)ptr,       ptr += binsSize;
+			globalData.tiles.sets[i].polygonCount = 0;
 		}
-#else
-		for ( uint32_t i = 0; i < alignedHeight; i++ )
-		{
-			globalData.outlineTable.minX[i] = (float)width, globalData.outlineTable.maxX[i] = 0;
-		}
-#endif
+		globalData.tiles.binning            = globalData.tiles.sets;
+		globalData.tiles.rasterizing        = NULL;
+		globalData.tiles.outlineTableStride = outlineTableStride;
+
+		globalData.hiz.minDepth = (float*)ptr, ptr += hizSize;
+
+		globalData.scaling.width  = width;
+		globalData.scaling.height = height;
+
+		globalData.occlusion.depth        = (float*)ptr,    ptr += occlusionWidth * occlusionHeight * sizeof ( float );
+		globalData.occlusion.pendingDepth = (float*)ptr,    ptr += occlusionWidth * occlusionHeight * sizeof ( float );
+		globalData.occlusion.pendingMask  = (uint16_t*)ptr;
+
+		__softrast_set_render_size ( width, height );
 	}
 
 	//--------------------------------
-	// Set variables
+	// Set variables; the color buffer can change every frame, so it's picked up when the next frame is submitted
 	//--------------------------------
-	globalData.renderTarget.colorBuffer = colorBuffer;
-	globalData.renderTarget.width       = width;
-	globalData.renderTarget.height      = height;
-	globalData.renderTarget.pitch       = pitchInBytes;
+	globalData.next.colorBuffer = colorBuffer;
+	globalData.next.pitch       = pitchInBytes;
 
 	return 0;
 }
 
-uint32_t softrast_set_view_matrix ( const bbm_aos_mat4* viewMat )
+uint32_t softrast_set_render_scale ( float scale )
 {
-	globalData.viewMatrix = *viewMat;
-	globalData.flags |= VIEW_PROJECTION_DIRTY_BIT;
+	if ( !(scale > 0.0f && scale <= 1.0f) )
+		return -1;
+	globalData.next.scaling.scale = scale;
 	return 0;
 }
 
-uint32_t softrast_set_projection_matrix ( const bbm_aos_mat4* projMat )
+uint32_t softrast_set_shading_rate_image ( const uint8_t* rates, uint32_t width, uint32_t height )
+{
+	if ( rates && (width == 0 || height == 0) )
+		return -1;
+	globalData.next.shadingRateImage.rates  = rates;
+	globalData.next.shadingRateImage.width  = width;
+	globalData.next.shadingRateImage.height = height;
+	return 0;
+}
+
+uint32_t softrast_set_frame_time_budget ( float milliseconds, float minScale )
+{
+	if ( !(milliseconds >= 0.0f) || !(minScale > 0.0f && minScale <= 1.0f) )
+		return -1;
+	globalData.next.scaling.budget   = milliseconds;
+	globalData.next.scaling.minScale = minScale;
+	return 0;
+}
+
+uint32_t softrast_set_view_matrix ( const bbm_aos_mat4* viewMat )
+{
+	globalData.next.viewMatrix = *viewMat;
+	globalData.next.flags     |= VIEW_PROJECTION_DIRTY_BIT;
+	return 0;
+}
+
+static void __softrast_clip_distances ( const bbm_aos_mat4* projMat, float* nearClip, float* farClip )
 {
-	//--------------------------------
-	// Calculate near and far clip distances
-	//--------------------------------
 	bbm_aos_vec4 minZOut, minZIn = { .x = 0.0f, .y = 0.0f, .z = -1.0f, .w = 1.0f };
 	bbm_aos_vec4 maxZOut, maxZIn = { .x = 0.0f, .y = 0.0f, .z =  1.0f, .w = 1.0f };
 	bbm_aos_mat4 projInv;
 	bbm_aos_mat4_inverse ( &projInv, projMat );
 	bbm_aos_mat4_mul_aos_vec4 ( &minZOut, &projInv, &minZIn );
 	bbm_aos_mat4_mul_aos_vec4 ( &maxZOut, &projInv, &maxZIn );
-	globalData.nearClip = 1.0f / minZOut.w, globalData.farClip = 1.0f / maxZOut.w;
+	*nearClip = 1.0f / minZOut.w, *farClip = 1.0f / maxZOut.w;
+}
+
+uint32_t softrast_set_projection_matrix ( const bbm_aos_mat4* projMat )
+{
+	//--------------------------------
+	// Calculate near and far clip distances
+	//--------------------------------
+	__softrast_clip_distances ( projMat, &globalData.next.nearClip, &globalData.next.farClip );
 
 	//--------------------------------
 	// Set projection matrix
 	//--------------------------------
-	globalData.projectionMatrix = *projMat;
-	globalData.flags           |= VIEW_PROJECTION_DIRTY_BIT;
+	globalData.next.projectionMatrix = *projMat;
+	globalData.next.flags           |= VIEW_PROJECTION_DIRTY_BIT;
 
 	//--------------------------------
 	// Return success
@@ -229,11 +866,12 @@ uint32_t softrast_set_projection_matrix ( const bbm_aos_mat4* projMat )
 ////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////
 
+// Clears happen at the start of the next submitted frame, so they stay in order with the frames in flight
 uint32_t softrast_clear_render_target ( )
 {
-	if ( !globalData.renderTarget.colorBuffer )
+	if ( !globalData.next.colorBuffer )
 		return -1;
-	memset ( globalData.renderTarget.colorBuffer, 0x80, globalData.renderTarget.pitch * globalData.renderTarget.height );
+	globalData.next.flags |= CLEAR_COLOR_BIT;
 	return 0;
 }
 
@@ -241,123 +879,24 @@ uint32_t softrast_clear_depth_render_target ( )
 {
 	if ( !globalData.renderTarget.depthBuffer )
 		return -1;
-	memset ( globalData.renderTarget.depthBuffer, 0x00, globalData.renderTarget.width * globalData.renderTarget.height * sizeof ( float ) );
+	globalData.next.flags |= CLEAR_DEPTH_BIT;
 	return 0;
 }
 
-////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////
-
-#define SOACLIP 0
-#if SOACLIP
-// clipPoint should always be the positive value; sign indicates whether or not the positive or negative side should be clipped!
-static uint32_t __softrast_clip ( bbm_soa_vec4* out, bbm_soa_vec2* ouv, const bbm_soa_vec4* in, const bbm_soa_vec2* iuv, const uint32_t inCount, uint32_t clipDim, float sign, float clipPoint )
+static void __softrast_clear ( uint32_t clearFlags )
 {
-	if ( inCount < 3 )
-		return 0;
-
-	uint32_t vectorCount = 0;
+	if ( clearFlags & CLEAR_COLOR_BIT )
+		memset ( globalData.renderTarget.colorBuffer, 0x80, globalData.renderTarget.pitch * globalData.renderTarget.height );
 
-	const float* x   = in->x;
-	const float* y   = in->y;
-	const float* z   = in->z;
-	const float* w   = in->w;
-	const float* u   = iuv->x;
-	const float* v   = iuv->y;
-	const float* val = in->cells[clipDim];
-
-		  float* ox  = out->x;
-		  float* oy  = out->y;
-		  float* oz  = out->z;
-		  float* ow  = out->w;
-		  float* ou  = ouv->x;
-		  float* ov  = ouv->y;
-
-	uint32_t last  = inCount-1;
-	//float lastDist = (1.0f - sign * val[last]) - 0.05f;
-	float lastDist = (clipPoint - sign * val[last]);
-						
-	float sdist;
-	for ( uint32_t i = 0; i < inCount; last = i++, lastDist = sdist )
+	if ( clearFlags & CLEAR_DEPTH_BIT )
 	{
-		sdist = (clipPoint - sign * *(val++));
-		//sdist = (1.0f - sign * (*val++)) - 0.05f;
-		if ( lastDist <= 0.0f )
-		{
-			// Last was OUT
-			if ( sdist > 0.0f )
-			{
-				// Cur is IN
-				// Push intersection of vector between last and now with the plane
-
-				// Determine lerp factor between last and current
-				float f = sdist / (sdist - lastDist);
-				*(ox++) = x[last] * f + x[i] * (1.0f-f);
-				*(oy++) = y[last] * f + y[i] * (1.0f-f);
-				*(oz++) = z[last] * f + z[i] * (1.0f-f);
-				*(ow++) = w[last] * f + w[i] * (1.0f-f);
-				*(ou++) = u[last] * f + u[i] * (1.0f-f);
-				*(ov++) = v[last] * f + v[i] * (1.0f-f);
-
-				*(ox++) = x[i];
-				*(oy++) = y[i];
-				*(oz++) = z[i];
-				*(ow++) = w[i];
-				*(ou++) = u[i];
-				*(ov++) = v[i];
-
-				vectorCount += 2;
-			}
-		}
-		else
-		{
-			// Last was IN
-			if ( sdist > 0.0f )
-			{
-				// Cur is IN
-				// Push
-				*(ox++) = x[i];
-				*(oy++) = y[i];
-				*(oz++) = z[i];
-				*(ow++) = w[i];
-				*(ou++) = u[i];
-				*(ov++) = v[i];
-
-				vectorCount++;
-			}
-			else
-			{
-				// Cur is OUT
-				// Push intersection of vector between last and now with the plane
-				float f = lastDist / (lastDist - sdist);
-				*(ox++) = x[i] * f + x[last] * (1.0f-f);
-				*(oy++) = y[i] * f + y[last] * (1.0f-f);
-				*(oz++) = z[i] * f + z[last] * (1.0f-f);
-				*(ow++) = w[i] * f + w[last] * (1.0f-f);
-				*(ou++) = u[i] * f + u[last] * (1.0f-f);
-				*(ov++) = v[i] * f + v[last] * (1.0f-f);
-
-				//sdist = 0.001f;
-
-				vectorCount++;
-			}
-		}
+		memset ( globalData.renderTarget.depthBuffer, 0x00, ((globalData.renderTarget.width + 1) & (~1)) * ((globalData.renderTarget.height + 1) & (~1)) * sizeof ( float ) );
+		memset ( globalData.hiz.minDepth, 0x00, globalData.hiz.tileCountX * globalData.hiz.tileCountY * sizeof ( float ) );
 	}
-	return vectorCount;
 }
-#else
-typedef struct
-{
-	struct
-	{
-		union
-		{
-			struct { float x, y, z, w; };
-			float cell[4];
-		};
-	} position;
-	float u, v;
-} vertex;
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
 
 // clipPoint should always be the positive value; sign indicates whether or not the positive or negative side should be clipped!
 static uint32_t __softrast_clip ( vertex* outv, const vertex* inv, const uint32_t inCount, uint32_t clipDim, float sign, float clipPoint )
@@ -444,14 +983,6 @@ static uint32_t __softrast_clip ( vertex* outv, const vertex* inv, const uint32_
 	}
 	return vectorCount;
 }
-#endif
-
-typedef enum
-{
-	AABB_FRUSTUM_INSIDE,
-	AABB_FRUSTUM_OUTSIDE,
-	AABB_FRUSTUM_INTERSECT,
-} aabb_frustum_result;
 
 static aabb_frustum_result __aabb_check_frustum ( softrast_mesh* mesh )
 {
@@ -537,1751 +1068,4123 @@ static aabb_frustum_result __aabb_check_frustum ( softrast_mesh* mesh )
 		return AABB_FRUSTUM_INTERSECT;
 }
 
-uint32_t softrast_render ( softrast_model* model )
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Fetches triangle vertices, clips, culls and transforms them to screen space. Returns the polygon's vertex count (< 3 if rejected)
+static uint32_t __softrast_setup_polygon ( vertex* outVerts, const softrast_mesh* mesh, const uint32_t* index, aabb_frustum_result res )
 {
 	//--------------------------------
-	// Update view projection matrix if needed
+	// Variables
+	//--------------------------------
+	__declspec(align(64)) vertex tempVertData[SOFTRAST_MAX_POLYGON_VERTICES];
+	vertex* curVerts = outVerts, *tempVerts = tempVertData;
+
+	//--------------------------------
+	// Initialize vertices for clipping
 	//--------------------------------
-	if ( globalData.flags & VIEW_PROJECTION_DIRTY_BIT )
 	{
-		bbm_aos_mat4_mul_aos_mat4 ( &globalData.viewProjectionMatrix, &globalData.projectionMatrix, &globalData.viewMatrix );
-		globalData.flags &= ~VIEW_PROJECTION_DIRTY_BIT;
+		const bbm_soa_vec4* transformedPositions = &mesh->transformedPositions;
+		const bbm_soa_vec2* texcoords            = &mesh->texcoords;
+
+		vertex* curv = curVerts;
+		for ( uint32_t i = 0; i < 3; i++, curv++, index++ )
+		{
+			curv->position.x = transformedPositions->x[*index], curv->position.y = transformedPositions->y[*index], curv->position.z = transformedPositions->z[*index], curv->position.w = transformedPositions->w[*index];
+			curv->u = texcoords->x[*index], curv->v = texcoords->y[*index];
+		}
 	}
 
 	//--------------------------------
-	// Transform mesh vertex positions
+	// Clip w against near clip plane
 	//--------------------------------
-	softrast_mesh* mesh = model->meshes;
-	for ( uint32_t i = 0; i < model->meshCount; i++, mesh++ )
+	uint32_t vectorCount = 3;
+	if ( res == AABB_FRUSTUM_INTERSECT && (FrameDebug.flags & FLAG_CLIP_W) )
 	{
-		bbm_aos_mat4_mul_soa_vec3w1_out_vec4 ( &mesh->transformedPositions, &globalData.viewProjectionMatrix, &mesh->positions );
+		vectorCount = __softrast_clip ( tempVerts, curVerts, 3, 3, -1.0f, -globalData.nearClip );
+		if ( vectorCount < 3 )
+			return 0;
+		
+		vertex* temp = tempVerts;
+		tempVerts = curVerts;
+		curVerts  = temp;
 	}
 
 	//--------------------------------
-	// Variables
+	// Take the reciprocal of w, and perspective-correct X, Y, Z, U and V
 	//--------------------------------
-#if SOACLIP
-	__declspec(align(16)) float clippedVertData[12*8];
-	bbm_soa_vec4 clippedVerts[2];
-	bbm_soa_vec2 clippedVertUVs[2];
-	bbm_soa_vec4_init ( &clippedVerts[0],   clippedVertData,      clippedVertData + 8,  clippedVertData + 16, clippedVertData + 24, 3 );
-	bbm_soa_vec4_init ( &clippedVerts[1],   clippedVertData + 32, clippedVertData + 40, clippedVertData + 48, clippedVertData + 56, 0 );
-	bbm_soa_vec2_init ( &clippedVertUVs[0], clippedVertData + 64, clippedVertData + 72, 3 );
-	bbm_soa_vec2_init ( &clippedVertUVs[1], clippedVertData + 80, clippedVertData + 88, 0 );
-#else
-	__declspec(align(64)) vertex clippedVerts[2][6];
-	vertex* curVerts = &clippedVerts[0][0], *tempVerts = &clippedVerts[1][0];
-#endif
+	{
+		vertex* curv = curVerts;
+		for ( uint32_t i = 0; i < vectorCount; i++, curv++ )
+		{
+			curv->position.w  = 1.0f / curv->position.w;
+			curv->position.x *= curv->position.w, curv->position.y *= curv->position.w, curv->position.z *= curv->position.w;
+			curv->u          *= curv->position.w, curv->v          *= curv->position.w;
+		}
+	}
 
-	const float offset[3]  = { globalData.renderTarget.width / 2.0f, globalData.renderTarget.height / 2.0f, 0.0f };
-	const float bias[3]    = { globalData.renderTarget.width / 2.0f, globalData.renderTarget.height / 2.0f, 0.0f };
-	const float epsilon[3] = { Debug.clipBorderDist / bias[0], Debug.clipBorderDist / bias[1], 0.0f };
+	//--------------------------------
+	// Check winding order
+	//--------------------------------
+	if ( FrameDebug.flags & FLAG_BACKFACE_CULLING_ENABLED )
+	{
+		float dx1 = curVerts[1].position.x - curVerts[0].position.x;
+		float dx2 = curVerts[2].position.x - curVerts[0].position.x;
+		float dy1 = curVerts[1].position.y - curVerts[0].position.y;
+		float dy2 = curVerts[2].position.y - curVerts[0].position.y;
+		float cz  = dx1 * dy2 - dx2 * dy1;
+		if ( ((FrameDebug.flags & FLAG_BACKFACE_CULLING_INVERTED) ? 1 : 0) ^ (cz < 0.0f) )
+			return 0;
+	}
 
 	//--------------------------------
-	// Rasterize
+	// Clipping
 	//--------------------------------
-	mesh = model->meshes;
-	for ( uint32_t i = 0; i < model->meshCount; i++, mesh++ )
+	if ( res == AABB_FRUSTUM_INTERSECT && (FrameDebug.flags & (FLAG_CLIP_FRUSTUM | FLAG_GUARD_BAND_CLIPPING)) == (FLAG_CLIP_FRUSTUM | FLAG_GUARD_BAND_CLIPPING) )
 	{
-		bbm_soa_vec4 transformedPositions = mesh->transformedPositions;
-		bbm_soa_vec2 texcoords            = mesh->texcoords;
+		//--------------------------------
+		// Reject polygons that are entirely off screen, and find the guard band planes that are actually crossed
+		//--------------------------------
+		const float farClip = 1.0f - globalData.viewport.epsilon[2];
 
-		aabb_frustum_result res = AABB_FRUSTUM_INTERSECT;
-		if ( Debug.flags & FLAG_AABB_FRUSTUM_CHECK )
+		uint32_t screenOutcode = 0x0F, guardBandOutcode = 0x00;
+		for ( uint32_t i = 0; i < vectorCount; i++ )
 		{
-			res = __aabb_check_frustum ( mesh );
-			if ( res == AABB_FRUSTUM_OUTSIDE )
-				continue;
+			const float x = curVerts[i].position.x, y = curVerts[i].position.y, z = curVerts[i].position.z;
+			screenOutcode    &= (x < -1.0f ? 0x01 : 0) | (x > 1.0f ? 0x02 : 0) | (y < -1.0f ? 0x04 : 0) | (y > 1.0f ? 0x08 : 0);
+			guardBandOutcode |= (x < -SOFTRAST_GUARD_BAND ? 0x01 : 0) | (x > SOFTRAST_GUARD_BAND ? 0x02 : 0) | (y < -SOFTRAST_GUARD_BAND ? 0x04 : 0) | (y > SOFTRAST_GUARD_BAND ? 0x08 : 0) | (z >= farClip ? 0x10 : 0);
 		}
+		if ( screenOutcode )
+			return 0;
 
-		if ( !(Debug.flags & FLAG_FILL_OUTLINES) )
-			continue;
+		//--------------------------------
+		// Clip against the crossed planes only
+		//--------------------------------
+		static const uint32_t planeDim[5]  = { 0, 0, 1, 1, 2 };
+		static const float    planeSign[5] = { -1.0f, 1.0f, -1.0f, 1.0f, 1.0f };
+		const float planePoint[5]          = { SOFTRAST_GUARD_BAND, SOFTRAST_GUARD_BAND, SOFTRAST_GUARD_BAND, SOFTRAST_GUARD_BAND, farClip };
 
-		softrast_submesh* submesh = mesh->submeshes;
-		for ( uint32_t j = 0; j < mesh->submeshCount; j++, submesh++ )
+		for ( uint32_t p = 0; p < 5; p++ )
 		{
-			//--------------------------------
-			// Variables
-			//--------------------------------
-			const uint32_t triCount = submesh->indexCount / 3;
-			uint32_t* index = submesh->indices;
+			if ( !(guardBandOutcode & (1 << p)) )
+				continue;
 
-			//--------------------------------
-			// Sanity checks
-			//--------------------------------
-			assert ( (submesh->indexCount % 3) == 0 );
+			vectorCount = __softrast_clip ( tempVerts, curVerts, vectorCount, planeDim[p], planeSign[p], planePoint[p] );
+			if ( vectorCount < 3 )
+				return 0;
 
-			//--------------------------------
-			// Fill triangles into outline table
-			//--------------------------------
-			for ( uint32_t k = 0; k < triCount; k++ )
-			{
-				int32_t minTriY = globalData.renderTarget.height, maxTriY = 0;
+			vertex* temp = tempVerts;
+			tempVerts = curVerts;
+			curVerts  = temp;
+		}
+	}
+	else if ( res == AABB_FRUSTUM_INTERSECT && FrameDebug.flags & FLAG_CLIP_FRUSTUM )
+	{
+		const float* epsilon = globalData.viewport.epsilon;
 
-				//--------------------------------
-				// Initialize vertices for clipping
-				//--------------------------------
-#if SOACLIP
-#if 1
-				  clippedVerts[0].x[0] = mesh->transformedPositions.x[*(index)],   clippedVerts[0].x[1] = mesh->transformedPositions.x[*(index+1)],   clippedVerts[0].x[2] = mesh->transformedPositions.x[*(index+2)];
-				  clippedVerts[0].y[0] = mesh->transformedPositions.y[*(index)],   clippedVerts[0].y[1] = mesh->transformedPositions.y[*(index+1)],   clippedVerts[0].y[2] = mesh->transformedPositions.y[*(index+2)];
-				  clippedVerts[0].z[0] = mesh->transformedPositions.z[*(index)],   clippedVerts[0].z[1] = mesh->transformedPositions.z[*(index+1)],   clippedVerts[0].z[2] = mesh->transformedPositions.z[*(index+2)];
-				  clippedVerts[0].w[0] = mesh->transformedPositions.w[*(index)],   clippedVerts[0].w[1] = mesh->transformedPositions.w[*(index+1)],   clippedVerts[0].w[2] = mesh->transformedPositions.w[*(index+2)];
-				clippedVertUVs[0].x[0] = mesh->texcoords.x[*(index)],            clippedVertUVs[0].x[1] = mesh->texcoords.x[*(index+1)],            clippedVertUVs[0].x[2] = mesh->texcoords.x[*(index+2)];
-				clippedVertUVs[0].y[0] = mesh->texcoords.y[*(index)],            clippedVertUVs[0].y[1] = mesh->texcoords.y[*(index+1)],            clippedVertUVs[0].y[2] = mesh->texcoords.y[*(index+2)];
-				index += 3;
-#else
-				// Slower
-				clippedVerts.x[0] = mesh->transformedPositions.x[*(index)];
-				clippedVerts.y[0] = mesh->transformedPositions.y[*(index)];
-				clippedVerts.z[0] = mesh->transformedPositions.z[*(index)];
-				clippedVerts.w[0] = mesh->transformedPositions.w[*(index)];
-				index++;
-				clippedVerts.x[1] = mesh->transformedPositions.x[*(index)];
-				clippedVerts.y[1] = mesh->transformedPositions.y[*(index)];
-				clippedVerts.z[1] = mesh->transformedPositions.z[*(index)];
-				clippedVerts.w[1] = mesh->transformedPositions.w[*(index)];
-				index++;
-				clippedVerts.x[2] = mesh->transformedPositions.x[*(index)];
-				clippedVerts.y[2] = mesh->transformedPositions.y[*(index)];
-				clippedVerts.z[2] = mesh->transformedPositions.z[*(index)];
-				clippedVerts.w[2] = mesh->transformedPositions.w[*(index)];
-#endif
-				clippedVerts[0].vectorCount = 3;
-				clippedVertUVs[0].vectorCount = 3;
+		vectorCount = __softrast_clip ( tempVerts, curVerts, vectorCount, 0, -1.0f, 1.0f - epsilon[0] );
+		vectorCount = __softrast_clip ( curVerts, tempVerts, vectorCount, 1, -1.0f, 1.0f - epsilon[1] );
+		
+		vectorCount = __softrast_clip ( tempVerts, curVerts, vectorCount, 0, 1.0f, 1.0f - epsilon[0] );
+		vectorCount = __softrast_clip ( curVerts, tempVerts, vectorCount, 1, 1.0f, 1.0f - epsilon[1] );
+		vectorCount = __softrast_clip ( tempVerts, curVerts, vectorCount, 2, 1.0f, 1.0f - epsilon[2] );
 
-				//--------------------------------
-				// Clip w against near clip plane
-				//--------------------------------
-				uint32_t vectorCount = 3;
-				if ( Debug.flags & FLAG_CLIP_W )
-				{
-					vectorCount = __softrast_clip ( &clippedVerts[1], &clippedVertUVs[1], &clippedVerts[0], &clippedVertUVs[0], 3, 3, -1.0f, -globalData.nearClip );
-					if ( vectorCount < 3 )
-						continue;
-					clippedVerts[1].vectorCount   = vectorCount;
-					clippedVertUVs[1].vectorCount = vectorCount;
-				}
-				else
-				{
-					memcpy ( clippedVerts[1].x, clippedVerts[0].x, 3 * sizeof ( float ) );
-					memcpy ( clippedVerts[1].y, clippedVerts[0].y, 3 * sizeof ( float ) );
-					memcpy ( clippedVerts[1].z, clippedVerts[0].z, 3 * sizeof ( float ) );
-					memcpy ( clippedVerts[1].w, clippedVerts[0].w, 3 * sizeof ( float ) );
-					memcpy ( clippedVertUVs[1].x, clippedVertUVs[0].x, 3 * sizeof ( float ) );
-					memcpy ( clippedVertUVs[1].y, clippedVertUVs[0].y, 3 * sizeof ( float ) );
-					clippedVerts[1].vectorCount   = vectorCount;
-					clippedVertUVs[1].vectorCount = vectorCount;
-				}
+		//--------------------------------
+		// Check whether or not enough vertices remain for rasterization
+		//--------------------------------
+		if ( vectorCount < 3 )
+			return 0;
 
-				//--------------------------------
-				// Take the reciprocal of w, and perspective-correct X, Y, Z, U and V
-				//--------------------------------
-				bbm_soa_vec4_overwrite_rcp_w ( &clippedVerts[1] );
-				bbm_soa_vec4_overwrite_mul_xyz_w ( &clippedVerts[1] );
-				bbm_soa_vec2_overwrite_mul_soa_vec4_w ( &clippedVertUVs[1], &clippedVerts[1] );
+		vertex* temp = tempVerts;
+		tempVerts = curVerts;
+		curVerts  = temp;
+	}
 
-				//--------------------------------
-				// Check winding order
-				//--------------------------------
-				if ( Debug.flags & FLAG_BACKFACE_CULLING_ENABLED )
-				{
-					float dx1 = clippedVerts[1].x[1] - clippedVerts[1].x[0];
-					float dx2 = clippedVerts[1].x[2] - clippedVerts[1].x[0];
-					float dy1 = clippedVerts[1].y[1] - clippedVerts[1].y[0];
-					float dy2 = clippedVerts[1].y[2] - clippedVerts[1].y[0];
-					float cz  = dx1 * dy2 - dx2 * dy1;
-					if ( ((Debug.flags & FLAG_BACKFACE_CULLING_INVERTED) ? 1 : 0) ^ (cz < 0.0f) )
-						continue;
-				}
+	assert ( vectorCount <= SOFTRAST_MAX_POLYGON_VERTICES );
 
-				//--------------------------------
-				// Clipping
-				//--------------------------------
-				if ( Debug.flags & FLAG_CLIP_FRUSTUM )
-				{
-					vectorCount = __softrast_clip ( &clippedVerts[0], &clippedVertUVs[0], &clippedVerts[1], &clippedVertUVs[1], vectorCount, 0, -1.0f, 1.0f - epsilon[0] );
-					vectorCount = __softrast_clip ( &clippedVerts[1], &clippedVertUVs[1], &clippedVerts[0], &clippedVertUVs[0], vectorCount, 1, -1.0f, 1.0f - epsilon[1] );
-					//vectorCount = __softrast_clip ( &clippedVerts[1], &clippedVertUVs[1], &clippedVerts[0], &clippedVertUVs[0], vectorCount, 2, -1.0f, 1.0f - epsilon[2] );
-				
-					vectorCount = __softrast_clip ( &clippedVerts[0], &clippedVertUVs[0], &clippedVerts[1], &clippedVertUVs[1], vectorCount, 0,  1.0f, 1.0f - epsilon[0] );
-					vectorCount = __softrast_clip ( &clippedVerts[1], &clippedVertUVs[1], &clippedVerts[0], &clippedVertUVs[0], vectorCount, 1,  1.0f, 1.0f - epsilon[1] );
-					vectorCount = __softrast_clip ( &clippedVerts[0], &clippedVertUVs[0], &clippedVerts[1], &clippedVertUVs[1], vectorCount, 2,  1.0f, 1.0f - epsilon[2] );
+	//--------------------------------
+	// Sanity checks
+	//--------------------------------
+//#ifndef NDEBUG
+//				for ( uint32_t cell = 0; cell < 3; cell++ )
+//				{
+//					for ( uint32_t i = 0; i < vectorCount; i++ )
+//					{
+//						assert ( clippedVerts[0].cells[cell][i] >= -1.0f && clippedVerts[0].cells[cell][i] <= 1.0f );
+//					}
+//				}
+//#endif
 
-					//--------------------------------
-					// Check whether or not enough vertices remain for rasterization
-					//--------------------------------
-					if ( vectorCount < 3 )
-						continue;
-					clippedVerts[0].vectorCount = vectorCount;
-					clippedVertUVs[0].vectorCount = vectorCount;
-				}
-				else
-				{
-					memcpy ( clippedVerts[0].x, clippedVerts[1].x, vectorCount * sizeof ( float ) );
-					memcpy ( clippedVerts[0].y, clippedVerts[1].y, vectorCount * sizeof ( float ) );
-					memcpy ( clippedVerts[0].z, clippedVerts[1].z, vectorCount * sizeof ( float ) );
-					memcpy ( clippedVerts[0].w, clippedVerts[1].w, vectorCount * sizeof ( float ) );
-					memcpy ( clippedVertUVs[0].x, clippedVertUVs[1].x, vectorCount * sizeof ( float ) );
-					memcpy ( clippedVertUVs[0].y, clippedVertUVs[1].y, vectorCount * sizeof ( float ) );
-					clippedVerts[0].vectorCount   = vectorCount;
-					clippedVertUVs[0].vectorCount = vectorCount;
-				}
+	//--------------------------------
+	// Warp XY into screen space
+	//--------------------------------
+	{
+		const float* offset = globalData.viewport.offset;
+		const float* bias   = globalData.viewport.bias;
 
-				//--------------------------------
-				// Sanity checks
-				//--------------------------------
-#ifndef NDEBUG
-				for ( uint32_t cell = 0; cell < 3; cell++ )
-				{
-					for ( uint32_t i = 0; i < vectorCount; i++ )
-					{
-						assert ( clippedVerts[0].cells[cell][i] >= -1.0f && clippedVerts[0].cells[cell][i] <= 1.0f );
-					}
-				}
-#endif
+		vertex* curv = curVerts;
+		for ( uint32_t i = 0; i < vectorCount; i++, curv++ )
+		{
+			curv->position.x  = curv->position.x * bias[0] + offset[0], curv->position.y = curv->position.y * bias[1] + offset[1];
+		}
+	}
 
-				//--------------------------------
-				// Warp XY into screen space
-				//--------------------------------
-				bbm_soa_vec4_overwrite_mad_x ( &clippedVerts[0], bias[0], offset[0] );
-				bbm_soa_vec4_overwrite_mad_y ( &clippedVerts[0], bias[1], offset[1] );
+	//--------------------------------
+	// Make sure the result ends up in the caller's buffer
+	//--------------------------------
+	if ( curVerts != outVerts )
+		memcpy ( outVerts, curVerts, vectorCount * sizeof ( vertex ) );
 
-				//--------------------------------
-				// Fill edges into outline table
-				//--------------------------------
-				for ( uint32_t i = 0; i < clippedVerts[0].vectorCount; i++ )
-				{
-					//--------------------------------
-					// Determine edge indices
-					//--------------------------------
-					uint32_t i1 =  i;
-					uint32_t i2 = (i + 1) % clippedVerts[0].vectorCount;
+	return vectorCount;
+}
 
-					//--------------------------------
-					// We want the edge to go from up to down, so swap if inversed
-					//--------------------------------
-					if ( clippedVerts[0].y[i1] > clippedVerts[0].y[i2] )
-					{
-						uint32_t t = i1;
-						i1 = i2;
-						i2 = t;
-					}
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
 
-					//--------------------------------
-					// Prepare for the loop
-					//--------------------------------
-					float y1 = clippedVerts[0].y[i1];
-					float y2 = clippedVerts[0].y[i2];
-					float x1 = clippedVerts[0].x[i1];
-					float x2 = clippedVerts[0].x[i2];
-					float z1 = clippedVerts[0].w[i1];	// Taking w instead of z (w = 1.0f / zInViewSpace)
-					float z2 = clippedVerts[0].w[i2];	// Taking w instead of z (w = 1.0f / zInViewSpace)
-					float u1 = clippedVertUVs[0].x[i1];
-					float u2 = clippedVertUVs[0].x[i2];
-					float v1 = clippedVertUVs[0].y[i1];
-					float v2 = clippedVertUVs[0].y[i2];
-
-					//if ( Debug.flags & FLAG_DERP3 )
-					//{
-					//	float a = clippedVerts[0].z[i1] * 0.5f + 0.5f;
-					//	float b = clippedVerts[0].z[i2] * 0.5f + 0.5f;
-					//
-					//	z1 = 1.0f / (a * globalData.farClip + (1.0f-a) * globalData.nearClip);
-					//	z2 = 1.0f / (b * globalData.farClip + (1.0f-b) * globalData.nearClip);
-					//}
+// Runs the rejection tests of __softrast_setup_polygon on 8 triangles at once, with the same operations in the same order so the
+// outcome always matches. Returns a bit for each triangle that survives and still needs setting up; triangles that would be
+// near-clipped always survive, since clipping changes the polygon the remaining tests run on
+static uint32_t __softrast_cull_triangles_avx2 ( const softrast_mesh* mesh, const uint32_t* index, aabb_frustum_result res )
+{
+	//--------------------------------
+	// Gather the clip space positions of 8 triangles into SoA registers
+	//--------------------------------
+	const bbm_soa_vec4* transformedPositions = &mesh->transformedPositions;
+	const __m256i triangleStride = _mm256_setr_epi32 ( 0, 3, 6, 9, 12, 15, 18, 21 );
 
-					float dy = (y2 - y1);// + (Debug.flags & FLAG_DERP ? 1 : 0);
-					float dx = (x2 - x1)/dy;
-					float dz = (z2 - z1)/dy;
-					float du = (u2 - u1)/dy;
-					float dv = (v2 - v1)/dy;
+	__m256 x[3], y[3], z[3], w[3];
+	for ( uint32_t i = 0; i < 3; i++ )
+	{
+		const __m256i vertexIndex = _mm256_i32gather_epi32 ( (const int*)(index + i), triangleStride, 4 );
+		x[i] = _mm256_i32gather_ps ( transformedPositions->x, vertexIndex, 4 );
+		y[i] = _mm256_i32gather_ps ( transformedPositions->y, vertexIndex, 4 );
+		z[i] = _mm256_i32gather_ps ( transformedPositions->z, vertexIndex, 4 );
+		w[i] = _mm256_i32gather_ps ( transformedPositions->w, vertexIndex, 4 );
+	}
 
-					int32_t iMinY = ((int32_t)y1) + 1;
-					int32_t iMaxY = (int32_t)y2;
-					if ( iMaxY < iMinY )
-						continue;
-					assert ( iMinY >= 0 && iMinY < (int32_t)globalData.renderTarget.height );
-					assert ( iMaxY >= 0 && iMaxY < (int32_t)globalData.renderTarget.height );
+	//--------------------------------
+	// Leave triangles crossing the near plane to the scalar clipper
+	//--------------------------------
+	const __m256 zero = _mm256_setzero_ps ( );
+	__m256 undecided  = zero;
+	if ( res == AABB_FRUSTUM_INTERSECT && (FrameDebug.flags & FLAG_CLIP_W) )
+	{
+		const __m256 nearClip = _mm256_set1_ps ( globalData.nearClip );
+		for ( uint32_t i = 0; i < 3; i++ )
+			undecided = _mm256_or_ps ( undecided, _mm256_cmp_ps ( _mm256_sub_ps ( w[i], nearClip ), zero, _CMP_LE_OQ ) );
+	}
 
-					float topClipY    = iMinY - y1;
-					float bottomClipY = y2 - iMaxY;
+	//--------------------------------
+	// Take the reciprocal of w, and perspective-correct X, Y and Z
+	//--------------------------------
+	const __m256 one = _mm256_set1_ps ( 1.0f );
+	for ( uint32_t i = 0; i < 3; i++ )
+	{
+		w[i] = _mm256_div_ps ( one, w[i] );
+		x[i] = _mm256_mul_ps ( x[i], w[i] ), y[i] = _mm256_mul_ps ( y[i], w[i] ), z[i] = _mm256_mul_ps ( z[i], w[i] );
+	}
 
-					//--------------------------------
-					// Do sub-pixel correction
-					//--------------------------------
-					x1 += dx * topClipY;
-					x2 -= dx * bottomClipY;
+	//--------------------------------
+	// Check winding order
+	//--------------------------------
+	const __m256 dx1 = _mm256_sub_ps ( x[1], x[0] );
+	const __m256 dx2 = _mm256_sub_ps ( x[2], x[0] );
+	const __m256 dy1 = _mm256_sub_ps ( y[1], y[0] );
+	const __m256 dy2 = _mm256_sub_ps ( y[2], y[0] );
+	const __m256 cz  = _mm256_sub_ps ( _mm256_mul_ps ( dx1, dy2 ), _mm256_mul_ps ( dx2, dy1 ) );
+
+	__m256 culled = zero;
+	if ( FrameDebug.flags & FLAG_BACKFACE_CULLING_ENABLED )
+	{
+		if ( FrameDebug.flags & FLAG_BACKFACE_CULLING_INVERTED )
+			culled = _mm256_or_ps ( culled, _mm256_cmp_ps ( cz, zero, _CMP_NLT_UQ ) );
+		else
+			culled = _mm256_or_ps ( culled, _mm256_cmp_ps ( cz, zero, _CMP_LT_OQ ) );
+	}
 
-					z1 += dz * topClipY;
-					z2 -= dz * bottomClipY;
+	//--------------------------------
+	// Reject triangles entirely outside of a single clip plane, which would leave the clipper with nothing
+	//--------------------------------
+	if ( res == AABB_FRUSTUM_INTERSECT && FrameDebug.flags & FLAG_CLIP_FRUSTUM )
+	{
+		// With a guard band, X and Y only reject polygons entirely off screen, which needs strictly negative distances
+		const uint32_t guardBand = (FrameDebug.flags & FLAG_GUARD_BAND_CLIPPING) != 0;
+		const float* epsilon = globalData.viewport.epsilon;
+		const __m256 clipX   = _mm256_set1_ps ( guardBand ? 1.0f : 1.0f - epsilon[0] );
+		const __m256 clipY   = _mm256_set1_ps ( guardBand ? 1.0f : 1.0f - epsilon[1] );
+		const __m256 clipZ   = _mm256_set1_ps ( 1.0f - epsilon[2] );
+
+		__m256 outside[5];
+		for ( uint32_t p = 0; p < 5; p++ )
+			outside[p] = _mm256_castsi256_ps ( _mm256_set1_epi32 ( -1 ) );
+		for ( uint32_t i = 0; i < 3; i++ )
+		{
+			outside[0] = _mm256_and_ps ( outside[0], _mm256_cmp_ps ( _mm256_add_ps ( clipX, x[i] ), zero, _CMP_LE_OQ ) );
+			outside[1] = _mm256_and_ps ( outside[1], _mm256_cmp_ps ( _mm256_add_ps ( clipY, y[i] ), zero, _CMP_LE_OQ ) );
+			outside[2] = _mm256_and_ps ( outside[2], _mm256_cmp_ps ( _mm256_sub_ps ( clipX, x[i] ), zero, _CMP_LE_OQ ) );
+			outside[3] = _mm256_and_ps ( outside[3], _mm256_cmp_ps ( _mm256_sub_ps ( clipY, y[i] ), zero, _CMP_LE_OQ ) );
+			outside[4] = _mm256_and_ps ( outside[4], _mm256_cmp_ps ( _mm256_sub_ps ( clipZ, z[i] ), zero, _CMP_LE_OQ ) );
+		}
+		if ( guardBand )
+		{
+			for ( uint32_t i = 0; i < 3; i++ )
+			{
+				outside[0] = _mm256_and_ps ( outside[0], _mm256_cmp_ps ( _mm256_add_ps ( clipX, x[i] ), zero, _CMP_NEQ_OQ ) );
+				outside[1] = _mm256_and_ps ( outside[1], _mm256_cmp_ps ( _mm256_add_ps ( clipY, y[i] ), zero, _CMP_NEQ_OQ ) );
+				outside[2] = _mm256_and_ps ( outside[2], _mm256_cmp_ps ( _mm256_sub_ps ( clipX, x[i] ), zero, _CMP_NEQ_OQ ) );
+				outside[3] = _mm256_and_ps ( outside[3], _mm256_cmp_ps ( _mm256_sub_ps ( clipY, y[i] ), zero, _CMP_NEQ_OQ ) );
+			}
+		}
+		for ( uint32_t p = 0; p < 5; p++ )
+			culled = _mm256_or_ps ( culled, outside[p] );
+	}
 
-					u1 += du * topClipY;
-					u2 -= du * bottomClipY;
-					v1 += dv * topClipY;
-					v2 -= dv * bottomClipY;
+	return ~_mm256_movemask_ps ( _mm256_andnot_ps ( undecided, culled ) ) & 0xFF;
+}
 
-					//dy = (float)(iMaxY - iMinY);
-					//
-					//dx = (x2 - x1)/dy;
-					//dz = (z2 - z1)/dy;
-					//du = (u2 - u1)/dy;
-					//dv = (v2 - v1)/dy;
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
 
-#if 0
-					float x = x1;
-					float z = z1;
-					float u = u1;
-					float v = v1;
-#endif
-
-					//--------------------------------
-					// Calculate min, max submesh Y
-					//--------------------------------
-					if ( iMinY < minTriY )
-						minTriY = iMinY;
-					if ( iMaxY > maxTriY )
-						maxTriY = iMaxY;
+// Picks the mip level for a block of pixels from the largest UV derivative inside it, in texels of the top level
+void softrast_select_mip ( mip_selection* mip, const softrast_texture* texture, float blockMaxDUV )
+{
+	const float scaledDUV = FrameDebug.lodBias + FrameDebug.lodScale * blockMaxDUV;
+	const float scale     = MAX ( 1.0f, scaledDUV );
 
-					//--------------------------------
-					// Loop over the rows
-					//--------------------------------
-					float* outlineMinX = globalData.outlineTable.minX + iMinY;
-					float* outlineMaxX = globalData.outlineTable.maxX + iMinY;
-					float* outlineMinZ = globalData.outlineTable.minZ + iMinY;
-					float* outlineMaxZ = globalData.outlineTable.maxZ + iMinY;
-					float* outlineMinU = globalData.outlineTable.minU + iMinY;
-					float* outlineMaxU = globalData.outlineTable.maxU + iMinY;
-					float* outlineMinV = globalData.outlineTable.minV + iMinY;
-					float* outlineMaxV = globalData.outlineTable.maxV + iMinY;
+	const float logScale = log2f ( scale );
 
-#if 0
-					for ( int32_t y = iMinY; y <= iMaxY; y++, outlineMinX++, outlineMaxX++, outlineMinZ++, outlineMaxZ++, outlineMinU++, outlineMaxU++, outlineMinV++, outlineMaxV++, x += dx, z += dz, u += du, v += dv )
-					{
-#else
-					int32_t yinc = 0;
-					for ( int32_t y = iMinY; y <= iMaxY; y++, yinc++, outlineMinX++, outlineMaxX++, outlineMinZ++, outlineMaxZ++, outlineMinU++, outlineMaxU++, outlineMinV++, outlineMaxV++ )
-					{
-						float x = x1 + yinc * dx;
-						float z = z1 + yinc * dz;
-						float u = u1 + yinc * du;
-						float v = v1 + yinc * dv;
-#endif
-						if ( x < *outlineMinX )
-						{
-#pragma message ( "TODO: Better out-of-bound checks!" )
-							//assert ( x > 10.0f );
-							*outlineMinX = x;
-							*outlineMinZ = z;
-							*outlineMinU = u;
-							*outlineMinV = v;
-						}
-						if ( x > *outlineMaxX )
-						{
-							//assert ( x > 10.0f );
-							*outlineMaxX = x;
-							*outlineMaxZ = z;
-							*outlineMaxU = u;
-							*outlineMaxV = v;
-						}
-					}
-				}
-#else
-				
-				{
-					vertex* curv = curVerts;
-					for ( uint32_t i = 0; i < 3; i++, curv++, index++ )
-					{
-						curv->position.x = transformedPositions.x[*index], curv->position.y = transformedPositions.y[*index], curv->position.z = transformedPositions.z[*index], curv->position.w = transformedPositions.w[*index];
-						curv->u = texcoords.x[*index], curv->v = texcoords.y[*index];
-					}
-				}
+	mip->level   = (uint32_t)logScale;
+	mip->t       = logScale - mip->level;
+	mip->level   = MIN ( mip->level, texture->mipLevels-1 );
+	mip->level2  = MIN ( mip->level+1, texture->mipLevels-1 );
+	mip->width   = (texture->width >> mip->level);
+	mip->uvScale = 1.0f / (1<<mip->level);
+}
 
-				//--------------------------------
-				// Clip w against near clip plane
-				//--------------------------------
-				uint32_t vectorCount = 3;
-				if ( res == AABB_FRUSTUM_INTERSECT && (Debug.flags & FLAG_CLIP_W) )
-				{
-					vectorCount = __softrast_clip ( tempVerts, curVerts, 3, 3, -1.0f, -globalData.nearClip );
-					if ( vectorCount < 3 )
-						continue;
-					
-					vertex* temp = tempVerts;
-					tempVerts = curVerts;
-					curVerts  = temp;
-				}
+// Spreads the low 16 bits of every lane to the even bits (xxxx => 0x0x 0x0x)
+static __forceinline __m128i __softrast_morton_spread_sse ( __m128i v )
+{
+	v = _mm_and_si128 ( v, _mm_set1_epi32 ( 0x0000FFFF ) );
+	v = _mm_and_si128 ( _mm_or_si128 ( v, _mm_slli_epi32 ( v, 8 ) ), _mm_set1_epi32 ( 0x00FF00FF ) );
+	v = _mm_and_si128 ( _mm_or_si128 ( v, _mm_slli_epi32 ( v, 4 ) ), _mm_set1_epi32 ( 0x0F0F0F0F ) );
+	v = _mm_and_si128 ( _mm_or_si128 ( v, _mm_slli_epi32 ( v, 2 ) ), _mm_set1_epi32 ( 0x33333333 ) );
+	v = _mm_and_si128 ( _mm_or_si128 ( v, _mm_slli_epi32 ( v, 1 ) ), _mm_set1_epi32 ( 0x55555555 ) );
+	return v;
+}
 
-				//--------------------------------
-				// Take the reciprocal of w, and perspective-correct X, Y, Z, U and V
-				//--------------------------------
-				{
-					vertex* curv = curVerts;
-					for ( uint32_t i = 0; i < vectorCount; i++, curv++ )
-					{
-						curv->position.w  = 1.0f / curv->position.w;
-						curv->position.x *= curv->position.w, curv->position.y *= curv->position.w, curv->position.z *= curv->position.w;
-						curv->u          *= curv->position.w, curv->v          *= curv->position.w;
-					}
-				}
+// Fetches the texels at (ix, iy) of a mip level; there are no gathers before AVX2, so every lane loads on its own, from the block cache for compressed textures
+static __forceinline __m128i __softrast_fetch_sse ( const softrast_texture* texture, uint32_t level, __m128i ix, __m128i iy, const int textureAddressingMode )
+{
+	if ( texture->format != SOFTRAST_TEXTURE_FORMAT_RGBA8 )
+		return _mm_setr_epi32 ( softrast_fetch_compressed ( texture, level, _mm_cvtsi128_si32 ( ix ), _mm_cvtsi128_si32 ( iy ) ),
+		                        softrast_fetch_compressed ( texture, level, _mm_extract_epi32 ( ix, 1 ), _mm_extract_epi32 ( iy, 1 ) ),
+		                        softrast_fetch_compressed ( texture, level, _mm_extract_epi32 ( ix, 2 ), _mm_extract_epi32 ( iy, 2 ) ),
+		                        softrast_fetch_compressed ( texture, level, _mm_extract_epi32 ( ix, 3 ), _mm_extract_epi32 ( iy, 3 ) ) );
+
+	const uint32_t* mipData = texture->mipData[level];
+	const uint32_t mipWidth = texture->width >> level;
+	__m128i index;
+	if ( textureAddressingMode == TEXTURE_ADDRESSING_TILED )
+	{
+		const __m128i three   = _mm_set1_epi32 ( 3 );
+		const __m128i tileidx = _mm_add_epi32 ( _mm_mullo_epi32 ( _mm_srli_epi32 ( iy, 2 ), _mm_set1_epi32 ( mipWidth >> 2 ) ), _mm_srli_epi32 ( ix, 2 ) );
+		const __m128i pixidx  = _mm_add_epi32 ( _mm_slli_epi32 ( _mm_and_si128 ( iy, three ), 2 ), _mm_and_si128 ( ix, three ) );
+		index = _mm_add_epi32 ( _mm_slli_epi32 ( tileidx, 4 ), pixidx );
+	}
+	else if ( textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
+		index = _mm_or_si128 ( __softrast_morton_spread_sse ( ix ), _mm_slli_epi32 ( __softrast_morton_spread_sse ( iy ), 1 ) );
+	else
+		index = _mm_add_epi32 ( _mm_mullo_epi32 ( iy, _mm_set1_epi32 ( mipWidth ) ), ix );
 
-				//--------------------------------
-				// Check winding order
-				//--------------------------------
-				if ( Debug.flags & FLAG_BACKFACE_CULLING_ENABLED )
-				{
-					float dx1 = curVerts[1].position.x - curVerts[0].position.x;
-					float dx2 = curVerts[2].position.x - curVerts[0].position.x;
-					float dy1 = curVerts[1].position.y - curVerts[0].position.y;
-					float dy2 = curVerts[2].position.y - curVerts[0].position.y;
-					float cz  = dx1 * dy2 - dx2 * dy1;
-					if ( ((Debug.flags & FLAG_BACKFACE_CULLING_INVERTED) ? 1 : 0) ^ (cz < 0.0f) )
-						continue;
-				}
+	return _mm_setr_epi32 ( mipData[_mm_cvtsi128_si32 ( index )], mipData[_mm_extract_epi32 ( index, 1 )], mipData[_mm_extract_epi32 ( index, 2 )], mipData[_mm_extract_epi32 ( index, 3 )] );
+}
 
-				//--------------------------------
-				// Clipping
-				//--------------------------------
-				if ( res == AABB_FRUSTUM_INTERSECT && Debug.flags & FLAG_CLIP_FRUSTUM )
-				{
-					vectorCount = __softrast_clip ( tempVerts, curVerts, vectorCount, 0, -1.0f, 1.0f - epsilon[0] );
-					vectorCount = __softrast_clip ( curVerts, tempVerts, vectorCount, 1, -1.0f, 1.0f - epsilon[1] );
-					
-					vectorCount = __softrast_clip ( tempVerts, curVerts, vectorCount, 0, 1.0f, 1.0f - epsilon[0] );
-					vectorCount = __softrast_clip ( curVerts, tempVerts, vectorCount, 1, 1.0f, 1.0f - epsilon[1] );
-					vectorCount = __softrast_clip ( tempVerts, curVerts, vectorCount, 2, 1.0f, 1.0f - epsilon[2] );
+// Samples one mip level at 4 pixels with point or bilinear filtering, wrapping around its edges. u and v are in top level texels
+static __forceinline __m128i __softrast_sample_level_sse ( const softrast_texture* texture, uint32_t level, __m128 u4, __m128 v4, const int textureAddressingMode, const int textureFilteringMode )
+{
+	const uint32_t mipWidth = texture->width >> level;
+	const __m128 uvScale4   = _mm_set1_ps ( 1.0f / (1<<level) );
+	const __m128i wrap      = _mm_set1_epi32 ( mipWidth - 1 );
+
+	const __m128 fx   = _mm_mul_ps ( u4, uvScale4 );
+	const __m128 fy   = _mm_mul_ps ( v4, uvScale4 );
+	const __m128i tx  = _mm_cvttps_epi32 ( fx );
+	const __m128i ty  = _mm_cvttps_epi32 ( fy );
+	const __m128i ix1 = _mm_and_si128 ( tx, wrap );
+	const __m128i iy1 = _mm_and_si128 ( ty, wrap );
+
+	if ( textureFilteringMode != TEXTURE_FILTERING_BILINEAR )
+		return __softrast_fetch_sse ( texture, level, ix1, iy1, textureAddressingMode );
+
+	const __m128i ix2 = _mm_and_si128 ( _mm_add_epi32 ( ix1, _mm_set1_epi32 ( 1 ) ), wrap );
+	const __m128i iy2 = _mm_and_si128 ( _mm_add_epi32 ( iy1, _mm_set1_epi32 ( 1 ) ), wrap );
+
+	const __m128i c00 = __softrast_fetch_sse ( texture, level, ix1, iy1, textureAddressingMode );
+	const __m128i c01 = __softrast_fetch_sse ( texture, level, ix2, iy1, textureAddressingMode );
+	const __m128i c10 = __softrast_fetch_sse ( texture, level, ix1, iy2, textureAddressingMode );
+	const __m128i c11 = __softrast_fetch_sse ( texture, level, ix2, iy2, textureAddressingMode );
+
+	// Fractions come from the unwrapped coordinates, which dithering can push past the edge
+	const __m128i fracX = _mm_cvttps_epi32 ( _mm_mul_ps ( _mm_sub_ps ( fx, _mm_cvtepi32_ps ( tx ) ), _mm_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	const __m128i fracY = _mm_cvttps_epi32 ( _mm_mul_ps ( _mm_sub_ps ( fy, _mm_cvtepi32_ps ( ty ) ), _mm_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	return softrast_bilinear_sse ( c00, c01, c10, c11, fracX, fracY );
+}
 
-					//--------------------------------
-					// Check whether or not enough vertices remain for rasterization
-					//--------------------------------
-					if ( vectorCount < 3 )
-						continue;
+// Texture sampler of the generic and SSE pixel pipelines: filters 4 pixels at once, which share the mip selection. u and v are in top level texels
+static __forceinline __m128i __softrast_sample_sse ( const softrast_texture* texture, const mip_selection* mip, __m128 u4, __m128 v4, const int textureAddressingMode, const int textureFilteringMode, const int textureMipmapMode )
+{
+	const __m128i color = __softrast_sample_level_sse ( texture, mip->level, u4, v4, textureAddressingMode, textureFilteringMode );
+	if ( textureMipmapMode != TEXTURE_MIPMAP_LINEAR )
+		return color;
 
-					vertex* temp = tempVerts;
-					tempVerts = curVerts;
-					curVerts  = temp;
-				}
+	const __m128i color2 = __softrast_sample_level_sse ( texture, mip->level2, u4, v4, textureAddressingMode, textureFilteringMode );
+	return softrast_lerp_texels_sse ( color, color2, _mm_set1_epi32 ( (int32_t)(mip->t * SOFTRAST_WEIGHT_SCALE) ) );
+}
 
-				assert ( vectorCount <= sizeof ( clippedVerts[0] ) / sizeof ( clippedVerts[0][0] ) );
+//--------------------------------
+// Scalar sampler, for the pixel pipeline that can't assume SSE4. It rounds like softrast_lerp_unpacked_sse, so both give the same images
+//--------------------------------
 
-				//--------------------------------
-				// Sanity checks
-				//--------------------------------
-//#ifndef NDEBUG
-//				for ( uint32_t cell = 0; cell < 3; cell++ )
-//				{
-//					for ( uint32_t i = 0; i < vectorCount; i++ )
-//					{
-//						assert ( clippedVerts[0].cells[cell][i] >= -1.0f && clippedVerts[0].cells[cell][i] <= 1.0f );
-//					}
-//				}
-//#endif
+// Spreads the low 16 bits to the even bits (xxxx => 0x0x 0x0x)
+static __forceinline uint32_t __softrast_morton_spread ( uint32_t v )
+{
+	v &= 0x0000FFFF;
+	v = (v | (v << 8)) & 0x00FF00FF;
+	v = (v | (v << 4)) & 0x0F0F0F0F;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
 
-				//--------------------------------
-				// Warp XY into screen space
-				//--------------------------------
-				{
-					vertex* curv = curVerts;
-					for ( uint32_t i = 0; i < vectorCount; i++, curv++ )
-					{
-						curv->position.x  = curv->position.x * bias[0] + offset[0], curv->position.y = curv->position.y * bias[1] + offset[1];
-					}
-				}
+static __forceinline uint32_t __softrast_fetch ( const softrast_texture* texture, uint32_t level, uint32_t ix, uint32_t iy, const int textureAddressingMode )
+{
+	if ( texture->format != SOFTRAST_TEXTURE_FORMAT_RGBA8 )
+		return softrast_fetch_compressed ( texture, level, ix, iy );
+
+	const uint32_t* mipData = texture->mipData[level];
+	const uint32_t mipWidth = texture->width >> level;
+	if ( textureAddressingMode == TEXTURE_ADDRESSING_TILED )
+		return mipData[(((iy >> 2) * (mipWidth >> 2) + (ix >> 2)) << 4) + ((iy & 3) << 2) + (ix & 3)];
+	else if ( textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
+		return mipData[__softrast_morton_spread ( ix ) | (__softrast_morton_spread ( iy ) << 1)];
+	else
+		return mipData[iy * mipWidth + ix];
+}
 
-				//--------------------------------
-				// Fill edges into outline table
-				//--------------------------------
-				uint32_t li = vectorCount-1;
-				for ( uint32_t i = 0; i < vectorCount; li = i++ )
-				{
-					//--------------------------------
-					// Determine edge indices
-					//--------------------------------
-					uint32_t i1 = li;
-					uint32_t i2 = i;
+// a + round ((b - a) * t) for every channel, t being Q15; alpha is cleared
+static __forceinline uint32_t __softrast_lerp_texels ( uint32_t a, uint32_t b, int32_t t )
+{
+	uint32_t result = 0;
+	for ( uint32_t c = 0; c < 24; c += 8 )
+	{
+		const int32_t ca = (a >> c) & 0xFF, cb = (b >> c) & 0xFF;
+		result |= (uint32_t)(ca + (((cb - ca) * t + 0x4000) >> 15)) << c;
+	}
+	return result;
+}
 
-					//--------------------------------
-					// We want the edge to go from up to down, so swap if inversed
-					//--------------------------------
-					if ( curVerts[i1].position.y > curVerts[i2].position.y )
-					{
-						uint32_t t = i1;
-						i1 = i2;
-						i2 = t;
-					}
+static __forceinline uint32_t __softrast_sample_level ( const softrast_texture* texture, uint32_t level, float u, float v, const int textureAddressingMode, const int textureFilteringMode )
+{
+	const uint32_t mipWidth = texture->width >> level;
+	const float    uvScale  = 1.0f / (1<<level);
+	const uint32_t wrap     = mipWidth - 1;
+
+	const float   fx  = u * uvScale;
+	const float   fy  = v * uvScale;
+	const int32_t tx  = (int32_t)fx;
+	const int32_t ty  = (int32_t)fy;
+	const uint32_t ix1 = (uint32_t)tx & wrap;
+	const uint32_t iy1 = (uint32_t)ty & wrap;
+
+	if ( textureFilteringMode != TEXTURE_FILTERING_BILINEAR )
+		return __softrast_fetch ( texture, level, ix1, iy1, textureAddressingMode );
+
+	const uint32_t ix2 = (ix1 + 1) & wrap;
+	const uint32_t iy2 = (iy1 + 1) & wrap;
+
+	const int32_t fracX = (int32_t)((fx - (float)tx) * SOFTRAST_WEIGHT_SCALE);
+	const int32_t fracY = (int32_t)((fy - (float)ty) * SOFTRAST_WEIGHT_SCALE);
+	const uint32_t top    = __softrast_lerp_texels ( __softrast_fetch ( texture, level, ix1, iy1, textureAddressingMode ), __softrast_fetch ( texture, level, ix2, iy1, textureAddressingMode ), fracX );
+	const uint32_t bottom = __softrast_lerp_texels ( __softrast_fetch ( texture, level, ix1, iy2, textureAddressingMode ), __softrast_fetch ( texture, level, ix2, iy2, textureAddressingMode ), fracX );
+	return __softrast_lerp_texels ( top, bottom, fracY );
+}
 
-					//--------------------------------
-					// Prepare for the loop
-					//--------------------------------
-					const vertex* vert1 = curVerts + i1;
-					const vertex* vert2 = curVerts + i2;
-
-					float x1 = vert1->position.x;
-					float y1 = vert1->position.y;
-					float z1 = vert1->position.w;	// Taking w instead of z (w = 1.0f / zInViewSpace)
-					float u1 = vert1->u;
-					float v1 = vert1->v;
-
-					float x2 = vert2->position.x;
-					float y2 = vert2->position.y;
-					float z2 = vert2->position.w;	// Taking w instead of z (w = 1.0f / zInViewSpace)
-					float u2 = vert2->u;
-					float v2 = vert2->v;
-
-					float dy = (y2 - y1);// + (Debug.flags & FLAG_DERP ? 1 : 0);
-					float dx = (x2 - x1)/dy;
-					float dz = (z2 - z1)/dy;
-					float du = (u2 - u1)/dy;
-					float dv = (v2 - v1)/dy;
-
-					int32_t iMinY = ((int32_t)y1) + 1;
-					int32_t iMaxY = (int32_t)y2;
-					if ( iMaxY < iMinY )
-						continue;
-					assert ( iMinY >= 0 && iMinY < (int32_t)globalData.renderTarget.height );
-					assert ( iMaxY >= 0 && iMaxY < (int32_t)globalData.renderTarget.height );
+static __forceinline uint32_t __softrast_sample ( const softrast_texture* texture, const mip_selection* mip, float u, float v, const int textureAddressingMode, const int textureFilteringMode, const int textureMipmapMode )
+{
+	const uint32_t color = __softrast_sample_level ( texture, mip->level, u, v, textureAddressingMode, textureFilteringMode );
+	if ( textureMipmapMode != TEXTURE_MIPMAP_LINEAR )
+		return color;
 
-					float topClipY    = iMinY - y1;
-					float bottomClipY = y2 - iMaxY;
+	const uint32_t color2 = __softrast_sample_level ( texture, mip->level2, u, v, textureAddressingMode, textureFilteringMode );
+	return __softrast_lerp_texels ( color, color2, (int32_t)(mip->t * SOFTRAST_WEIGHT_SCALE) );
+}
 
-					//--------------------------------
-					// Do sub-pixel correction
-					//--------------------------------
-					x1 += dx * topClipY;
-					x2 -= dx * bottomClipY;
+// Selects a mip level from the quad's UV derivatives, then depth tests and shades the covered pixels. Only ever called with constant
+// render settings by the specialized kernels below, so those branches fold away.
+static __forceinline void __softrast_shade_quad_generic ( const raster_quad* quad, const softrast_submesh* submesh, const int renderMode, const int textureAddressingMode, const int textureFilteringMode, const int textureMipmapMode,
+                                                          const int dithering, const int simd )
+{
+	//--------------------------------
+	// Unpack the quad
+	//--------------------------------
+	const int32_t ix = quad->x;
+	const int32_t y1 = quad->y;
+
+	ThreadPixelStats.testedPixels += softrast_bit_count ( quad->coverage );
+
+	const float* z     = quad->z;
+	const float* u     = quad->u;
+	const float* v     = quad->v;
+	const float* zstep = quad->zstep;
+	const float* ustep = quad->ustep;
+	const float* vstep = quad->vstep;
+
+	uint32_t* ptr[2][2] = {
+		{ quad->color[0], quad->color[0] + 1 },
+		{ quad->color[1], quad->color[1] + 1 },
+	};
+	float* dptr[2][2] = {
+		{ quad->depth[0], quad->depth[0] + 1 },
+		{ quad->depth[1], quad->depth[1] + 1 },
+	};
+
+	// Take dx, dy of U and V
+	//	-> dx[0] = du[0], dx[1] = du[1]
+	//  -> dy[0] = u[1] - u[0], u[1] - u[0] - (ustep[1] - ustep[0])
+	// [per pixel] Take max of dx and dy, and find the mipmap that would make that max <= 1
 
-					z1 += dz * topClipY;
-					z2 -= dz * bottomClipY;
+	//--------------------------------
+	// Calculate reciprocal Z for each pixel in the block (actually reciprocal of reciprocal of z, being z, but I digress)
+	//--------------------------------
+	const float rz[2][2] = {
+		{ 1.0f / z[0], 1.0f/(z[0] + zstep[0]) },
+		{ 1.0f / z[1], 1.0f/(z[1] + zstep[1]) },
+	};
 
-					u1 += du * topClipY;
-					u2 -= du * bottomClipY;
-					v1 += dv * topClipY;
-					v2 -= dv * bottomClipY;
+	//--------------------------------
+	// Calculate UV for each pixel in the block
+	//--------------------------------
+	float pxu[2][2] = {
+		{ u[0] * rz[0][0], (u[0] + ustep[0]) * rz[0][1] },
+		{ u[1] * rz[1][0], (u[1] + ustep[1]) * rz[1][1] },
+	};
 
-					//dy = (float)(iMaxY - iMinY);
-					//
-					//dx = (x2 - x1)/dy;
-					//dz = (z2 - z1)/dy;
-					//du = (u2 - u1)/dy;
-					//dv = (v2 - v1)/dy;
+	float pxv[2][2] = {
+		{ v[0] * rz[0][0], (v[0] + vstep[0]) * rz[0][1] },
+		{ v[1] * rz[1][0], (v[1] + vstep[1]) * rz[1][1] },
+	};
 
-#if 0
-					float x = x1;
-					float z = z1;
-					float u = u1;
-					float v = v1;
-#endif
+	const uint32_t coarse = quad->shadingRate != SOFTRAST_SHADING_RATE_1X1 && (renderMode == RENDER_MODE_UV || renderMode == RENDER_MODE_TEXTURED);
 
-					//--------------------------------
-					// Calculate min, max submesh Y
-					//--------------------------------
-					if ( iMinY < minTriY )
-						minTriY = iMinY;
-					if ( iMaxY > maxTriY )
-						maxTriY = iMaxY;
+#define SINGLE_DESIRED_MIP 1
+#if SINGLE_DESIRED_MIP
+	//--------------------------------
+	// Determine mipmap data
+	//--------------------------------
+	mip_selection mip;
 
-					//--------------------------------
-					// Loop over the rows
-					//--------------------------------
-#if AOS_OUTLINE_TABLE
-					outline_table_entry* outline = globalData.outlineTable + iMinY;
+	if ( textureMipmapMode != TEXTURE_MIPMAP_NONE )
+	{
+		//--------------------------------
+		// Calculate UV deltas
+		//--------------------------------
+		float dux[2] = {
+			submesh->texture->width * fabsf ( pxu[0][0] - pxu[0][1] ), // top left -> top right
+			submesh->texture->width * fabsf ( pxu[1][0] - pxu[1][1] ), // bottom left -> bottom right
+		};
+		float dvx[2] = {
+			submesh->texture->width * fabsf ( pxv[0][0] - pxv[0][1] ), // top left -> top right
+			submesh->texture->width * fabsf ( pxv[1][0] - pxv[1][1] ), // bottom left -> bottom right
+		};
+		float duy[2] = {
+			submesh->texture->width * fabsf ( pxu[0][0] - pxu[1][0] ), // top left -> bottom left
+			submesh->texture->width * fabsf ( pxu[0][1] - pxu[1][1] ), // top right -> bottom right
+		};
+		float dvy[2] = {
+			submesh->texture->width * fabsf ( pxv[0][0] - pxv[1][0] ), // top left -> bottom left
+			submesh->texture->width * fabsf ( pxv[0][1] - pxv[1][1] ), // top right -> bottom right
+		};
 
-#if 0
-					for ( int32_t y = iMinY; y <= iMaxY; y++, outlineMinX++, outlineMaxX++, outlineMinZ++, outlineMaxZ++, outlineMinU++, outlineMaxU++, outlineMinV++, outlineMaxV++, x += dx, z += dz, u += du, v += dv )
-					{
-#else
-					int32_t yinc = 0;
-					for ( int32_t y = iMinY; y <= iMaxY; y++, yinc++, outline++ )
-					{
-						float x = x1 + yinc * dx;
-						float z = z1 + yinc * dz;
-						float u = u1 + yinc * du;
-						float v = v1 + yinc * dv;
-#endif
-						if ( x < outline->minX || !(outline->flags & 0x1) )
-						{
-#pragma message ( "TODO: Better out-of-bound checks!" )
-							//assert ( x > 10.0f );
-							outline->minX = x;
-							outline->minZ = z;
-							outline->minU = u;
-							outline->minV = v;
-						}
-						if ( x > outline->maxX || !(outline->flags & 0x1) )
-						{
-							//assert ( x > 10.0f );
-							outline->maxX = x;
-							outline->maxZ = z;
-							outline->maxU = u;
-							outline->maxV = v;
-						}
-						outline->flags = 0x1;
-					}
+		////--------------------------------
+		//// Fix delta UV involving dead pixels to prevent artifacts
+		////--------------------------------
+		//for ( int32_t r = 0; r < 2; r++ )
+		//{
+		//	int32_t px = ix;
+		//	for ( int32_t c = 0; c < 2; c++, px++ )
+		//	{
+		//		//if ( !(outline[r]->flags & 0x1) /*|| y1 < minTriY || y2 > maxTriY*/ /*|| px < ix1[r] || px > ix2[r]*/ )
+		//		{
+		//			// Ded
+		//			dux[r] = 1.0f;
+		//			dvx[r] = 1.0f;
+		//
+		//			duy[c] = 1.0f;
+		//			dvy[c] = 1.0f;
+		//		}
+		//	}
+		//}
 
-					outline_table_entry* preEntry = globalData.outlineTable + (iMinY - 1);
-					outline_table_entry* postEntry = outline;//globalData.outlineTable + (iMaxY + 1);
+		//--------------------------------
+		// Calculate mip data
+		//--------------------------------
+		const float maxdux = MAX ( dux[0], dux[1] ), maxduy = MAX ( duy[0], duy[1] );
+		const float maxdvx = MAX ( dvx[0], dvx[1] ), maxdvy = MAX ( dvy[0], dvy[1] );
 
-					float preX  = x1 - 1 * dx;
-					float postX = x1 + (iMaxY - iMinY + 1) * dx;
+		const float maxdu       = MAX ( maxdux, maxduy ), maxdv  = MAX ( maxdvx, maxdvy );
+		const float blockMaxDUV = (float)(1 << quad->shadingRate) * MAX ( maxdu, maxdv );
 
-					if ( !(preEntry->flags & 0x1) && preX < preEntry->minX )
-					{
-						preEntry->minX = x1 - 1 * dx;
-						preEntry->minZ = z1 - 1 * dz;
-						preEntry->minU = u1 - 1 * du;
-						preEntry->minV = v1 - 1 * dv;
-					}
-					if ( !(preEntry->flags & 0x1) && preX > preEntry->maxX )
-					{
-						preEntry->maxX = x1 + (iMaxY - iMinY + 1) * dx;
-						preEntry->maxZ = z1 + (iMaxY - iMinY + 1) * dz;
-						preEntry->maxU = u1 + (iMaxY - iMinY + 1) * du;
-						preEntry->maxV = v1 + (iMaxY - iMinY + 1) * dv;
-					}
-					if ( !(postEntry->flags & 0x1) && postX < postEntry->minX )
-					{
-						postEntry->minX = x1 - 1 * dx;
-						postEntry->minZ = z1 - 1 * dz;
-						postEntry->minU = u1 - 1 * du;
-						postEntry->minV = v1 - 1 * dv;
-					}
-					if ( !(postEntry->flags & 0x1) && postX > postEntry->maxX )
-					{
-						postEntry->maxX = x1 + (iMaxY - iMinY + 1) * dx;
-						postEntry->maxZ = z1 + (iMaxY - iMinY + 1) * dz;
-						postEntry->maxU = u1 + (iMaxY - iMinY + 1) * du;
-						postEntry->maxV = v1 + (iMaxY - iMinY + 1) * dv;
-					}
-#else
-					float* outlineMinX = globalData.outlineTable.minX + iMinY;
-					float* outlineMaxX = globalData.outlineTable.maxX + iMinY;
-					float* outlineMinZ = globalData.outlineTable.minZ + iMinY;
-					float* outlineMaxZ = globalData.outlineTable.maxZ + iMinY;
-					float* outlineMinU = globalData.outlineTable.minU + iMinY;
-					float* outlineMaxU = globalData.outlineTable.maxU + iMinY;
-					float* outlineMinV = globalData.outlineTable.minV + iMinY;
-					float* outlineMaxV = globalData.outlineTable.maxV + iMinY;
+		softrast_select_mip ( &mip, submesh->texture, blockMaxDUV );
+	}
+	else
+	{
+		mip.level   = mip.level2 = 0;
+		mip.t       = 0.0f;
+		mip.width   = submesh->texture->width;
+		mip.uvScale = 1.0f;
+	}
 
-#if 0
-					for ( int32_t y = iMinY; y <= iMaxY; y++, outlineMinX++, outlineMaxX++, outlineMinZ++, outlineMaxZ++, outlineMinU++, outlineMaxU++, outlineMinV++, outlineMaxV++, x += dx, z += dz, u += du, v += dv )
-					{
+	const uint32_t desiredMip  = mip.level;
+	const uint32_t desiredMip2 = mip.level2;
 #else
-					int32_t yinc = 0;
-					for ( int32_t y = iMinY; y <= iMaxY; y++, yinc++, outlineMinX++, outlineMaxX++, outlineMinZ++, outlineMaxZ++, outlineMinU++, outlineMaxU++, outlineMinV++, outlineMaxV++ )
-					{
-						float x = x1 + yinc * dx;
-						float z = z1 + yinc * dz;
-						float u = u1 + yinc * du;
-						float v = v1 + yinc * dv;
-#endif
-						if ( x < *outlineMinX )
-						{
-#pragma message ( "TODO: Better out-of-bound checks!" )
-							//assert ( x > 10.0f );
-							*outlineMinX = x;
-							*outlineMinZ = z;
-							*outlineMinU = u;
-							*outlineMinV = v;
-						}
-						if ( x > *outlineMaxX )
-						{
-							//assert ( x > 10.0f );
-							*outlineMaxX = x;
-							*outlineMaxZ = z;
-							*outlineMaxU = u;
-							*outlineMaxV = v;
-						}
-					}
-#endif
-				}
-#endif
+	//--------------------------------
+	// Determine mipmap data
+	//--------------------------------
+	uint32_t desiredMip[2][2] = { { 0, 0 }, { 0, 0 } };
+	uint32_t mipWidth[2][2]   = { { submesh->texture->width, submesh->texture->width }, { submesh->texture->width, submesh->texture->width } };
+	float uvScale[2][2]       = { { 1.0f, 1.0f }, { 1.0f, 1.0f } };
+	
+	if ( textureMipmapMode == TEXTURE_MIPMAP_POINT )
+	{
+		//--------------------------------
+		// Calculate UV deltas
+		//--------------------------------
+		float dux[2] = {
+			submesh->texture->width * fabsf ( pxu[0][0] - pxu[0][1] ), // top left -> top right
+			submesh->texture->width * fabsf ( pxu[1][0] - pxu[1][1] ), // bottom left -> bottom right
+		};
+		float dvx[2] = {
+			submesh->texture->width * fabsf ( pxv[0][0] - pxv[0][1] ), // top left -> top right
+			submesh->texture->width * fabsf ( pxv[1][0] - pxv[1][1] ), // bottom left -> bottom right
+		};
+		float duy[2] = {
+			submesh->texture->width * fabsf ( pxu[0][0] - pxu[1][0] ), // top left -> bottom left
+			submesh->texture->width * fabsf ( pxu[0][1] - pxu[1][1] ), // top right -> bottom right
+		};
+		float dvy[2] = {
+			submesh->texture->width * fabsf ( pxv[0][0] - pxv[1][0] ), // top left -> bottom left
+			submesh->texture->width * fabsf ( pxv[0][1] - pxv[1][1] ), // top right -> bottom right
+		};
 
-				if ( (Debug.flags & FLAG_RASTERIZE) && (Debug.flags & FLAG_ENABLE_QUAD_RASTERIZATION) )
-#pragma region Quad rasterization
+		//--------------------------------
+		// Fix delta UV involving dead pixels to prevent artifacts
+		//--------------------------------
+		for ( int32_t r = 0; r < 2; r++ )
+		{
+			int32_t px = ix;
+			for ( int32_t c = 0; c < 2; c++, px++ )
+			{
+				if ( y1 < minTriY || y2 > maxTriY /*|| px < ix1[r] || px > ix2[r]*/ )
 				{
-#if 1
-					//--------------------------------
-					// Fill surrounding outlines
-					//--------------------------------
-#if AOS_OUTLINE_TABLE
-					globalData.outlineTable[minTriY-1] = globalData.outlineTable[minTriY];
-					globalData.outlineTable[maxTriY+1] = globalData.outlineTable[maxTriY];
+					// Ded
+					dux[r] = 0.01f;
+					dvx[r] = 0.01f;
+		
+					duy[c] = 0.01f;
+					dvy[c] = 0.01f;
+				}
+			}
+		}
 
-					globalData.outlineTable[minTriY-1].minX = (float)globalData.renderTarget.width, globalData.outlineTable[minTriY-1].maxX = 0;
-					globalData.outlineTable[maxTriY+1].minX = (float)globalData.renderTarget.width, globalData.outlineTable[maxTriY+1].maxX = 0;
-#else
-					*(globalData.outlineTable.minZ + (minTriY-1)) = *(globalData.outlineTable.minZ + minTriY);
-					*(globalData.outlineTable.maxZ + (minTriY-1)) = *(globalData.outlineTable.maxZ + minTriY);
-					*(globalData.outlineTable.minU + (minTriY-1)) = *(globalData.outlineTable.minU + minTriY);
-					*(globalData.outlineTable.maxU + (minTriY-1)) = *(globalData.outlineTable.maxU + minTriY);
-					*(globalData.outlineTable.minV + (minTriY-1)) = *(globalData.outlineTable.minV + minTriY);
-					*(globalData.outlineTable.maxV + (minTriY-1)) = *(globalData.outlineTable.maxV + minTriY);
-
-					*(globalData.outlineTable.minZ + (maxTriY+1)) = *(globalData.outlineTable.minZ + maxTriY);
-					*(globalData.outlineTable.maxZ + (maxTriY+1)) = *(globalData.outlineTable.maxZ + maxTriY);
-					*(globalData.outlineTable.minU + (maxTriY+1)) = *(globalData.outlineTable.minU + maxTriY);
-					*(globalData.outlineTable.maxU + (maxTriY+1)) = *(globalData.outlineTable.maxU + maxTriY);
-					*(globalData.outlineTable.minV + (maxTriY+1)) = *(globalData.outlineTable.minV + maxTriY);
-					*(globalData.outlineTable.maxV + (maxTriY+1)) = *(globalData.outlineTable.maxV + maxTriY);
+		//--------------------------------
+		// Calculate UV deltas
+		//--------------------------------
+		float pxdu[2][2] = {
+			{ MAX ( dux[0], duy[0] ), MAX ( dux[0], duy[1] ) },
+			{ MAX ( dux[1], duy[0] ), MAX ( dux[1], duy[1] ) },
+		};
+		float pxdv[2][2] = {
+			{ MAX ( dvx[0], dvy[0] ), MAX ( dvx[0], dvy[1] ) },
+			{ MAX ( dvx[1], dvy[0] ), MAX ( dvx[1], dvy[1] ) },
+		};
+		float pxduv[2][2] = {
+			{ MAX ( pxdu[0][0], pxdv[0][0] ), MAX ( pxdu[0][1], pxdv[0][1] ) },
+			{ MAX ( pxdu[1][0], pxdv[1][0] ), MAX ( pxdu[1][1], pxdv[1][1] ) },
+		};
+		
+		int32_t desiredMipUnclamped[2][2] = {
+			{ (int32_t)log2f ( ceilf ( FrameDebug.lodBias + FrameDebug.lodScale * pxduv[0][0] ) ), (int32_t)log2f ( ceilf ( FrameDebug.lodBias + FrameDebug.lodScale * pxduv[0][1] ) ) },
+			{ (int32_t)log2f ( ceilf ( FrameDebug.lodBias + FrameDebug.lodScale * pxduv[1][0] ) ), (int32_t)log2f ( ceilf ( FrameDebug.lodBias + FrameDebug.lodScale * pxduv[1][1] ) ) },
+		};
+		desiredMip[0][0] = (uint32_t)CLAMP ( desiredMipUnclamped[0][0], 0, (int32_t)submesh->texture->mipLevels-1 ), desiredMip[0][1] = (uint32_t)CLAMP ( desiredMipUnclamped[0][1], 0, (int32_t)submesh->texture->mipLevels-1 );
+		desiredMip[1][0] = (uint32_t)CLAMP ( desiredMipUnclamped[1][0], 0, (int32_t)submesh->texture->mipLevels-1 ), desiredMip[1][1] = (uint32_t)CLAMP ( desiredMipUnclamped[1][1], 0, (int32_t)submesh->texture->mipLevels-1 );
+
+		mipWidth[0][0] = (submesh->texture->width >> desiredMip[0][0]), mipWidth[0][1] = (submesh->texture->width >> desiredMip[0][1]);
+		mipWidth[1][0] = (submesh->texture->width >> desiredMip[1][0]), mipWidth[1][1] = (submesh->texture->width >> desiredMip[1][1]);
+
+		uvScale[0][0] = 1.0f / (1<<desiredMip[0][0]), uvScale[0][1] = 1.0f / (1<<desiredMip[0][1]);
+		uvScale[1][0] = 1.0f / (1<<desiredMip[1][0]), uvScale[1][1] = 1.0f / (1<<desiredMip[1][1]);
+
+		////--------------------------------
+		//// Calculate mip data
+		////--------------------------------
+		//const float maxdux = MAX ( dux[0], dux[1] ), maxduy = MAX ( duy[0], duy[1] );
+		//const float maxdvx = MAX ( dvx[0], dvx[1] ), maxdvy = MAX ( dvy[0], dvy[1] );
+		//
+		//const float maxdu       = MAX ( maxdux, maxduy ), maxdv  = MAX ( maxdvx, maxdvy );
+		//const float blockMaxDUV = MAX ( maxdu, maxdv );
+		//
+		//const int32_t desiredMipUnclamped  = (int32_t)log2f ( ceilf ( FrameDebug.lodBias + FrameDebug.lodScale * blockMaxDUV ) );
+		//
+		//desiredMip = (uint32_t)CLAMP( desiredMipUnclamped, 0, (int32_t)submesh->texture->mipLevels-1);
+		//mipWidth   = (submesh->texture->width >> desiredMip);
+		//uvScale    = 1.0f / (1<<desiredMip);
+	}
 #endif
+
+#if !SINGLE_DESIRED_MIP
+	#define uvScale uvScale[r][c]
+	#define desiredMip desiredMip[r][c]
+	#define mipWidth mipWidth[r][c]
 #endif
 
-					//--------------------------------
-					// Rasterize time
-					//--------------------------------
-					const int32_t minBlockY = minTriY & (~(1));
-					const int32_t maxBlockY = maxTriY & (~(1));
+	//--------------------------------
+	// Coarse shading uses one UV for the whole quad, and the scalar pipeline only samples the texture for the first pixel it shades
+	//--------------------------------
+	if ( coarse )
+	{
+		float cu, cv;
+		softrast_coarse_sample ( quad, &cu, &cv );
+		pxu[0][0] = pxu[0][1] = pxu[1][0] = pxu[1][1] = cu;
+		pxv[0][0] = pxv[0][1] = pxv[1][0] = pxv[1][1] = cv;
+	}
 
-#pragma message ( "TODO: Support non-textured meshes pls!" )
-					if ( submesh->texture )
-					{
-						int32_t y1 = minBlockY;
-						int32_t y2 = minBlockY + 1;
+	//--------------------------------
+	// Wrap UV and transform to pixel units
+	//--------------------------------
+	for ( int32_t r = 0; r < 2; r++ )
+	{
+		for ( int32_t c = 0; c < 2; c++ )
+		{
+			pxu[r][c] = (pxu[r][c] - (int32_t)pxu[r][c]) * submesh->texture->width;
+			pxv[r][c] = (pxv[r][c] - (int32_t)pxv[r][c]) * submesh->texture->width;
+		}
+	}
 
-#if AOS_OUTLINE_TABLE
-						outline_table_entry* outline[2] = { globalData.outlineTable + y1, globalData.outlineTable + y2 };
-#else
-						float* outlineMinX[2] = { globalData.outlineTable.minX + y1, globalData.outlineTable.minX + y2 };
-						float* outlineMaxX[2] = { globalData.outlineTable.maxX + y1, globalData.outlineTable.maxX + y2 };
-						float* outlineMinZ[2] = { globalData.outlineTable.minZ + y1, globalData.outlineTable.minZ + y2 };
-						float* outlineMaxZ[2] = { globalData.outlineTable.maxZ + y1, globalData.outlineTable.maxZ + y2 };
-						float* outlineMinU[2] = { globalData.outlineTable.minU + y1, globalData.outlineTable.minU + y2 };
-						float* outlineMaxU[2] = { globalData.outlineTable.maxU + y1, globalData.outlineTable.maxU + y2 };
-						float* outlineMinV[2] = { globalData.outlineTable.minV + y1, globalData.outlineTable.minV + y2 };
-						float* outlineMaxV[2] = { globalData.outlineTable.maxV + y1, globalData.outlineTable.maxV + y2 };
-#endif
+	//--------------------------------
+	// Apply dithering ( http://www.flipcode.com/archives/Texturing_As_In_Unreal.shtml )
+	//--------------------------------
+	if ( dithering && !coarse )
+	{
+		float ditherLookup[2][2][2] = {
+			{ { 0.25f, 0.0f }, { 0.5f, 0.75f } },
+			{ { 0.75f, 0.5f }, { 0.0f, 0.25f } },
+		};
 
-						uint32_t* colorRowPtr[2] = {
-							(uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - y1 - 1) * globalData.renderTarget.pitch),
-							(uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - y2 - 1) * globalData.renderTarget.pitch)
-						};
-						float* depthRowPtr[2]    = {
-							globalData.renderTarget.depthBuffer + y1 * globalData.renderTarget.width,
-							globalData.renderTarget.depthBuffer + y2 * globalData.renderTarget.width
-						};
+		for ( int32_t r = 0; r < 2; r++ )
+		{
+			for ( int32_t c = 0; c < 2; c++ )
+			{
+				pxu[r][c] += ditherLookup[(y1 + r) & 1][(ix + c) & 1][0];
+				pxv[r][c] += ditherLookup[(y1 + r) & 1][(ix + c) & 1][1];
+			}
+		}
+	}
 
-						for ( ; y1 <= maxBlockY; y1 +=2, y2 += 2,
-												colorRowPtr[0] = (uint32_t*)((uintptr_t)colorRowPtr[0] - 2 * globalData.renderTarget.pitch),
-												colorRowPtr[1] = (uint32_t*)((uintptr_t)colorRowPtr[1] - 2 * globalData.renderTarget.pitch),
-												depthRowPtr[0] += 2 * globalData.renderTarget.width, depthRowPtr[1] += 2 * globalData.renderTarget.width,
-#if AOS_OUTLINE_TABLE
-												outline[0] += 2, outline[1] += 2 )
-#else
-												outlineMinX[0] += 2, outlineMinX[1] += 2, outlineMaxX[0] += 2, outlineMaxX[1] += 2,
-												outlineMinZ[0] += 2, outlineMinZ[1] += 2, outlineMaxZ[0] += 2, outlineMaxZ[1] += 2,
-												outlineMinU[0] += 2, outlineMinU[1] += 2, outlineMaxU[0] += 2, outlineMaxU[1] += 2,
-												outlineMinV[0] += 2, outlineMinV[1] += 2, outlineMaxV[0] += 2, outlineMaxV[1] += 2 )
-#endif
-						{
-							//--------------------------------
-							// Prepare useful constant data
-							//--------------------------------
-#if AOS_OUTLINE_TABLE
-							const float x1[2] = { outline[0]->minX, outline[1]->minX };
-							const float x2[2] = { outline[0]->maxX, outline[1]->maxX };
-
-							const int32_t ix1[2] = { (int32_t)x1[0], (int32_t)x1[1] };
-							const int32_t ix2[2] = { (int32_t)x2[0], (int32_t)x2[1] };
-
-							float z1[2] = { outline[0]->minZ, outline[1]->minZ };
-							float u1[2] = { outline[0]->minU, outline[1]->minU };
-							float v1[2] = { outline[0]->minV, outline[1]->minV };
-
-							float z2[2] = { outline[0]->maxZ, outline[1]->maxZ };
-							float u2[2] = { outline[0]->maxU, outline[1]->maxU };
-							float v2[2] = { outline[0]->maxV, outline[1]->maxV };
-#else
-							const float x1[2] = { *outlineMinX[0], *outlineMinX[1] };
-							const float x2[2] = { *outlineMaxX[0], *outlineMaxX[1] };
+	//--------------------------------
+	// Plot pixels
+	//--------------------------------
+	if ( simd )
+	{
+		const uint32_t blockIDX = (uint32_t)(ix) >> 1;
+		const uint32_t blockIDY = (uint32_t)(y1) >> 1;
 
-							const int32_t ix1[2] = { (int32_t)x1[0], (int32_t)x1[1] };
-							const int32_t ix2[2] = { (int32_t)x2[0], (int32_t)x2[1] };
+		float* dbquadptr = globalData.renderTarget.depthBuffer + blockIDY * globalData.renderTarget.depthBufferQuadFloatStride + 4 * blockIDX;
 
-							float z1[2] = { *outlineMinZ[0], *outlineMinZ[1] };
-							float u1[2] = { *outlineMinU[0], *outlineMinU[1] };
-							float v1[2] = { *outlineMinV[0], *outlineMinV[1] };
+		const __m128 fi4 = _mm_set_ps ( 3, 2, 1, 0 );
+		const __m128i ii4 = _mm_set_epi32 ( 3, 2, 1, 0 );
+		(void)fi4, (void)ii4;
 
-							const float z2[2] = { *outlineMaxZ[0], *outlineMaxZ[1] };
-							const float u2[2] = { *outlineMaxU[0], *outlineMaxU[1] };
-							const float v2[2] = { *outlineMaxV[0], *outlineMaxV[1] };
-#endif
+		//const __m128i sc4   = _mm_set_epi32 ( *ptr[1][1], *ptr[1][0], *ptr[0][1], *ptr[0][0] );
+		const __m128  d4    = _mm_load_ps ( dbquadptr );//_mm_set_ps ( *dptr[1][1], *dptr[1][0], *dptr[0][1], *dptr[0][0] );
+		const __m128  z4    = _mm_set_ps ( z[1] + zstep[1], z[1], z[0] + zstep[0], z[0] );
+		const __m128i coverage4 = _mm_set_epi32 ( -(int32_t)((quad->coverage >> 3) & 1), -(int32_t)((quad->coverage >> 2) & 1), -(int32_t)((quad->coverage >> 1) & 1), -(int32_t)(quad->coverage & 1) );
 
-							const int32_t iMinX = (ix1[0] < ix1[1] ? ix1[0] : ix1[1]) & (~1);
-							const int32_t iMaxX = (ix2[0] > ix2[1] ? ix2[0] : ix2[1]) & (~1);
-
-							//--------------------------------
-							// Calculate deltas and steps
-							//--------------------------------
-							const float dx[2] = { x2[0] - x1[0], x2[1] - x1[1] };
-						
-							const float zstep[2] = { (z2[0] - z1[0]) / dx[0], (z2[1] - z1[1]) / dx[1] };
-							const float ustep[2] = { (u2[0] - u1[0]) / dx[0], (u2[1] - u1[1]) / dx[1] };
-							const float vstep[2] = { (v2[0] - v1[0]) / dx[0], (v2[1] - v1[1]) / dx[1] };
-
-							//--------------------------------
-							// Prepare useful mutable data
-							//--------------------------------
-							uint32_t* ptr[2][2] = {
-								{ colorRowPtr[0] + iMinX, colorRowPtr[0] + iMinX + 1 },
-								{ colorRowPtr[1] + iMinX, colorRowPtr[1] + iMinX + 1 },
-							};
-							float* dptr[2][2] = {
-								{ depthRowPtr[0] + iMinX, depthRowPtr[0] + iMinX + 1 },
-								{ depthRowPtr[1] + iMinX, depthRowPtr[1] + iMinX + 1 },
-							};
-							int32_t spanCorrection[2] = { iMinX - ix1[0], iMinX - ix1[1] };
-							z1[0] = z1[0] + zstep[0] * spanCorrection[0], z1[1] = z1[1] + zstep[1] * spanCorrection[1];
-							u1[0] = u1[0] + ustep[0] * spanCorrection[0], u1[1] = u1[1] + ustep[1] * spanCorrection[1];
-							v1[0] = v1[0] + vstep[0] * spanCorrection[0], v1[1] = v1[1] + vstep[1] * spanCorrection[1];
-							
-#if 0
-							float z[2] = { z1[0], z1[1] };
-							float u[2] = { u1[0], u1[1] };
-							float v[2] = { v1[0], v1[1] };
-							
-							const float zstep2[2] = { 2.0f * zstep[0], 2.0f * zstep[1] };
-							const float ustep2[2] = { 2.0f * ustep[0], 2.0f * ustep[1] };
-							const float vstep2[2] = { 2.0f * vstep[0], 2.0f * vstep[1] };
-
-							//--------------------------------
-							// Time to fill some spans
-							//--------------------------------
-							for ( int32_t ix = iMinX; ix <= iMaxX; ix+=2,	ptr[0][0] += 2, ptr[0][1] += 2, ptr[1][0] += 2, ptr[1][1] += 2,
-																			dptr[0][0] += 2, dptr[0][1] += 2, dptr[1][0] += 2, dptr[1][1] += 2,
-																			z[0] += zstep2[0], z[1] += zstep2[1],
-																			u[0] += ustep2[0], u[1] += ustep2[1],
-																			v[0] += vstep2[0], v[1] += vstep2[1] )
-							{
-#else
-							//--------------------------------
-							// Time to fill some spans
-							//--------------------------------
-							int32_t xinc = 0;
-							for ( int32_t ix = iMinX; ix <= iMaxX; ix+=2, xinc+=2,	ptr[0][0] += 2, ptr[0][1] += 2, ptr[1][0] += 2, ptr[1][1] += 2,
-																			dptr[0][0] += 2, dptr[0][1] += 2, dptr[1][0] += 2, dptr[1][1] += 2 )
-							{
-								float z[2] = { z1[0] + xinc * zstep[0], z1[1] + xinc * zstep[1] };
-								float u[2] = { u1[0] + xinc * ustep[0], u1[1] + xinc * ustep[1] };
-								float v[2] = { v1[0] + xinc * vstep[0], v1[1] + xinc * vstep[1] };
-#endif
-#define MIN(x,y) (((x) < (y)) ? (x) : (y))
-#define MAX(x,y) (((x) > (y)) ? (x) : (y))
-#define CLAMP(x,min,max) (MIN((max),MAX((min),(x))))
+		const __m128  depthTestMask  = _mm_cmpgt_ps ( z4, d4 );
+		const __m128i depthTestMaski = *(__m128i*)&depthTestMask;
+		const __m128i pixelMaski     = _mm_and_si128 ( coverage4, depthTestMaski ); // if ( covered && pz > *dptr[r][c] )
+		const __m128  pixelMask      = *(__m128*)&pixelMaski;
+		ThreadPixelStats.shadedPixels += softrast_bit_count ( _mm_movemask_ps ( pixelMask ) );
 
-								// Take dx, dy of U and V
-								//	-> dx[0] = du[0], dx[1] = du[1]
-								//  -> dy[0] = u[1] - u[0], u[1] - u[0] - (ustep[1] - ustep[0])
-								// [per pixel] Take max of dx and dy, and find the mipmap that would make that max <= 1
-
-								//--------------------------------
-								// Calculate reciprocal Z for each pixel in the block (actually reciprocal of reciprocal of z, being z, but I digress)
-								//--------------------------------
-								const float rz[2][2] = {
-									{ 1.0f / z[0], 1.0f/(z[0] + zstep[0]) },
-									{ 1.0f / z[1], 1.0f/(z[1] + zstep[1]) },
-								};
-
-								//--------------------------------
-								// Calculate UV for each pixel in the block
-								//--------------------------------
-								float pxu[2][2] = {
-									{ u[0] * rz[0][0], (u[0] + ustep[0]) * rz[0][1] },
-									{ u[1] * rz[1][0], (u[1] + ustep[1]) * rz[1][1] },
-								};
-
-								float pxv[2][2] = {
-									{ v[0] * rz[0][0], (v[0] + vstep[0]) * rz[0][1] },
-									{ v[1] * rz[1][0], (v[1] + vstep[1]) * rz[1][1] },
-								};
+		const __m128 do4 = _mm_or_ps ( _mm_and_ps ( pixelMask, z4 ), _mm_andnot_ps ( pixelMask, d4 ) );
+		_mm_store_ps ( dbquadptr, do4 );
 
-#define SINGLE_DESIRED_MIP 1
-#if SINGLE_DESIRED_MIP
-								//--------------------------------
-								// Determine mipmap data
-								//--------------------------------
-								uint32_t desiredMip, desiredMip2;
-								uint32_t mipWidth;
-								uint32_t shiftScale;
-								float mipT;
-								float uvScale;
-
-								
-								if ( Debug.textureMipmapMode != TEXTURE_MIPMAP_NONE )
-								{
-									//--------------------------------
-									// Calculate UV deltas
-									//--------------------------------
-									float dux[2] = {
-										submesh->texture->width * fabsf ( pxu[0][0] - pxu[0][1] ), // top left -> top right
-										submesh->texture->width * fabsf ( pxu[1][0] - pxu[1][1] ), // bottom left -> bottom right
-									};
-									float dvx[2] = {
-										submesh->texture->width * fabsf ( pxv[0][0] - pxv[0][1] ), // top left -> top right
-										submesh->texture->width * fabsf ( pxv[1][0] - pxv[1][1] ), // bottom left -> bottom right
-									};
-									float duy[2] = {
-										submesh->texture->width * fabsf ( pxu[0][0] - pxu[1][0] ), // top left -> bottom left
-										submesh->texture->width * fabsf ( pxu[0][1] - pxu[1][1] ), // top right -> bottom right
-									};
-									float dvy[2] = {
-										submesh->texture->width * fabsf ( pxv[0][0] - pxv[1][0] ), // top left -> bottom left
-										submesh->texture->width * fabsf ( pxv[0][1] - pxv[1][1] ), // top right -> bottom right
-									};
+		if ( renderMode == RENDER_MODE_FLAT_COLOR )
+		{
+			//const __m128i dc4 = _mm_or_si128 ( _mm_and_si128 ( pixelMaski, _mm_set1_epi32 ( 0xFFFF0000 ) ), _mm_andnot_si128 ( pixelMaski, sc4 ) );
 
-									////--------------------------------
-									//// Fix delta UV involving dead pixels to prevent artifacts
-									////--------------------------------
-									//for ( int32_t r = 0; r < 2; r++ )
-									//{
-									//	int32_t px = ix;
-									//	for ( int32_t c = 0; c < 2; c++, px++ )
-									//	{
-									//		//if ( !(outline[r]->flags & 0x1) /*|| y1 < minTriY || y2 > maxTriY*/ /*|| px < ix1[r] || px > ix2[r]*/ )
-									//		{
-									//			// Ded
-									//			dux[r] = 1.0f;
-									//			dvx[r] = 1.0f;
-									//
-									//			duy[c] = 1.0f;
-									//			dvy[c] = 1.0f;
-									//		}
-									//	}
-									//}
-
-									//--------------------------------
-									// Calculate mip data
-									//--------------------------------
-									const float maxdux = MAX ( dux[0], dux[1] ), maxduy = MAX ( duy[0], duy[1] );
-									const float maxdvx = MAX ( dvx[0], dvx[1] ), maxdvy = MAX ( dvy[0], dvy[1] );
-
-									const float maxdu       = MAX ( maxdux, maxduy ), maxdv  = MAX ( maxdvx, maxdvy );
-									const float blockMaxDUV = MAX ( maxdu, maxdv );
-
-									const float scaledDUV = Debug.lodBias + Debug.lodScale * blockMaxDUV;
-									const float scale     = MAX ( 1.0f, scaledDUV );
-
-									const float logScale = log2f ( scale );
-
-									desiredMip  = (uint32_t)logScale;// (uint32_t)CLAMP( desiredMipUnclamped, 0, (int32_t)submesh->texture->mipLevels-1);
-									mipT        = logScale - desiredMip;
-									desiredMip  = MIN ( desiredMip, submesh->texture->mipLevels-1 );
-									desiredMip2 = MIN ( desiredMip+1, submesh->texture->mipLevels-1 );
-									shiftScale  = desiredMip2 - desiredMip;
-									mipWidth    = (submesh->texture->width >> desiredMip);
-									uvScale     = 1.0f / (1<<desiredMip);
-								}
-								else
-								{
-									desiredMip = 0;
-									mipWidth   = submesh->texture->width;
-									uvScale    = 1.0f;
-								}
-#else
-								//--------------------------------
-								// Determine mipmap data
-								//--------------------------------
-								uint32_t desiredMip[2][2] = { { 0, 0 }, { 0, 0 } };
-								uint32_t mipWidth[2][2]   = { { submesh->texture->width, submesh->texture->width }, { submesh->texture->width, submesh->texture->width } };
-								float uvScale[2][2]       = { { 1.0f, 1.0f }, { 1.0f, 1.0f } };
-								
-								if ( Debug.textureMipmapMode == TEXTURE_MIPMAP_POINT )
-								{
-									//--------------------------------
-									// Calculate UV deltas
-									//--------------------------------
-									float dux[2] = {
-										submesh->texture->width * fabsf ( pxu[0][0] - pxu[0][1] ), // top left -> top right
-										submesh->texture->width * fabsf ( pxu[1][0] - pxu[1][1] ), // bottom left -> bottom right
-									};
-									float dvx[2] = {
-										submesh->texture->width * fabsf ( pxv[0][0] - pxv[0][1] ), // top left -> top right
-										submesh->texture->width * fabsf ( pxv[1][0] - pxv[1][1] ), // bottom left -> bottom right
-									};
-									float duy[2] = {
-										submesh->texture->width * fabsf ( pxu[0][0] - pxu[1][0] ), // top left -> bottom left
-										submesh->texture->width * fabsf ( pxu[0][1] - pxu[1][1] ), // top right -> bottom right
-									};
-									float dvy[2] = {
-										submesh->texture->width * fabsf ( pxv[0][0] - pxv[1][0] ), // top left -> bottom left
-										submesh->texture->width * fabsf ( pxv[0][1] - pxv[1][1] ), // top right -> bottom right
-									};
+			union
+			{
+				__m128 f;
+				__m128i i;
+			} a;
+			union
+			{
+				__m128 f;
+				__m128i i;
+			} b;
+			a.f = _mm_shuffle_ps ( pixelMask, _mm_set1_ps ( 0 ), _MM_SHUFFLE ( 3, 2, 1, 0 ) );
+			b.f = _mm_shuffle_ps ( pixelMask, _mm_set1_ps ( 0 ), _MM_SHUFFLE ( 3, 2, 3, 2 ) );
+
+			_mm_maskmoveu_si128 ( _mm_set1_epi32 ( 0xFFFF0000 ), a.i, (char*)ptr[0][0] );
+			_mm_maskmoveu_si128 ( _mm_set1_epi32 ( 0xFFFF0000 ), b.i, (char*)ptr[1][0] );
+
+			//// Repeat this for breakpoint purposes =D
+			//*dptr[0][0] = do4.m128_f32[0], *dptr[0][1] = do4.m128_f32[1], *dptr[1][0] = do4.m128_f32[2], *dptr[1][1] = do4.m128_f32[3];
+			//
+			//(void)a;
+			//*ptr[0][0] = dc4.m128i_u32[0], *ptr[0][1] = dc4.m128i_u32[1], *ptr[1][0] = dc4.m128i_u32[2], *ptr[1][1] = dc4.m128i_u32[3];
+		}
+		else if ( renderMode == RENDER_MODE_TEXTURED && submesh->texture && _mm_movemask_ps ( pixelMask ) )
+		{
+			const __m128 u4      = _mm_setr_ps ( pxu[0][0], pxu[0][1], pxu[1][0], pxu[1][1] );
+			const __m128 v4      = _mm_setr_ps ( pxv[0][0], pxv[0][1], pxv[1][0], pxv[1][1] );
+			const __m128i color4 = __softrast_sample_sse ( submesh->texture, &mip, u4, v4, textureAddressingMode, textureFilteringMode, textureMipmapMode );
 
-									//--------------------------------
-									// Fix delta UV involving dead pixels to prevent artifacts
-									//--------------------------------
-									for ( int32_t r = 0; r < 2; r++ )
-									{
-										int32_t px = ix;
-										for ( int32_t c = 0; c < 2; c++, px++ )
-										{
-											if ( y1 < minTriY || y2 > maxTriY /*|| px < ix1[r] || px > ix2[r]*/ )
-											{
-												// Ded
-												dux[r] = 0.01f;
-												dvx[r] = 0.01f;
-									
-												duy[c] = 0.01f;
-												dvy[c] = 0.01f;
-											}
-										}
-									}
+			// Lanes 0 and 1 hold the top row, 2 and 3 the bottom one
+			_mm_maskmoveu_si128 ( color4, _mm_move_epi64 ( pixelMaski ), (char*)ptr[0][0] );
+			_mm_maskmoveu_si128 ( _mm_srli_si128 ( color4, 8 ), _mm_srli_si128 ( pixelMaski, 8 ), (char*)ptr[1][0] );
+		}
+		//else if ( renderMode == RENDER_MODE_UV )
+		//else if ( renderMode == RENDER_MODE_ZBUFFER )
 
-									//--------------------------------
-									// Calculate UV deltas
-									//--------------------------------
-									float pxdu[2][2] = {
-										{ MAX ( dux[0], duy[0] ), MAX ( dux[0], duy[1] ) },
-										{ MAX ( dux[1], duy[0] ), MAX ( dux[1], duy[1] ) },
-									};
-									float pxdv[2][2] = {
-										{ MAX ( dvx[0], dvy[0] ), MAX ( dvx[0], dvy[1] ) },
-										{ MAX ( dvx[1], dvy[0] ), MAX ( dvx[1], dvy[1] ) },
-									};
-									float pxduv[2][2] = {
-										{ MAX ( pxdu[0][0], pxdv[0][0] ), MAX ( pxdu[0][1], pxdv[0][1] ) },
-										{ MAX ( pxdu[1][0], pxdv[1][0] ), MAX ( pxdu[1][1], pxdv[1][1] ) },
-									};
-									
-									int32_t desiredMipUnclamped[2][2] = {
-										{ (int32_t)log2f ( ceilf ( Debug.lodBias + Debug.lodScale * pxduv[0][0] ) ), (int32_t)log2f ( ceilf ( Debug.lodBias + Debug.lodScale * pxduv[0][1] ) ) },
-										{ (int32_t)log2f ( ceilf ( Debug.lodBias + Debug.lodScale * pxduv[1][0] ) ), (int32_t)log2f ( ceilf ( Debug.lodBias + Debug.lodScale * pxduv[1][1] ) ) },
-									};
-									desiredMip[0][0] = (uint32_t)CLAMP ( desiredMipUnclamped[0][0], 0, (int32_t)submesh->texture->mipLevels-1 ), desiredMip[0][1] = (uint32_t)CLAMP ( desiredMipUnclamped[0][1], 0, (int32_t)submesh->texture->mipLevels-1 );
-									desiredMip[1][0] = (uint32_t)CLAMP ( desiredMipUnclamped[1][0], 0, (int32_t)submesh->texture->mipLevels-1 ), desiredMip[1][1] = (uint32_t)CLAMP ( desiredMipUnclamped[1][1], 0, (int32_t)submesh->texture->mipLevels-1 );
-
-									mipWidth[0][0] = (submesh->texture->width >> desiredMip[0][0]), mipWidth[0][1] = (submesh->texture->width >> desiredMip[0][1]);
-									mipWidth[1][0] = (submesh->texture->width >> desiredMip[1][0]), mipWidth[1][1] = (submesh->texture->width >> desiredMip[1][1]);
-
-									uvScale[0][0] = 1.0f / (1<<desiredMip[0][0]), uvScale[0][1] = 1.0f / (1<<desiredMip[0][1]);
-									uvScale[1][0] = 1.0f / (1<<desiredMip[1][0]), uvScale[1][1] = 1.0f / (1<<desiredMip[1][1]);
-
-									////--------------------------------
-									//// Calculate mip data
-									////--------------------------------
-									//const float maxdux = MAX ( dux[0], dux[1] ), maxduy = MAX ( duy[0], duy[1] );
-									//const float maxdvx = MAX ( dvx[0], dvx[1] ), maxdvy = MAX ( dvy[0], dvy[1] );
-									//
-									//const float maxdu       = MAX ( maxdux, maxduy ), maxdv  = MAX ( maxdvx, maxdvy );
-									//const float blockMaxDUV = MAX ( maxdu, maxdv );
-									//
-									//const int32_t desiredMipUnclamped  = (int32_t)log2f ( ceilf ( Debug.lodBias + Debug.lodScale * blockMaxDUV ) );
-									//
-									//desiredMip = (uint32_t)CLAMP( desiredMipUnclamped, 0, (int32_t)submesh->texture->mipLevels-1);
-									//mipWidth   = (submesh->texture->width >> desiredMip);
-									//uvScale    = 1.0f / (1<<desiredMip);
-								}
-#endif
+		//for ( uint32_t r = 0; r < 2; r++ )
+		//		for ( uint32_t c = 0; c < 2; c++ )
+		//			*ptr[r][c] = (uint32_t)((((1.0f/(*dptr[r][c]))-globalData.nearClip)/(globalData.farClip-globalData.nearClip)) * 255.0f);
+	}
+	else
+	{
+		uint32_t coarseColor = 0, coarseColorValid = 0;
+		for ( int32_t r = 0; r < 2; r++ )
+		{
+			int32_t px = ix;
+			float   pz = z[r];
 
-#if !SINGLE_DESIRED_MIP
-	#define uvScale uvScale[r][c]
-	#define desiredMip desiredMip[r][c]
-	#define mipWidth mipWidth[r][c]
-#endif
+			for ( int32_t c = 0; c < 2; c++, px++, pz += zstep[r] )
+			{
+				if ( (quad->coverage & (1 << (r * 2 + c))) && pz > *dptr[r][c] )
+				{
+					*dptr[r][c] = pz;
+					ThreadPixelStats.shadedPixels++;
 
-								//--------------------------------
-								// Wrap UV and transform to pixel units
-								//--------------------------------
-								for ( int32_t r = 0; r < 2; r++ )
-								{
-									for ( int32_t c = 0; c < 2; c++ )
-									{
-										pxu[r][c] = (pxu[r][c] - (int32_t)pxu[r][c]) * submesh->texture->width;
-										pxv[r][c] = (pxv[r][c] - (int32_t)pxv[r][c]) * submesh->texture->width;
-									}
-								}
+					if ( renderMode == RENDER_MODE_FLAT_COLOR )
+						*ptr[r][c] = 0xFFFF0000;
+					else if ( renderMode == RENDER_MODE_UV )
+					{
+						float fx = pxu[r][c] / submesh->texture->width;
+						float fy = pxv[r][c] / submesh->texture->height;
+						*ptr[r][c] = (((uint32_t)(fx * 256.0f))<<16) | (((uint32_t)(fy * 256.0f))<<8);
+					}
+					else if ( renderMode == RENDER_MODE_ZBUFFER )
+						*ptr[r][c] = (uint32_t)(((rz[r][c]-globalData.shadeTarget.nearClip)/(globalData.shadeTarget.farClip-globalData.shadeTarget.nearClip)) * 255.0f);
+					else if ( renderMode == RENDER_MODE_MIPMAP )
+					{
+						static const uint32_t mipmapLUT[] = {
+							0xFF0000,
+							0x00FF00,
+							0xFFFF00,
+							0x0000FF,
+							0xFF00FF,
+							0x00FFFF,
+							0xFFFFFF,
+						};
 
-								//--------------------------------
-								// Apply dithering ( http://www.flipcode.com/archives/Texturing_As_In_Unreal.shtml )
-								//--------------------------------
-								if ( Debug.flags & FLAG_TEXTURE_DITHERING )
-								{
-									float ditherLookup[2][2][2] = {
-										{ { 0.25f, 0.0f }, { 0.5f, 0.75f } },
-										{ { 0.75f, 0.5f }, { 0.0f, 0.25f } },
-									};
+						if ( textureMipmapMode == TEXTURE_MIPMAP_LINEAR )
+							*ptr[r][c] = mipmapLUT[MIN(desiredMip2,sizeof(mipmapLUT)/sizeof(mipmapLUT[0])-1)];
+						else
+							*ptr[r][c] = mipmapLUT[MIN(desiredMip,sizeof(mipmapLUT)/sizeof(mipmapLUT[0])-1)];
+					}
+					else if ( renderMode == RENDER_MODE_TEXTURED && !submesh->texture )
+						*ptr[r][c] = 0xFF00FF;
+					else if ( renderMode == RENDER_MODE_TEXTURED )
+					{
+						if ( !coarse || !coarseColorValid )
+						{
+							coarseColor      = __softrast_sample ( submesh->texture, &mip, pxu[r][c], pxv[r][c], textureAddressingMode, textureFilteringMode, textureMipmapMode );
+							coarseColorValid = coarse;
+						}
+						*ptr[r][c] = coarseColor;
+					}
+				}
+			}
+		}
+	}
+}
 
-									for ( int32_t r = 0; r < 2; r++ )
-									{
-										for ( int32_t c = 0; c < 2; c++ )
-										{
-											pxu[r][c] += ditherLookup[(y1 + r) & 1][(ix + c) & 1][0];
-											pxv[r][c] += ditherLookup[(y1 + r) & 1][(ix + c) & 1][1];
-										}
-									}
-								}
+//--------------------------------
+// Specialized pixel pipelines, once for the scalar and once for the SSE path
+//--------------------------------
+#define SOFTRAST_SHADE_QUAD_SCALAR(name,renderMode,addressing,filtering,mipmap,dithering) \
+	static void name ( const raster_quad* quad, const softrast_submesh* submesh ) { __softrast_shade_quad_generic ( quad, submesh, renderMode, addressing, filtering, mipmap, dithering, 0 ); }
 
-								//--------------------------------
-								// Plot pixels
-								//--------------------------------
-								if ( Debug.flags & FLAG_QUAD_RASTERIZATION_SIMD )
-								{
-									const uint32_t blockIDX = (uint32_t)(ix) >> 1;
-									const uint32_t blockIDY = (uint32_t)(y1) >> 1;
+#define SOFTRAST_SHADE_QUAD_SSE(name,renderMode,addressing,filtering,mipmap,dithering) \
+	static void name ( const raster_quad* quad, const softrast_submesh* submesh ) { __softrast_shade_quad_generic ( quad, submesh, renderMode, addressing, filtering, mipmap, dithering, 1 ); }
 
-									float* dbquadptr = globalData.renderTarget.depthBuffer + blockIDY * globalData.renderTarget.depthBufferQuadFloatStride + 4 * blockIDX;
+SOFTRAST_SHADE_KERNELS ( __softrast_shade_quad_scalar, SOFTRAST_SHADE_QUAD_SCALAR )
+SOFTRAST_SHADE_KERNELS ( __softrast_shade_quad_sse,    SOFTRAST_SHADE_QUAD_SSE )
 
-									const __m128 fi4 = _mm_set_ps ( 3, 2, 1, 0 );
-									const __m128i ii4 = _mm_set_epi32 ( 3, 2, 1, 0 );
-									(void)fi4, (void)ii4;
+// Indexed by whether the SSE path is enabled
+static const SOFTRAST_SHADE_KERNEL_TABLE_TYPE ( shade_quad_func ) __softrast_shade_quad_table[2] = {
+	SOFTRAST_SHADE_KERNEL_TABLE ( __softrast_shade_quad_scalar ),
+	SOFTRAST_SHADE_KERNEL_TABLE ( __softrast_shade_quad_sse ),
+};
 
-									//const __m128i sc4   = _mm_set_epi32 ( *ptr[1][1], *ptr[1][0], *ptr[0][1], *ptr[0][0] );
-									const __m128  d4    = _mm_load_ps ( dbquadptr );//_mm_set_ps ( *dptr[1][1], *dptr[1][0], *dptr[0][1], *dptr[0][0] );
-									const __m128  z4    = _mm_set_ps ( z[1] + zstep[1], z[1], z[0] + zstep[0], z[0] );
-									const __m128i x4    = _mm_set_epi32 ( ix + 1, ix, ix + 1, ix );
-									const __m128i minx4 = _mm_set_epi32 ( ix1[1] - 1, ix1[1] - 1, ix1[0] - 1, ix1[0] - 1 );
-									const __m128i maxx4 = _mm_set_epi32 ( ix2[1] + 1, ix2[1] + 1, ix2[0] + 1, ix2[0] + 1 );
+// Picks the pixel pipeline matching the current render settings
+static shade_quad_func __softrast_select_shade_quad ( )
+{
+	return SOFTRAST_SELECT_SHADE_KERNEL ( __softrast_shade_quad_table[(globalData.kernelFlags & FLAG_QUAD_RASTERIZATION_SIMD) != 0], &FrameDebug );
+}
 
-									const __m128  depthTestMask  = _mm_cmpgt_ps ( z4, d4 );
-									const __m128i depthTestMaski = *(__m128i*)&depthTestMask;
-									const __m128i pixelMaski     = _mm_and_si128 ( _mm_and_si128 ( _mm_cmpgt_epi32 ( x4, minx4 ), _mm_cmplt_epi32 ( x4, maxx4 ) ), depthTestMaski ); // if ( px >= ix1[r] && px <= ix2[r] && pz > *dptr[r][c] )
-									const __m128  pixelMask      = *(__m128*)&pixelMaski;
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
 
-									const __m128 do4 = _mm_or_ps ( _mm_and_ps ( pixelMask, z4 ), _mm_andnot_ps ( pixelMask, d4 ) );
-									_mm_store_ps ( dbquadptr, do4 );
+// Spreads the low 16 bits of every lane to the even bits (xxxx => 0x0x 0x0x)
+static __m256i __softrast_morton_spread_avx2 ( __m256i v )
+{
+	v = _mm256_and_si256 ( v, _mm256_set1_epi32 ( 0x0000FFFF ) );
+	v = _mm256_and_si256 ( _mm256_or_si256 ( v, _mm256_slli_epi32 ( v, 8 ) ), _mm256_set1_epi32 ( 0x00FF00FF ) );
+	v = _mm256_and_si256 ( _mm256_or_si256 ( v, _mm256_slli_epi32 ( v, 4 ) ), _mm256_set1_epi32 ( 0x0F0F0F0F ) );
+	v = _mm256_and_si256 ( _mm256_or_si256 ( v, _mm256_slli_epi32 ( v, 2 ) ), _mm256_set1_epi32 ( 0x33333333 ) );
+	v = _mm256_and_si256 ( _mm256_or_si256 ( v, _mm256_slli_epi32 ( v, 1 ) ), _mm256_set1_epi32 ( 0x55555555 ) );
+	return v;
+}
 
-									if ( Debug.renderMode == RENDER_MODE_FLAT_COLOR )
-									{
-										//const __m128i dc4 = _mm_or_si128 ( _mm_and_si128 ( pixelMaski, _mm_set1_epi32 ( 0xFFFF0000 ) ), _mm_andnot_si128 ( pixelMaski, sc4 ) );
-
-										union
-										{
-											__m128 f;
-											__m128i i;
-										} a;
-										union
-										{
-											__m128 f;
-											__m128i i;
-										} b;
-										a.f = _mm_shuffle_ps ( pixelMask, _mm_set1_ps ( 0 ), _MM_SHUFFLE ( 3, 2, 1, 0 ) );
-										b.f = _mm_shuffle_ps ( pixelMask, _mm_set1_ps ( 0 ), _MM_SHUFFLE ( 3, 2, 3, 2 ) );
-
-										_mm_maskmoveu_si128 ( _mm_set1_epi32 ( 0xFFFF0000 ), a.i, (char*)ptr[0][0] );
-										_mm_maskmoveu_si128 ( _mm_set1_epi32 ( 0xFFFF0000 ), b.i, (char*)ptr[1][0] );
-
-										//// Repeat this for breakpoint purposes =D
-										//*dptr[0][0] = do4.m128_f32[0], *dptr[0][1] = do4.m128_f32[1], *dptr[1][0] = do4.m128_f32[2], *dptr[1][1] = do4.m128_f32[3];
-										//
-										//(void)a;
-										//*ptr[0][0] = dc4.m128i_u32[0], *ptr[0][1] = dc4.m128i_u32[1], *ptr[1][0] = dc4.m128i_u32[2], *ptr[1][1] = dc4.m128i_u32[3];
-									}
-									//else if ( Debug.renderMode == RENDER_MODE_UV )
-									//else if ( Debug.renderMode == RENDER_MODE_ZBUFFER )
+// Texel index of (ix, iy) inside a mip level, following the addressing mode
+static __forceinline __m256i __softrast_texel_index_avx2 ( __m256i ix, __m256i iy, __m256i mipWidth, const int textureAddressingMode )
+{
+	if ( textureAddressingMode == TEXTURE_ADDRESSING_TILED )
+	{
+		const __m256i three   = _mm256_set1_epi32 ( 3 );
+		const __m256i tileidx = _mm256_add_epi32 ( _mm256_mullo_epi32 ( _mm256_srli_epi32 ( iy, 2 ), _mm256_srli_epi32 ( mipWidth, 2 ) ), _mm256_srli_epi32 ( ix, 2 ) );
+		const __m256i pixidx  = _mm256_add_epi32 ( _mm256_slli_epi32 ( _mm256_and_si256 ( iy, three ), 2 ), _mm256_and_si256 ( ix, three ) );
+		return _mm256_add_epi32 ( _mm256_slli_epi32 ( tileidx, 4 ), pixidx );
+	}
+	else if ( textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
+		return _mm256_or_si256 ( __softrast_morton_spread_avx2 ( ix ), _mm256_slli_epi32 ( __softrast_morton_spread_avx2 ( iy ), 1 ) );
+	else
+		return _mm256_add_epi32 ( _mm256_mullo_epi32 ( iy, mipWidth ), ix );
+}
 
-									//for ( uint32_t r = 0; r < 2; r++ )
-									//		for ( uint32_t c = 0; c < 2; c++ )
-									//			*ptr[r][c] = (uint32_t)((((1.0f/(*dptr[r][c]))-globalData.nearClip)/(globalData.farClip-globalData.nearClip)) * 255.0f);
-								}
-								else
-								{
-									for ( int32_t r = 0; r < 2; r++ )
-									{
-										int32_t px = ix;
-										float   pz = z[r];
-
-										for ( int32_t c = 0; c < 2; c++, px++, pz += zstep[r] )
-										{
-											if ( (outline[r]->flags & 0x1) && px >= ix1[r] && px <= ix2[r] && pz > *dptr[r][c] )
-											{
-												*dptr[r][c] = pz;
-
-												if ( Debug.renderMode == RENDER_MODE_FLAT_COLOR )
-													*ptr[r][c] = 0xFFFF0000;
-												else if ( Debug.renderMode == RENDER_MODE_UV )
-												{
-													float fx = pxu[r][c] / submesh->texture->width;
-													float fy = pxv[r][c] / submesh->texture->height;
-													*ptr[r][c] = (((uint32_t)(fx * 256.0f))<<16) | (((uint32_t)(fy * 256.0f))<<8);
-												}
-												else if ( Debug.renderMode == RENDER_MODE_ZBUFFER )
-													*ptr[r][c] = (uint32_t)(((rz[r][c]-globalData.nearClip)/(globalData.farClip-globalData.nearClip)) * 255.0f);
-												else if ( Debug.renderMode == RENDER_MODE_MIPMAP )
-												{
-													static const uint32_t mipmapLUT[] = {
-														0xFF0000,
-														0x00FF00,
-														0xFFFF00,
-														0x0000FF,
-														0xFF00FF,
-														0x00FFFF,
-														0xFFFFFF,
-													};
-
-													if ( Debug.textureMipmapMode == TEXTURE_MIPMAP_LINEAR )
-														*ptr[r][c] = mipmapLUT[MIN(desiredMip2,sizeof(mipmapLUT)/sizeof(mipmapLUT[0])-1)];
-													else
-														*ptr[r][c] = mipmapLUT[MIN(desiredMip,sizeof(mipmapLUT)/sizeof(mipmapLUT[0])-1)];
-												}
-												else if ( Debug.renderMode == RENDER_MODE_TEXTURED )
-												{
-													if ( submesh->texture )
-													{
-														uint32_t color[2];
-														const uint32_t itCount = Debug.textureMipmapMode == TEXTURE_MIPMAP_LINEAR ? 2 : 1;
-
-														uint32_t tdesiredMip = desiredMip;
-														uint32_t tmipWidth   = mipWidth;
-														float tuvScale       = uvScale;
-
-														for ( uint32_t it = 0; it < itCount; it++ )
-														{
-															if ( Debug.textureFilteringMode == TEXTURE_FILTERING_POINT )
-															{
-																//--------------------------------
-																// Mipmap stuff
-																//--------------------------------
-																int32_t iy = (int32_t)(pxv[r][c] * uvScale);
-																int32_t ix = (int32_t)(pxu[r][c] * uvScale);
-													
-																if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_LINEAR )
-																{
-																	color[it] = submesh->texture->mipData[desiredMip][iy * mipWidth + ix];
-																	assert ( ix < (int32_t)mipWidth && iy < (int32_t)mipWidth && ix >= 0 && iy >= 0 );
-																}
-																else if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_TILED )
-																{
-																	uint32_t tileidx = (iy >> 2) * (mipWidth >> 2) + (ix >> 2);
-																	uint32_t pixidx  = ((iy & 3) << 2) + (ix & 3);
-																	color[it] = submesh->texture->mipData[desiredMip][(tileidx << 4) + pixidx];
-																}
-																else if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
-																{
-																	if ( !(Debug.flags & FLAG_FILTER_LUT ) )
-																	{
-																		uint32_t swizIdx;
-										
-																		// yxyx yxyx yxyx yxyx yxyx yxyx yxyx yxyx
-																		swizIdx = 0;
-
-																		//    0000 0000 0000 0000 xxxx xxxx xxxx xxxx
-																		// => 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x
-																		for ( uint32_t i = 0; i < 16; i++ )
-																		{
-																			swizIdx |= ((ix & (1<<(i))) << (i));
-																			swizIdx |= ((iy & (1<<(i))) << (i+1));
-																		}
-																		color[it] = submesh->texture->mipData[desiredMip][swizIdx];
-																	}
-																	else
-																	{
-																		uint32_t swizIdx;
-
-																		// xxxx => 0x0x 0x0x
-																		static const uint32_t mortonLUT[] = {
-																			0x00, // 0000 (0x0) => 0000 0000 (0x00)
-																			0x01, // 0001 (0x1) => 0000 0001 (0x01)
-																			0x04, // 0010 (0x2) => 0000 0100 (0x04)
-																			0x05, // 0011 (0x3) => 0000 0101 (0x05)
-																			0x10, // 0100 (0x4) => 0001 0000 (0x10)
-																			0x11, // 0101 (0x5) => 0001 0001 (0x11)
-																			0x14, // 0110 (0x6) => 0001 0100 (0x14)
-																			0x15, // 0111 (0x7) => 0001 0101 (0x15)
-																			0x40, // 1000 (0x8) => 0100 0000 (0x40)
-																			0x41, // 1001 (0x9) => 0100 0001 (0x41)
-																			0x44, // 1010 (0xA) => 0100 0100 (0x44)
-																			0x45, // 1011 (0xB) => 0100 0101 (0x45)
-																			0x50, // 1100 (0xC) => 0101 0000 (0x50)
-																			0x51, // 1101 (0xD) => 0101 0001 (0x51)
-																			0x54, // 1110 (0xE) => 0101 0100 (0x54)
-																			0x55, // 1111 (0xF) => 0101 0101 (0x55)
-																		};
-
-																		uint32_t swizX   = mortonLUT[(ix    ) & 0xF]
-																						| (mortonLUT[(ix>> 4) & 0xF] <<  8)
-																						| (mortonLUT[(ix>> 8) & 0xF] << 16)
-																						| (mortonLUT[(ix>>12) & 0xF] << 24);
-																		uint32_t swizY   = mortonLUT[(iy    ) & 0xF]
-																						| (mortonLUT[(iy>> 4) & 0xF] <<  8)
-																						| (mortonLUT[(iy>> 8) & 0xF] << 16)
-																						| (mortonLUT[(iy>>12) & 0xF] << 24);
-																					swizIdx = swizX | (swizY<<1);
-
-																		color[it] = submesh->texture->mipData[desiredMip][swizIdx];
-																	}
-																}
-															}
-															else if ( Debug.textureFilteringMode == TEXTURE_FILTERING_BILINEAR )
-															{
-																float fx = pxu[r][c] * uvScale;
-																float fy = pxv[r][c] * uvScale;
-															
-																int32_t ix1 = ((int32_t)(fx)) & (mipWidth-1);
-																int32_t iy1 = ((int32_t)(fy)) & (mipWidth-1);
-																int32_t ix2 = (ix1 + 1)       & (mipWidth-1);
-																int32_t iy2 = (iy1 + 1)       & (mipWidth-1);
-
-																uint32_t c00, c01, c10, c11;
-
-																if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_LINEAR )
-																{
-																	c00 = submesh->texture->mipData[desiredMip][iy1 * mipWidth + ix1];
-																	c01 = submesh->texture->mipData[desiredMip][iy1 * mipWidth + ix2];
-																	c10 = submesh->texture->mipData[desiredMip][iy2 * mipWidth + ix1];
-																	c11 = submesh->texture->mipData[desiredMip][iy2 * mipWidth + ix2];
-																}
-																else if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_TILED )
-																{
-																	uint32_t tileidx = (iy1 >> 2) * (mipWidth >> 2) + (ix1 >> 2);
-																	uint32_t pixidx  = ((iy1 & 3) << 2) + (ix1 & 3);
-																	c00 = submesh->texture->mipData[desiredMip][(tileidx << 4) + pixidx];
-																	tileidx = (iy1 >> 2) * (mipWidth >> 2) + (ix2 >> 2);
-																	pixidx  = ((iy1 & 3) << 2) + (ix2 & 3);
-																	c01 = submesh->texture->mipData[desiredMip][(tileidx << 4) + pixidx];
-																	tileidx = (iy2 >> 2) * (mipWidth >> 2) + (ix1 >> 2);
-																	pixidx  = ((iy2 & 3) << 2) + (ix1 & 3);
-																	c10 = submesh->texture->mipData[desiredMip][(tileidx << 4) + pixidx];
-																	tileidx = (iy2 >> 2) * (mipWidth >> 2) + (ix2 >> 2);
-																	pixidx  = ((iy2 & 3) << 2) + (ix2 & 3);
-																	c11 = submesh->texture->mipData[desiredMip][(tileidx << 4) + pixidx];
-																}
-																else if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
-																{
-																	if ( !(Debug.flags & FLAG_FILTER_LUT ) )
-																	{
-																		uint32_t swizIdx;
-										
-																		//    yxyx yxyx yxyx yxyx yxyx yxyx yxyx yxyx
-																		//    0000 0000 0000 0000 xxxx xxxx xxxx xxxx
-																		// => 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x
-																		swizIdx = 0;
-																		for ( uint32_t i = 0; i < 16; i++ )
-																		{
-																			swizIdx |= ((ix1 & (1<<(i))) << (i));
-																			swizIdx |= ((iy1 & (1<<(i))) << (i+1));
-																		}
-																		c00 = submesh->texture->mipData[desiredMip][swizIdx];
-																		swizIdx = 0;
-																		for ( uint32_t i = 0; i < 16; i++ )
-																		{
-																			swizIdx |= ((ix2 & (1<<(i))) << (i));
-																			swizIdx |= ((iy1 & (1<<(i))) << (i+1));
-																		}
-																		c01 = submesh->texture->mipData[desiredMip][swizIdx];
-																		swizIdx = 0;
-																		for ( uint32_t i = 0; i < 16; i++ )
-																		{
-																			swizIdx |= ((ix1 & (1<<(i))) << (i));
-																			swizIdx |= ((iy2 & (1<<(i))) << (i+1));
-																		}
-																		c10 = submesh->texture->mipData[desiredMip][swizIdx];
-																		swizIdx = 0;
-																		for ( uint32_t i = 0; i < 16; i++ )
-																		{
-																			swizIdx |= ((ix2 & (1<<(i))) << (i));
-																			swizIdx |= ((iy2 & (1<<(i))) << (i+1));
-																		}
-																		c11 = submesh->texture->mipData[desiredMip][swizIdx];
-																	}
-																	else
-																	{
-																		uint32_t swizIdx;
-
-																		// xxxx => 0x0x 0x0x
-																		static const uint32_t mortonLUT[] = {
-																			0x00, // 0000 (0x0) => 0000 0000 (0x00)
-																			0x01, // 0001 (0x1) => 0000 0001 (0x01)
-																			0x04, // 0010 (0x2) => 0000 0100 (0x04)
-																			0x05, // 0011 (0x3) => 0000 0101 (0x05)
-																			0x10, // 0100 (0x4) => 0001 0000 (0x10)
-																			0x11, // 0101 (0x5) => 0001 0001 (0x11)
-																			0x14, // 0110 (0x6) => 0001 0100 (0x14)
-																			0x15, // 0111 (0x7) => 0001 0101 (0x15)
-																			0x40, // 1000 (0x8) => 0100 0000 (0x40)
-																			0x41, // 1001 (0x9) => 0100 0001 (0x41)
-																			0x44, // 1010 (0xA) => 0100 0100 (0x44)
-																			0x45, // 1011 (0xB) => 0100 0101 (0x45)
-																			0x50, // 1100 (0xC) => 0101 0000 (0x50)
-																			0x51, // 1101 (0xD) => 0101 0001 (0x51)
-																			0x54, // 1110 (0xE) => 0101 0100 (0x54)
-																			0x55, // 1111 (0xF) => 0101 0101 (0x55)
-																		};
-
-																		uint32_t swizX   = mortonLUT[(ix1    ) & 0xF]
-																						| (mortonLUT[(ix1>> 4) & 0xF] <<  8)
-																						| (mortonLUT[(ix1>> 8) & 0xF] << 16)
-																						| (mortonLUT[(ix1>>12) & 0xF] << 24);
-																		uint32_t swizY   = mortonLUT[(iy1    ) & 0xF]
-																						| (mortonLUT[(iy1>> 4) & 0xF] <<  8)
-																						| (mortonLUT[(iy1>> 8) & 0xF] << 16)
-																						| (mortonLUT[(iy1>>12) & 0xF] << 24);
-																					swizIdx = swizX | (swizY<<1);
-
-																		c00 = submesh->texture->mipData[desiredMip][swizIdx];
-
-																		swizX    = mortonLUT[(ix2    ) & 0xF]
-																				| (mortonLUT[(ix2>> 4) & 0xF] <<  8)
-																				| (mortonLUT[(ix2>> 8) & 0xF] << 16)
-																				| (mortonLUT[(ix2>>12) & 0xF] << 24);
-																		swizY    = mortonLUT[(iy1    ) & 0xF]
-																				| (mortonLUT[(iy1>> 4) & 0xF] <<  8)
-																				| (mortonLUT[(iy1>> 8) & 0xF] << 16)
-																				| (mortonLUT[(iy1>>12) & 0xF] << 24);
-																			swizIdx = swizX | (swizY<<1);
-
-																		c01 = submesh->texture->mipData[desiredMip][swizIdx];
-
-																		swizX    = mortonLUT[(ix1    ) & 0xF]
-																				| (mortonLUT[(ix1>> 4) & 0xF] <<  8)
-																				| (mortonLUT[(ix1>> 8) & 0xF] << 16)
-																				| (mortonLUT[(ix1>>12) & 0xF] << 24);
-																		swizY    = mortonLUT[(iy2    ) & 0xF]
-																				| (mortonLUT[(iy2>> 4) & 0xF] <<  8)
-																				| (mortonLUT[(iy2>> 8) & 0xF] << 16)
-																				| (mortonLUT[(iy2>>12) & 0xF] << 24);
-																			swizIdx = swizX | (swizY<<1);
-
-																		c10 = submesh->texture->mipData[desiredMip][swizIdx];
-
-																		swizX    = mortonLUT[(ix2    ) & 0xF]
-																				| (mortonLUT[(ix2>> 4) & 0xF] <<  8)
-																				| (mortonLUT[(ix2>> 8) & 0xF] << 16)
-																				| (mortonLUT[(ix2>>12) & 0xF] << 24);
-																		swizY    = mortonLUT[(iy2    ) & 0xF]
-																				| (mortonLUT[(iy2>> 4) & 0xF] <<  8)
-																				| (mortonLUT[(iy2>> 8) & 0xF] << 16)
-																				| (mortonLUT[(iy2>>12) & 0xF] << 24);
-																			swizIdx = swizX | (swizY<<1);
-
-																		c11 = submesh->texture->mipData[desiredMip][swizIdx];
-																	}
-																}
-																else
-																	c00 = 0xFF00FF, c01 = 0xFFFFFFFF, c10 = 0xFFFFFFFF, c11 = 0xFF00FF;
-															
-																uint32_t fracXFactor = (uint32_t)((fx - ix1) * 65536);
-																uint32_t fracYFactor = (uint32_t)((fy - iy1) * 65536);
-															
-																uint8_t cr =
-																		(((65536 - fracYFactor) * ((((65536 - fracXFactor) * (c00 & 0xFF)) + ((fracXFactor) * (c01 & 0xFF))) >> 16)) >> 16)
-																	+ (((        fracYFactor) * ((((65536 - fracXFactor) * (c10 & 0xFF)) + ((fracXFactor) * (c11 & 0xFF))) >> 16)) >> 16);
-																uint8_t cg =
-																		(((65536 - fracYFactor) * ((((65536 - fracXFactor) * ((c00>>8) & 0xFF)) + ((fracXFactor) * ((c01>>8) & 0xFF))) >> 16)) >> 16)
-																	+ (((        fracYFactor) * ((((65536 - fracXFactor) * ((c10>>8) & 0xFF)) + ((fracXFactor) * ((c11>>8) & 0xFF))) >> 16)) >> 16);
-																uint8_t cb =
-																		(((65536 - fracYFactor) * ((((65536 - fracXFactor) * ((c00>>16) & 0xFF)) + ((fracXFactor) * ((c01>>16) & 0xFF))) >> 16)) >> 16)
-																	+ (((        fracYFactor) * ((((65536 - fracXFactor) * ((c10>>16) & 0xFF)) + ((fracXFactor) * ((c11>>16) & 0xFF))) >> 16)) >> 16);
-															
-																uint32_t blendedColor = (cb<<16) | (cg<<8) | (cr);
-															
-																color[it] = blendedColor;
-															}
-
-															desiredMip = desiredMip2;
-															mipWidth   = (submesh->texture->width >> desiredMip);
-															uvScale    = 1.0f / (1<<desiredMip);
-														}
-
-														desiredMip = tdesiredMip;
-														mipWidth   = tmipWidth;
-														uvScale    = tuvScale;
-
-														if ( Debug.textureMipmapMode == TEXTURE_MIPMAP_LINEAR )
-														{
-															uint32_t f2 = (uint32_t)(mipT * 65536);
-															uint32_t f1 = 65536 - f2;
-
-															//(color[0] * f1 + color[1] * f2) >> 16
-
-															uint8_t cr = (f1 * ((color[0]    )&0xFF) + f2 * ((color[1]    )&0xFF))>>16;
-															uint8_t cg = (f1 * ((color[0]>>8 )&0xFF) + f2 * ((color[1]>>8 )&0xFF))>>16;
-															uint8_t cb = (f1 * ((color[0]>>16)&0xFF) + f2 * ((color[1]>>16)&0xFF))>>16;
-
-															*ptr[r][c] = (cb<<16) | (cg<<8) | (cr);
-														}
-														else
-														{
-															*ptr[r][c] = color[0];
-														}
-													}
-													else
-														*ptr[r][c] = 0xFF00FF;
-												}
-											}
-										}
-									}
-								}
-							}
-						}
-					}
+// Fetches texels for both quads, each from its own mip level; masked off lanes aren't read
+static __m256i __softrast_gather_avx2 ( const uint32_t* const mipData[2], __m256i index, __m256i mask )
+{
+	const __m128i a = _mm_mask_i32gather_epi32 ( _mm_setzero_si128 ( ), (const int*)mipData[0], _mm256_castsi256_si128 ( index ), _mm256_castsi256_si128 ( mask ), 4 );
+	const __m128i b = _mm_mask_i32gather_epi32 ( _mm_setzero_si128 ( ), (const int*)mipData[1], _mm256_extracti128_si256 ( index, 1 ), _mm256_extracti128_si256 ( mask, 1 ), 4 );
+	return _mm256_inserti128_si256 ( _mm256_castsi128_si256 ( a ), b, 1 );
+}
 
-					//--------------------------------
-					// Reset outline table
-					//--------------------------------
-#if AOS_OUTLINE_TABLE
-					outline_table_entry* outline = globalData.outlineTable + minTriY;
-					for ( int32_t y = minTriY; y <= maxTriY; y++, outline++ )
-					{
-						outline->flags = 0;
-						outline->minX = (float)globalData.renderTarget.width;
-						outline->maxX = 0.0f;
-					}
-#else
-					float* outlineMinX = globalData.outlineTable.minX + minTriY;
-					float* outlineMaxX = globalData.outlineTable.maxX + minTriY;
-					for ( int32_t y = minTriY; y <= maxTriY; y++, outlineMinX++, outlineMaxX++ )
-					{
-						*outlineMinX = (float)globalData.renderTarget.width;
-						*outlineMaxX = 0.0f;
-					}
-#endif
-				}
-#pragma endregion
-				else if ( Debug.flags & FLAG_RASTERIZE )
-#pragma region Pixel rasterization
-				{
-					//--------------------------------
-					// Rasterize time
-					//--------------------------------
-#if AOS_OUTLINE_TABLE
-					outline_table_entry* outline = globalData.outlineTable + minTriY;
-					uint32_t* colorRowPtr        = (uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - minTriY - 1) * globalData.renderTarget.pitch);
-					float* depthRowPtr           = globalData.renderTarget.depthBuffer + minTriY * globalData.renderTarget.width;
-					for ( int32_t y = minTriY; y <= maxTriY; y++, outline++, depthRowPtr += globalData.renderTarget.width )
-#else
-					float* outlineMinX    = globalData.outlineTable.minX + minTriY;
-					float* outlineMaxX    = globalData.outlineTable.maxX + minTriY;
-					float* outlineMinZ    = globalData.outlineTable.minZ + minTriY;
-					float* outlineMaxZ    = globalData.outlineTable.maxZ + minTriY;
-					float* outlineMinU    = globalData.outlineTable.minU + minTriY;
-					float* outlineMaxU    = globalData.outlineTable.maxU + minTriY;
-					float* outlineMinV    = globalData.outlineTable.minV + minTriY;
-					float* outlineMaxV    = globalData.outlineTable.maxV + minTriY;
-					uint32_t* colorRowPtr = (uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - minTriY - 1) * globalData.renderTarget.pitch);
-					float* depthRowPtr    = globalData.renderTarget.depthBuffer + minTriY * globalData.renderTarget.width;
-					for ( int32_t y = minTriY; y <= maxTriY; y++, outlineMinX++, outlineMaxX++, outlineMinZ++, outlineMaxZ++, outlineMinU++, outlineMinV++, outlineMaxU++, outlineMaxV++, depthRowPtr += globalData.renderTarget.width )
-#endif
-					{
-#if AOS_OUTLINE_TABLE
-						uint32_t* ptr     = colorRowPtr + (uint32_t)outline->minX;
-						uint32_t* endptr  = colorRowPtr + (uint32_t)outline->maxX;
-						float* zptr       = depthRowPtr + (uint32_t)outline->minX;
-						float* endzptr    = depthRowPtr + (uint32_t)outline->maxX;
-						float x1 = outline->minX;
-						float x2 = outline->maxX;
-#else
-						uint32_t* ptr     = colorRowPtr + (uint32_t)*outlineMinX;
-						uint32_t* endptr  = colorRowPtr + (uint32_t)*outlineMaxX;
-						float* zptr       = depthRowPtr + (uint32_t)*outlineMinX;
-						float* endzptr    = depthRowPtr + (uint32_t)*outlineMaxX;
-						float x1 = *outlineMinX;
-						float x2 = *outlineMaxX;
-#endif
+// Fetches the texels at (ix, iy) for both quads: gathered for RGBA8, decoded lane by lane through the block cache for compressed textures
+static __forceinline __m256i __softrast_fetch_avx2 ( const softrast_texture* texture, const uint32_t level[2], const uint32_t* const mipData[2], __m256i ix, __m256i iy, __m256i mipWidth8, __m256i mask, const int textureAddressingMode )
+{
+	if ( texture->format == SOFTRAST_TEXTURE_FORMAT_RGBA8 )
+		return __softrast_gather_avx2 ( mipData, __softrast_texel_index_avx2 ( ix, iy, mipWidth8, textureAddressingMode ), mask );
+
+	uint32_t x[8], y[8], texels[8];
+	_mm256_storeu_si256 ( (__m256i*)x, ix );
+	_mm256_storeu_si256 ( (__m256i*)y, iy );
+	const uint32_t active = _mm256_movemask_ps ( _mm256_castsi256_ps ( mask ) );
+	for ( uint32_t i = 0; i < 8; i++ )
+		texels[i] = (active & (1 << i)) ? softrast_fetch_compressed ( texture, level[i >> 2], x[i], y[i] ) : 0;
+	return _mm256_loadu_si256 ( (const __m256i*)texels );
+}
 
-						//assert ( x1 > 10.0f );
+// Samples one mip level per quad with point or bilinear filtering. u and v are in top level texels
+static __forceinline __m256i __softrast_sample_avx2 ( const softrast_texture* texture, const uint32_t level[2], __m256 u8, __m256 v8, __m256i mask, const int textureAddressingMode, const int textureFilteringMode )
+{
+	const uint32_t* const mipData[2] = { texture->mipData[level[0]], texture->mipData[level[1]] };
+	const __m256i mipWidth8 = _mm256_setr_epi32 ( texture->width >> level[0], texture->width >> level[0], texture->width >> level[0], texture->width >> level[0],
+	                                              texture->width >> level[1], texture->width >> level[1], texture->width >> level[1], texture->width >> level[1] );
+	const __m256  uvScale8  = _mm256_setr_ps ( 1.0f / (1<<level[0]), 1.0f / (1<<level[0]), 1.0f / (1<<level[0]), 1.0f / (1<<level[0]),
+	                                           1.0f / (1<<level[1]), 1.0f / (1<<level[1]), 1.0f / (1<<level[1]), 1.0f / (1<<level[1]) );
 
-#if AOS_OUTLINE_TABLE
-						float z1 = outline->minZ;
-						float z2 = outline->maxZ;
+	const __m256 fx = _mm256_mul_ps ( u8, uvScale8 );
+	const __m256 fy = _mm256_mul_ps ( v8, uvScale8 );
 
-						float u1 = outline->minU;
-						float u2 = outline->maxU;
-						float v1 = outline->minV;
-						float v2 = outline->maxV;
-#else
-						float z1 = *outlineMinZ;
-						float z2 = *outlineMaxZ;
+	//--------------------------------
+	// Fetch the texel, or the 2x2 footprint, wrapping around the edges of the level
+	//--------------------------------
+	const __m256i tx   = _mm256_cvttps_epi32 ( fx );
+	const __m256i ty   = _mm256_cvttps_epi32 ( fy );
+	const __m256i wrap = _mm256_sub_epi32 ( mipWidth8, _mm256_set1_epi32 ( 1 ) );
+	const __m256i ix1  = _mm256_and_si256 ( tx, wrap );
+	const __m256i iy1  = _mm256_and_si256 ( ty, wrap );
 
-						float u1 = *outlineMinU;
-						float u2 = *outlineMaxU;
-						float v1 = *outlineMinV;
-						float v2 = *outlineMaxV;
-#endif
+	if ( textureFilteringMode != TEXTURE_FILTERING_BILINEAR )
+		return __softrast_fetch_avx2 ( texture, level, mipData, ix1, iy1, mipWidth8, mask, textureAddressingMode );
 
-						float dx = (x2 - x1);//+(Debug.flags & FLAG_DERP ? 1 : 0);
-						float dz = (z2 - z1) / dx;
-						float du = (u2 - u1) / dx;
-						float dv = (v2 - v1) / dx;
-
-						//if ( Debug.flags & FLAG_DERP2 )
-						//{
-						//	int32_t ix1  = (int32_t)x1 + 1;
-						//	float subtex = ix1 - x1;
-						//
-						//	z1 += subtex * dz;
-						//	u1 += subtex * du;
-						//	v1 += subtex * dv;
-						//}
+	const __m256i ix2  = _mm256_and_si256 ( _mm256_add_epi32 ( ix1, _mm256_set1_epi32 ( 1 ) ), wrap );
+	const __m256i iy2  = _mm256_and_si256 ( _mm256_add_epi32 ( iy1, _mm256_set1_epi32 ( 1 ) ), wrap );
 
-#if 0
-						// Faster, but causes extremely jumpy textures. Avoid using!
-						float z = z1;
-						float u = u1;
-						float v = v1;
-						for ( ; ptr <= endptr; ptr++, zptr++, z += dz, u += du, v += dv )
-						{
-#else
-						for ( int32_t xinc = 0; ptr <= endptr; ptr++, zptr++, xinc++ )
-						{
-							float z = z1 + xinc * dz;
-							float u = u1 + xinc * du;
-							float v = v1 + xinc * dv;
-#endif
-							if ( !(Debug.flags & FLAG_DEPTH_TESTING) || z > *zptr )
-							{
-								if ( Debug.renderMode == RENDER_MODE_FLAT_COLOR )
-									*ptr = 0xFFFF0000;
-								else if ( Debug.renderMode == RENDER_MODE_UV )
-								{
-									float fx = u * (1.0f/z);
-									float fy = v * (1.0f/z);
-									fx = fx - (int32_t)fx;
-									fy = fy - (int32_t)fy;
-									*ptr = (((uint8_t)(fx * 256.0f))<<16) | (((uint8_t)(fy * 256.0f))<<8);
-								}
-								else if ( Debug.renderMode == RENDER_MODE_ZBUFFER )
-									*ptr = (uint32_t)((1.0f-((1.0f/z)-globalData.nearClip)/(globalData.farClip-globalData.nearClip)) * 255.0f);
-								else if ( Debug.renderMode == RENDER_MODE_TEXTURED )
-								{
-									if ( submesh->texture )
-									{
-										float fx = u * (1.0f/z);
-										float fy = v * (1.0f/z);
-										int32_t ix = (int32_t)((fx - (int32_t)fx) * submesh->texture->width );
-										int32_t iy = (int32_t)((fy - (int32_t)fy) * submesh->texture->height);
-										assert ( ix >= 0 && ix < submesh->texture->width );
-										assert ( iy >= 0 && iy < submesh->texture->height );
-
-										if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_LINEAR )
-										{
-											*ptr = submesh->texture->mipData[0][iy * submesh->texture->width + ix];
-										}
-										else if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_TILED )
-										{
-											uint32_t tileidx = (iy >> 2) * (submesh->texture->width >> 2) + (ix >> 2);
-											uint32_t pixidx  = ((iy & 3) << 2) + (ix & 3);
-											*ptr = submesh->texture->mipData[0][(tileidx << 4) + pixidx];
-										}
-										else if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
-										{
-											if ( !(Debug.flags & FLAG_FILTER_LUT) )
-											{
-												uint32_t swizIdx;
-										
-												// yxyx yxyx yxyx yxyx yxyx yxyx yxyx yxyx
-												swizIdx = 0;
-
-												//    0000 0000 0000 0000 xxxx xxxx xxxx xxxx
-												// => 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x
-												for ( uint32_t i = 0; i < 16; i++ )
-												{
-													swizIdx |= ((ix & (1<<(i))) << (i));
-													swizIdx |= ((iy & (1<<(i))) << (i+1));
-												}
-												*ptr = submesh->texture->mipData[0][swizIdx];
-											}
-											else
-											{
-												uint32_t swizIdx;
-
-												// xxxx => 0x0x 0x0x
-												static const uint32_t mortonLUT[] = {
-													0x00, // 0000 (0x0) => 0000 0000 (0x00)
-													0x01, // 0001 (0x1) => 0000 0001 (0x01)
-													0x04, // 0010 (0x2) => 0000 0100 (0x04)
-													0x05, // 0011 (0x3) => 0000 0101 (0x05)
-													0x10, // 0100 (0x4) => 0001 0000 (0x10)
-													0x11, // 0101 (0x5) => 0001 0001 (0x11)
-													0x14, // 0110 (0x6) => 0001 0100 (0x14)
-													0x15, // 0111 (0x7) => 0001 0101 (0x15)
-													0x40, // 1000 (0x8) => 0100 0000 (0x40)
-													0x41, // 1001 (0x9) => 0100 0001 (0x41)
-													0x44, // 1010 (0xA) => 0100 0100 (0x44)
-													0x45, // 1011 (0xB) => 0100 0101 (0x45)
-													0x50, // 1100 (0xC) => 0101 0000 (0x50)
-													0x51, // 1101 (0xD) => 0101 0001 (0x51)
-													0x54, // 1110 (0xE) => 0101 0100 (0x54)
-													0x55, // 1111 (0xF) => 0101 0101 (0x55)
-												};
-
-												uint32_t swizX   = mortonLUT[(ix    ) & 0xF]
-																| (mortonLUT[(ix>> 4) & 0xF] <<  8)
-																| (mortonLUT[(ix>> 8) & 0xF] << 16)
-																| (mortonLUT[(ix>>12) & 0xF] << 24);
-												uint32_t swizY   = mortonLUT[(iy    ) & 0xF]
-																| (mortonLUT[(iy>> 4) & 0xF] <<  8)
-																| (mortonLUT[(iy>> 8) & 0xF] << 16)
-																| (mortonLUT[(iy>>12) & 0xF] << 24);
-															swizIdx = swizX | (swizY<<1);
-
-												*ptr = submesh->texture->mipData[0][swizIdx];
-											}
-										}
-									}
-									else
-										*ptr = 0xFF00FF;
-								}
-								//else if ( Debug.renderMode == RENDER_MODE_TEXTURE_BILINEAR )
-								//{
-								//	if ( submesh->texture )
-								//	{
-								//		float fx = (u * (1.0f/z));
-								//		float fy = (v * (1.0f/z));
-								//		fx = (fx - (int32_t)fx) * submesh->texture->width;
-								//		fy = (fy - (int32_t)fy) * submesh->texture->height;
-								//
-								//		int32_t ix1 = ((int32_t)(fx)) & (submesh->texture->width -1);
-								//		int32_t iy1 = ((int32_t)(fy)) & (submesh->texture->height-1);
-								//		int32_t ix2 = (ix1 + 1)                                  & (submesh->texture->width -1);
-								//		int32_t iy2 = (iy1 + 1)                                  & (submesh->texture->height-1);
-								//
-								//		uint32_t fracXFactor = (uint32_t)((fx - ix1) * 65536);
-								//		uint32_t fracYFactor = (uint32_t)((fy - iy1) * 65536);
-								//
-								//		uint32_t c00 = submesh->texture->mipData[0][iy1 * submesh->texture->width + ix1];
-								//		uint32_t c01 = submesh->texture->mipData[0][iy1 * submesh->texture->width + ix2];
-								//		uint32_t c10 = submesh->texture->mipData[0][iy2 * submesh->texture->width + ix1];
-								//		uint32_t c11 = submesh->texture->mipData[0][iy2 * submesh->texture->width + ix2];
-								//
-								//		uint8_t r =
-								//			  (((65536 - fracYFactor) * ((((65536 - fracXFactor) * (c00 & 0xFF)) + ((fracXFactor) * (c01 & 0xFF))) >> 16)) >> 16)
-								//			+ (((        fracYFactor) * ((((65536 - fracXFactor) * (c10 & 0xFF)) + ((fracXFactor) * (c11 & 0xFF))) >> 16)) >> 16);
-								//		uint8_t g =
-								//			  (((65536 - fracYFactor) * ((((65536 - fracXFactor) * ((c00>>8) & 0xFF)) + ((fracXFactor) * ((c01>>8) & 0xFF))) >> 16)) >> 16)
-								//			+ (((        fracYFactor) * ((((65536 - fracXFactor) * ((c10>>8) & 0xFF)) + ((fracXFactor) * ((c11>>8) & 0xFF))) >> 16)) >> 16);
-								//		uint8_t b =
-								//			  (((65536 - fracYFactor) * ((((65536 - fracXFactor) * ((c00>>16) & 0xFF)) + ((fracXFactor) * ((c01>>16) & 0xFF))) >> 16)) >> 16)
-								//			+ (((        fracYFactor) * ((((65536 - fracXFactor) * ((c10>>16) & 0xFF)) + ((fracXFactor) * ((c11>>16) & 0xFF))) >> 16)) >> 16);
-								//
-								//		uint32_t color = (b<<16) | (g<<8) | (r);
-								//
-								//		*ptr = color;
-								//	}
-								//	else
-								//		*ptr = 0xFF00FF;
-								//}
-								*zptr = z;
-							}
-						}
+	const __m256i c00 = __softrast_fetch_avx2 ( texture, level, mipData, ix1, iy1, mipWidth8, mask, textureAddressingMode );
+	const __m256i c01 = __softrast_fetch_avx2 ( texture, level, mipData, ix2, iy1, mipWidth8, mask, textureAddressingMode );
+	const __m256i c10 = __softrast_fetch_avx2 ( texture, level, mipData, ix1, iy2, mipWidth8, mask, textureAddressingMode );
+	const __m256i c11 = __softrast_fetch_avx2 ( texture, level, mipData, ix2, iy2, mipWidth8, mask, textureAddressingMode );
 
-						colorRowPtr = (uint32_t*)((uintptr_t)colorRowPtr - globalData.renderTarget.pitch);
-					}
+	//--------------------------------
+	// Blend with Q15 weights, taken from the unwrapped coordinates like __softrast_sample_level_sse
+	//--------------------------------
+	const __m256i fracX = _mm256_cvttps_epi32 ( _mm256_mul_ps ( _mm256_sub_ps ( fx, _mm256_cvtepi32_ps ( tx ) ), _mm256_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	const __m256i fracY = _mm256_cvttps_epi32 ( _mm256_mul_ps ( _mm256_sub_ps ( fy, _mm256_cvtepi32_ps ( ty ) ), _mm256_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	return softrast_bilinear_avx2 ( c00, c01, c10, c11, fracX, fracY );
+}
 
-					//--------------------------------
-					// Reset outline table
-					//--------------------------------
-#if AOS_OUTLINE_TABLE
-					outline = globalData.outlineTable + minTriY;
-					for ( int32_t y = minTriY; y <= maxTriY; y++, outline++ )
-					{
-						outline->flags = 0;
-						outline->minX  = (float)globalData.renderTarget.width;
-						outline->maxX  = 0.0f;
-					}
-#else
-					outlineMinX = globalData.outlineTable.minX + minTriY;
-					outlineMaxX = globalData.outlineTable.maxX + minTriY;
-					for ( int32_t y = minTriY; y <= maxTriY; y++, outlineMinX++, outlineMaxX++ )
-					{
-						*outlineMinX = (float)globalData.renderTarget.width;
-						*outlineMaxX = 0.0f;
-					}
-#endif
+// Samples coarse quads, whose lanes all hold the same UV, with one gather for their whole bilinear footprint: lane (r * 2 + c) of a quad
+// fetches texel (c, r), then the texels are blended across the quad, which leaves every lane with the color of the block. u and v are in top
+// level texels
+static __forceinline __m256i __softrast_sample_coarse_avx2 ( const softrast_texture* texture, const uint32_t level[2], __m256 u8, __m256 v8, __m256i mask, const int textureAddressingMode, const int textureFilteringMode )
+{
+	if ( textureFilteringMode != TEXTURE_FILTERING_BILINEAR )
+		return __softrast_sample_avx2 ( texture, level, u8, v8, mask, textureAddressingMode, textureFilteringMode );
+
+	const uint32_t* const mipData[2] = { texture->mipData[level[0]], texture->mipData[level[1]] };
+	const __m256i mipWidth8 = _mm256_setr_epi32 ( texture->width >> level[0], texture->width >> level[0], texture->width >> level[0], texture->width >> level[0],
+	                                              texture->width >> level[1], texture->width >> level[1], texture->width >> level[1], texture->width >> level[1] );
+	const __m256  uvScale8  = _mm256_setr_ps ( 1.0f / (1<<level[0]), 1.0f / (1<<level[0]), 1.0f / (1<<level[0]), 1.0f / (1<<level[0]),
+	                                           1.0f / (1<<level[1]), 1.0f / (1<<level[1]), 1.0f / (1<<level[1]), 1.0f / (1<<level[1]) );
+
+	const __m256 fx = _mm256_mul_ps ( u8, uvScale8 );
+	const __m256 fy = _mm256_mul_ps ( v8, uvScale8 );
+
+	//--------------------------------
+	// Fetch the 2x2 footprint, one texel per lane, wrapping around the edges of the level
+	//--------------------------------
+	const __m256i tx   = _mm256_cvttps_epi32 ( fx );
+	const __m256i ty   = _mm256_cvttps_epi32 ( fy );
+	const __m256i wrap = _mm256_sub_epi32 ( mipWidth8, _mm256_set1_epi32 ( 1 ) );
+	const __m256i ix1  = _mm256_and_si256 ( tx, wrap );
+	const __m256i iy1  = _mm256_and_si256 ( ty, wrap );
+	const __m256i ix   = _mm256_and_si256 ( _mm256_add_epi32 ( ix1, _mm256_setr_epi32 ( 0, 1, 0, 1, 0, 1, 0, 1 ) ), wrap );
+	const __m256i iy   = _mm256_and_si256 ( _mm256_add_epi32 ( iy1, _mm256_setr_epi32 ( 0, 0, 1, 1, 0, 0, 1, 1 ) ), wrap );
+
+	const __m256i texel = __softrast_fetch_avx2 ( texture, level, mipData, ix, iy, mipWidth8, mask, textureAddressingMode );
+
+	//--------------------------------
+	// Hand every lane the whole footprint of its quad, and blend it like __softrast_sample_avx2 does
+	//--------------------------------
+	const __m256i fracX = _mm256_cvttps_epi32 ( _mm256_mul_ps ( _mm256_sub_ps ( fx, _mm256_cvtepi32_ps ( tx ) ), _mm256_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	const __m256i fracY = _mm256_cvttps_epi32 ( _mm256_mul_ps ( _mm256_sub_ps ( fy, _mm256_cvtepi32_ps ( ty ) ), _mm256_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	return softrast_bilinear_avx2 ( _mm256_shuffle_epi32 ( texel, _MM_SHUFFLE ( 0, 0, 0, 0 ) ), _mm256_shuffle_epi32 ( texel, _MM_SHUFFLE ( 1, 1, 1, 1 ) ),
+	                                _mm256_shuffle_epi32 ( texel, _MM_SHUFFLE ( 2, 2, 2, 2 ) ), _mm256_shuffle_epi32 ( texel, _MM_SHUFFLE ( 3, 3, 3, 3 ) ), fracX, fracY );
+}
+
+// Samples the pixels in sampleMask on their own, and the coarse quads in coarseMask once each
+static __forceinline __m256i __softrast_sample_quads_avx2 ( const softrast_texture* texture, const uint32_t level[2], __m256 u8, __m256 v8, __m256i sampleMask, __m256i coarseMask, const int textureAddressingMode, const int textureFilteringMode )
+{
+	__m256i color = _mm256_setzero_si256 ( );
+	if ( !_mm256_testz_si256 ( sampleMask, sampleMask ) )
+		color = __softrast_sample_avx2 ( texture, level, u8, v8, sampleMask, textureAddressingMode, textureFilteringMode );
+	if ( !_mm256_testz_si256 ( coarseMask, coarseMask ) )
+		color = _mm256_blendv_epi8 ( color, __softrast_sample_coarse_avx2 ( texture, level, u8, v8, coarseMask, textureAddressingMode, textureFilteringMode ), coarseMask );
+	return color;
+}
+
+// Shades one quad, or two horizontally adjacent ones (quads[1].x == quads[0].x + 2), 8 pixels at a time with AVX2.
+// Lane (q * 4 + r * 2 + c) holds pixel (x + q * 2 + c, y + r), which matches the quad-swizzled depth buffer layout of the SSE path. Only ever
+// called with constant render settings by the specialized kernels below.
+static __forceinline void __softrast_shade_quads_avx2_generic ( const raster_quad* quads, uint32_t quadCount, const softrast_submesh* submesh, const raster_shade_target* target,
+                                                                const int renderMode, const int textureAddressingMode, const int textureFilteringMode, const int textureMipmapMode, const int dithering )
+{
+	const softrast_texture* texture = submesh->texture;
+
+	//--------------------------------
+	// With a single quad the second one mirrors the first, and has all of its lanes masked off
+	//--------------------------------
+	const raster_quad* qa = quads;
+	const raster_quad* qb = quads + (quadCount - 1);
+
+	const int32_t ix = qa->x;
+	const int32_t y1 = qa->y;
+
+	//--------------------------------
+	// Depth test
+	//--------------------------------
+	float* dbquadptr = target->depthBuffer + ((uint32_t)y1 >> 1) * target->depthBufferQuadFloatStride + 4 * ((uint32_t)ix >> 1);
+
+	const __m256i bit8      = _mm256_setr_epi32 ( 1, 2, 4, 8, 16, 32, 64, 128 );
+	const uint32_t coverage = qa->coverage | (quadCount > 1 ? qb->coverage << 4 : 0);
+	const __m256i coverage8 = _mm256_cmpeq_epi32 ( _mm256_and_si256 ( _mm256_set1_epi32 ( coverage ), bit8 ), bit8 );
+
+	const __m256 d8 = quadCount > 1 ? _mm256_loadu_ps ( dbquadptr ) : _mm256_broadcast_ps ( (const __m128*)dbquadptr );
+	const __m256 z8 = _mm256_setr_ps ( qa->z[0], qa->z[0] + qa->zstep[0], qa->z[1], qa->z[1] + qa->zstep[1],
+	                                   qb->z[0], qb->z[0] + qb->zstep[0], qb->z[1], qb->z[1] + qb->zstep[1] );
+
+	const __m256i pixelMask = _mm256_and_si256 ( coverage8, _mm256_castps_si256 ( _mm256_cmp_ps ( z8, d8, _CMP_GT_OQ ) ) ); // if ( covered && pz > *dptr[r][c] )
+	ThreadPixelStats.testedPixels += softrast_bit_count ( coverage );
+	ThreadPixelStats.shadedPixels += softrast_bit_count ( _mm256_movemask_ps ( _mm256_castsi256_ps ( pixelMask ) ) );
+	if ( _mm256_testz_si256 ( pixelMask, pixelMask ) )
+		return;
+
+	const __m256 do8 = _mm256_blendv_ps ( d8, z8, _mm256_castsi256_ps ( pixelMask ) );
+	if ( quadCount > 1 )
+		_mm256_storeu_ps ( dbquadptr, do8 );
+	else
+		_mm_store_ps ( dbquadptr, _mm256_castps256_ps128 ( do8 ) );
+
+	//--------------------------------
+	// Perspective divide, and UV for each pixel
+	//--------------------------------
+	const __m256 rz8 = _mm256_div_ps ( _mm256_set1_ps ( 1.0f ), z8 );
+	__m256 u8 = _mm256_mul_ps ( _mm256_setr_ps ( qa->u[0], qa->u[0] + qa->ustep[0], qa->u[1], qa->u[1] + qa->ustep[1],
+	                                             qb->u[0], qb->u[0] + qb->ustep[0], qb->u[1], qb->u[1] + qb->ustep[1] ), rz8 );
+	__m256 v8 = _mm256_mul_ps ( _mm256_setr_ps ( qa->v[0], qa->v[0] + qa->vstep[0], qa->v[1], qa->v[1] + qa->vstep[1],
+	                                             qb->v[0], qb->v[0] + qb->vstep[0], qb->v[1], qb->v[1] + qb->vstep[1] ), rz8 );
+
+	const raster_quad* quadPair[2] = { qa, qb };
+
+	//--------------------------------
+	// Determine mipmap data per quad, from the largest UV delta between neighbouring pixels, scaled up to the shading block for coarse quads
+	//--------------------------------
+	const __m256 width8 = _mm256_set1_ps ( (float)texture->width );
+	mip_selection mip[2];
+
+	if ( textureMipmapMode != TEXTURE_MIPMAP_NONE )
+	{
+		const __m256 absMask = _mm256_castsi256_ps ( _mm256_set1_epi32 ( 0x7FFFFFFF ) );
+
+		const __m256 dx = _mm256_max_ps ( _mm256_and_ps ( absMask, _mm256_sub_ps ( u8, _mm256_permute_ps ( u8, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) ) ),
+		                                  _mm256_and_ps ( absMask, _mm256_sub_ps ( v8, _mm256_permute_ps ( v8, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) ) ) );
+		const __m256 dy = _mm256_max_ps ( _mm256_and_ps ( absMask, _mm256_sub_ps ( u8, _mm256_permute_ps ( u8, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) ) ),
+		                                  _mm256_and_ps ( absMask, _mm256_sub_ps ( v8, _mm256_permute_ps ( v8, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) ) ) );
+
+		__m256 maxDUV = _mm256_mul_ps ( width8, _mm256_max_ps ( dx, dy ) );
+		maxDUV = _mm256_max_ps ( maxDUV, _mm256_permute_ps ( maxDUV, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) );
+		maxDUV = _mm256_max_ps ( maxDUV, _mm256_permute_ps ( maxDUV, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) );
+
+		const float quadMaxDUV[2] = { _mm256_cvtss_f32 ( maxDUV ), _mm_cvtss_f32 ( _mm256_extractf128_ps ( maxDUV, 1 ) ) };
+		for ( uint32_t q = 0; q < 2; q++ )
+			softrast_select_mip ( &mip[q], texture, (float)(1 << quadPair[q]->shadingRate) * quadMaxDUV[q] );
+	}
+	else
+	{
+		mip[0].level = mip[0].level2 = 0;
+		mip[0].t     = 0.0f;
+		mip[1]       = mip[0];
+	}
+
+	//--------------------------------
+	// Coarse quads shade all of their lanes with the UV at the center of their shading block, in the modes that look at UVs
+	//--------------------------------
+	const __m256i quadLanes[2] = { _mm256_setr_epi32 ( -1, -1, -1, -1, 0, 0, 0, 0 ), _mm256_setr_epi32 ( 0, 0, 0, 0, -1, -1, -1, -1 ) };
+	const uint32_t usesUV      = renderMode == RENDER_MODE_UV || renderMode == RENDER_MODE_TEXTURED;
+	__m256i coarse8 = _mm256_setzero_si256 ( );
+
+	for ( uint32_t q = 0; usesUV && q < 2; q++ )
+	{
+		if ( quadPair[q]->shadingRate == SOFTRAST_SHADING_RATE_1X1 )
+			continue;
+
+		float cu, cv;
+		softrast_coarse_sample ( quadPair[q], &cu, &cv );
+		u8      = _mm256_blendv_ps ( u8, _mm256_set1_ps ( cu ), _mm256_castsi256_ps ( quadLanes[q] ) );
+		v8      = _mm256_blendv_ps ( v8, _mm256_set1_ps ( cv ), _mm256_castsi256_ps ( quadLanes[q] ) );
+		coarse8 = _mm256_or_si256 ( coarse8, quadLanes[q] );
+	}
+
+	//--------------------------------
+	// Wrap UV and transform to pixel units
+	//--------------------------------
+	u8 = _mm256_mul_ps ( _mm256_sub_ps ( u8, _mm256_round_ps ( u8, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC ) ), width8 );
+	v8 = _mm256_mul_ps ( _mm256_sub_ps ( v8, _mm256_round_ps ( v8, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC ) ), width8 );
+
+	//--------------------------------
+	// Apply dithering, quads always start on an even pixel so the pattern is the same for each of them
+	//--------------------------------
+	if ( dithering )
+	{
+		u8 = _mm256_add_ps ( u8, _mm256_andnot_ps ( _mm256_castsi256_ps ( coarse8 ), _mm256_setr_ps ( 0.25f, 0.5f, 0.75f, 0.0f, 0.25f, 0.5f, 0.75f, 0.0f ) ) );
+		v8 = _mm256_add_ps ( v8, _mm256_andnot_ps ( _mm256_castsi256_ps ( coarse8 ), _mm256_setr_ps ( 0.0f, 0.75f, 0.5f, 0.25f, 0.0f, 0.75f, 0.5f, 0.25f ) ) );
+	}
+
+	//--------------------------------
+	// Shade
+	//--------------------------------
+	__m256i color8;
+	if ( renderMode == RENDER_MODE_FLAT_COLOR )
+		color8 = _mm256_set1_epi32 ( 0xFFFF0000 );
+	else if ( renderMode == RENDER_MODE_UV )
+	{
+		const __m256i fx = _mm256_cvttps_epi32 ( _mm256_mul_ps ( _mm256_div_ps ( u8, width8 ), _mm256_set1_ps ( 256.0f ) ) );
+		const __m256i fy = _mm256_cvttps_epi32 ( _mm256_mul_ps ( _mm256_div_ps ( v8, _mm256_set1_ps ( (float)texture->height ) ), _mm256_set1_ps ( 256.0f ) ) );
+		color8 = _mm256_or_si256 ( _mm256_slli_epi32 ( fx, 16 ), _mm256_slli_epi32 ( fy, 8 ) );
+	}
+	else if ( renderMode == RENDER_MODE_ZBUFFER )
+		color8 = _mm256_cvttps_epi32 ( _mm256_mul_ps ( _mm256_div_ps ( _mm256_sub_ps ( rz8, _mm256_set1_ps ( target->nearClip ) ), _mm256_set1_ps ( target->farClip - target->nearClip ) ), _mm256_set1_ps ( 255.0f ) ) );
+	else if ( renderMode == RENDER_MODE_MIPMAP )
+	{
+		static const uint32_t mipmapLUT[] = {
+			0xFF0000,
+			0x00FF00,
+			0xFFFF00,
+			0x0000FF,
+			0xFF00FF,
+			0x00FFFF,
+			0xFFFFFF,
+		};
+
+		uint32_t mipColor[2];
+		for ( uint32_t q = 0; q < 2; q++ )
+		{
+			const uint32_t level = textureMipmapMode == TEXTURE_MIPMAP_LINEAR ? mip[q].level2 : mip[q].level;
+			mipColor[q] = mipmapLUT[MIN(level,sizeof(mipmapLUT)/sizeof(mipmapLUT[0])-1)];
+		}
+		color8 = _mm256_setr_epi32 ( mipColor[0], mipColor[0], mipColor[0], mipColor[0], mipColor[1], mipColor[1], mipColor[1], mipColor[1] );
+	}
+	else if ( renderMode == RENDER_MODE_TEXTURED )
+	{
+		//--------------------------------
+		// Pixels that passed the depth test sample on their own, coarse quads with any of them once for the whole quad
+		//--------------------------------
+		const __m256i sampleMask = _mm256_andnot_si256 ( coarse8, pixelMask );
+		__m256i coarseMask = _mm256_setzero_si256 ( );
+		for ( uint32_t q = 0; q < 2; q++ )
+		{
+			if ( quadPair[q]->shadingRate != SOFTRAST_SHADING_RATE_1X1 && !_mm256_testz_si256 ( pixelMask, quadLanes[q] ) )
+				coarseMask = _mm256_or_si256 ( coarseMask, quadLanes[q] );
+		}
+
+		const uint32_t level[2] = { mip[0].level, mip[1].level };
+		color8 = __softrast_sample_quads_avx2 ( texture, level, u8, v8, sampleMask, coarseMask, textureAddressingMode, textureFilteringMode );
+
+		if ( textureMipmapMode == TEXTURE_MIPMAP_LINEAR )
+		{
+			const uint32_t level2[2] = { mip[0].level2, mip[1].level2 };
+			const __m256i color2 = __softrast_sample_quads_avx2 ( texture, level2, u8, v8, sampleMask, coarseMask, textureAddressingMode, textureFilteringMode );
+
+			const int32_t t[2] = { (int32_t)(mip[0].t * SOFTRAST_WEIGHT_SCALE), (int32_t)(mip[1].t * SOFTRAST_WEIGHT_SCALE) };
+			color8 = softrast_lerp_texels_avx2 ( color8, color2, _mm256_setr_epi32 ( t[0], t[0], t[0], t[0], t[1], t[1], t[1], t[1] ) );
+		}
+	}
+	else
+		return;
+
+	//--------------------------------
+	// Write the rows back with a masked blend and store. Rows without any covered pixels aren't touched
+	// (they may lie outside of the render target), and neither are pixels past the right edge of the render target.
+	//--------------------------------
+	const __m256i rowOrder   = _mm256_setr_epi32 ( 0, 1, 4, 5, 2, 3, 6, 7 );
+	const __m256i rowColor8  = _mm256_permutevar8x32_epi32 ( color8, rowOrder );
+	const __m256i rowMask8   = _mm256_permutevar8x32_epi32 ( pixelMask, rowOrder );
+	const uint32_t inside    = (uint32_t)ix + 2 * quadCount <= globalData.renderTarget.width;
+
+	for ( int32_t r = 0; r < 2; r++ )
+	{
+		const __m128i rowColor = r ? _mm256_extracti128_si256 ( rowColor8, 1 ) : _mm256_castsi256_si128 ( rowColor8 );
+		const __m128i rowMask  = r ? _mm256_extracti128_si256 ( rowMask8, 1 )  : _mm256_castsi256_si128 ( rowMask8 );
+		if ( _mm_testz_si128 ( rowMask, rowMask ) )
+			continue;
+
+		uint32_t* ptr = qa->color[r];
+		if ( !inside )
+			_mm_maskstore_epi32 ( (int*)ptr, rowMask, rowColor );
+		else if ( quadCount > 1 )
+			_mm_storeu_si128 ( (__m128i*)ptr, _mm_blendv_epi8 ( _mm_loadu_si128 ( (const __m128i*)ptr ), rowColor, rowMask ) );
+		else
+			_mm_storel_epi64 ( (__m128i*)ptr, _mm_blendv_epi8 ( _mm_loadl_epi64 ( (const __m128i*)ptr ), rowColor, rowMask ) );
+	}
+}
+
+#define SOFTRAST_SHADE_QUADS_AVX2(name,renderMode,addressing,filtering,mipmap,dithering) \
+	static void name ( const raster_quad* quads, uint32_t quadCount, const softrast_submesh* submesh, const raster_shade_target* target ) \
+	{ __softrast_shade_quads_avx2_generic ( quads, quadCount, submesh, target, renderMode, addressing, filtering, mipmap, dithering ); }
+
+SOFTRAST_SHADE_KERNELS ( __softrast_shade_quads_avx2, SOFTRAST_SHADE_QUADS_AVX2 )
+
+static const SOFTRAST_SHADE_KERNEL_TABLE_TYPE ( softrast_shade_quads_func ) __softrast_shade_quads_avx2_table = SOFTRAST_SHADE_KERNEL_TABLE ( __softrast_shade_quads_avx2 );
+
+// Whether the kernels selected by kernelFlags keep the depth buffer quad-swizzled
+static uint32_t __softrast_depth_swizzled ( )
+{
+	return (globalData.kernelFlags & (FLAG_QUAD_RASTERIZATION_SIMD | FLAG_QUAD_RASTERIZATION_AVX2 | FLAG_QUAD_RASTERIZATION_AVX512)) != 0;
+}
+
+// Pixel pipeline of the depth pre-pass. Depth is interpolated exactly like the shading kernels do, and written in the layout they use, so the shading pass can test for equality
+static __forceinline void __softrast_shade_quad_depth_generic ( const raster_quad* quad, const int swizzled )
+{
+	float* dbquadptr = globalData.renderTarget.depthBuffer + ((uint32_t)quad->y >> 1) * globalData.renderTarget.depthBufferQuadFloatStride + 4 * ((uint32_t)quad->x >> 1);
+
+	for ( int32_t r = 0; r < 2; r++ )
+	{
+		for ( int32_t c = 0; c < 2; c++ )
+		{
+			if ( !(quad->coverage & (1 << (r * 2 + c))) )
+				continue;
+
+			const float pz = c ? quad->z[r] + quad->zstep[r] : quad->z[r];
+			float* depth   = swizzled ? dbquadptr + r * 2 + c : quad->depth[r] + c;
+			if ( pz > *depth )
+				*depth = pz;
+		}
+	}
+}
+
+static void __softrast_shade_quad_depth_linear ( const raster_quad* quad, const softrast_submesh* submesh )   { (void)submesh; __softrast_shade_quad_depth_generic ( quad, 0 ); }
+static void __softrast_shade_quad_depth_swizzled ( const raster_quad* quad, const softrast_submesh* submesh ) { (void)submesh; __softrast_shade_quad_depth_generic ( quad, 1 ); }
+
+// Pixel pipeline of submeshes without a texture. The render modes that don't sample a texture shade them as the generic kernel does, the
+// others fill them with the missing texture color
+static __forceinline void __softrast_shade_quad_untextured_generic ( const raster_quad* quad, const int renderMode, const int swizzled )
+{
+	float* dbquadptr = globalData.renderTarget.depthBuffer + ((uint32_t)quad->y >> 1) * globalData.renderTarget.depthBufferQuadFloatStride + 4 * ((uint32_t)quad->x >> 1);
+
+	float cu = 0.0f, cv = 0.0f;
+	const uint32_t coarse = renderMode == RENDER_MODE_UV && quad->shadingRate != SOFTRAST_SHADING_RATE_1X1;
+	if ( coarse )
+		softrast_coarse_sample ( quad, &cu, &cv );
+
+	ThreadPixelStats.testedPixels += softrast_bit_count ( quad->coverage );
+	for ( int32_t r = 0; r < 2; r++ )
+	{
+		for ( int32_t c = 0; c < 2; c++ )
+		{
+			if ( !(quad->coverage & (1 << (r * 2 + c))) )
+				continue;
+
+			const float pz = c ? quad->z[r] + quad->zstep[r] : quad->z[r];
+			float* depth   = swizzled ? dbquadptr + r * 2 + c : quad->depth[r] + c;
+			if ( !(pz > *depth) )
+				continue;
+
+			*depth = pz;
+			ThreadPixelStats.shadedPixels++;
+
+			if ( renderMode == RENDER_MODE_FLAT_COLOR )
+				quad->color[r][c] = 0xFFFF0000;
+			else if ( renderMode == RENDER_MODE_UV )
+			{
+				float fx = cu, fy = cv;
+				if ( !coarse )
+				{
+					const float rz = 1.0f / pz;
+					fx = (c ? quad->u[r] + quad->ustep[r] : quad->u[r]) * rz;
+					fy = (c ? quad->v[r] + quad->vstep[r] : quad->v[r]) * rz;
+					fx = fx - (int32_t)fx;
+					fy = fy - (int32_t)fy;
 				}
-#pragma endregion
+				quad->color[r][c] = (((uint32_t)(fx * 256.0f))<<16) | (((uint32_t)(fy * 256.0f))<<8);
 			}
+			else if ( renderMode == RENDER_MODE_ZBUFFER )
+				quad->color[r][c] = (uint32_t)((((1.0f / pz)-globalData.shadeTarget.nearClip)/(globalData.shadeTarget.farClip-globalData.shadeTarget.nearClip)) * 255.0f);
+			else
+				quad->color[r][c] = 0xFF00FF;
 		}
 	}
-	
+}
+
+#define SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL(name,renderMode,swizzled) \
+	static void name ( const raster_quad* quad, const softrast_submesh* submesh ) { (void)submesh; __softrast_shade_quad_untextured_generic ( quad, renderMode, swizzled ); }
+
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_flat_0,    RENDER_MODE_FLAT_COLOR, 0 )
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_uv_0,      RENDER_MODE_UV,         0 )
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_zbuffer_0, RENDER_MODE_ZBUFFER,    0 )
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_missing_0, RENDER_MODE_TEXTURED,   0 )
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_flat_1,    RENDER_MODE_FLAT_COLOR, 1 )
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_uv_1,      RENDER_MODE_UV,         1 )
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_zbuffer_1, RENDER_MODE_ZBUFFER,    1 )
+SOFTRAST_SHADE_QUAD_UNTEXTURED_KERNEL ( __softrast_shade_quad_untextured_missing_1, RENDER_MODE_TEXTURED,   1 )
+
+// Indexed by [swizzled][flat, uv, zbuffer, missing]
+static const shade_quad_func __softrast_shade_quad_untextured_table[2][4] = {
+	{ __softrast_shade_quad_untextured_flat_0, __softrast_shade_quad_untextured_uv_0, __softrast_shade_quad_untextured_zbuffer_0, __softrast_shade_quad_untextured_missing_0 },
+	{ __softrast_shade_quad_untextured_flat_1, __softrast_shade_quad_untextured_uv_1, __softrast_shade_quad_untextured_zbuffer_1, __softrast_shade_quad_untextured_missing_1 },
+};
+
+// Picks the pixel pipeline of untextured submeshes matching the current render mode
+static shade_quad_func __softrast_select_shade_quad_untextured ( )
+{
+	const shade_quad_func* kernels = __softrast_shade_quad_untextured_table[__softrast_depth_swizzled ( )];
+	switch ( FrameDebug.renderMode )
+	{
+	case RENDER_MODE_FLAT_COLOR: return kernels[0];
+	case RENDER_MODE_UV:         return kernels[1];
+	case RENDER_MODE_ZBUFFER:    return kernels[2];
+	default:                     return kernels[3];
+	}
+}
+
+// Shades a quad right away, with the pixel pipeline of the current pass that fits the submesh
+static void __softrast_shade_quad ( const raster_quad* quad, const softrast_submesh* submesh )
+{
+	if ( submesh->texture || globalData.depthPrePass )
+		globalData.shadeQuad ( quad, submesh );
+	else
+		globalData.shadeQuadUntextured ( quad, submesh );
+}
+
+// Coarsest of the frame's shading rate, the submesh's, and the rate image's at pixel (x, y)
+static uint32_t __softrast_shading_rate ( int32_t x, int32_t y, const softrast_submesh* submesh )
+{
+	uint32_t rate = MAX ( (uint32_t)FrameDebug.shadingRate, submesh->shadingRate );
+	if ( globalData.shadingRateImage.rates )
+	{
+		const shading_rate_image* image = &globalData.shadingRateImage;
+		const uint32_t cellX = MIN ( (uint32_t)((float)x * image->scaleX), image->width - 1 );
+		const uint32_t cellY = MIN ( (uint32_t)((float)(globalData.renderTarget.height - 1 - y) * image->scaleY), image->height - 1 );
+		rate = MAX ( rate, image->rates[cellY * image->width + cellX] );
+	}
+	return MIN ( rate, SOFTRAST_SHADING_RATE_4X4 );
+}
+
+// Whether checkerboard rendering leaves the quad at pixel (x, y) for the reconstruction to fill in this frame
+static uint32_t __softrast_checkerboard_skips ( int32_t x, int32_t y )
+{
+	return globalData.checkerboard.active && ((((uint32_t)x >> 1) + ((uint32_t)y >> 1) + globalData.checkerboard.parity) & 1);
+}
+
+// The AVX-512 kernel is used when it's asked for, and the SIMD level allows it
+static uint32_t __softrast_use_avx512 ( )
+{
+	return (globalData.kernelFlags & FLAG_QUAD_RASTERIZATION_AVX512) != 0;
+}
+
+// Shades and empties the queued quads
+static void __softrast_flush_quads ( raster_quad_batch* batch, const softrast_submesh* submesh )
+{
+	if ( batch->quadCount && (globalData.depthPrePass || !submesh->texture) )
+	{
+		// The wide kernels only shade textured submeshes
+		for ( uint32_t i = 0; i < batch->quadCount; i++ )
+			__softrast_shade_quad ( batch->quads + i, submesh );
+	}
+	else if ( batch->quadCount )
+		globalData.shadeQuads ( batch->quads, batch->quadCount, submesh, &globalData.shadeTarget );
+	batch->quadCount = 0;
+}
+
+// Queues a quad for the wide pixel pipelines. The AVX-512 kernel takes four quads at any position, the AVX2 one horizontally adjacent pairs.
+static void __softrast_queue_quad ( raster_quad_batch* batch, const raster_quad* quad, const softrast_submesh* submesh )
+{
+	if ( !quad->coverage )
+		return;
+
+	const uint32_t avx512 = __softrast_use_avx512 ( );
+	if ( !avx512 && batch->quadCount && (quad->y != batch->quads[0].y || quad->x != batch->quads[0].x + 2) )
+		__softrast_flush_quads ( batch, submesh );
+
+	batch->quads[batch->quadCount++] = *quad;
+	if ( batch->quadCount == (avx512 ? SOFTRAST_MAX_BATCH_QUADS : 2) )
+		__softrast_flush_quads ( batch, submesh );
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Snaps the triangle to sub-pixel fixed point and sets up its edge functions, swapping v1 and v2 if that is needed to make the inside
+// positive. Edge e runs from vertex e to vertex e + 1. Returns 0 for triangles that are degenerate once snapped
+static uint32_t __softrast_half_space_setup ( half_space_edges* edges, const vertex** v0, const vertex** v1, const vertex** v2 )
+{
+	const float snap = (float)(1 << SOFTRAST_SUBPIXEL_BITS);
+
+	const vertex* verts[3] = { *v0, *v1, *v2 };
+	int32_t x[3], y[3];
+	for ( uint32_t i = 0; i < 3; i++ )
+	{
+		x[i] = (int32_t)floorf ( verts[i]->position.x * snap + 0.5f );
+		y[i] = (int32_t)floorf ( verts[i]->position.y * snap + 0.5f );
+	}
+
+	//--------------------------------
+	// Wind by the snapped area, so neighbouring triangles agree on it exactly
+	//--------------------------------
+	const int64_t area = (int64_t)(x[1] - x[0]) * (y[2] - y[0]) - (int64_t)(x[2] - x[0]) * (y[1] - y[0]);
+	if ( area == 0 )
+		return 0;
+	if ( area < 0 )
+	{
+		const vertex* t = verts[1];
+		verts[1] = verts[2], verts[2] = t;
+		int32_t ti = x[1];
+		x[1] = x[2], x[2] = ti;
+		ti = y[1];
+		y[1] = y[2], y[2] = ti;
+	}
+
+	for ( uint32_t e = 0; e < 3; e++ )
+	{
+		const uint32_t n = (e + 1) % 3;
+		edges->a[e]    = y[e] - y[n];
+		edges->b[e]    = x[n] - x[e];
+		edges->ox[e]   = x[e];
+		edges->oy[e]   = y[e];
+		edges->bias[e] = (edges->a[e] > 0 || (edges->a[e] == 0 && edges->b[e] < 0)) ? 0 : -1;
+
+		edges->fa[e]   = verts[e]->position.y - verts[n]->position.y;
+		edges->fb[e]   = verts[n]->position.x - verts[e]->position.x;
+	}
+
+	//--------------------------------
+	// Attributes keep using the unsnapped positions; the sign of the area doesn't matter to the gradients
+	//--------------------------------
+	edges->area = (verts[1]->position.x - verts[0]->position.x) * (verts[2]->position.y - verts[0]->position.y) - (verts[2]->position.x - verts[0]->position.x) * (verts[1]->position.y - verts[0]->position.y);
+	if ( edges->area == 0.0f )
+		return 0;
+
+	//--------------------------------
+	// Pixels whose sample lies within the snapped bounds (arithmetic shifts round down)
+	//--------------------------------
+	const int32_t round = (1 << SOFTRAST_SUBPIXEL_BITS) - 1;
+	edges->minX = (MIN ( MIN ( x[0], x[1] ), x[2] ) + round) >> SOFTRAST_SUBPIXEL_BITS;
+	edges->minY = (MIN ( MIN ( y[0], y[1] ), y[2] ) + round) >> SOFTRAST_SUBPIXEL_BITS;
+	edges->maxX = MAX ( MAX ( x[0], x[1] ), x[2] ) >> SOFTRAST_SUBPIXEL_BITS;
+	edges->maxY = MAX ( MAX ( y[0], y[1] ), y[2] ) >> SOFTRAST_SUBPIXEL_BITS;
+
+	*v0 = verts[0], *v1 = verts[1], *v2 = verts[2];
+	return 1;
+}
+
+// Evaluates edge e exactly at pixel (x, y), fill rule bias included, clamped into 32 bits; the sample is inside when the result is >= 0
+static __forceinline int32_t __softrast_half_space_evaluate ( const half_space_edges* edges, uint32_t e, int32_t x, int32_t y )
+{
+	const int64_t value = (int64_t)edges->a[e] * ((x << SOFTRAST_SUBPIXEL_BITS) - edges->ox[e]) + (int64_t)edges->b[e] * ((y << SOFTRAST_SUBPIXEL_BITS) - edges->oy[e]) + edges->bias[e];
+	return (int32_t)CLAMP ( value, -SOFTRAST_HALF_SPACE_CLAMP, SOFTRAST_HALF_SPACE_CLAMP );
+}
+
+// Classifies the size x size pixel block at (x, y) by evaluating every edge at the block corners where it is smallest and largest
+static block_coverage __softrast_half_space_classify ( const half_space_edges* edges, int32_t x, int32_t y, int32_t size )
+{
+	const int64_t span = (int64_t)(size - 1) << SOFTRAST_SUBPIXEL_BITS;
+
+	uint32_t inside = 1;
+	for ( uint32_t e = 0; e < 3; e++ )
+	{
+		const int64_t value = (int64_t)edges->a[e] * ((x << SOFTRAST_SUBPIXEL_BITS) - edges->ox[e]) + (int64_t)edges->b[e] * ((y << SOFTRAST_SUBPIXEL_BITS) - edges->oy[e]) + edges->bias[e];
+		if ( value + (MAX ( edges->a[e], 0 ) + MAX ( edges->b[e], 0 )) * span < 0 )
+			return BLOCK_OUTSIDE;
+		inside &= value + (MIN ( edges->a[e], 0 ) + MIN ( edges->b[e], 0 )) * span >= 0;
+	}
+	return inside ? BLOCK_INSIDE : BLOCK_PARTIAL;
+}
+
+// Evaluates the edge functions for a 4x4 block; bit (r * 4 + c) is set when pixel (x + c, y + r) lies inside the triangle
+static uint64_t __softrast_half_space_block_4x4 ( const half_space_edges* edges, int32_t x, int32_t y )
+{
+	const __m128i outside = _mm_set1_epi32 ( -1 );
+
+	__m128i inside[4];
+	for ( uint32_t r = 0; r < 4; r++ )
+		inside[r] = outside;
+
+	for ( uint32_t e = 0; e < 3; e++ )
+	{
+		//--------------------------------
+		// Evaluate the block corner exactly, and step across the block with integer adds
+		//--------------------------------
+		const int32_t stepX = edges->a[e] << SOFTRAST_SUBPIXEL_BITS;
+		const __m128i stepY = _mm_set1_epi32 ( edges->b[e] << SOFTRAST_SUBPIXEL_BITS );
+
+		__m128i e4 = _mm_add_epi32 ( _mm_set1_epi32 ( __softrast_half_space_evaluate ( edges, e, x, y ) ), _mm_set_epi32 ( 3 * stepX, 2 * stepX, stepX, 0 ) );
+		for ( uint32_t r = 0; r < 4; r++, e4 = _mm_add_epi32 ( e4, stepY ) )
+			inside[r] = _mm_and_si128 ( inside[r], _mm_cmpgt_epi32 ( e4, outside ) );
+	}
+
+	uint64_t mask = 0;
+	for ( uint32_t r = 0; r < 4; r++ )
+		mask |= (uint64_t)_mm_movemask_ps ( _mm_castsi128_ps ( inside[r] ) ) << (r * 4);
+	return mask;
+}
+
+// Evaluates the edge functions for an 8x8 block; bit (r * 8 + c) is set when pixel (x + c, y + r) lies inside the triangle
+static uint64_t __softrast_half_space_block_8x8 ( const half_space_edges* edges, int32_t x, int32_t y )
+{
+	const __m256i outside = _mm256_set1_epi32 ( -1 );
+
+	__m256i inside[8];
+	for ( uint32_t r = 0; r < 8; r++ )
+		inside[r] = outside;
+
+	for ( uint32_t e = 0; e < 3; e++ )
+	{
+		//--------------------------------
+		// Evaluate the block corner exactly, and step across the block with integer adds
+		//--------------------------------
+		const __m256i stepX = _mm256_set1_epi32 ( edges->a[e] << SOFTRAST_SUBPIXEL_BITS );
+		const __m256i stepY = _mm256_set1_epi32 ( edges->b[e] << SOFTRAST_SUBPIXEL_BITS );
+
+		__m256i e8 = _mm256_add_epi32 ( _mm256_set1_epi32 ( __softrast_half_space_evaluate ( edges, e, x, y ) ), _mm256_mullo_epi32 ( stepX, _mm256_setr_epi32 ( 0, 1, 2, 3, 4, 5, 6, 7 ) ) );
+		for ( uint32_t r = 0; r < 8; r++, e8 = _mm256_add_epi32 ( e8, stepY ) )
+			inside[r] = _mm256_and_si256 ( inside[r], _mm256_cmpgt_epi32 ( e8, outside ) );
+	}
+
+	uint64_t mask = 0;
+	for ( uint32_t r = 0; r < 8; r++ )
+		mask |= (uint64_t)_mm256_movemask_ps ( _mm256_castsi256_ps ( inside[r] ) ) << (r * 8);
+	return mask;
+}
+
+// Whether a surface no nearer than maxZ fails the depth test on every pixel of the rectangle, going by the HiZ tiles covering it
+static uint32_t __softrast_hiz_occluded ( int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, float maxZ )
+{
+	const float z = maxZ * (1.0f + SOFTRAST_HIZ_EPSILON);
+	for ( int32_t ty = minY / SOFTRAST_HIZ_TILE_SIZE; ty <= maxY / SOFTRAST_HIZ_TILE_SIZE; ty++ )
+	{
+		const float* minDepth = globalData.hiz.minDepth + ty * globalData.hiz.tileCountX;
+		for ( int32_t tx = minX / SOFTRAST_HIZ_TILE_SIZE; tx <= maxX / SOFTRAST_HIZ_TILE_SIZE; tx++ )
+		{
+			if ( z > minDepth[tx] )
+				return 0;
+		}
+	}
+	return 1;
+}
+
+// Recomputes the HiZ tile containing pixel (x, y) from the depth buffer, in whichever layout the active pixel pipeline writes
+static void __softrast_hiz_update ( int32_t x, int32_t y )
+{
+	const uint32_t tx = (uint32_t)x / SOFTRAST_HIZ_TILE_SIZE, ty = (uint32_t)y / SOFTRAST_HIZ_TILE_SIZE;
+	const uint32_t px = tx * SOFTRAST_HIZ_TILE_SIZE, py = ty * SOFTRAST_HIZ_TILE_SIZE;
+	const uint32_t swizzled = __softrast_depth_swizzled ( );
+	const float* depthBuffer = globalData.renderTarget.depthBuffer;
+
+	float tileMin;
+	if ( px + SOFTRAST_HIZ_TILE_SIZE <= globalData.renderTarget.width && py + SOFTRAST_HIZ_TILE_SIZE <= globalData.renderTarget.height )
+	{
+		//--------------------------------
+		// Full tile: 4 rows of 4 adjacent quads when swizzled, 8 rows of 8 pixels otherwise. Quads checkerboard rendering skips hold no depth this frame, so
+		// those are left out where the layout makes that cheap
+		//--------------------------------
+		__m128 min4 = _mm_set1_ps ( FLT_MAX );
+		if ( swizzled )
+		{
+			const uint32_t step = globalData.checkerboard.active ? 8 : 4;
+			for ( uint32_t r = 0; r < SOFTRAST_HIZ_TILE_SIZE / 2; r++ )
+			{
+				const float* row = depthBuffer + ((py >> 1) + r) * globalData.renderTarget.depthBufferQuadFloatStride + 4 * (px >> 1);
+				const uint32_t first = globalData.checkerboard.active ? 4 * (((px >> 1) + (py >> 1) + r + globalData.checkerboard.parity) & 1) : 0;
+				for ( uint32_t i = first; i < 2 * SOFTRAST_HIZ_TILE_SIZE; i += step )
+					min4 = _mm_min_ps ( min4, _mm_load_ps ( row + i ) );
+			}
+		}
+		else
+		{
+			for ( uint32_t r = 0; r < SOFTRAST_HIZ_TILE_SIZE; r++ )
+			{
+				const float* row = depthBuffer + (py + r) * globalData.renderTarget.width + px;
+				for ( uint32_t i = 0; i < SOFTRAST_HIZ_TILE_SIZE; i += 4 )
+					min4 = _mm_min_ps ( min4, _mm_loadu_ps ( row + i ) );
+			}
+		}
+		min4 = _mm_min_ps ( min4, _mm_shuffle_ps ( min4, min4, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) );
+		min4 = _mm_min_ps ( min4, _mm_shuffle_ps ( min4, min4, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) );
+		tileMin = _mm_cvtss_f32 ( min4 );
+	}
+	else
+	{
+		//--------------------------------
+		// Tile cut off by the render target edge, only look at the pixels on screen
+		//--------------------------------
+		const uint32_t maxX = MIN ( px + SOFTRAST_HIZ_TILE_SIZE, globalData.renderTarget.width );
+		const uint32_t maxY = MIN ( py + SOFTRAST_HIZ_TILE_SIZE, globalData.renderTarget.height );
+
+		tileMin = FLT_MAX;
+		for ( uint32_t py2 = py; py2 < maxY; py2++ )
+		{
+			for ( uint32_t px2 = px; px2 < maxX; px2++ )
+			{
+				const float d = swizzled ? depthBuffer[(py2 >> 1) * globalData.renderTarget.depthBufferQuadFloatStride + 4 * (px2 >> 1) + 2 * (py2 & 1) + (px2 & 1)] : depthBuffer[py2 * globalData.renderTarget.width + px2];
+				tileMin = MIN ( tileMin, d );
+			}
+		}
+	}
+
+	globalData.hiz.minDepth[ty * globalData.hiz.tileCountX + tx] = tileMin;
+}
+
+// Screen space planes of a triangle's attributes, derived from its half-space edges; the barycentric weight of a vertex is the edge
+// function opposite to it divided by the area
+static void __softrast_half_space_planes ( attribute_planes* planes, const half_space_edges* edges, const vertex* v0, const vertex* v1, const vertex* v2 )
+{
+	const float invArea = 1.0f / edges->area;
+
+	planes->x0   = v0->position.x, planes->y0 = v0->position.y;
+	planes->z0   = v0->position.w, planes->u0 = v0->u, planes->v0 = v0->v;
+	planes->dzdx = (edges->fa[1] * v0->position.w + edges->fa[2] * v1->position.w + edges->fa[0] * v2->position.w) * invArea;
+	planes->dzdy = (edges->fb[1] * v0->position.w + edges->fb[2] * v1->position.w + edges->fb[0] * v2->position.w) * invArea;
+	planes->dudx = (edges->fa[1] * v0->u + edges->fa[2] * v1->u + edges->fa[0] * v2->u) * invArea;
+	planes->dudy = (edges->fb[1] * v0->u + edges->fb[2] * v1->u + edges->fb[0] * v2->u) * invArea;
+	planes->dvdx = (edges->fa[1] * v0->v + edges->fa[2] * v1->v + edges->fa[0] * v2->v) * invArea;
+	planes->dvdy = (edges->fb[1] * v0->v + edges->fb[2] * v1->v + edges->fb[0] * v2->v) * invArea;
+}
+
+// Shades the covered pixels of a block quad by quad; bit (r * blockSize + c) of the mask covers pixel (bx + c, by + r)
+static void __softrast_shade_block ( const attribute_planes* planes, uint64_t mask, int32_t blockSize, int32_t bx, int32_t by, const softrast_submesh* submesh )
+{
+	if ( globalData.checkerboard.active )
+	{
+		mask &= globalData.checkerboard.blockMasks[blockSize == 8][(((uint32_t)bx >> 1) + ((uint32_t)by >> 1) + globalData.checkerboard.parity) & 1];
+		if ( !mask )
+			return;
+	}
+
+	raster_quad_batch batch;
+	batch.quadCount = 0;
+
+	for ( int32_t qy = 0; qy < blockSize; qy += 2 )
+	{
+		for ( int32_t qx = 0; qx < blockSize; qx += 2 )
+		{
+			const uint32_t coverage = (uint32_t)((mask >> (qy * blockSize + qx)) & 0x3) | (uint32_t)(((mask >> ((qy + 1) * blockSize + qx)) & 0x3) << 2);
+			if ( !coverage )
+				continue;
+
+			raster_quad quad;
+			quad.x        = bx + qx;
+			quad.y        = by + qy;
+			quad.coverage = coverage;
+			for ( int32_t r = 0; r < 2; r++ )
+			{
+				const float dx = (float)quad.x - planes->x0;
+				const float dy = (float)(quad.y + r) - planes->y0;
+
+				quad.z[r]     = planes->z0 + planes->dzdx * dx + planes->dzdy * dy;
+				quad.u[r]     = planes->u0 + planes->dudx * dx + planes->dudy * dy;
+				quad.v[r]     = planes->v0 + planes->dvdx * dx + planes->dvdy * dy;
+				quad.zstep[r] = planes->dzdx;
+				quad.ustep[r] = planes->dudx;
+				quad.vstep[r] = planes->dvdx;
+				quad.color[r] = (uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - (quad.y + r) - 1) * globalData.renderTarget.pitch) + quad.x;
+				quad.depth[r] = globalData.renderTarget.depthBuffer + (quad.y + r) * globalData.renderTarget.width + quad.x;
+			}
+			quad.shadingRate = __softrast_shading_rate ( quad.x, quad.y, submesh );
+
+			if ( globalData.kernelFlags & (FLAG_QUAD_RASTERIZATION_AVX2 | FLAG_QUAD_RASTERIZATION_AVX512) )
+				__softrast_queue_quad ( &batch, &quad, submesh );
+			else
+				__softrast_shade_quad ( &quad, submesh );
+		}
+	}
+	__softrast_flush_quads ( &batch, submesh );
+}
+
+// Rasterizes a triangle by evaluating its edge functions over 4x4 (SSE) or 8x8 (AVX) blocks, and shades the covered 2x2 quads
+static void __softrast_rasterize_triangle_half_space ( const raster_region* region, const vertex* v0, const vertex* v1, const vertex* v2, const softrast_submesh* submesh )
+{
+	//--------------------------------
+	// Snap to fixed point and set up the edge functions, winding the triangle so the inside is positive for all edges
+	//--------------------------------
+	half_space_edges edges;
+	if ( !__softrast_half_space_setup ( &edges, &v0, &v1, &v2 ) )
+		return;
+
+	//--------------------------------
+	// Bounding box, clipped to the region
+	//--------------------------------
+	const int32_t minX = MAX ( edges.minX, region->minX );
+	const int32_t minY = MAX ( edges.minY, region->minY );
+	const int32_t maxX = MIN ( edges.maxX, region->maxX );
+	const int32_t maxY = MIN ( edges.maxY, region->maxY );
+	if ( minX > maxX || minY > maxY )
+		return;
+
+	//--------------------------------
+	// Reject the whole triangle when even its nearest vertex is behind every HiZ tile it touches
+	//--------------------------------
+	const uint32_t hiz = (FrameDebug.flags & (FLAG_HIZ | FLAG_DEPTH_TESTING)) == (FLAG_HIZ | FLAG_DEPTH_TESTING);
+	if ( hiz && __softrast_hiz_occluded ( minX, minY, maxX, maxY, MAX ( MAX ( v0->position.w, v1->position.w ), v2->position.w ) ) )
+		return;
+
+	//--------------------------------
+	// Attribute gradients
+	//--------------------------------
+	attribute_planes planes;
+	__softrast_half_space_planes ( &planes, &edges, v0, v1, v2 );
+
+	//--------------------------------
+	// Walk the coarse blocks covering the bounding box; those outside of the triangle are skipped as a whole, and inside of those
+	// that are fully covered the blocks need no edge tests at all
+	//--------------------------------
+	const int32_t blockSize = (globalData.kernelFlags & FLAG_HALF_SPACE_AVX) ? 8 : 4;
+	const uint64_t fullMask = blockSize == 8 ? ~0ull : 0xFFFFull;
+	for ( int32_t cy = minY & ~(SOFTRAST_COARSE_BLOCK_SIZE - 1); cy <= maxY; cy += SOFTRAST_COARSE_BLOCK_SIZE )
+	{
+		for ( int32_t cx = minX & ~(SOFTRAST_COARSE_BLOCK_SIZE - 1); cx <= maxX; cx += SOFTRAST_COARSE_BLOCK_SIZE )
+		{
+			const block_coverage coarse = __softrast_half_space_classify ( &edges, cx, cy, SOFTRAST_COARSE_BLOCK_SIZE );
+			if ( coarse == BLOCK_OUTSIDE )
+				continue;
+
+			const int32_t endY = MIN ( maxY, cy + SOFTRAST_COARSE_BLOCK_SIZE - 1 );
+			const int32_t endX = MIN ( maxX, cx + SOFTRAST_COARSE_BLOCK_SIZE - 1 );
+			for ( int32_t by = MAX ( cy, minY & ~(blockSize - 1) ); by <= endY; by += blockSize )
+			{
+				for ( int32_t bx = MAX ( cx, minX & ~(blockSize - 1) ); bx <= endX; bx += blockSize )
+				{
+					//--------------------------------
+					// Skip blocks whose nearest point is behind their HiZ tile, before doing any edge or attribute work
+					//--------------------------------
+					const float blockZ = planes.z0 + planes.dzdx * ((float)bx - planes.x0) + planes.dzdy * ((float)by - planes.y0);
+					if ( hiz && __softrast_hiz_occluded ( bx, by, bx, by, blockZ + (MAX ( planes.dzdx, 0.0f ) + MAX ( planes.dzdy, 0.0f )) * (blockSize - 1) ) )
+						continue;
+
+					//--------------------------------
+					// Only blocks straddling an edge get their pixels tested
+					//--------------------------------
+					uint64_t mask = fullMask;
+					if ( coarse == BLOCK_PARTIAL )
+					{
+						const block_coverage fine = __softrast_half_space_classify ( &edges, bx, by, blockSize );
+						if ( fine == BLOCK_OUTSIDE )
+							continue;
+						if ( fine == BLOCK_PARTIAL )
+							mask = blockSize == 8 ? __softrast_half_space_block_8x8 ( &edges, bx, by ) : __softrast_half_space_block_4x4 ( &edges, bx, by );
+						if ( !mask )
+							continue;
+					}
+
+					//--------------------------------
+					// Blocks sticking out of the region lose the pixels outside of it
+					//--------------------------------
+					if ( bx < region->minX || by < region->minY || bx + blockSize - 1 > region->maxX || by + blockSize - 1 > region->maxY )
+					{
+						for ( int32_t r = 0; r < blockSize; r++ )
+						{
+							for ( int32_t c = 0; c < blockSize; c++ )
+							{
+								if ( bx + c < region->minX || bx + c > region->maxX || by + r < region->minY || by + r > region->maxY )
+									mask &= ~(1ull << (r * blockSize + c));
+							}
+						}
+					}
+
+					__softrast_shade_block ( &planes, mask, blockSize, bx, by, submesh );
+
+					//--------------------------------
+					// The block lies within a single HiZ tile, which can only have moved closer
+					//--------------------------------
+					if ( hiz )
+						__softrast_hiz_update ( bx, by );
+				}
+			}
+		}
+	}
+}
+
+// Rasterizes a triangle whose spans fit in a single 4x4 block without going through the outline table. Coverage follows the outline table's
+// rule exactly (edges stepped per row the same way, spans from the floor of their ends), so it stays watertight with the neighbours that go
+// through it; only the attributes come from the half-space planes. Returns 0 when the triangle is too large, leaving it to the regular rasterizer
+static uint32_t __softrast_rasterize_small_triangle ( const raster_region* region, const vertex* v0, const vertex* v1, const vertex* v2, const softrast_submesh* submesh )
+{
+	//--------------------------------
+	// Rows the outline table would fill, which have to fit in the block
+	//--------------------------------
+	const float minVertY = MIN ( MIN ( v0->position.y, v1->position.y ), v2->position.y );
+	const float maxVertY = MAX ( MAX ( v0->position.y, v1->position.y ), v2->position.y );
+	const int32_t minY   = MAX ( ((int32_t)floorf ( minVertY )) + 1, region->minY );
+	const int32_t maxY   = MIN ( (int32_t)floorf ( maxVertY ), region->maxY );
+	if ( minY > maxY )
+		return 1;
+
+	const int32_t by = minY & ~1;
+	if ( maxY - by >= 4 )
+		return 0;
+
+	//--------------------------------
+	// Step the edges over the rows as the outline table does
+	//--------------------------------
+	const vertex* verts[3] = { v0, v1, v2 };
+	float spanMinX[4], spanMaxX[4];
+	uint32_t rowFilled = 0;
+
+	uint32_t li = 2;
+	for ( uint32_t i = 0; i < 3; li = i++ )
+	{
+		const vertex* vert1 = verts[li];
+		const vertex* vert2 = verts[i];
+		if ( vert1->position.y > vert2->position.y )
+		{
+			const vertex* t = vert1;
+			vert1 = vert2;
+			vert2 = t;
+		}
+
+		float x1       = vert1->position.x;
+		const float y1 = vert1->position.y;
+		const float y2 = vert2->position.y;
+		const float dx = (vert2->position.x - x1)/(y2 - y1);
+
+		const int32_t iMinY = ((int32_t)floorf ( y1 )) + 1;
+		const int32_t iMaxY = (int32_t)floorf ( y2 );
+		if ( iMaxY < iMinY )
+			continue;
+
+		x1 += dx * (iMinY - y1);
+
+		const int32_t iStartY = MAX ( iMinY, minY );
+		const int32_t iEndY   = MIN ( iMaxY, maxY );
+
+		int32_t yinc = iStartY - iMinY;
+		for ( int32_t y = iStartY; y <= iEndY; y++, yinc++ )
+		{
+			const float x   = x1 + yinc * dx;
+			const int32_t r = y - by;
+			if ( x < spanMinX[r] || !(rowFilled & (1 << r)) )
+				spanMinX[r] = x;
+			if ( x > spanMaxX[r] || !(rowFilled & (1 << r)) )
+				spanMaxX[r] = x;
+			rowFilled |= 1 << r;
+		}
+	}
+	if ( !rowFilled )
+		return 1;
+
+	//--------------------------------
+	// Spans cover the pixels from the floor of one end to the floor of the other, which have to fit in the block as well
+	//--------------------------------
+	int32_t ix1[4], ix2[4];
+	int32_t minX = INT32_MAX, maxX = INT32_MIN;
+	for ( int32_t r = 0; r < 4; r++ )
+	{
+		if ( !(rowFilled & (1 << r)) )
+			continue;
+		ix1[r] = MAX ( (int32_t)floorf ( spanMinX[r] ), region->minX );
+		ix2[r] = MIN ( (int32_t)floorf ( spanMaxX[r] ), region->maxX );
+		minX   = MIN ( minX, ix1[r] );
+		maxX   = MAX ( maxX, ix2[r] );
+	}
+	if ( minX > maxX )
+		return 1;
+
+	const int32_t bx = minX & ~1;
+	if ( maxX - bx >= 4 )
+		return 0;
+
+	uint64_t mask = 0;
+	for ( int32_t r = 0; r < 4; r++ )
+	{
+		for ( int32_t c = 0; c < 4; c++ )
+		{
+			if ( (rowFilled & (1 << r)) && bx + c >= ix1[r] && bx + c <= ix2[r] )
+				mask |= 1ull << (r * 4 + c);
+		}
+	}
+	if ( !mask )
+		return 1;
+
+	//--------------------------------
+	// Attributes only; triangles the half-space setup can't handle are left to the regular rasterizer
+	//--------------------------------
+	half_space_edges edges;
+	if ( !__softrast_half_space_setup ( &edges, &v0, &v1, &v2 ) )
+		return 0;
+
+	attribute_planes planes;
+	__softrast_half_space_planes ( &planes, &edges, v0, v1, v2 );
+	__softrast_shade_block ( &planes, mask, 4, bx, by, submesh );
+	return 1;
+}
+
+// Fan-triangulates the polygon and rasterizes each triangle with the half-space rasterizer, touching only pixels inside the region
+static void __softrast_rasterize_polygon_half_space ( const raster_region* region, const vertex* curVerts, uint32_t vectorCount, const softrast_submesh* submesh )
+{
+	for ( uint32_t i = 2; i < vectorCount; i++ )
+		__softrast_rasterize_triangle_half_space ( region, curVerts, curVerts + i - 1, curVerts + i, submesh );
+}
+
+// Depth buffer address of a pixel, in whichever layout the active pixel pipeline uses
+static float* __softrast_depth_pixel ( int32_t x, int32_t y )
+{
+	if ( globalData.kernelFlags & (FLAG_QUAD_RASTERIZATION_SIMD | FLAG_QUAD_RASTERIZATION_AVX2 | FLAG_QUAD_RASTERIZATION_AVX512) )
+		return globalData.renderTarget.depthBuffer + (y >> 1) * globalData.renderTarget.depthBufferQuadFloatStride + 4 * (x >> 1) + 2 * (y & 1) + (x & 1);
+	return globalData.renderTarget.depthBuffer + y * globalData.renderTarget.width + x;
+}
+
+// Depth tests a triangle and writes its ID into the visibility buffer where it wins; nothing is interpolated but 1/w
+static void __softrast_rasterize_triangle_visibility ( const raster_region* region, const vertex* v0, const vertex* v1, const vertex* v2, uint32_t id )
+{
+	half_space_edges edges;
+	if ( !__softrast_half_space_setup ( &edges, &v0, &v1, &v2 ) )
+		return;
+
+	const float invArea = 1.0f / edges.area;
+	const float x0 = v0->position.x, y0 = v0->position.y;
+	const float dzdx = (edges.fa[1] * v0->position.w + edges.fa[2] * v1->position.w + edges.fa[0] * v2->position.w) * invArea;
+	const float dzdy = (edges.fb[1] * v0->position.w + edges.fb[2] * v1->position.w + edges.fb[0] * v2->position.w) * invArea;
+
+	const int32_t minX = MAX ( edges.minX, region->minX );
+	const int32_t minY = MAX ( edges.minY, region->minY );
+	const int32_t maxX = MIN ( edges.maxX, region->maxX );
+	const int32_t maxY = MIN ( edges.maxY, region->maxY );
+	if ( minX > maxX || minY > maxY )
+		return;
+
+	//--------------------------------
+	// Same block walk and coverage rule as the half-space rasterizer, so both cover exactly the same pixels
+	//--------------------------------
+	const int32_t blockSize = (globalData.kernelFlags & FLAG_HALF_SPACE_AVX) ? 8 : 4;
+	for ( int32_t by = minY & ~(blockSize - 1); by <= maxY; by += blockSize )
+	{
+		for ( int32_t bx = minX & ~(blockSize - 1); bx <= maxX; bx += blockSize )
+		{
+			const uint64_t mask = blockSize == 8 ? __softrast_half_space_block_8x8 ( &edges, bx, by ) : __softrast_half_space_block_4x4 ( &edges, bx, by );
+			if ( !mask )
+				continue;
+
+			for ( int32_t r = 0; r < blockSize; r++ )
+			{
+				const int32_t y = by + r;
+				if ( y < region->minY || y > region->maxY )
+					continue;
+
+				uint32_t* ids = globalData.visibility.ids + y * globalData.renderTarget.width;
+				for ( int32_t c = 0; c < blockSize; c++ )
+				{
+					const int32_t x = bx + c;
+					if ( !(mask & (1ull << (r * blockSize + c))) || x < region->minX || x > region->maxX )
+						continue;
+
+					float* depth = __softrast_depth_pixel ( x, y );
+					const float z = v0->position.w + dzdx * ((float)x - x0) + dzdy * ((float)y - y0);
+					ThreadPixelStats.testedPixels++;
+					if ( z > *depth )
+					{
+						*depth = z;
+						ids[x] = id;
+						ThreadPixelStats.shadedPixels++;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Fan-triangulates the polygon into the visibility buffer; every triangle of the fan keeps the ID of the triangle the polygon was clipped from
+static void __softrast_rasterize_polygon_visibility ( const raster_region* region, const vertex* curVerts, uint32_t vectorCount, uint32_t id )
+{
+	for ( uint32_t i = 2; i < vectorCount; i++ )
+		__softrast_rasterize_triangle_visibility ( region, curVerts, curVerts + i - 1, curVerts + i, id );
+}
+
+// Fills the polygon's edges into the region's outline table and rasterizes the spans, touching only pixels inside the region
+static void __softrast_rasterize_polygon ( const raster_region* region, const vertex* curVerts, uint32_t vectorCount, const softrast_submesh* submesh )
+{
+	//--------------------------------
+	// Variables
+	//--------------------------------
+	outline_table_entry* outlineTable = region->outlineTable;
+	int32_t minTriY = globalData.renderTarget.height, maxTriY = 0;
+
+	//--------------------------------
+	// The half-space rasterizer doesn't need the outline table at all
+	//--------------------------------
+	if ( (FrameDebug.flags & FLAG_RASTERIZE) && (FrameDebug.flags & FLAG_HALF_SPACE_RASTERIZATION) )
+	{
+		__softrast_rasterize_polygon_half_space ( region, curVerts, vectorCount, submesh );
+		return;
+	}
+
+	//--------------------------------
+	// Triangles covering no more than a few pixels skip the outline table altogether
+	//--------------------------------
+	if ( vectorCount == 3 && (FrameDebug.flags & (FLAG_RASTERIZE | FLAG_ENABLE_QUAD_RASTERIZATION | FLAG_SMALL_TRIANGLES)) == (FLAG_RASTERIZE | FLAG_ENABLE_QUAD_RASTERIZATION | FLAG_SMALL_TRIANGLES) )
+	{
+		if ( __softrast_rasterize_small_triangle ( region, curVerts, curVerts + 1, curVerts + 2, submesh ) )
+			return;
+	}
+
+	//--------------------------------
+	// Fill edges into outline table
+	//--------------------------------
+	uint32_t li = vectorCount-1;
+	for ( uint32_t i = 0; i < vectorCount; li = i++ )
+	{
+		//--------------------------------
+		// Determine edge indices
+		//--------------------------------
+		uint32_t i1 = li;
+		uint32_t i2 = i;
+
+		//--------------------------------
+		// We want the edge to go from up to down, so swap if inversed
+		//--------------------------------
+		if ( curVerts[i1].position.y > curVerts[i2].position.y )
+		{
+			uint32_t t = i1;
+			i1 = i2;
+			i2 = t;
+		}
+
+		//--------------------------------
+		// Prepare for the loop
+		//--------------------------------
+		const vertex* vert1 = curVerts + i1;
+		const vertex* vert2 = curVerts + i2;
+
+		float x1 = vert1->position.x;
+		float y1 = vert1->position.y;
+		float z1 = vert1->position.w;	// Taking w instead of z (w = 1.0f / zInViewSpace)
+		float u1 = vert1->u;
+		float v1 = vert1->v;
+
+		float x2 = vert2->position.x;
+		float y2 = vert2->position.y;
+		float z2 = vert2->position.w;	// Taking w instead of z (w = 1.0f / zInViewSpace)
+		float u2 = vert2->u;
+		float v2 = vert2->v;
+
+		float dy = (y2 - y1);// + (FrameDebug.flags & FLAG_DERP ? 1 : 0);
+		float dx = (x2 - x1)/dy;
+		float dz = (z2 - z1)/dy;
+		float du = (u2 - u1)/dy;
+		float dv = (v2 - v1)/dy;
+
+		// Vertices in the guard band can lie above the screen, so round down rather than towards zero
+		int32_t iMinY = ((int32_t)floorf ( y1 )) + 1;
+		int32_t iMaxY = (int32_t)floorf ( y2 );
+		if ( iMaxY < iMinY )
+			continue;
+
+		float topClipY    = iMinY - y1;
+		float bottomClipY = y2 - iMaxY;
+
+		//--------------------------------
+		// Do sub-pixel correction
+		//--------------------------------
+		x1 += dx * topClipY;
+		x2 -= dx * bottomClipY;
+
+		z1 += dz * topClipY;
+		z2 -= dz * bottomClipY;
+
+		u1 += du * topClipY;
+		u2 -= du * bottomClipY;
+		v1 += dv * topClipY;
+		v2 -= dv * bottomClipY;
+
+		//dy = (float)(iMaxY - iMinY);
+		//
+		//dx = (x2 - x1)/dy;
+		//dz = (z2 - z1)/dy;
+		//du = (u2 - u1)/dy;
+		//dv = (v2 - v1)/dy;
+
+#if 0
+		float x = x1;
+		float z = z1;
+		float u = u1;
+		float v = v1;
+#endif
+
+		//--------------------------------
+		// Calculate min, max submesh Y
+		//--------------------------------
+		if ( iMinY < minTriY )
+			minTriY = iMinY;
+		if ( iMaxY > maxTriY )
+			maxTriY = iMaxY;
+
+		//--------------------------------
+		// Loop over the rows (only those that lie within the region)
+		//--------------------------------
+		const int32_t iStartY = MAX ( iMinY, region->minY );
+		const int32_t iEndY   = MIN ( iMaxY, region->maxY );
+
+		outline_table_entry* outline = outlineTable + iStartY;
+
+#if 0
+		for ( int32_t y = iMinY; y <= iMaxY; y++, outlineMinX++, outlineMaxX++, outlineMinZ++, outlineMaxZ++, outlineMinU++, outlineMaxU++, outlineMinV++, outlineMaxV++, x += dx, z += dz, u += du, v += dv )
+		{
+#else
+		int32_t yinc = iStartY - iMinY;
+		for ( int32_t y = iStartY; y <= iEndY; y++, yinc++, outline++ )
+		{
+			float x = x1 + yinc * dx;
+			float z = z1 + yinc * dz;
+			float u = u1 + yinc * du;
+			float v = v1 + yinc * dv;
+#endif
+			if ( x < outline->minX || !(outline->flags & 0x1) )
+			{
+#pragma message ( "TODO: Better out-of-bound checks!" )
+				//assert ( x > 10.0f );
+				outline->minX = x;
+				outline->minZ = z;
+				outline->minU = u;
+				outline->minV = v;
+			}
+			if ( x > outline->maxX || !(outline->flags & 0x1) )
+			{
+				//assert ( x > 10.0f );
+				outline->maxX = x;
+				outline->maxZ = z;
+				outline->maxU = u;
+				outline->maxV = v;
+			}
+			outline->flags = 0x1;
+		}
+
+		//--------------------------------
+		// The rows around the edge only exist in the outline table when the edge touches the screen
+		//--------------------------------
+		if ( iMinY < 0 || iMaxY >= (int32_t)globalData.renderTarget.height )
+			continue;
+
+		outline_table_entry* preEntry  = outlineTable + (iMinY - 1);
+		outline_table_entry* postEntry = outlineTable + (iMaxY + 1);
+
+		float preX  = x1 - 1 * dx;
+		float postX = x1 + (iMaxY - iMinY + 1) * dx;
+
+		if ( !(preEntry->flags & 0x1) && preX < preEntry->minX )
+		{
+			preEntry->minX = x1 - 1 * dx;
+			preEntry->minZ = z1 - 1 * dz;
+			preEntry->minU = u1 - 1 * du;
+			preEntry->minV = v1 - 1 * dv;
+		}
+		if ( !(preEntry->flags & 0x1) && preX > preEntry->maxX )
+		{
+			preEntry->maxX = x1 + (iMaxY - iMinY + 1) * dx;
+			preEntry->maxZ = z1 + (iMaxY - iMinY + 1) * dz;
+			preEntry->maxU = u1 + (iMaxY - iMinY + 1) * du;
+			preEntry->maxV = v1 + (iMaxY - iMinY + 1) * dv;
+		}
+		if ( !(postEntry->flags & 0x1) && postX < postEntry->minX )
+		{
+			postEntry->minX = x1 - 1 * dx;
+			postEntry->minZ = z1 - 1 * dz;
+			postEntry->minU = u1 - 1 * du;
+			postEntry->minV = v1 - 1 * dv;
+		}
+		if ( !(postEntry->flags & 0x1) && postX > postEntry->maxX )
+		{
+			postEntry->maxX = x1 + (iMaxY - iMinY + 1) * dx;
+			postEntry->maxZ = z1 + (iMaxY - iMinY + 1) * dz;
+			postEntry->maxU = u1 + (iMaxY - iMinY + 1) * du;
+			postEntry->maxV = v1 + (iMaxY - iMinY + 1) * dv;
+		}
+	}
+
+	//--------------------------------
+	// Only rasterize the rows that lie within the region
+	//--------------------------------
+	minTriY = MAX ( minTriY, region->minY );
+	maxTriY = MIN ( maxTriY, region->maxY );
+	if ( minTriY > maxTriY )
+		return;
+
+	if ( (FrameDebug.flags & FLAG_RASTERIZE) && (FrameDebug.flags & FLAG_ENABLE_QUAD_RASTERIZATION) )
+#pragma region Quad rasterization
+	{
+#if 1
+		//--------------------------------
+		// Fill surrounding outlines
+		//--------------------------------
+		outlineTable[minTriY-1] = outlineTable[minTriY];
+		outlineTable[maxTriY+1] = outlineTable[maxTriY];
+
+		outlineTable[minTriY-1].minX = (float)globalData.renderTarget.width, outlineTable[minTriY-1].maxX = 0;
+		outlineTable[maxTriY+1].minX = (float)globalData.renderTarget.width, outlineTable[maxTriY+1].maxX = 0;
+#endif
+
+		//--------------------------------
+		// Rasterize time
+		//--------------------------------
+		const int32_t minBlockY = minTriY & (~(1));
+		const int32_t maxBlockY = maxTriY & (~(1));
+
+		{
+			int32_t y1 = minBlockY;
+			int32_t y2 = minBlockY + 1;
+
+			outline_table_entry* outline[2] = { outlineTable + y1, outlineTable + y2 };
+
+			uint32_t* colorRowPtr[2] = {
+				(uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - y1 - 1) * globalData.renderTarget.pitch),
+				(uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - y2 - 1) * globalData.renderTarget.pitch)
+			};
+			float* depthRowPtr[2]    = {
+				globalData.renderTarget.depthBuffer + y1 * globalData.renderTarget.width,
+				globalData.renderTarget.depthBuffer + y2 * globalData.renderTarget.width
+			};
+
+			for ( ; y1 <= maxBlockY; y1 +=2, y2 += 2,
+									colorRowPtr[0] = (uint32_t*)((uintptr_t)colorRowPtr[0] - 2 * globalData.renderTarget.pitch),
+									colorRowPtr[1] = (uint32_t*)((uintptr_t)colorRowPtr[1] - 2 * globalData.renderTarget.pitch),
+									depthRowPtr[0] += 2 * globalData.renderTarget.width, depthRowPtr[1] += 2 * globalData.renderTarget.width,
+									outline[0] += 2, outline[1] += 2 )
+			{
+				//--------------------------------
+				// Prepare useful constant data
+				//--------------------------------
+				const float x1[2] = { outline[0]->minX, outline[1]->minX };
+				const float x2[2] = { outline[0]->maxX, outline[1]->maxX };
+
+				const int32_t ix1[2] = { (int32_t)floorf ( x1[0] ), (int32_t)floorf ( x1[1] ) };
+				const int32_t ix2[2] = { (int32_t)floorf ( x2[0] ), (int32_t)floorf ( x2[1] ) };
+
+				float z1[2] = { outline[0]->minZ, outline[1]->minZ };
+				float u1[2] = { outline[0]->minU, outline[1]->minU };
+				float v1[2] = { outline[0]->minV, outline[1]->minV };
+
+				float z2[2] = { outline[0]->maxZ, outline[1]->maxZ };
+				float u2[2] = { outline[0]->maxU, outline[1]->maxU };
+				float v2[2] = { outline[0]->maxV, outline[1]->maxV };
+
+				const int32_t iMinX = (ix1[0] < ix1[1] ? ix1[0] : ix1[1]) & (~1);
+				const int32_t iMaxX = (ix2[0] > ix2[1] ? ix2[0] : ix2[1]) & (~1);
+
+				//--------------------------------
+				// Clip the span to the region (interpolation still starts at iMinX, so the results don't depend on the region)
+				//--------------------------------
+				const int32_t iStartX = MAX ( iMinX, region->minX );
+				const int32_t iEndX   = MIN ( iMaxX, region->maxX );
+
+				//--------------------------------
+				// Calculate deltas and steps
+				//--------------------------------
+				const float dx[2] = { x2[0] - x1[0], x2[1] - x1[1] };
+			
+				const float zstep[2] = { (z2[0] - z1[0]) / dx[0], (z2[1] - z1[1]) / dx[1] };
+				const float ustep[2] = { (u2[0] - u1[0]) / dx[0], (u2[1] - u1[1]) / dx[1] };
+				const float vstep[2] = { (v2[0] - v1[0]) / dx[0], (v2[1] - v1[1]) / dx[1] };
+
+				//--------------------------------
+				// Prepare useful mutable data
+				//--------------------------------
+				uint32_t* ptr[2][2] = {
+					{ colorRowPtr[0] + iStartX, colorRowPtr[0] + iStartX + 1 },
+					{ colorRowPtr[1] + iStartX, colorRowPtr[1] + iStartX + 1 },
+				};
+				float* dptr[2][2] = {
+					{ depthRowPtr[0] + iStartX, depthRowPtr[0] + iStartX + 1 },
+					{ depthRowPtr[1] + iStartX, depthRowPtr[1] + iStartX + 1 },
+				};
+				int32_t spanCorrection[2] = { iMinX - ix1[0], iMinX - ix1[1] };
+				z1[0] = z1[0] + zstep[0] * spanCorrection[0], z1[1] = z1[1] + zstep[1] * spanCorrection[1];
+				u1[0] = u1[0] + ustep[0] * spanCorrection[0], u1[1] = u1[1] + ustep[1] * spanCorrection[1];
+				v1[0] = v1[0] + vstep[0] * spanCorrection[0], v1[1] = v1[1] + vstep[1] * spanCorrection[1];
+
+				raster_quad_batch batch;
+				batch.quadCount = 0;
+				
+#if 0
+				float z[2] = { z1[0], z1[1] };
+				float u[2] = { u1[0], u1[1] };
+				float v[2] = { v1[0], v1[1] };
+				
+				const float zstep2[2] = { 2.0f * zstep[0], 2.0f * zstep[1] };
+				const float ustep2[2] = { 2.0f * ustep[0], 2.0f * ustep[1] };
+				const float vstep2[2] = { 2.0f * vstep[0], 2.0f * vstep[1] };
+
+				//--------------------------------
+				// Time to fill some spans
+				//--------------------------------
+				for ( int32_t ix = iMinX; ix <= iMaxX; ix+=2,	ptr[0][0] += 2, ptr[0][1] += 2, ptr[1][0] += 2, ptr[1][1] += 2,
+																dptr[0][0] += 2, dptr[0][1] += 2, dptr[1][0] += 2, dptr[1][1] += 2,
+																z[0] += zstep2[0], z[1] += zstep2[1],
+																u[0] += ustep2[0], u[1] += ustep2[1],
+																v[0] += vstep2[0], v[1] += vstep2[1] )
+				{
+#else
+				//--------------------------------
+				// Time to fill some spans
+				//--------------------------------
+				int32_t xinc = iStartX - iMinX;
+				for ( int32_t ix = iStartX; ix <= iEndX; ix+=2, xinc+=2,	ptr[0][0] += 2, ptr[0][1] += 2, ptr[1][0] += 2, ptr[1][1] += 2,
+																dptr[0][0] += 2, dptr[0][1] += 2, dptr[1][0] += 2, dptr[1][1] += 2 )
+				{
+					float z[2] = { z1[0] + xinc * zstep[0], z1[1] + xinc * zstep[1] };
+					float u[2] = { u1[0] + xinc * ustep[0], u1[1] + xinc * ustep[1] };
+					float v[2] = { v1[0] + xinc * vstep[0], v1[1] + xinc * vstep[1] };
+#endif
+					if ( __softrast_checkerboard_skips ( ix, y1 ) )
+						continue;
+
+					//--------------------------------
+					// Determine which pixels of the quad are covered, and shade it
+					//--------------------------------
+					raster_quad quad;
+					quad.x        = ix;
+					quad.y        = y1;
+					quad.coverage = 0;
+					for ( int32_t r = 0; r < 2; r++ )
+					{
+						for ( int32_t c = 0; c < 2; c++ )
+						{
+							if ( (outline[r]->flags & 0x1) && ix + c >= ix1[r] && ix + c <= ix2[r] )
+								quad.coverage |= 1 << (r * 2 + c);
+						}
+					}
+
+					quad.z[0]     = z[0],        quad.z[1]     = z[1];
+					quad.u[0]     = u[0],        quad.u[1]     = u[1];
+					quad.v[0]     = v[0],        quad.v[1]     = v[1];
+					quad.zstep[0] = zstep[0],    quad.zstep[1] = zstep[1];
+					quad.ustep[0] = ustep[0],    quad.ustep[1] = ustep[1];
+					quad.vstep[0] = vstep[0],    quad.vstep[1] = vstep[1];
+					quad.color[0] = ptr[0][0],   quad.color[1] = ptr[1][0];
+					quad.depth[0] = dptr[0][0],  quad.depth[1] = dptr[1][0];
+					quad.shadingRate = __softrast_shading_rate ( ix, y1, submesh );
+
+					if ( globalData.kernelFlags & (FLAG_QUAD_RASTERIZATION_AVX2 | FLAG_QUAD_RASTERIZATION_AVX512) )
+						__softrast_queue_quad ( &batch, &quad, submesh );
+					else
+						__softrast_shade_quad ( &quad, submesh );
+				}
+				__softrast_flush_quads ( &batch, submesh );
+			}
+		}
+
+		//--------------------------------
+		// Reset outline table
+		//--------------------------------
+		outline_table_entry* outline = outlineTable + minTriY;
+		for ( int32_t y = minTriY; y <= maxTriY; y++, outline++ )
+		{
+			outline->flags = 0;
+			outline->minX = (float)globalData.renderTarget.width;
+			outline->maxX = 0.0f;
+		}
+	}
+#pragma endregion
+	else if ( FrameDebug.flags & FLAG_RASTERIZE )
+#pragma region Pixel rasterization
+	{
+		//--------------------------------
+		// Rasterize time
+		//--------------------------------
+		outline_table_entry* outline = outlineTable + minTriY;
+		uint32_t* colorRowPtr        = (uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - minTriY - 1) * globalData.renderTarget.pitch);
+		float* depthRowPtr           = globalData.renderTarget.depthBuffer + minTriY * globalData.renderTarget.width;
+		for ( int32_t y = minTriY; y <= maxTriY; y++, outline++, depthRowPtr += globalData.renderTarget.width )
+		{
+			const int32_t ix1     = (int32_t)floorf ( outline->minX );
+			const int32_t iStartX = MAX ( ix1, region->minX );
+			const int32_t iEndX   = MIN ( (int32_t)floorf ( outline->maxX ), region->maxX );
+
+			uint32_t* ptr     = colorRowPtr + iStartX;
+			uint32_t* endptr  = colorRowPtr + iEndX;
+			float* zptr       = depthRowPtr + iStartX;
+			float x1 = outline->minX;
+			float x2 = outline->maxX;
+
+			//assert ( x1 > 10.0f );
+
+			float z1 = outline->minZ;
+			float z2 = outline->maxZ;
+
+			float u1 = outline->minU;
+			float u2 = outline->maxU;
+			float v1 = outline->minV;
+			float v2 = outline->maxV;
+
+			float dx = (x2 - x1);//+(FrameDebug.flags & FLAG_DERP ? 1 : 0);
+			float dz = (z2 - z1) / dx;
+			float du = (u2 - u1) / dx;
+			float dv = (v2 - v1) / dx;
+
+			//if ( FrameDebug.flags & FLAG_DERP2 )
+			//{
+			//	int32_t ix1  = (int32_t)x1 + 1;
+			//	float subtex = ix1 - x1;
+			//
+			//	z1 += subtex * dz;
+			//	u1 += subtex * du;
+			//	v1 += subtex * dv;
+			//}
+
+			//--------------------------------
+			// Depth pre-pass; 1/w is interpolated exactly like below, and nothing else is
+			//--------------------------------
+			if ( globalData.depthPrePass )
+			{
+				for ( int32_t xinc = iStartX - ix1; zptr <= depthRowPtr + iEndX; zptr++, xinc++ )
+				{
+					const float z = z1 + xinc * dz;
+					if ( z > *zptr )
+						*zptr = z;
+				}
+				colorRowPtr = (uint32_t*)((uintptr_t)colorRowPtr - globalData.renderTarget.pitch);
+				continue;
+			}
+			ThreadPixelStats.testedPixels += MAX ( iEndX - iStartX + 1, 0 );
+
+#if 0
+			// Faster, but causes extremely jumpy textures. Avoid using!
+			float z = z1;
+			float u = u1;
+			float v = v1;
+			for ( ; ptr <= endptr; ptr++, zptr++, z += dz, u += du, v += dv )
+			{
+#else
+			for ( int32_t xinc = iStartX - ix1; ptr <= endptr; ptr++, zptr++, xinc++ )
+			{
+				float z = z1 + xinc * dz;
+				float u = u1 + xinc * du;
+				float v = v1 + xinc * dv;
+#endif
+				if ( !(FrameDebug.flags & FLAG_DEPTH_TESTING) || z > *zptr )
+				{
+					ThreadPixelStats.shadedPixels++;
+					if ( FrameDebug.renderMode == RENDER_MODE_FLAT_COLOR )
+						*ptr = 0xFFFF0000;
+					else if ( FrameDebug.renderMode == RENDER_MODE_UV )
+					{
+						float fx = u * (1.0f/z);
+						float fy = v * (1.0f/z);
+						fx = fx - (int32_t)fx;
+						fy = fy - (int32_t)fy;
+						*ptr = (((uint8_t)(fx * 256.0f))<<16) | (((uint8_t)(fy * 256.0f))<<8);
+					}
+					else if ( FrameDebug.renderMode == RENDER_MODE_ZBUFFER )
+						*ptr = (uint32_t)((1.0f-((1.0f/z)-globalData.shadeTarget.nearClip)/(globalData.shadeTarget.farClip-globalData.shadeTarget.nearClip)) * 255.0f);
+					else if ( FrameDebug.renderMode == RENDER_MODE_TEXTURED )
+					{
+						if ( submesh->texture )
+						{
+							float fx = u * (1.0f/z);
+							float fy = v * (1.0f/z);
+							int32_t ix = (int32_t)((fx - (int32_t)fx) * submesh->texture->width );
+							int32_t iy = (int32_t)((fy - (int32_t)fy) * submesh->texture->height);
+							assert ( ix >= 0 && ix < submesh->texture->width );
+							assert ( iy >= 0 && iy < submesh->texture->height );
+
+							if ( submesh->texture->format != SOFTRAST_TEXTURE_FORMAT_RGBA8 )
+							{
+								*ptr = softrast_fetch_compressed ( submesh->texture, 0, ix, iy );
+							}
+							else if ( FrameDebug.textureAddressingMode == TEXTURE_ADDRESSING_LINEAR )
+							{
+								*ptr = submesh->texture->mipData[0][iy * submesh->texture->width + ix];
+							}
+							else if ( FrameDebug.textureAddressingMode == TEXTURE_ADDRESSING_TILED )
+							{
+								uint32_t tileidx = (iy >> 2) * (submesh->texture->width >> 2) + (ix >> 2);
+								uint32_t pixidx  = ((iy & 3) << 2) + (ix & 3);
+								*ptr = submesh->texture->mipData[0][(tileidx << 4) + pixidx];
+							}
+							else if ( FrameDebug.textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
+							{
+								if ( !(FrameDebug.flags & FLAG_FILTER_LUT) )
+								{
+									uint32_t swizIdx;
+							
+									// yxyx yxyx yxyx yxyx yxyx yxyx yxyx yxyx
+									swizIdx = 0;
+
+									//    0000 0000 0000 0000 xxxx xxxx xxxx xxxx
+									// => 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x 0x0x
+									for ( uint32_t i = 0; i < 16; i++ )
+									{
+										swizIdx |= ((ix & (1<<(i))) << (i));
+										swizIdx |= ((iy & (1<<(i))) << (i+1));
+									}
+									*ptr = submesh->texture->mipData[0][swizIdx];
+								}
+								else
+								{
+									uint32_t swizIdx;
+
+									// xxxx => 0x0x 0x0x
+									static const uint32_t mortonLUT[] = {
+										0x00, // 0000 (0x0) => 0000 0000 (0x00)
+										0x01, // 0001 (0x1) => 0000 0001 (0x01)
+										0x04, // 0010 (0x2) => 0000 0100 (0x04)
+										0x05, // 0011 (0x3) => 0000 0101 (0x05)
+										0x10, // 0100 (0x4) => 0001 0000 (0x10)
+										0x11, // 0101 (0x5) => 0001 0001 (0x11)
+										0x14, // 0110 (0x6) => 0001 0100 (0x14)
+										0x15, // 0111 (0x7) => 0001 0101 (0x15)
+										0x40, // 1000 (0x8) => 0100 0000 (0x40)
+										0x41, // 1001 (0x9) => 0100 0001 (0x41)
+										0x44, // 1010 (0xA) => 0100 0100 (0x44)
+										0x45, // 1011 (0xB) => 0100 0101 (0x45)
+										0x50, // 1100 (0xC) => 0101 0000 (0x50)
+										0x51, // 1101 (0xD) => 0101 0001 (0x51)
+										0x54, // 1110 (0xE) => 0101 0100 (0x54)
+										0x55, // 1111 (0xF) => 0101 0101 (0x55)
+									};
+
+									uint32_t swizX   = mortonLUT[(ix    ) & 0xF]
+													| (mortonLUT[(ix>> 4) & 0xF] <<  8)
+													| (mortonLUT[(ix>> 8) & 0xF] << 16)
+													| (mortonLUT[(ix>>12) & 0xF] << 24);
+									uint32_t swizY   = mortonLUT[(iy    ) & 0xF]
+													| (mortonLUT[(iy>> 4) & 0xF] <<  8)
+													| (mortonLUT[(iy>> 8) & 0xF] << 16)
+													| (mortonLUT[(iy>>12) & 0xF] << 24);
+												swizIdx = swizX | (swizY<<1);
+
+									*ptr = submesh->texture->mipData[0][swizIdx];
+								}
+							}
+						}
+						else
+							*ptr = 0xFF00FF;
+					}
+					//else if ( FrameDebug.renderMode == RENDER_MODE_TEXTURE_BILINEAR )
+					//{
+					//	if ( submesh->texture )
+					//	{
+					//		float fx = (u * (1.0f/z));
+					//		float fy = (v * (1.0f/z));
+					//		fx = (fx - (int32_t)fx) * submesh->texture->width;
+					//		fy = (fy - (int32_t)fy) * submesh->texture->height;
+					//
+					//		int32_t ix1 = ((int32_t)(fx)) & (submesh->texture->width -1);
+					//		int32_t iy1 = ((int32_t)(fy)) & (submesh->texture->height-1);
+					//		int32_t ix2 = (ix1 + 1)                                  & (submesh->texture->width -1);
+					//		int32_t iy2 = (iy1 + 1)                                  & (submesh->texture->height-1);
+					//
+					//		uint32_t fracXFactor = (uint32_t)((fx - ix1) * 65536);
+					//		uint32_t fracYFactor = (uint32_t)((fy - iy1) * 65536);
+					//
+					//		uint32_t c00 = submesh->texture->mipData[0][iy1 * submesh->texture->width + ix1];
+					//		uint32_t c01 = submesh->texture->mipData[0][iy1 * submesh->texture->width + ix2];
+					//		uint32_t c10 = submesh->texture->mipData[0][iy2 * submesh->texture->width + ix1];
+					//		uint32_t c11 = submesh->texture->mipData[0][iy2 * submesh->texture->width + ix2];
+					//
+					//		uint8_t r =
+					//			  (((65536 - fracYFactor) * ((((65536 - fracXFactor) * (c00 & 0xFF)) + ((fracXFactor) * (c01 & 0xFF))) >> 16)) >> 16)
+					//			+ (((        fracYFactor) * ((((65536 - fracXFactor) * (c10 & 0xFF)) + ((fracXFactor) * (c11 & 0xFF))) >> 16)) >> 16);
+					//		uint8_t g =
+					//			  (((65536 - fracYFactor) * ((((65536 - fracXFactor) * ((c00>>8) & 0xFF)) + ((fracXFactor) * ((c01>>8) & 0xFF))) >> 16)) >> 16)
+					//			+ (((        fracYFactor) * ((((65536 - fracXFactor) * ((c10>>8) & 0xFF)) + ((fracXFactor) * ((c11>>8) & 0xFF))) >> 16)) >> 16);
+					//		uint8_t b =
+					//			  (((65536 - fracYFactor) * ((((65536 - fracXFactor) * ((c00>>16) & 0xFF)) + ((fracXFactor) * ((c01>>16) & 0xFF))) >> 16)) >> 16)
+					//			+ (((        fracYFactor) * ((((65536 - fracXFactor) * ((c10>>16) & 0xFF)) + ((fracXFactor) * ((c11>>16) & 0xFF))) >> 16)) >> 16);
+					//
+					//		uint32_t color = (b<<16) | (g<<8) | (r);
+					//
+					//		*ptr = color;
+					//	}
+					//	else
+					//		*ptr = 0xFF00FF;
+					//}
+					*zptr = z;
+				}
+			}
+
+			colorRowPtr = (uint32_t*)((uintptr_t)colorRowPtr - globalData.renderTarget.pitch);
+		}
+
+		//--------------------------------
+		// Reset outline table
+		//--------------------------------
+		outline = outlineTable + minTriY;
+		for ( int32_t y = minTriY; y <= maxTriY; y++, outline++ )
+		{
+			outline->flags = 0;
+			outline->minX  = (float)globalData.renderTarget.width;
+			outline->maxX  = 0.0f;
+		}
+	}
+#pragma endregion
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Hands the calling thread's pixel statistics over to the frame; threads only ever add to their own slot, so no atomics are needed
+static void __softrast_gather_pixel_stats ( uint32_t threadIndex )
+{
+	globalData.threadPixelStats[threadIndex].testedPixels += ThreadPixelStats.testedPixels;
+	globalData.threadPixelStats[threadIndex].shadedPixels += ThreadPixelStats.shadedPixels;
+	ThreadPixelStats.testedPixels = ThreadPixelStats.shadedPixels = 0;
+}
+
+static void __softrast_rasterize_tile ( void* userData, uint32_t jobIndex, uint32_t threadIndex )
+{
+	const tile_bins* bins = (const tile_bins*)userData;
+
+	const uint32_t polygonCount = bins->binCounts[jobIndex];
+	if ( !polygonCount )
+		return;
+
+	//--------------------------------
+	// Determine the tile's pixel region; every thread gets its own outline table
+	//--------------------------------
+	const int32_t tileX = (int32_t)(jobIndex % globalData.tiles.tileCountX);
+	const int32_t tileY = (int32_t)(jobIndex / globalData.tiles.tileCountX);
+
+	raster_region region;
+	region.outlineTable = globalData.outlineTable + threadIndex * globalData.tiles.outlineTableStride;
+	region.minX         = tileX * SOFTRAST_TILE_SIZE;
+	region.minY         = tileY * SOFTRAST_TILE_SIZE;
+	region.maxX         = MIN ( region.minX + SOFTRAST_TILE_SIZE, (int32_t)globalData.renderTarget.width  ) - 1;
+	region.maxY         = MIN ( region.minY + SOFTRAST_TILE_SIZE, (int32_t)globalData.renderTarget.height ) - 1;
+
+	//--------------------------------
+	// Rasterize the binned polygons in submission order
+	//--------------------------------
+	const uint16_t* bin = bins->bins + jobIndex * SOFTRAST_TILE_BIN_CAPACITY;
+	for ( uint32_t i = 0; i < polygonCount; i++ )
+	{
+		const binned_polygon* polygon = bins->polygons + bin[i];
+		if ( polygon->visibilityID )
+			__softrast_rasterize_polygon_visibility ( &region, polygon->verts, polygon->vectorCount, polygon->visibilityID );
+		else
+			__softrast_rasterize_polygon ( &region, polygon->verts, polygon->vectorCount, polygon->submesh );
+	}
+	__softrast_gather_pixel_stats ( threadIndex );
+}
+
+static void __softrast_empty_bins ( tile_bins* bins )
+{
+	memset ( bins->binCounts, 0, globalData.tiles.tileCountX * globalData.tiles.tileCountY * sizeof ( uint32_t ) );
+	bins->polygonCount = 0;
+}
+
+static void __softrast_acquire_target ( );
+static void __softrast_poll_finishing_frame ( );
+
+static void __softrast_flush_tiles ( )
+{
+	tile_bins* bins = globalData.tiles.binning;
+	if ( !bins->polygonCount )
+		return;
+
+	//--------------------------------
+	// Rasterize all tiles in parallel (tiles never share pixels, so no further synchronization is needed)
+	//--------------------------------
+	__softrast_acquire_target ( );
+	softrast_thread_pool_run ( __softrast_rasterize_tile, bins, globalData.tiles.tileCountX * globalData.tiles.tileCountY );
+	__softrast_empty_bins ( bins );
+}
+
+static void __softrast_bin_polygon ( binned_polygon* polygon, const softrast_submesh* submesh )
+{
+	tile_bins* bins = globalData.tiles.binning;
+
+	//--------------------------------
+	// Determine the screen space bounds of the polygon
+	//--------------------------------
+	float minX = polygon->verts[0].position.x, maxX = minX;
+	float minY = polygon->verts[0].position.y, maxY = minY;
+	for ( uint32_t i = 1; i < polygon->vectorCount; i++ )
+	{
+		minX = MIN ( minX, polygon->verts[i].position.x ), maxX = MAX ( maxX, polygon->verts[i].position.x );
+		minY = MIN ( minY, polygon->verts[i].position.y ), maxY = MAX ( maxY, polygon->verts[i].position.y );
+	}
+
+	//--------------------------------
+	// Determine the range of tiles it touches
+	//--------------------------------
+	const int32_t tileMinX = CLAMP ( (int32_t)minX, 0, (int32_t)globalData.renderTarget.width  - 1 ) / SOFTRAST_TILE_SIZE;
+	const int32_t tileMaxX = CLAMP ( (int32_t)maxX, 0, (int32_t)globalData.renderTarget.width  - 1 ) / SOFTRAST_TILE_SIZE;
+	const int32_t tileMinY = CLAMP ( (int32_t)minY, 0, (int32_t)globalData.renderTarget.height - 1 ) / SOFTRAST_TILE_SIZE;
+	const int32_t tileMaxY = CLAMP ( (int32_t)maxY, 0, (int32_t)globalData.renderTarget.height - 1 ) / SOFTRAST_TILE_SIZE;
+
+	//--------------------------------
+	// Flush first if any of those bins is out of space
+	//--------------------------------
+	for ( int32_t ty = tileMinY; ty <= tileMaxY; ty++ )
+	{
+		const uint32_t* binCount = bins->binCounts + ty * globalData.tiles.tileCountX + tileMinX;
+		for ( int32_t tx = tileMinX; tx <= tileMaxX; tx++, binCount++ )
+		{
+			if ( *binCount == SOFTRAST_TILE_BIN_CAPACITY )
+			{
+				__softrast_flush_tiles ( );
+				memmove ( bins->polygons, polygon, sizeof ( binned_polygon ) );
+				polygon = bins->polygons;
+				ty = tileMaxY;
+				break;
+			}
+		}
+	}
+
+	//--------------------------------
+	// Add the polygon to the bins
+	//--------------------------------
+	const uint16_t polygonIndex = (uint16_t)(polygon - bins->polygons);
+	polygon->submesh = submesh;
+
+	for ( int32_t ty = tileMinY; ty <= tileMaxY; ty++ )
+	{
+		for ( int32_t tx = tileMinX; tx <= tileMaxX; tx++ )
+		{
+			const uint32_t tile = ty * globalData.tiles.tileCountX + tx;
+			bins->bins[tile * SOFTRAST_TILE_BIN_CAPACITY + bins->binCounts[tile]++] = polygonIndex;
+		}
+	}
+
+	//--------------------------------
+	// Flush when the polygon storage is full
+	//--------------------------------
+	if ( ++bins->polygonCount == SOFTRAST_TILE_MAX_POLYGONS )
+		__softrast_flush_tiles ( );
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Sets up the triangle behind a visibility buffer ID again, and derives the screen space planes of its attributes
+static void __softrast_visibility_setup ( visibility_setup* setup, uint32_t id )
+{
+	const visibility_draw* draw = globalData.visibility.draws + (id >> SOFTRAST_VISIBILITY_TRIANGLE_BITS) - 1;
+	const uint32_t* index = draw->submesh->indices + 3 * (id & SOFTRAST_VISIBILITY_TRIANGLE_MASK);
+
+	__declspec(align(64)) vertex verts[SOFTRAST_MAX_POLYGON_VERTICES];
+	const uint32_t vectorCount = __softrast_setup_polygon ( verts, draw->mesh, index, draw->res );
+	assert ( vectorCount >= 3 );
+
+	//--------------------------------
+	// Clipping keeps the polygon in the triangle's plane, so any triangle of the fan will do; take the largest for well-conditioned gradients
+	//--------------------------------
+	const vertex* v0 = verts, *v1 = verts + 1, *v2 = verts + 2;
+	float area = 0.0f;
+	for ( uint32_t i = 2; i < vectorCount; i++ )
+	{
+		const float a = (verts[i - 1].position.x - verts[0].position.x) * (verts[i].position.y - verts[0].position.y) - (verts[i].position.x - verts[0].position.x) * (verts[i - 1].position.y - verts[0].position.y);
+		if ( fabsf ( a ) > fabsf ( area ) )
+		{
+			area = a;
+			v1   = verts + i - 1;
+			v2   = verts + i;
+		}
+	}
+
+	//--------------------------------
+	// Barycentric weights are the edge functions opposite to each vertex divided by the (signed) area
+	//--------------------------------
+	const float invArea = 1.0f / area;
+	const float a0 = v1->position.y - v2->position.y, b0 = v2->position.x - v1->position.x;
+	const float a1 = v2->position.y - v0->position.y, b1 = v0->position.x - v2->position.x;
+	const float a2 = v0->position.y - v1->position.y, b2 = v1->position.x - v0->position.x;
+
+	setup->id      = id;
+	setup->submesh = draw->submesh;
+	setup->x0      = v0->position.x, setup->y0 = v0->position.y;
+	setup->z0      = v0->position.w, setup->u0 = v0->u, setup->v0 = v0->v;
+	setup->dzdx    = (a0 * v0->position.w + a1 * v1->position.w + a2 * v2->position.w) * invArea;
+	setup->dzdy    = (b0 * v0->position.w + b1 * v1->position.w + b2 * v2->position.w) * invArea;
+	setup->dudx    = (a0 * v0->u + a1 * v1->u + a2 * v2->u) * invArea;
+	setup->dudy    = (b0 * v0->u + b1 * v1->u + b2 * v2->u) * invArea;
+	setup->dvdx    = (a0 * v0->v + a1 * v1->v + a2 * v2->v) * invArea;
+	setup->dvdy    = (b0 * v0->v + b1 * v1->v + b2 * v2->v) * invArea;
+}
+
+// Shades the visibility buffer's pixels in a band of rows, every visible pixel exactly once
+static void __softrast_resolve_visibility_band ( void* userData, uint32_t jobIndex, uint32_t threadIndex )
+{
+	(void)userData;
+
+	visibility_setup cache[SOFTRAST_VISIBILITY_CACHE_SIZE];
+	for ( uint32_t i = 0; i < SOFTRAST_VISIBILITY_CACHE_SIZE; i++ )
+		cache[i].id = 0;
+
+	raster_quad_batch batch;
+	const softrast_submesh* batchSubmesh = NULL;
+	batch.quadCount = 0;
+
+	const int32_t width  = (int32_t)globalData.renderTarget.width;
+	const int32_t height = (int32_t)globalData.renderTarget.height;
+	const int32_t minY   = (int32_t)jobIndex * SOFTRAST_TILE_SIZE;
+	const int32_t maxY   = MIN ( minY + SOFTRAST_TILE_SIZE, height );
+
+	for ( int32_t y = minY; y < maxY; y += 2 )
+	{
+		const uint32_t* ids[2] = { globalData.visibility.ids + y * width, globalData.visibility.ids + MIN ( y + 1, height - 1 ) * width };
+
+		for ( int32_t x = 0; x < width; x += 2 )
+		{
+			if ( __softrast_checkerboard_skips ( x, y ) )
+				continue;
+
+			//--------------------------------
+			// Pixels past the render target edge stay empty
+			//--------------------------------
+			uint32_t quadIDs[4] = {
+				ids[0][x], x + 1 < width ? ids[0][x + 1] : 0,
+				y + 1 < height ? ids[1][x] : 0, x + 1 < width && y + 1 < height ? ids[1][x + 1] : 0,
+			};
+
+			//--------------------------------
+			// Shade one quad per distinct triangle in it, covering just its own pixels
+			//--------------------------------
+			for ( uint32_t p = 0; p < 4; p++ )
+			{
+				const uint32_t id = quadIDs[p];
+				if ( !id )
+					continue;
+
+				uint32_t coverage = 0;
+				for ( uint32_t q = p; q < 4; q++ )
+				{
+					if ( quadIDs[q] == id )
+					{
+						coverage   |= 1 << q;
+						quadIDs[q]  = 0;
+					}
+				}
+
+				visibility_setup* setup = cache + (id & (SOFTRAST_VISIBILITY_CACHE_SIZE - 1));
+				if ( setup->id != id )
+					__softrast_visibility_setup ( setup, id );
+
+				raster_quad quad;
+				quad.x        = x;
+				quad.y        = y;
+				quad.coverage = coverage;
+				for ( int32_t r = 0; r < 2; r++ )
+				{
+					const float dx = (float)quad.x - setup->x0;
+					const float dy = (float)(quad.y + r) - setup->y0;
+
+					quad.z[r]     = setup->z0 + setup->dzdx * dx + setup->dzdy * dy;
+					quad.u[r]     = setup->u0 + setup->dudx * dx + setup->dudy * dy;
+					quad.v[r]     = setup->v0 + setup->dvdx * dx + setup->dvdy * dy;
+					quad.zstep[r] = setup->dzdx;
+					quad.ustep[r] = setup->dudx;
+					quad.vstep[r] = setup->dvdx;
+					quad.color[r] = (uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (globalData.renderTarget.height - (quad.y + r) - 1) * globalData.renderTarget.pitch) + quad.x;
+					quad.depth[r] = globalData.renderTarget.depthBuffer + (quad.y + r) * globalData.renderTarget.width + quad.x;
+				}
+				quad.shadingRate = __softrast_shading_rate ( quad.x, quad.y, setup->submesh );
+
+				//--------------------------------
+				// The visibility pass already settled depth; reset it for the covered pixels so the shaders' depth test passes and writes it back
+				//--------------------------------
+				for ( uint32_t q = 0; q < 4; q++ )
+				{
+					if ( coverage & (1 << q) )
+						*__softrast_depth_pixel ( x + (q & 1), y + (q >> 1) ) = 0.0f;
+				}
+
+				if ( globalData.kernelFlags & (FLAG_QUAD_RASTERIZATION_AVX2 | FLAG_QUAD_RASTERIZATION_AVX512) )
+				{
+					if ( batchSubmesh != setup->submesh )
+					{
+						__softrast_flush_quads ( &batch, batchSubmesh );
+						batchSubmesh = setup->submesh;
+					}
+					__softrast_queue_quad ( &batch, &quad, batchSubmesh );
+				}
+				else
+				{
+					__softrast_shade_quad ( &quad, setup->submesh );
+				}
+			}
+		}
+	}
+	__softrast_flush_quads ( &batch, batchSubmesh );
+	__softrast_gather_pixel_stats ( threadIndex );
+}
+
+// Shades the visibility buffer, spreading bands of rows over the thread pool when rasterizing tiled
+static void __softrast_resolve_visibility ( uint32_t parallel )
+{
+	const uint32_t bandCount = (globalData.renderTarget.height + SOFTRAST_TILE_SIZE - 1) / SOFTRAST_TILE_SIZE;
+	if ( parallel )
+	{
+		softrast_thread_pool_run ( __softrast_resolve_visibility_band, NULL, bandCount );
+	}
+	else
+	{
+		for ( uint32_t i = 0; i < bandCount; i++ )
+			__softrast_resolve_visibility_band ( NULL, i, 0 );
+	}
+}
+
+// Shades everything drawn into the visibility buffer so far and empties it, so the draw table can start over. Shading settles depth, which the
+// draws after it test against as usual.
+static void __softrast_restart_visibility ( uint32_t tiled )
+{
+	if ( tiled )
+		__softrast_flush_tiles ( );
+	__softrast_resolve_visibility ( tiled );
+
+	memset ( globalData.visibility.ids, 0, globalData.renderTarget.width * globalData.renderTarget.height * sizeof ( uint32_t ) );
+	globalData.visibility.drawCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static void __softrast_transform_vertices ( void* userData, uint32_t jobIndex, uint32_t threadIndex )
+{
+	(void)threadIndex;
+	const transform_job* job = (const transform_job*)userData + jobIndex;
+	softrast_mesh* mesh      = job->mesh->mesh;
+	const uint32_t first     = job->firstVertex;
+
+	bbm_soa_vec3 positions;
+	bbm_soa_vec4 transformedPositions;
+	bbm_soa_vec3_init ( &positions, mesh->positions.x + first, mesh->positions.y + first, mesh->positions.z + first, job->vertexCount );
+	bbm_soa_vec4_init ( &transformedPositions, mesh->transformedPositions.x + first, mesh->transformedPositions.y + first, mesh->transformedPositions.z + first, mesh->transformedPositions.w + first, job->vertexCount );
+	bbm_aos_mat4_mul_soa_vec3w1_out_vec4 ( &transformedPositions, &globalData.viewProjectionMatrix, &positions );
+
+	softrast_thread_pool_atomic_decrement ( &job->mesh->pendingJobs );
+}
+
+// Number of jobs the mesh's vertex transform is split into. Huge meshes get larger ranges rather than more jobs, so the occluders always fit in the job table together
+static uint32_t __softrast_transform_job_count ( const softrast_mesh* mesh, uint32_t* rangeSize )
+{
+	const uint32_t vertexCount = mesh->positions.vectorCount;
+	const uint32_t maxJobs     = SOFTRAST_MAX_TRANSFORM_JOBS / SOFTRAST_MAX_OCCLUDERS;
+
+	*rangeSize = MAX ( SOFTRAST_TRANSFORM_JOB_VERTICES, ((vertexCount + maxJobs - 1) / maxJobs + 15) & ~15u );
+	return (vertexCount + *rangeSize - 1) / *rangeSize;
+}
+
+// Appends the jobs transforming the mesh's vertices to the job table, which must have room for them
+static void __softrast_queue_transform ( queued_mesh* queuedMesh )
+{
+	uint32_t rangeSize;
+	const uint32_t vertexCount = queuedMesh->mesh->positions.vectorCount;
+	const uint32_t jobCount    = __softrast_transform_job_count ( queuedMesh->mesh, &rangeSize );
+	assert ( globalData.transform.jobCount + jobCount <= SOFTRAST_MAX_TRANSFORM_JOBS );
+
+	queuedMesh->pendingJobs = (long)jobCount;
+	for ( uint32_t first = 0; first < vertexCount; first += rangeSize )
+	{
+		transform_job* job = globalData.transform.jobs + globalData.transform.jobCount++;
+		job->mesh        = queuedMesh;
+		job->firstVertex = first;
+		job->vertexCount = MIN ( rangeSize, vertexCount - first );
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Projects the corners of a mesh's AABB to the screen. Returns 0 when a corner doesn't lie beyond the near plane, leaving the mesh's extent on screen unbounded
+static uint32_t __softrast_project_aabb ( const softrast_mesh* mesh, float* rect, float* maxZ )
+{
+	__declspec(align(16))
+		float _aabbCornersIn[8*3] = {
+			mesh->aabbMin.x, mesh->aabbMin.x, mesh->aabbMin.x, mesh->aabbMin.x, mesh->aabbMax.x, mesh->aabbMax.x, mesh->aabbMax.x, mesh->aabbMax.x,
+			mesh->aabbMin.y, mesh->aabbMin.y, mesh->aabbMax.y, mesh->aabbMax.y, mesh->aabbMin.y, mesh->aabbMin.y, mesh->aabbMax.y, mesh->aabbMax.y,
+			mesh->aabbMin.z, mesh->aabbMax.z, mesh->aabbMin.z, mesh->aabbMax.z, mesh->aabbMin.z, mesh->aabbMax.z, mesh->aabbMin.z, mesh->aabbMax.z,
+		};
+	__declspec(align(16))
+		float _aabbCornersOut[8*4];
+	bbm_soa_vec3 aabbCornersIn;
+	bbm_soa_vec4 aabbCornersOut;
+
+	bbm_soa_vec3_init ( &aabbCornersIn,  _aabbCornersIn,  _aabbCornersIn  + 8, _aabbCornersIn  + 16, 8 );
+	bbm_soa_vec4_init ( &aabbCornersOut, _aabbCornersOut, _aabbCornersOut + 8, _aabbCornersOut + 16, _aabbCornersOut + 24, 8 );
+
+	bbm_aos_mat4_mul_soa_vec3w1_out_vec4 ( &aabbCornersOut, &globalData.viewProjectionMatrix, &aabbCornersIn );
+
+	rect[0] = rect[1] = FLT_MAX, rect[2] = rect[3] = -FLT_MAX;
+	*maxZ = 0.0f;
+	for ( uint32_t i = 0; i < 8; i++ )
+	{
+		if ( aabbCornersOut.w[i] <= globalData.nearClip )
+			return 0;
+
+		//--------------------------------
+		// 1/w is largest at a corner, and the depth buffer holds 1/w, so no surface inside the box gets any closer than this
+		//--------------------------------
+		const float invW = 1.0f / aabbCornersOut.w[i];
+		const float x    = aabbCornersOut.x[i] * invW * globalData.viewport.bias[0] + globalData.viewport.offset[0];
+		const float y    = aabbCornersOut.y[i] * invW * globalData.viewport.bias[1] + globalData.viewport.offset[1];
+
+		rect[0] = MIN ( rect[0], x ), rect[1] = MIN ( rect[1], y );
+		rect[2] = MAX ( rect[2], x ), rect[3] = MAX ( rect[3], y );
+		*maxZ   = MAX ( *maxZ, invW );
+	}
+	return 1;
+}
+
+// Writes a screen space triangle into the occlusion buffer. A pixel's depth only moves once triangles have covered all of its samples; until then their coverage and nearest depth are gathered on the side
+static void __softrast_rasterize_occluder_triangle ( const vertex* v0, const vertex* v1, const vertex* v2 )
+{
+	half_space_edges edges;
+	if ( !__softrast_half_space_setup ( &edges, &v0, &v1, &v2 ) )
+		return;
+
+	const float dzdx = (edges.fa[1] * v0->position.w + edges.fa[2] * v1->position.w + edges.fa[0] * v2->position.w) / edges.area;
+	const float dzdy = (edges.fb[1] * v0->position.w + edges.fb[2] * v1->position.w + edges.fb[0] * v2->position.w) / edges.area;
+
+	//--------------------------------
+	// Occlusion buffer pixels touching the triangle's bounding box
+	//--------------------------------
+	const int32_t minX = MAX ( edges.minX, 0 );
+	const int32_t minY = MAX ( edges.minY, 0 );
+	const int32_t maxX = MIN ( edges.maxX, (int32_t)globalData.renderTarget.width  - 1 );
+	const int32_t maxY = MIN ( edges.maxY, (int32_t)globalData.renderTarget.height - 1 );
+	if ( minX > maxX || minY > maxY )
+		return;
+
+	const int32_t span = SOFTRAST_OCCLUSION_SCALE - 1;
+	for ( int32_t oy = minY / SOFTRAST_OCCLUSION_SCALE; oy <= maxY / SOFTRAST_OCCLUSION_SCALE; oy++ )
+	{
+		const int32_t y    = oy * SOFTRAST_OCCLUSION_SCALE;
+		const uint32_t row = oy * globalData.occlusion.width;
+
+		for ( int32_t ox = minX / SOFTRAST_OCCLUSION_SCALE; ox <= maxX / SOFTRAST_OCCLUSION_SCALE; ox++ )
+		{
+			const int32_t x = ox * SOFTRAST_OCCLUSION_SCALE;
+
+			//--------------------------------
+			// Samples past the render target edge can't be seen through, so count them as covered
+			//--------------------------------
+			uint32_t mask = (uint32_t)__softrast_half_space_block_4x4 ( &edges, x, y );
+			if ( !mask )
+				continue;
+			for ( int32_t r = 0; r <= span; r++ )
+			{
+				for ( int32_t c = 0; c <= span; c++ )
+				{
+					if ( x + c >= (int32_t)globalData.renderTarget.width || y + r >= (int32_t)globalData.renderTarget.height )
+						mask |= 1u << (r * SOFTRAST_OCCLUSION_SCALE + c);
+				}
+			}
+
+			//--------------------------------
+			// Depth is linear, so its minimum over the pixel is found at a corner, which bounds every covered sample
+			//--------------------------------
+			const float minZ = v0->position.w + dzdx * ((float)x - v0->position.x) + dzdy * ((float)y - v0->position.y) + (MIN ( dzdx, 0.0f ) + MIN ( dzdy, 0.0f )) * span;
+
+			const uint32_t i = row + ox;
+			if ( mask == SOFTRAST_OCCLUSION_FULL_MASK )
+			{
+				globalData.occlusion.depth[i] = MAX ( globalData.occlusion.depth[i], minZ );
+				continue;
+			}
+
+			globalData.occlusion.pendingDepth[i] = MIN ( globalData.occlusion.pendingDepth[i], minZ );
+			globalData.occlusion.pendingMask[i] |= (uint16_t)mask;
+			if ( globalData.occlusion.pendingMask[i] == SOFTRAST_OCCLUSION_FULL_MASK )
+			{
+				globalData.occlusion.depth[i]        = MAX ( globalData.occlusion.depth[i], globalData.occlusion.pendingDepth[i] );
+				globalData.occlusion.pendingDepth[i] = FLT_MAX;
+				globalData.occlusion.pendingMask[i]  = 0;
+			}
+		}
+	}
+}
+
+// Picks the meshes with the largest screen footprint, ignoring those too small to hide much, and rasterizes them into the occlusion buffer. Only draws of whole meshes are candidates. Returns the number of occluders, which are written to occluders
+static uint32_t __softrast_render_occluders ( const frame_draw* draws, uint32_t drawCount, softrast_mesh** occluders )
+{
+	const float screenArea = (float)globalData.renderTarget.width * (float)globalData.renderTarget.height;
+
+	float occluderArea[SOFTRAST_MAX_OCCLUDERS];
+	uint32_t occluderCount = 0;
+
+	//--------------------------------
+	// Keep the largest meshes on screen, sorted by area
+	//--------------------------------
+	for ( uint32_t i = 0; i < drawCount; i++ )
+	{
+		softrast_mesh* mesh = draws[i].mesh;
+		if ( draws[i].submesh )
+			continue;
+
+		uint32_t duplicate = 0;
+		for ( uint32_t o = 0; o < occluderCount; o++ )
+			duplicate |= (occluders[o] == mesh);
+		if ( duplicate || ((FrameDebug.flags & FLAG_AABB_FRUSTUM_CHECK) && __aabb_check_frustum ( mesh ) == AABB_FRUSTUM_OUTSIDE) )
+			continue;
+
+		float rect[4], maxZ, area = screenArea;
+		if ( __softrast_project_aabb ( mesh, rect, &maxZ ) )
+		{
+			const float w = MIN ( rect[2], (float)globalData.renderTarget.width )  - MAX ( rect[0], 0.0f );
+			const float h = MIN ( rect[3], (float)globalData.renderTarget.height ) - MAX ( rect[1], 0.0f );
+			area = MAX ( w, 0.0f ) * MAX ( h, 0.0f );
+		}
+		if ( area < screenArea * SOFTRAST_MIN_OCCLUDER_AREA || (occluderCount == SOFTRAST_MAX_OCCLUDERS && area <= occluderArea[occluderCount - 1]) )
+			continue;
+
+		uint32_t slot = MIN ( occluderCount, SOFTRAST_MAX_OCCLUDERS - 1 );
+		for ( ; slot > 0 && occluderArea[slot - 1] < area; slot-- )
+		{
+			occluderArea[slot] = occluderArea[slot - 1];
+			occluders[slot]    = occluders[slot - 1];
+		}
+		occluderArea[slot] = area;
+		occluders[slot]    = mesh;
+		occluderCount      = MIN ( occluderCount + 1, SOFTRAST_MAX_OCCLUDERS );
+	}
+
+	//--------------------------------
+	// Set up their triangles like the main pass would, and rasterize them depth-only
+	//--------------------------------
+	const uint32_t occlusionPixelCount = globalData.occlusion.width * globalData.occlusion.height;
+	memset ( globalData.occlusion.depth, 0, occlusionPixelCount * sizeof ( float ) );
+	memset ( globalData.occlusion.pendingMask, 0, occlusionPixelCount * sizeof ( uint16_t ) );
+	for ( uint32_t i = 0; i < occlusionPixelCount; i++ )
+		globalData.occlusion.pendingDepth[i] = FLT_MAX;
+
+	//--------------------------------
+	// Transform the occluders on all threads before any of them is needed
+	//--------------------------------
+	queued_mesh queuedOccluders[SOFTRAST_MAX_OCCLUDERS];
+	globalData.transform.jobCount = 0;
+	for ( uint32_t i = 0; i < occluderCount; i++ )
+	{
+		queuedOccluders[i].mesh = occluders[i];
+		__softrast_queue_transform ( queuedOccluders + i );
+	}
+	softrast_thread_pool_run ( __softrast_transform_vertices, globalData.transform.jobs, globalData.transform.jobCount );
+
+	__declspec(align(64)) vertex polygonVerts[SOFTRAST_MAX_POLYGON_VERTICES];
+	for ( uint32_t i = 0; i < occluderCount; i++ )
+	{
+		softrast_mesh* mesh = occluders[i];
+
+		const aabb_frustum_result res = (FrameDebug.flags & FLAG_AABB_FRUSTUM_CHECK) ? __aabb_check_frustum ( mesh ) : AABB_FRUSTUM_INTERSECT;
+
+		softrast_submesh* submesh = mesh->submeshes;
+		for ( uint32_t j = 0; j < mesh->submeshCount; j++, submesh++ )
+		{
+			const uint32_t triCount = submesh->indexCount / 3;
+			const uint32_t* index = submesh->indices;
+			for ( uint32_t k = 0; k < triCount; k++, index += 3 )
+			{
+				const uint32_t vectorCount = __softrast_setup_polygon ( polygonVerts, mesh, index, res );
+				for ( uint32_t v = 2; v < vectorCount; v++ )
+					__softrast_rasterize_occluder_triangle ( polygonVerts, polygonVerts + v - 1, polygonVerts + v );
+			}
+		}
+	}
+
+	return occluderCount;
+}
+
+// Whether no pixel the mesh's AABB projects onto could pass the depth test against the occlusion buffer
+static uint32_t __softrast_mesh_occluded ( const softrast_mesh* mesh )
+{
+	float rect[4], maxZ;
+	if ( !__softrast_project_aabb ( mesh, rect, &maxZ ) )
+		return 0;
+
+	//--------------------------------
+	// Pixels covered by the projected box, with a pixel of slack for the rasterizers' rounding
+	//--------------------------------
+	const int32_t minX = MAX ( (int32_t)floorf ( rect[0] ) - 1, 0 );
+	const int32_t minY = MAX ( (int32_t)floorf ( rect[1] ) - 1, 0 );
+	const int32_t maxX = MIN ( (int32_t)ceilf  ( rect[2] ) + 1, (int32_t)globalData.renderTarget.width  - 1 );
+	const int32_t maxY = MIN ( (int32_t)ceilf  ( rect[3] ) + 1, (int32_t)globalData.renderTarget.height - 1 );
+	if ( minX > maxX || minY > maxY )
+		return 0;
+
+	const float z = maxZ * (1.0f + SOFTRAST_HIZ_EPSILON);
+	for ( int32_t oy = minY / SOFTRAST_OCCLUSION_SCALE; oy <= maxY / SOFTRAST_OCCLUSION_SCALE; oy++ )
+	{
+		const float* depth = globalData.occlusion.depth + oy * globalData.occlusion.width;
+		for ( int32_t ox = minX / SOFTRAST_OCCLUSION_SCALE; ox <= maxX / SOFTRAST_OCCLUSION_SCALE; ox++ )
+		{
+			if ( z > depth[ox] )
+				return 0;
+		}
+	}
+	return 1;
+}
+
+// Finds the mesh's entry in this round's lookup table, or the empty entry it goes into
+static mesh_lookup_entry* __softrast_lookup_mesh ( const softrast_mesh* mesh )
+{
+	uint32_t slot = (uint32_t)(((uintptr_t)mesh >> 4) * 2654435761u);
+	for ( ;; slot++ )
+	{
+		mesh_lookup_entry* entry = globalData.transform.lookup + (slot & (SOFTRAST_MESH_LOOKUP_SIZE - 1));
+		if ( entry->mesh == mesh || !entry->mesh )
+			return entry;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Culls and rasterizes draws that share the current view; draws are culled and their meshes' transforms queued up front, so the worker threads transform the next
+// meshes while earlier ones are rasterized. Without transform, the vertices are used as an earlier pass over the same draws left them.
+static void __softrast_rasterize_draws ( const frame_draw* draws, uint32_t drawCount, softrast_mesh* const* occluders, uint32_t occluderCount, uint32_t visibility, uint32_t transform )
+{
+	//--------------------------------
+	// Variables
+	//--------------------------------
+	__declspec(align(64)) vertex polygonVerts[SOFTRAST_MAX_POLYGON_VERTICES];
+
+	const uint32_t tiled = (FrameDebug.flags & FLAG_TILED_RASTERIZATION) && globalData.tiles.binning;
+	const uint32_t batched = (globalData.kernelFlags & FLAG_BATCHED_TRIANGLE_CULLING) != 0;
+	const raster_region screenRegion = { globalData.outlineTable, 0, 0, (int32_t)globalData.renderTarget.width - 1, (int32_t)globalData.renderTarget.height - 1 };
+
+	uint32_t nextDraw = 0;
+	while ( nextDraw < drawCount )
+	{
+		globalData.transform.meshCount = globalData.transform.jobCount = globalData.transform.drawCount = 0;
+		memset ( globalData.transform.lookup, 0, sizeof ( globalData.transform.lookup ) );
+		for ( ; nextDraw < drawCount && globalData.transform.drawCount < SOFTRAST_MAX_TRANSFORM_JOBS; nextDraw++ )
+		{
+			softrast_mesh* mesh = draws[nextDraw].mesh;
+
+			//--------------------------------
+			// Draws of a mesh culled or queued earlier in the round share its result and its transform
+			//--------------------------------
+			mesh_lookup_entry* entry = __softrast_lookup_mesh ( mesh );
+			if ( !entry->mesh )
+			{
+				aabb_frustum_result res = AABB_FRUSTUM_INTERSECT;
+				if ( FrameDebug.flags & FLAG_AABB_FRUSTUM_CHECK )
+					res = __aabb_check_frustum ( mesh );
+
+				//--------------------------------
+				// Skip meshes hidden behind the occluders, before transforming any of their vertices. Occluders were already transformed for the occlusion buffer
+				//--------------------------------
+				uint32_t occluder = 0;
+				for ( uint32_t o = 0; o < occluderCount; o++ )
+					occluder |= (occluders[o] == mesh);
+				if ( res == AABB_FRUSTUM_OUTSIDE || (occluderCount && !occluder && __softrast_mesh_occluded ( mesh )) )
+				{
+					entry->mesh = mesh, entry->queued = NULL;
+					continue;
+				}
+
+				uint32_t rangeSize;
+				const uint32_t jobCount = (occluder || !transform) ? 0 : __softrast_transform_job_count ( mesh, &rangeSize );
+				if ( globalData.transform.jobCount + jobCount > SOFTRAST_MAX_TRANSFORM_JOBS )
+					break;
+
+				queued_mesh* queuedMesh = globalData.transform.meshes + globalData.transform.meshCount++;
+				queuedMesh->mesh        = mesh;
+				queuedMesh->res         = res;
+				queuedMesh->pendingJobs = 0;
+				if ( jobCount )
+					__softrast_queue_transform ( queuedMesh );
+				entry->mesh = mesh, entry->queued = queuedMesh;
+			}
+			else if ( !entry->queued )
+				continue;
+
+			queued_draw* queuedDraw = globalData.transform.draws + globalData.transform.drawCount++;
+			queuedDraw->mesh        = entry->queued;
+			queuedDraw->submesh     = draws[nextDraw].submesh;
+		}
+
+		softrast_job_batch transformBatch;
+		softrast_thread_pool_submit ( &transformBatch, __softrast_transform_vertices, globalData.transform.jobs, globalData.transform.jobCount );
+
+		for ( uint32_t i = 0; i < globalData.transform.drawCount; i++ )
+		{
+			const queued_draw* queuedDraw = globalData.transform.draws + i;
+			queued_mesh* queuedMesh       = queuedDraw->mesh;
+			softrast_mesh* mesh           = queuedMesh->mesh;
+			const aabb_frustum_result res = queuedMesh->res;
+			__softrast_poll_finishing_frame ( );
+
+			//--------------------------------
+			// Help out with the transforms until this mesh's are done; jobs are handed out in mesh order, so the wait is short
+			//--------------------------------
+			while ( queuedMesh->pendingJobs )
+			{
+				if ( !softrast_thread_pool_help ( &transformBatch ) )
+					_mm_pause ( );
+			}
+
+			softrast_submesh* submesh     = queuedDraw->submesh ? queuedDraw->submesh : mesh->submeshes;
+			const uint32_t submeshCount = queuedDraw->submesh ? 1 : mesh->submeshCount;
+			for ( uint32_t j = 0; j < submeshCount; j++, submesh++ )
+			{
+				//--------------------------------
+				// Variables
+				//--------------------------------
+				const uint32_t triCount = submesh->indexCount / 3;
+				const uint32_t* index = submesh->indices;
+
+				//--------------------------------
+				// Sanity checks
+				//--------------------------------
+				assert ( (submesh->indexCount % 3) == 0 );
+
+				//--------------------------------
+				// Register the draw the visibility buffer IDs will point back to. Once the table is full, what's drawn so far gets shaded to make room.
+				// Submeshes with more triangles than IDs can tell apart are shaded right away, after shading what's in the buffer so none of its IDs
+				// end up behind them.
+				//--------------------------------
+				uint32_t drawID = 0;
+				const uint32_t fitsID = triCount <= SOFTRAST_VISIBILITY_TRIANGLE_MASK + 1;
+				if ( visibility && (!fitsID || globalData.visibility.drawCount == SOFTRAST_MAX_VISIBILITY_DRAWS) )
+					__softrast_restart_visibility ( tiled );
+				if ( visibility && fitsID )
+				{
+					visibility_draw* draw = globalData.visibility.draws + globalData.visibility.drawCount++;
+					draw->mesh    = mesh;
+					draw->submesh = submesh;
+					draw->res     = res;
+					drawID        = globalData.visibility.drawCount << SOFTRAST_VISIBILITY_TRIANGLE_BITS;
+				}
+
+				//--------------------------------
+				// Set up triangles, and either rasterize them right away or bin them into screen tiles
+				//--------------------------------
+				uint32_t survivors = 0xFF;
+				for ( uint32_t k = 0; k < triCount; k++, index += 3 )
+				{
+					//--------------------------------
+					// Cull 8 triangles at a time up front, so only the survivors go through scalar setup
+					//--------------------------------
+					const uint32_t batchIndex = k & 7;
+					if ( batchIndex == 0 )
+						survivors = (batched && triCount - k >= 8) ? __softrast_cull_triangles_avx2 ( mesh, index, res ) : 0xFF;
+					if ( !(survivors & (1 << batchIndex)) )
+						continue;
+
+					if ( tiled )
+					{
+						binned_polygon* polygon = globalData.tiles.binning->polygons + globalData.tiles.binning->polygonCount;
+						polygon->vectorCount  = __softrast_setup_polygon ( polygon->verts, mesh, index, res );
+						polygon->visibilityID = drawID ? (drawID | k) : 0;
+						if ( polygon->vectorCount >= 3 )
+							__softrast_bin_polygon ( polygon, submesh );
+					}
+					else
+					{
+						uint32_t vectorCount = __softrast_setup_polygon ( polygonVerts, mesh, index, res );
+						if ( vectorCount < 3 )
+							continue;
+						if ( drawID )
+							__softrast_rasterize_polygon_visibility ( &screenRegion, polygonVerts, vectorCount, drawID | k );
+						else
+							__softrast_rasterize_polygon ( &screenRegion, polygonVerts, vectorCount, submesh );
+					}
+				}
+			}
+		}
+
+		softrast_thread_pool_wait ( &transformBatch );
+	}
+}
+
+// Steps every written depth down to the next smaller float, so the shading pass's depth test (z > depth) passes exactly where z equals what the pre-pass wrote
+static void __softrast_prepare_depth_equal_test ( )
+{
+	const __m128i zero  = _mm_setzero_si128 ( );
+	const __m128i one   = _mm_set1_epi32 ( 1 );
+	const uint32_t size = ((globalData.renderTarget.width + 1) & (~1)) * ((globalData.renderTarget.height + 1) & (~1));
+
+	__m128i* depth = (__m128i*)globalData.renderTarget.depthBuffer;
+	for ( uint32_t i = 0; i < size; i += 4, depth++ )
+	{
+		const __m128i d = _mm_loadu_si128 ( depth );
+		_mm_storeu_si128 ( depth, _mm_sub_epi32 ( d, _mm_andnot_si128 ( _mm_cmpeq_epi32 ( d, zero ), one ) ) );
+	}
+}
+
+// Renders draws that share the current view and projection. The tiles of the frame's last view are left in the bins
+static void __softrast_render_view ( const frame_draw* draws, uint32_t drawCount, uint32_t lastView )
+{
+	//--------------------------------
+	// Prepare viewport transform and clip border
+	//--------------------------------
+	globalData.viewport.offset[0]  = globalData.renderTarget.width / 2.0f, globalData.viewport.offset[1] = globalData.renderTarget.height / 2.0f, globalData.viewport.offset[2] = 0.0f;
+	globalData.viewport.bias[0]    = globalData.renderTarget.width / 2.0f, globalData.viewport.bias[1]   = globalData.renderTarget.height / 2.0f, globalData.viewport.bias[2]   = 0.0f;
+	globalData.viewport.epsilon[0] = FrameDebug.clipBorderDist / globalData.viewport.bias[0], globalData.viewport.epsilon[1] = FrameDebug.clipBorderDist / globalData.viewport.bias[1], globalData.viewport.epsilon[2] = 0.0f;
+
+	//--------------------------------
+	// Only binning can happen before the frame has taken over the render target; the visibility buffer, the depth pre-pass and rasterizing without tiles
+	// write pixels as they go
+	//--------------------------------
+	const uint32_t tiled      = (FrameDebug.flags & FLAG_TILED_RASTERIZATION) && globalData.tiles.binning;
+	const uint32_t visibility = (FrameDebug.flags & FLAG_VISIBILITY_BUFFER) && globalData.visibility.ids;
+	const uint32_t prePass    = (FrameDebug.flags & (FLAG_DEPTH_PRE_PASS | FLAG_DEPTH_TESTING)) == (FLAG_DEPTH_PRE_PASS | FLAG_DEPTH_TESTING) && !visibility;
+	if ( !tiled || visibility || prePass )
+		__softrast_acquire_target ( );
+	if ( globalData.rendering.acquired )
+	{
+		globalData.shadeTarget.nearClip = globalData.nearClip;
+		globalData.shadeTarget.farClip  = globalData.farClip;
+	}
+
+	//--------------------------------
+	// Fill the occlusion buffer with the largest meshes, which already get transformed there
+	//--------------------------------
+	softrast_mesh* occluders[SOFTRAST_MAX_OCCLUDERS];
+	uint32_t occluderCount = 0;
+	if ( (FrameDebug.flags & FLAG_OCCLUSION_CULLING) && globalData.occlusion.depth )
+		occluderCount = __softrast_render_occluders ( draws, drawCount, occluders );
+
+	//--------------------------------
+	// With a visibility buffer, the main pass only resolves visibility and shading happens afterwards
+	//--------------------------------
+	if ( visibility )
+	{
+		memset ( globalData.visibility.ids, 0, globalData.renderTarget.width * globalData.renderTarget.height * sizeof ( uint32_t ) );
+		globalData.visibility.drawCount = 0;
+	}
+
+	//--------------------------------
+	// The depth pre-pass lays down the nearest depth of every pixel first, so the shading pass only shades the pixels that end up visible
+	//--------------------------------
+	if ( !(FrameDebug.flags & FLAG_FILL_OUTLINES) )
+		drawCount = 0;
+	if ( prePass )
+	{
+		globalData.depthPrePass = 1;
+		globalData.shadeQuad    = __softrast_depth_swizzled ( ) ? __softrast_shade_quad_depth_swizzled : __softrast_shade_quad_depth_linear;
+		__softrast_rasterize_draws ( draws, drawCount, occluders, occluderCount, 0, 1 );
+		if ( tiled )
+			__softrast_flush_tiles ( );
+		__softrast_prepare_depth_equal_test ( );
+		globalData.depthPrePass = 0;
+		globalData.shadeQuad    = __softrast_select_shade_quad ( );
+	}
+	__softrast_rasterize_draws ( draws, drawCount, occluders, occluderCount, visibility, !prePass );
+
+	//--------------------------------
+	// Rasterize what's left in the tile bins; the last view's are rasterized as the frame finishes, while the next one is set up
+	//--------------------------------
+	if ( tiled && (visibility || !lastView) )
+		__softrast_flush_tiles ( );
+
+	//--------------------------------
+	// Shade what ended up visible
+	//--------------------------------
+	if ( visibility )
+		__softrast_resolve_visibility ( tiled );
+}
+
+static int __softrast_compare_draws ( const void* a, const void* b )
+{
+	const frame_draw* drawA = (const frame_draw*)a;
+	const frame_draw* drawB = (const frame_draw*)b;
+	if ( drawA->key != drawB->key )
+		return drawA->key < drawB->key ? -1 : 1;
+	return drawA->order < drawB->order ? -1 : (drawA->order > drawB->order);
+}
+
+// Render scale of the next frame. Pixel work is taken to grow with the square of the scale, so a budget moves the scale towards the one that would have
+// met it last frame; only partway, so a single slow frame doesn't make it jump
+static float __softrast_select_render_scale ( const render_scaling* scaling )
+{
+	if ( scaling->budget <= 0.0f )
+		return scaling->scale;
+
+	float scale = globalData.scaling.scale;
+	if ( globalData.scaling.milliseconds > 0.0f )
+	{
+		const float target = scale * sqrtf ( scaling->budget / globalData.scaling.milliseconds );
+		scale += (target - scale) * SOFTRAST_RENDER_SCALE_DAMPING;
+	}
+	return CLAMP ( scale, scaling->minScale, 1.0f );
+}
+
+// Blends pixels a and b, unpacked to 16 bits per channel, with weights out of 256 adding up to 256
+static __m128i __softrast_blend_unpacked ( __m128i a, __m128i b, __m128i weightA, __m128i weightB )
+{
+	return _mm_srli_epi16 ( _mm_add_epi16 ( _mm_mullo_epi16 ( a, weightA ), _mm_mullo_epi16 ( b, weightB ) ), 8 );
+}
+
+// Bilinearly upscales a band of output rows; every row first blends its two source rows into the thread's row buffer, which the columns then blend pairs of
+static void __softrast_upscale_job ( void* userData, uint32_t jobIndex, uint32_t threadIndex )
+{
+	const upscale_job* job = (const upscale_job*)userData;
+	uint32_t* row          = globalData.scaling.rows + threadIndex * (globalData.scaling.width + 1);
+	const __m128i zero     = _mm_setzero_si128 ( );
+
+	const uint32_t minY = jobIndex * SOFTRAST_UPSCALE_BAND_ROWS;
+	const uint32_t maxY = MIN ( minY + SOFTRAST_UPSCALE_BAND_ROWS, job->dstHeight );
+	for ( uint32_t y = minY; y < maxY; y++ )
+	{
+		//--------------------------------
+		// Blend the two nearest source rows, 4 pixels at a time
+		//--------------------------------
+		const float srcY     = MAX ( ((float)y + 0.5f) * (float)job->srcHeight / (float)job->dstHeight - 0.5f, 0.0f );
+		const uint32_t y0    = MIN ( (uint32_t)srcY, job->srcHeight - 1 );
+		const uint32_t y1    = MIN ( y0 + 1, job->srcHeight - 1 );
+		const __m128i weight1 = _mm_set1_epi16 ( (int16_t)((srcY - (float)y0) * 256.0f) );
+		const __m128i weight0 = _mm_sub_epi16 ( _mm_set1_epi16 ( 256 ), weight1 );
+
+		const uint32_t* src0 = (const uint32_t*)((const uint8_t*)job->src + y0 * job->srcPitch);
+		const uint32_t* src1 = (const uint32_t*)((const uint8_t*)job->src + y1 * job->srcPitch);
+
+		uint32_t x = 0;
+		for ( ; x + 4 <= job->srcWidth; x += 4 )
+		{
+			const __m128i a  = _mm_loadu_si128 ( (const __m128i*)(src0 + x) );
+			const __m128i b  = _mm_loadu_si128 ( (const __m128i*)(src1 + x) );
+			const __m128i lo = __softrast_blend_unpacked ( _mm_unpacklo_epi8 ( a, zero ), _mm_unpacklo_epi8 ( b, zero ), weight0, weight1 );
+			const __m128i hi = __softrast_blend_unpacked ( _mm_unpackhi_epi8 ( a, zero ), _mm_unpackhi_epi8 ( b, zero ), weight0, weight1 );
+			_mm_storeu_si128 ( (__m128i*)(row + x), _mm_packus_epi16 ( lo, hi ) );
+		}
+		for ( ; x < job->srcWidth; x++ )
+		{
+			const __m128i a = _mm_unpacklo_epi8 ( _mm_cvtsi32_si128 ( (int32_t)src0[x] ), zero );
+			const __m128i b = _mm_unpacklo_epi8 ( _mm_cvtsi32_si128 ( (int32_t)src1[x] ), zero );
+			row[x] = (uint32_t)_mm_cvtsi128_si32 ( _mm_packus_epi16 ( __softrast_blend_unpacked ( a, b, weight0, weight1 ), zero ) );
+		}
+		row[job->srcWidth] = row[job->srcWidth - 1];	// The last column's tap reads one past it
+
+		//--------------------------------
+		// Blend each output pixel from the pair of row pixels its tap starts at; both are unpacked at once, left in the low half
+		//--------------------------------
+		uint32_t* dst = (uint32_t*)((uint8_t*)job->dst + y * job->dstPitch);
+		for ( uint32_t dx = 0; dx < job->dstWidth; dx++ )
+		{
+			const upscale_tap tap  = globalData.scaling.taps[dx];
+			const __m128i pixels   = _mm_unpacklo_epi8 ( _mm_loadl_epi64 ( (const __m128i*)(row + tap.x) ), zero );
+			const __m128i weights  = _mm_unpacklo_epi64 ( _mm_set1_epi16 ( (int16_t)(256 - tap.weight) ), _mm_set1_epi16 ( (int16_t)tap.weight ) );
+			const __m128i weighted = _mm_mullo_epi16 ( pixels, weights );
+			const __m128i sum      = _mm_srli_epi16 ( _mm_add_epi16 ( weighted, _mm_srli_si128 ( weighted, 8 ) ), 8 );
+			dst[dx] = (uint32_t)_mm_cvtsi128_si32 ( _mm_packus_epi16 ( sum, zero ) );
+		}
+	}
+}
+
+static void __softrast_upscale ( uint32_t* dst, uint32_t dstPitch )
+{
+	upscale_job job =
+	{
+		.src = globalData.renderTarget.colorBuffer, .srcWidth = globalData.renderTarget.width, .srcHeight = globalData.renderTarget.height, .srcPitch = globalData.renderTarget.pitch,
+		.dst = dst, .dstWidth = globalData.scaling.width, .dstHeight = globalData.scaling.height, .dstPitch = dstPitch,
+	};
+
+	for ( uint32_t x = 0; x < job.dstWidth; x++ )
+	{
+		const float srcX  = MAX ( ((float)x + 0.5f) * (float)job.srcWidth / (float)job.dstWidth - 0.5f, 0.0f );
+		const uint32_t x0 = MIN ( (uint32_t)srcX, job.srcWidth - 1 );
+		globalData.scaling.taps[x].x      = (uint16_t)x0;
+		globalData.scaling.taps[x].weight = (uint16_t)((srcX - (float)x0) * 256.0f);
+	}
+
+	softrast_thread_pool_run ( __softrast_upscale_job, &job, (job.dstHeight + SOFTRAST_UPSCALE_BAND_ROWS - 1) / SOFTRAST_UPSCALE_BAND_ROWS );
+}
+
+// Nearest row or column to c in a neighbouring quad, which checkerboard rendering rendered when it skipped c's quad
+static int32_t __softrast_checkerboard_neighbor ( int32_t c, int32_t size )
+{
+	const int32_t near = (c & 1) ? c + 1 : c - 1;
+	if ( near >= 0 && near < size )
+		return near;
+	const int32_t far = (c & 1) ? c - 2 : c + 2;
+	return (far >= 0 && far < size) ? far : c;
+}
+
+// Bilinearly filters the history's color at raster position (x, y), which lies within the render target
+static uint32_t __softrast_checkerboard_history_color ( const uint32_t* history, float x, float y )
+{
+	const int32_t width  = (int32_t)globalData.renderTarget.width;
+	const int32_t height = (int32_t)globalData.renderTarget.height;
+	const int32_t x0     = MIN ( (int32_t)x, width  - 2 );
+	const int32_t y0     = MIN ( (int32_t)y, height - 2 );
+	const __m128i zero   = _mm_setzero_si128 ( );
+
+	//--------------------------------
+	// Blend the pixel pairs of both rows, then the pair that leaves; weights are rounded, so pixels that land on one exactly take its color as is
+	//--------------------------------
+	const uint32_t* row0   = history + (height - y0 - 1) * width + x0;
+	const uint32_t* row1   = row0 - width;
+	const __m128i weightY1 = _mm_set1_epi16 ( (int16_t)((y - (float)y0) * 256.0f + 0.5f) );
+	const __m128i weightY0 = _mm_sub_epi16 ( _mm_set1_epi16 ( 256 ), weightY1 );
+	const __m128i pair     = __softrast_blend_unpacked ( _mm_unpacklo_epi8 ( _mm_loadl_epi64 ( (const __m128i*)row0 ), zero ), _mm_unpacklo_epi8 ( _mm_loadl_epi64 ( (const __m128i*)row1 ), zero ), weightY0, weightY1 );
+
+	const int16_t weightX1 = (int16_t)((x - (float)x0) * 256.0f + 0.5f);
+	const __m128i weighted = _mm_mullo_epi16 ( pair, _mm_unpacklo_epi64 ( _mm_set1_epi16 ( (int16_t)(256 - weightX1) ), _mm_set1_epi16 ( weightX1 ) ) );
+	const __m128i sum      = _mm_srli_epi16 ( _mm_add_epi16 ( weighted, _mm_srli_si128 ( weighted, 8 ) ), 8 );
+	return (uint32_t)_mm_cvtsi128_si32 ( _mm_packus_epi16 ( sum, zero ) );
+}
+
+// Fills in the skipped quads of a band of color buffer rows, and stores the completed rows as the next history frame. A skipped pixel takes the depth of the
+// nearest of its rendered neighbours across the quad edges; at that depth it's reprojected into the history, whose color it takes when the history's depth
+// agrees. Anything else, like pixels that were off screen or hidden last frame, averages the neighbours instead
+static void __softrast_checkerboard_job ( void* userData, uint32_t jobIndex, uint32_t threadIndex )
+{
+	(void)threadIndex;
+	const checkerboard_job* job = (const checkerboard_job*)userData;
+
+	const int32_t width      = (int32_t)globalData.renderTarget.width;
+	const int32_t height     = (int32_t)globalData.renderTarget.height;
+	const float halfWidth    = (float)width  * 0.5f;
+	const float halfHeight   = (float)height * 0.5f;
+	const uint32_t* oldColor = globalData.checkerboard.historyColor[globalData.checkerboard.history];
+	const float* oldDepth    = globalData.checkerboard.historyDepth[globalData.checkerboard.history];
+	uint32_t* newColor       = globalData.checkerboard.historyColor[globalData.checkerboard.history ^ 1];
+	float* newDepth          = globalData.checkerboard.historyDepth[globalData.checkerboard.history ^ 1];
+
+	const int32_t minRow = (int32_t)jobIndex * SOFTRAST_CHECKERBOARD_BAND_ROWS;
+	const int32_t maxRow = MIN ( minRow + SOFTRAST_CHECKERBOARD_BAND_ROWS, height );
+	for ( int32_t row = minRow; row < maxRow; row++ )
+	{
+		const int32_t y          = height - row - 1;
+		const int32_t neighborY  = __softrast_checkerboard_neighbor ( y, height );
+		uint32_t* color          = (uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + row * globalData.renderTarget.pitch);
+		const uint32_t* colorY   = (const uint32_t*)((uintptr_t)globalData.renderTarget.colorBuffer + (height - neighborY - 1) * globalData.renderTarget.pitch);
+
+		for ( int32_t x = 0; x < width; x++ )
+		{
+			const int32_t i = row * width + x;
+			if ( !__softrast_checkerboard_skips ( x, y ) )
+			{
+				newColor[i] = color[x];
+				newDepth[i] = *__softrast_depth_pixel ( x, y );
+				continue;
+			}
+
+			//--------------------------------
+			// Rendered neighbours; their colors are averaged per channel, rounding down
+			//--------------------------------
+			const int32_t neighborX = __softrast_checkerboard_neighbor ( x, width );
+			const uint32_t a        = color[neighborX];
+			const uint32_t b        = colorY[x];
+			const float depth       = MAX ( *__softrast_depth_pixel ( neighborX, y ), *__softrast_depth_pixel ( x, neighborY ) );
+			uint32_t result         = (((a ^ b) & 0xFEFEFEFE) >> 1) + (a & b);
+
+			if ( job->historyValid && depth > 0.0f )
+			{
+				//--------------------------------
+				// Find the point along the view ray at the depth's w, and where it was on screen last frame
+				//--------------------------------
+				float q[8];
+				for ( uint32_t j = 0; j < 8; j++ )
+					q[j] = job->base[j] + job->stepX[j] * (float)x + job->stepY[j] * (float)row;
+
+				const float w0 = 1.0f / q[0], w1 = 1.0f / q[1];
+				const float t  = (1.0f / depth - w0) / (w1 - w0);
+				const float s0 = (1.0f - t) * w0, s1 = t * w1;
+				const float clipX = s0 * q[2] + s1 * q[5];
+				const float clipY = s0 * q[3] + s1 * q[6];
+				const float clipW = s0 * q[4] + s1 * q[7];
+
+				if ( clipW > 0.0f )
+				{
+					const float invW = 1.0f / clipW;
+					const float oldX = clipX * invW * halfWidth  + halfWidth;
+					const float oldY = clipY * invW * halfHeight + halfHeight;
+					if ( oldX >= 0.0f && oldX <= (float)(width - 1) && oldY >= 0.0f && oldY <= (float)(height - 1) )
+					{
+						const int32_t j = (height - (int32_t)(oldY + 0.5f) - 1) * width + (int32_t)(oldX + 0.5f);
+						if ( fabsf ( oldDepth[j] * clipW - 1.0f ) <= SOFTRAST_CHECKERBOARD_DEPTH_TOLERANCE )
+							result = __softrast_checkerboard_history_color ( oldColor, oldX, oldY );
+					}
+				}
+			}
+
+			color[x]    = result;
+			newColor[i] = result;
+			newDepth[i] = depth;
+		}
+	}
+}
+
+// Sets up value index of the job as component c of m * (ndcX, ndcY, z, 1)
+static void __softrast_checkerboard_plane ( checkerboard_job* job, uint32_t index, const bbm_aos_mat4* m, uint32_t c, float z )
+{
+	// ndcX = 2 x / width - 1, and ndcY = 2 (height - 1 - row) / height - 1
+	const float width  = (float)globalData.renderTarget.width;
+	const float height = (float)globalData.renderTarget.height;
+	job->stepX[index]  = 2.0f * m->rows[0][c] / width;
+	job->stepY[index]  = -2.0f * m->rows[1][c] / height;
+	job->base[index]   = -m->rows[0][c] + (2.0f * (height - 1.0f) / height - 1.0f) * m->rows[1][c] + z * m->rows[2][c] + m->rows[3][c];
+}
+
+// Completes a checkerboard rendered frame from the history, which it then replaces
+static void __softrast_checkerboard_reconstruct ( const bbm_aos_mat4* viewProjectionMatrix )
+{
+	checkerboard_job job;
+	job.historyValid = globalData.checkerboard.historyValid && globalData.renderTarget.width > 1 && globalData.renderTarget.height > 1;	// Filtering takes 2x2 pixels
+	if ( job.historyValid )
+	{
+		//--------------------------------
+		// The inverse takes NDC back to homogeneous world space, and the history's view projection on to its clip space. Both are linear in NDC, and NDC in
+		// turn is affine in the pixel position, so all the values the pixels need step by a constant along rows and columns
+		//--------------------------------
+		bbm_aos_mat4 inverse, reprojection;
+		bbm_aos_mat4_inverse ( &inverse, viewProjectionMatrix );
+		bbm_aos_mat4_mul_aos_mat4 ( &reprojection, &globalData.checkerboard.viewProjectionMatrix, &inverse );
+
+		static const uint32_t components[3] = { 0, 1, 3 };	// Clip x, y and w
+		for ( uint32_t p = 0; p < 2; p++ )
+		{
+			const float z = 0.5f * (float)p;	// Two points along the ray, both within the depth range
+			__softrast_checkerboard_plane ( &job, p, &inverse, 3, z );
+			for ( uint32_t k = 0; k < 3; k++ )
+				__softrast_checkerboard_plane ( &job, 2 + 3 * p + k, &reprojection, components[k], z );
+		}
+	}
+
+	softrast_thread_pool_run ( __softrast_checkerboard_job, &job, (globalData.renderTarget.height + SOFTRAST_CHECKERBOARD_BAND_ROWS - 1) / SOFTRAST_CHECKERBOARD_BAND_ROWS );
+
+	globalData.checkerboard.history             ^= 1;
+	globalData.checkerboard.historyValid         = 1;
+	globalData.checkerboard.viewProjectionMatrix = *viewProjectionMatrix;
+}
+
+// Waits for the last tiles of the frame before the one being set up, and completes it
+static void __softrast_finish_frame ( )
+{
+	frame_progress* finishing = &globalData.finishing;
+	queued_frame* frame       = finishing->frame;
+	if ( !frame )
+		return;
+
+	if ( globalData.tiles.rasterizing )
+	{
+		softrast_thread_pool_wait ( &globalData.tiles.batch );
+		__softrast_empty_bins ( globalData.tiles.rasterizing );
+		globalData.tiles.rasterizing = NULL;
+	}
+
+	//--------------------------------
+	// Pool jobs have gathered their threads' statistics already; add what this thread rasterized itself
+	//--------------------------------
+	__softrast_gather_pixel_stats ( 0 );
+	frame->stats.testedPixels = frame->stats.shadedPixels = 0;
+	for ( uint32_t i = 0; i < SOFTRAST_MAX_THREADS; i++ )
+	{
+		frame->stats.testedPixels += globalData.threadPixelStats[i].testedPixels;
+		frame->stats.shadedPixels += globalData.threadPixelStats[i].shadedPixels;
+	}
+	frame->stats.drawCount = frame->drawCount;
+
+	if ( globalData.checkerboard.active )
+		__softrast_checkerboard_reconstruct ( &frame->views[0].viewProjectionMatrix );
+	if ( finishing->scaled )
+		__softrast_upscale ( frame->colorBuffer, frame->pitch );
+
+	globalData.scaling.scale        = finishing->scale;
+	globalData.scaling.milliseconds = (float)((softrast_frame_queue_clock ( ) - finishing->startTime) * 1000.0);
+	frame->stats.renderScale        = finishing->scale;
+	frame->stats.milliseconds       = globalData.scaling.milliseconds;
+
+	finishing->frame = NULL;
+	softrast_frame_queue_complete ( frame->fence );
+}
+
+// Finishes the last frame as soon as its tiles are done, rather than when the frame being set up first needs the render target
+static void __softrast_poll_finishing_frame ( )
+{
+	if ( globalData.finishing.frame && (!globalData.tiles.rasterizing || softrast_thread_pool_is_done ( &globalData.tiles.batch )) )
+		__softrast_finish_frame ( );
+}
+
+// Hands the render target over to the frame being set up, once the frame before it has finished; only then does it set up the state rasterizing reads
+// and start writing pixels
+static void __softrast_acquire_target ( )
+{
+	frame_progress* rendering = &globalData.rendering;
+	queued_frame* frame       = rendering->frame;
+	if ( rendering->acquired )
+		return;
+
+	__softrast_finish_frame ( );
+	rendering->acquired = 1;
+
+	uint32_t clearFlags = frame->clearFlags;
+	if ( rendering->width != globalData.renderTarget.width || rendering->height != globalData.renderTarget.height )
+	{
+		__softrast_set_render_size ( rendering->width, rendering->height );
+		clearFlags |= CLEAR_DEPTH_BIT;	// Depth laid out for another size is meaningless
+	}
+
+	globalData.renderTarget.colorBuffer = rendering->scaled ? globalData.scaling.colorBuffer : frame->colorBuffer;
+	globalData.renderTarget.pitch       = rendering->scaled ? globalData.scaling.width * sizeof ( uint32_t ) : frame->pitch;
+	FrameDebug                          = frame->debug;
+
+	globalData.shadingRateImage        = frame->shadingRateImage;
+	globalData.shadingRateImage.scaleX = (float)globalData.shadingRateImage.width  / (float)rendering->width;
+	globalData.shadingRateImage.scaleY = (float)globalData.shadingRateImage.height / (float)rendering->height;
+
+	//--------------------------------
+	// Settle the kernels and the pixel pipelines up front, so none of them branch on the render settings
+	//--------------------------------
+	globalData.kernelFlags         = __softrast_kernel_flags ( FrameDebug.flags );
+	globalData.shadeQuad           = __softrast_select_shade_quad ( );
+	globalData.shadeQuadUntextured = __softrast_select_shade_quad_untextured ( );
+	globalData.shadeQuads          = __softrast_use_avx512 ( ) ? softrast_select_shade_quads_avx512 ( &FrameDebug ) : SOFTRAST_SELECT_SHADE_KERNEL ( __softrast_shade_quads_avx2_table, &FrameDebug );
+
+	globalData.shadeTarget.depthBuffer                = globalData.renderTarget.depthBuffer;
+	globalData.shadeTarget.depthBufferQuadFloatStride = globalData.renderTarget.depthBufferQuadFloatStride;
+	globalData.shadeTarget.nearClip                   = globalData.nearClip;
+	globalData.shadeTarget.farClip                    = globalData.farClip;
+
+	//--------------------------------
+	// Checkerboard rendering skips every other quad, alternating between frames; only the quad pipelines can skip them
+	//--------------------------------
+	globalData.checkerboard.active = (FrameDebug.flags & FLAG_CHECKERBOARD) && (FrameDebug.flags & FLAG_RASTERIZE) && (FrameDebug.flags & (FLAG_ENABLE_QUAD_RASTERIZATION | FLAG_HALF_SPACE_RASTERIZATION)) && globalData.checkerboard.historyColor[0];
+	if ( globalData.checkerboard.active )
+		globalData.checkerboard.parity ^= 1;
+	else
+		globalData.checkerboard.historyValid = 0;
+
+	__softrast_clear ( clearFlags );
+	memset ( globalData.threadPixelStats, 0, sizeof ( globalData.threadPixelStats ) );
+}
+
+// Runs on the frame queue's thread, one frame after the other. The frame's front-end runs while the tiles of the frame before it are still being
+// rasterized, and its own last tiles are left rasterizing when it returns; the next frame, or the queue's flush once there's none, finishes it
+static void __softrast_render_frame ( softrast_fence fence )
+{
+	frame_progress* rendering = &globalData.rendering;
+	queued_frame* frame       = globalData.frames + fence % SOFTRAST_MAX_FRAMES_IN_FLIGHT;
+	rendering->frame          = frame;
+	rendering->startTime      = softrast_frame_queue_clock ( );
+	rendering->acquired       = 0;
+
+	//--------------------------------
+	// Pick the frame's resolution; scaled frames rasterize into the internal color buffer, and are upscaled into the frame's once done
+	//--------------------------------
+	__softrast_poll_finishing_frame ( );
+	rendering->scale  = globalData.scaling.colorBuffer ? __softrast_select_render_scale ( &frame->scaling ) : 1.0f;
+	rendering->width  = globalData.scaling.width;
+	rendering->height = globalData.scaling.height;
+	if ( rendering->scale < 1.0f )
+	{
+		rendering->width  = MAX ( (uint32_t)((float)rendering->width  * rendering->scale + 0.5f), 1 );
+		rendering->height = MAX ( (uint32_t)((float)rendering->height * rendering->scale + 0.5f), 1 );
+	}
+	rendering->scaled = rendering->width != globalData.scaling.width || rendering->height != globalData.scaling.height;
+
+	//--------------------------------
+	// The front-end reads the render size and settings the last frame's tiles are rasterized with, so it waits for them when it needs others
+	//--------------------------------
+	if ( rendering->width != globalData.renderTarget.width || rendering->height != globalData.renderTarget.height ||
+	     memcmp ( &frame->debug, &FrameDebug, sizeof ( DEBUG_SETTINGS ) ) || __softrast_kernel_flags ( frame->debug.flags ) != globalData.kernelFlags )
+		__softrast_acquire_target ( );
+
+	//--------------------------------
+	// The view sits in the top bits of the keys, so sorting groups each view's draws together, in the order the views were set
+	//--------------------------------
+	if ( frame->sorted )
+		qsort ( frame->draws, frame->drawCount, sizeof ( frame_draw ), __softrast_compare_draws );
+
+	for ( uint32_t first = 0; first < frame->drawCount; )
+	{
+		const uint64_t view = frame->draws[first].key >> SOFTRAST_SORT_KEY_VIEW_SHIFT;
+		uint32_t last = first + 1;
+		while ( last < frame->drawCount && (frame->draws[last].key >> SOFTRAST_SORT_KEY_VIEW_SHIFT) == view )
+			last++;
+
+		globalData.viewProjectionMatrix = frame->views[view].viewProjectionMatrix;
+		globalData.nearClip             = frame->views[view].nearClip;
+		globalData.farClip              = frame->views[view].farClip;
+		__softrast_render_view ( frame->draws + first, last - first, last == frame->drawCount );
+		first = last;
+	}
+
+	//--------------------------------
+	// Leave the last tiles rasterizing while the next frame bins into the other set; the frame finishes once they're done
+	//--------------------------------
+	__softrast_acquire_target ( );
+	globalData.finishing = *rendering;
+
+	tile_bins* bins = globalData.tiles.binning;
+	if ( bins && bins->polygonCount )
+	{
+		globalData.tiles.rasterizing = bins;
+		globalData.tiles.binning     = globalData.tiles.sets + (bins == globalData.tiles.sets);
+		softrast_thread_pool_submit ( &globalData.tiles.batch, __softrast_rasterize_tile, bins, globalData.tiles.tileCountX * globalData.tiles.tileCountY );
+	}
+	else
+		__softrast_finish_frame ( );
+}
+
+// Waits for a free frame slot with room for drawCount draws, which is only handed out once the frame that used it last has completed. Returns 0 when the draws can't be stored
+static softrast_fence __softrast_reserve_frame ( uint32_t drawCount )
+{
+	//--------------------------------
+	// Update view projection matrix if needed
+	//--------------------------------
+	if ( globalData.next.flags & VIEW_PROJECTION_DIRTY_BIT )
+	{
+		bbm_aos_mat4_mul_aos_mat4 ( &globalData.next.viewProjectionMatrix, &globalData.next.projectionMatrix, &globalData.next.viewMatrix );
+		globalData.next.flags &= ~VIEW_PROJECTION_DIRTY_BIT;
+	}
+
+	__softrast_allocate_feature_buffers ( );
+
+	const softrast_fence fence = softrast_frame_queue_reserve ( );
+	queued_frame* frame        = globalData.frames + fence % SOFTRAST_MAX_FRAMES_IN_FLIGHT;
+
+	//--------------------------------
+	// Draw storage only grows, so it settles after the first few frames
+	//--------------------------------
+	if ( drawCount > frame->drawCapacity )
+	{
+		frame_draw* draws = (frame_draw*)miltyalloc_buddy_allocator_alloc ( _softrastAllocator, drawCount * sizeof ( frame_draw ) );
+		if ( !draws )
+			return 0;
+		if ( frame->draws )
+			miltyalloc_buddy_allocator_free ( _softrastAllocator, frame->draws );
+		frame->draws        = draws;
+		frame->drawCapacity = drawCount;
+	}
+
+	frame->fence                         = fence;
+	frame->drawCount                     = drawCount;
+	frame->views[0].viewProjectionMatrix = globalData.next.viewProjectionMatrix;
+	frame->views[0].nearClip             = globalData.next.nearClip;
+	frame->views[0].farClip              = globalData.next.farClip;
+	frame->colorBuffer                   = globalData.next.colorBuffer;
+	frame->pitch                         = globalData.next.pitch;
+	frame->clearFlags                    = globalData.next.flags & (CLEAR_COLOR_BIT | CLEAR_DEPTH_BIT);
+	frame->scaling                       = globalData.next.scaling;
+	frame->shadingRateImage              = globalData.next.shadingRateImage;
+	frame->debug                         = Debug;
+	globalData.next.flags               &= ~(CLEAR_COLOR_BIT | CLEAR_DEPTH_BIT);
+	return fence;
+}
+
+// View depth of the nearest point of the mesh's AABB, found as the smallest clip space w of its corners; positive floats sort like their bit patterns, so these are returned
+static uint32_t __softrast_mesh_depth_bits ( const bbm_aos_mat4* viewProjectionMatrix, const softrast_mesh* mesh )
+{
+	float minW = FLT_MAX;
+	for ( uint32_t i = 0; i < 8; i++ )
+	{
+		bbm_aos_vec4 corner = { .x = (i & 4) ? mesh->aabbMax.x : mesh->aabbMin.x, .y = (i & 2) ? mesh->aabbMax.y : mesh->aabbMin.y, .z = (i & 1) ? mesh->aabbMax.z : mesh->aabbMin.z, .w = 1.0f };
+		bbm_aos_vec4 clipCorner;
+		bbm_aos_mat4_mul_aos_vec4 ( &clipCorner, viewProjectionMatrix, &corner );
+		minW = MIN ( minW, clipCorner.w );
+	}
+
+	const float depth = MAX ( minW, 0.0f );
+	uint32_t depthBits;
+	memcpy ( &depthBits, &depth, sizeof ( depthBits ) );
+	return depthBits;
+}
+
+// Key ordering draws within their view by pipeline, then by texture so texture data stays in cache, then front to back
+static uint64_t __softrast_sort_key ( uint32_t view, const bbm_aos_mat4* viewProjectionMatrix, const softrast_mesh* mesh, const softrast_submesh* submesh )
+{
+	const softrast_texture* texture = submesh ? submesh->texture : (mesh->submeshCount ? mesh->submeshes[0].texture : NULL);
+	const uint64_t pipeline         = texture ? 0 : 1;
+	const uint64_t textureBits      = (uint32_t)((uintptr_t)texture >> 4);
+	const uint64_t depthBits        = __softrast_mesh_depth_bits ( viewProjectionMatrix, mesh ) >> 8;
+
+	return ((uint64_t)view << SOFTRAST_SORT_KEY_VIEW_SHIFT) | (pipeline << SOFTRAST_SORT_KEY_PIPELINE_SHIFT) | (textureBits << SOFTRAST_SORT_KEY_TEXTURE_SHIFT) | depthBits;
+}
+
+softrast_fence softrast_render_async ( softrast_model* model )
+{
+	const softrast_fence fence = __softrast_reserve_frame ( model->meshCount );
+	if ( !fence )
+		return 0;
+
+	//--------------------------------
+	// The model's meshes are drawn whole under the current view; in file order, or front to back so the depth test rejects more pixels before they're shaded
+	//--------------------------------
+	queued_frame* frame = globalData.frames + fence % SOFTRAST_MAX_FRAMES_IN_FLIGHT;
+	frame->sorted       = (frame->debug.flags & FLAG_FRONT_TO_BACK) != 0;
+	for ( uint32_t i = 0; i < model->meshCount; i++ )
+	{
+		frame_draw* draw = frame->draws + i;
+		draw->mesh       = model->meshes + i;
+		draw->submesh    = NULL;
+		draw->key        = frame->sorted ? __softrast_mesh_depth_bits ( &frame->views[0].viewProjectionMatrix, draw->mesh ) : 0;
+		draw->order      = i;
+	}
+
+	softrast_frame_queue_submit ( );
+	return fence;
+}
+
+softrast_fence softrast_submit_async ( const softrast_command_list* const* lists, uint32_t listCount )
+{
+	//--------------------------------
+	// Count the draws, and the views the matrix commands start
+	//--------------------------------
+	uint32_t drawCount = 0, viewCount = 1;
+	for ( uint32_t i = 0; i < listCount; i++ )
+	{
+		for ( uint32_t j = 0; j < lists[i]->count; j++ )
+		{
+			const softrast_command_type type = lists[i]->commands[j].type;
+			drawCount += (type == SOFTRAST_COMMAND_DRAW_MESH || type == SOFTRAST_COMMAND_DRAW_SUBMESH);
+			viewCount += (type == SOFTRAST_COMMAND_SET_VIEW_MATRIX || type == SOFTRAST_COMMAND_SET_PROJECTION_MATRIX);
+		}
+	}
+	if ( viewCount > SOFTRAST_MAX_VIEWS )
+		return 0;
+
+	const softrast_fence fence = __softrast_reserve_frame ( drawCount );
+	if ( !fence )
+		return 0;
+	queued_frame* frame = globalData.frames + fence % SOFTRAST_MAX_FRAMES_IN_FLIGHT;
+
+	//--------------------------------
+	// Every list starts out with the current view and projection
+	//--------------------------------
+	uint32_t drawIndex = 0, viewIndex = 1;
+	for ( uint32_t i = 0; i < listCount; i++ )
+	{
+		bbm_aos_mat4 viewMatrix = globalData.next.viewMatrix, projectionMatrix = globalData.next.projectionMatrix;
+		float nearClip = globalData.next.nearClip, farClip = globalData.next.farClip;
+		uint32_t view = 0;
+
+		const softrast_command* command = lists[i]->commands;
+		for ( uint32_t j = 0; j < lists[i]->count; j++, command++ )
+		{
+			if ( command->type == SOFTRAST_COMMAND_DRAW_MESH || command->type == SOFTRAST_COMMAND_DRAW_SUBMESH )
+			{
+				frame_draw* draw = frame->draws + drawIndex;
+				draw->mesh       = command->draw.mesh;
+				draw->submesh    = command->type == SOFTRAST_COMMAND_DRAW_SUBMESH ? command->draw.submesh : NULL;
+				draw->key        = __softrast_sort_key ( view, &frame->views[view].viewProjectionMatrix, draw->mesh, draw->submesh );
+				draw->order      = drawIndex++;
+				continue;
+			}
+
+			if ( command->type == SOFTRAST_COMMAND_SET_VIEW_MATRIX )
+				viewMatrix = command->matrix;
+			else
+			{
+				projectionMatrix = command->matrix;
+				__softrast_clip_distances ( &projectionMatrix, &nearClip, &farClip );
+			}
+
+			view = viewIndex++;
+			bbm_aos_mat4_mul_aos_mat4 ( &frame->views[view].viewProjectionMatrix, &projectionMatrix, &viewMatrix );
+			frame->views[view].nearClip = nearClip;
+			frame->views[view].farClip  = farClip;
+		}
+	}
+	frame->sorted = 1;
+
+	softrast_frame_queue_submit ( );
+	return fence;
+}
+
+uint32_t softrast_submit ( const softrast_command_list* const* lists, uint32_t listCount )
+{
+	const softrast_fence fence = softrast_submit_async ( lists, listCount );
+	if ( !fence )
+		return -1;
+	softrast_fence_wait ( fence );
+	return 0;
+}
+
+uint32_t softrast_render ( softrast_model* model )
+{
+	const softrast_fence fence = softrast_render_async ( model );
+	if ( !fence )
+		return -1;
+	softrast_fence_wait ( fence );
+	return 0;
+}
+
+uint32_t softrast_fence_completed ( softrast_fence fence )
+{
+	return softrast_frame_queue_is_done ( fence );
+}
+
+void softrast_fence_wait ( softrast_fence fence )
+{
+	softrast_frame_queue_wait ( fence );
+}
+
+void softrast_finish ( )
+{
+	softrast_frame_queue_finish ( );
+}
+
+uint32_t softrast_set_render_ahead ( uint32_t frameCount )
+{
+	return softrast_frame_queue_set_limit ( frameCount );
+}
+
+uint32_t softrast_get_frame_stats ( softrast_fence fence, softrast_frame_stats* stats )
+{
+	if ( !fence || !softrast_fence_completed ( fence ) )
+		return -1;
+
+	// The slot is handed to a later frame once that one is reserved, and its stats get overwritten as it renders
+	const queued_frame* frame = globalData.frames + fence % SOFTRAST_MAX_FRAMES_IN_FLIGHT;
+	if ( frame->fence != fence )
+		return -1;
+
+	*stats = frame->stats;
 	return 0;
 }
 
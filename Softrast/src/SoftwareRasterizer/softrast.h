@@ -23,6 +23,8 @@ extern "C" {
 #include "types.h"
 #include <miltyalloc.h>
 
+#define SOFTRAST_MAX_FRAMES_IN_FLIGHT 3
+
 #define DEBUG_STUFF
 
 #ifdef DEBUG_STUFF
@@ -59,6 +61,10 @@ extern "C" {
 	};
 	static const char* TextureMipmapModes[] = { "None", "Point", "Linear" };
 
+	static const char* ShadingRates[] = { "1x1", "2x2", "4x4" };	// softrast_shading_rate
+
+	static const char* TextureFormats[] = { "RGBA8", "BC1", "BC3", "BC7" };	// softrast_texture_format
+
 	enum
 	{
 		FLAG_BACKFACE_CULLING_ENABLED  = (1<<0),
@@ -73,6 +79,20 @@ extern "C" {
 		FLAG_AABB_FRUSTUM_CHECK        = (1<<9),
 		FLAG_FILL_OUTLINES             = (1<<10),
 		FLAG_RASTERIZE                 = (1<<11),
+		FLAG_TILED_RASTERIZATION       = (1<<12),
+		FLAG_HALF_SPACE_RASTERIZATION  = (1<<13),
+		FLAG_HALF_SPACE_AVX            = (1<<14),
+		FLAG_QUAD_RASTERIZATION_AVX2   = (1<<15),
+		FLAG_QUAD_RASTERIZATION_AVX512 = (1<<16),
+		FLAG_HIZ                       = (1<<17),
+		FLAG_OCCLUSION_CULLING         = (1<<18),
+		FLAG_VISIBILITY_BUFFER         = (1<<19),
+		FLAG_BATCHED_TRIANGLE_CULLING  = (1<<20),
+		FLAG_GUARD_BAND_CLIPPING       = (1<<21),
+		FLAG_SMALL_TRIANGLES           = (1<<22),
+		FLAG_FRONT_TO_BACK             = (1<<23),
+		FLAG_DEPTH_PRE_PASS            = (1<<24),
+		FLAG_CHECKERBOARD              = (1<<25),
 
 		//FLAG_DERP = (1<<6),
 		//FLAG_DERP2 = (1<<7),
@@ -88,15 +108,40 @@ extern "C" {
 		int textureMipmapMode;
 		float lodScale, lodBias;
 		float clipBorderDist;
+		int shadingRate;			// softrast_shading_rate of the whole frame
+		int textureFormat;			// softrast_texture_format textures are stored in when loaded
 	} DEBUG_SETTINGS;
 #endif
 
+typedef enum
+{
+	SOFTRAST_SIMD_SCALAR,		// Nothing beyond the x64 baseline
+	SOFTRAST_SIMD_SSE4,
+	SOFTRAST_SIMD_AVX2,
+	SOFTRAST_SIMD_AVX512,
+} softrast_simd_level;
+static const char* SimdLevels[] = { "Scalar", "SSE4", "AVX2", "AVX-512" };
+
 uint32_t softrast_initialize ( buddy_allocator* allocator );
 
+// softrast_initialize picks the best level the CPU supports. Forcing a lower one is meant for benchmarking; returns -1 when the level isn't supported.
+uint32_t            softrast_set_simd_level ( softrast_simd_level level );
+softrast_simd_level softrast_get_simd_level ( );
+softrast_simd_level softrast_get_supported_simd_level ( );
+
 uint32_t softrast_set_render_target ( uint32_t width, uint32_t height, uint32_t* colorBuffer, uint32_t pitchInBytes );
 uint32_t softrast_set_view_matrix ( const bbm_aos_mat4* projMat );
 uint32_t softrast_set_projection_matrix ( const bbm_aos_mat4* projMat );
 
+// Dynamic resolution: frames rasterize into the top left part of internal buffers, scaled down from the render target's size, and are upscaled into its color buffer when done.
+// A fixed scale holds until changed; with a frame time budget, every frame picks its scale from the time the previous one took, staying between minScale and 1.
+uint32_t softrast_set_render_scale ( float scale );
+uint32_t softrast_set_frame_time_budget ( float milliseconds, float minScale );	// 0 milliseconds goes back to the fixed scale
+
+// Screen-space shading rates (softrast_shading_rate per byte), stretched over the render target with row 0 at the top, like the color buffer. Must stay
+// untouched until the frames using it have completed; NULL turns it off again.
+uint32_t softrast_set_shading_rate_image ( const uint8_t* rates, uint32_t width, uint32_t height );
+
 uint32_t softrast_clear_render_target ( );
 uint32_t softrast_clear_depth_render_target ( );
 
@@ -108,6 +153,31 @@ uint32_t softrast_model_free ( softrast_model* model );
 
 uint32_t softrast_render ( softrast_model* model );
 
+// Queues a frame with the current matrices, render target, clears and Debug settings, and returns right away; frames are rendered in order on a thread of their own.
+// Blocks while the render-ahead limit's worth of frames is in flight. The model and color buffer must stay untouched until the frame's fence has completed.
+softrast_fence softrast_render_async ( softrast_model* model );
+uint32_t       softrast_fence_completed ( softrast_fence fence );
+void           softrast_fence_wait ( softrast_fence fence );
+void           softrast_finish ( );
+uint32_t       softrast_set_render_ahead ( uint32_t frameCount );	// 1 up to SOFTRAST_MAX_FRAMES_IN_FLIGHT, 1 by default
+
+// Statistics of a completed frame; they stay available until SOFTRAST_MAX_FRAMES_IN_FLIGHT more frames have been queued. Returns -1 when the fence hasn't completed, or its statistics are gone.
+uint32_t       softrast_get_frame_stats ( softrast_fence fence, softrast_frame_stats* stats );
+
+// Recording functions return -1 once the list is full
+void     softrast_command_list_init ( softrast_command_list* list, softrast_command* storage, uint32_t capacity );
+void     softrast_command_list_reset ( softrast_command_list* list );
+uint32_t softrast_command_set_view_matrix ( softrast_command_list* list, const bbm_aos_mat4* viewMat );
+uint32_t softrast_command_set_projection_matrix ( softrast_command_list* list, const bbm_aos_mat4* projMat );
+uint32_t softrast_command_draw_mesh ( softrast_command_list* list, softrast_mesh* mesh );
+uint32_t softrast_command_draw_submesh ( softrast_command_list* list, softrast_mesh* mesh, softrast_submesh* submesh );
+
+// Queues a frame like softrast_render_async, drawing the lists' commands. Each list starts from the current view and projection; the draws of all lists are
+// sorted by view, pipeline, texture and then front to back, and draws sharing a mesh are culled and transformed together. At most SOFTRAST_MAX_VIEWS - 1 matrix
+// commands can be submitted in one frame. Returns 0 when the frame couldn't be queued; the lists can be reset or reused as soon as this returns.
+softrast_fence softrast_submit_async ( const softrast_command_list* const* lists, uint32_t listCount );
+uint32_t       softrast_submit ( const softrast_command_list* const* lists, uint32_t listCount );
+
 #ifdef __cplusplus
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,440 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "softrast_kernels.h"
+
+//--------------------------------
+// Only compilers that know AVX-512 build the kernel, everyone else gets a stub that reports it's unavailable
+//--------------------------------
+#if defined(_MSC_VER)
+	#define SOFTRAST_AVX512_KERNEL (_MSC_VER >= 1911)
+#elif defined(__AVX512F__) && defined(__AVX512VL__)
+	#define SOFTRAST_AVX512_KERNEL 1
+#else
+	#define SOFTRAST_AVX512_KERNEL 0
+#endif
+
+#if SOFTRAST_AVX512_KERNEL
+
+#include <immintrin.h>
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+#define MIN(x,y) (((x) < (y)) ? (x) : (y))
+
+// Lanes belonging to quad q
+#define QUAD_LANES(q) ((__mmask16)(0xF << ((q) * 4)))
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Spreads the low 16 bits of every lane to the even bits (xxxx => 0x0x 0x0x)
+static __m512i __softrast_morton_spread_avx512 ( __m512i v )
+{
+	v = _mm512_and_si512 ( v, _mm512_set1_epi32 ( 0x0000FFFF ) );
+	v = _mm512_and_si512 ( _mm512_or_si512 ( v, _mm512_slli_epi32 ( v, 8 ) ), _mm512_set1_epi32 ( 0x00FF00FF ) );
+	v = _mm512_and_si512 ( _mm512_or_si512 ( v, _mm512_slli_epi32 ( v, 4 ) ), _mm512_set1_epi32 ( 0x0F0F0F0F ) );
+	v = _mm512_and_si512 ( _mm512_or_si512 ( v, _mm512_slli_epi32 ( v, 2 ) ), _mm512_set1_epi32 ( 0x33333333 ) );
+	v = _mm512_and_si512 ( _mm512_or_si512 ( v, _mm512_slli_epi32 ( v, 1 ) ), _mm512_set1_epi32 ( 0x55555555 ) );
+	return v;
+}
+
+// The 16-bit texel filters take AVX-512 BW, which the kernel doesn't require, so they run on both 256-bit halves instead
+static __m512i __softrast_lerp_texels_avx512 ( __m512i a, __m512i b, __m512i t )
+{
+	const __m256i lo = softrast_lerp_texels_avx2 ( _mm512_castsi512_si256 ( a ), _mm512_castsi512_si256 ( b ), _mm512_castsi512_si256 ( t ) );
+	const __m256i hi = softrast_lerp_texels_avx2 ( _mm512_extracti64x4_epi64 ( a, 1 ), _mm512_extracti64x4_epi64 ( b, 1 ), _mm512_extracti64x4_epi64 ( t, 1 ) );
+	return _mm512_inserti64x4 ( _mm512_castsi256_si512 ( lo ), hi, 1 );
+}
+
+static __m512i __softrast_bilinear_avx512 ( __m512i c00, __m512i c01, __m512i c10, __m512i c11, __m512i fracX, __m512i fracY )
+{
+	const __m256i lo = softrast_bilinear_avx2 ( _mm512_castsi512_si256 ( c00 ), _mm512_castsi512_si256 ( c01 ), _mm512_castsi512_si256 ( c10 ), _mm512_castsi512_si256 ( c11 ),
+	                                            _mm512_castsi512_si256 ( fracX ), _mm512_castsi512_si256 ( fracY ) );
+	const __m256i hi = softrast_bilinear_avx2 ( _mm512_extracti64x4_epi64 ( c00, 1 ), _mm512_extracti64x4_epi64 ( c01, 1 ), _mm512_extracti64x4_epi64 ( c10, 1 ), _mm512_extracti64x4_epi64 ( c11, 1 ),
+	                                            _mm512_extracti64x4_epi64 ( fracX, 1 ), _mm512_extracti64x4_epi64 ( fracY, 1 ) );
+	return _mm512_inserti64x4 ( _mm512_castsi256_si512 ( lo ), hi, 1 );
+}
+
+// Texel index of (ix, iy) inside a mip level, following the addressing mode
+static __forceinline __m512i __softrast_texel_index_avx512 ( __m512i ix, __m512i iy, __m512i mipWidth, const int textureAddressingMode )
+{
+	if ( textureAddressingMode == TEXTURE_ADDRESSING_TILED )
+	{
+		const __m512i three   = _mm512_set1_epi32 ( 3 );
+		const __m512i tileidx = _mm512_add_epi32 ( _mm512_mullo_epi32 ( _mm512_srli_epi32 ( iy, 2 ), _mm512_srli_epi32 ( mipWidth, 2 ) ), _mm512_srli_epi32 ( ix, 2 ) );
+		const __m512i pixidx  = _mm512_add_epi32 ( _mm512_slli_epi32 ( _mm512_and_si512 ( iy, three ), 2 ), _mm512_and_si512 ( ix, three ) );
+		return _mm512_add_epi32 ( _mm512_slli_epi32 ( tileidx, 4 ), pixidx );
+	}
+	else if ( textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
+		return _mm512_or_si512 ( __softrast_morton_spread_avx512 ( ix ), _mm512_slli_epi32 ( __softrast_morton_spread_avx512 ( iy ), 1 ) );
+	else
+		return _mm512_add_epi32 ( _mm512_mullo_epi32 ( iy, mipWidth ), ix );
+}
+
+// Fetches texels for each quad from its own mip level; masked off lanes aren't read
+static __m512i __softrast_gather_avx512 ( const uint32_t* const mipData[4], __m512i index, __mmask16 mask )
+{
+	const __m512i iota = _mm512_setr_epi32 ( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 );
+
+	__m512i texels = _mm512_setzero_si512 ( );
+	for ( uint32_t q = 0; q < 4; q++ )
+	{
+		const __mmask8 quadMask = (__mmask8)((mask >> (q * 4)) & 0xF);
+		if ( !quadMask )
+			continue;
+
+		const __m128i quadIndex  = _mm512_castsi512_si128 ( _mm512_permutexvar_epi32 ( _mm512_add_epi32 ( iota, _mm512_set1_epi32 ( q * 4 ) ), index ) );
+		const __m128i quadTexels = _mm_mmask_i32gather_epi32 ( _mm_setzero_si128 ( ), quadMask, quadIndex, mipData[q], 4 );
+		texels = _mm512_mask_broadcast_i32x4 ( texels, QUAD_LANES ( q ), quadTexels );
+	}
+	return texels;
+}
+
+// Fetches the texels at (ix, iy) for each quad: gathered for RGBA8, decoded lane by lane through the block cache for compressed textures
+static __forceinline __m512i __softrast_fetch_avx512 ( const softrast_texture* texture, const uint32_t level[4], const uint32_t* const mipData[4], __m512i ix, __m512i iy, __m512i mipWidth, __mmask16 mask, const int textureAddressingMode )
+{
+	if ( texture->format == SOFTRAST_TEXTURE_FORMAT_RGBA8 )
+		return __softrast_gather_avx512 ( mipData, __softrast_texel_index_avx512 ( ix, iy, mipWidth, textureAddressingMode ), mask );
+
+	uint32_t x[16], y[16], texels[16];
+	_mm512_storeu_si512 ( x, ix );
+	_mm512_storeu_si512 ( y, iy );
+	for ( uint32_t i = 0; i < 16; i++ )
+		texels[i] = (mask & (1 << i)) ? softrast_fetch_compressed ( texture, level[i >> 2], x[i], y[i] ) : 0;
+	return _mm512_loadu_si512 ( texels );
+}
+
+// Samples one mip level per quad with point or bilinear filtering. u and v are in top level texels
+static __forceinline __m512i __softrast_sample_avx512 ( const softrast_texture* texture, const uint32_t level[4], __m512 u16, __m512 v16, __mmask16 mask, const int textureAddressingMode, const int textureFilteringMode )
+{
+	const uint32_t* const mipData[4] = { texture->mipData[level[0]], texture->mipData[level[1]], texture->mipData[level[2]], texture->mipData[level[3]] };
+
+	__m512i mipWidth16 = _mm512_setzero_si512 ( );
+	__m512  uvScale16  = _mm512_setzero_ps ( );
+	for ( uint32_t q = 0; q < 4; q++ )
+	{
+		mipWidth16 = _mm512_mask_set1_epi32 ( mipWidth16, QUAD_LANES ( q ), texture->width >> level[q] );
+		uvScale16  = _mm512_mask_mov_ps ( uvScale16, QUAD_LANES ( q ), _mm512_set1_ps ( 1.0f / (1<<level[q]) ) );
+	}
+
+	const __m512 fx = _mm512_mul_ps ( u16, uvScale16 );
+	const __m512 fy = _mm512_mul_ps ( v16, uvScale16 );
+
+	//--------------------------------
+	// Fetch the texel, or the 2x2 footprint, wrapping around the edges of the level
+	//--------------------------------
+	const __m512i tx   = _mm512_cvttps_epi32 ( fx );
+	const __m512i ty   = _mm512_cvttps_epi32 ( fy );
+	const __m512i wrap = _mm512_sub_epi32 ( mipWidth16, _mm512_set1_epi32 ( 1 ) );
+	const __m512i ix1  = _mm512_and_si512 ( tx, wrap );
+	const __m512i iy1  = _mm512_and_si512 ( ty, wrap );
+
+	if ( textureFilteringMode != TEXTURE_FILTERING_BILINEAR )
+		return __softrast_fetch_avx512 ( texture, level, mipData, ix1, iy1, mipWidth16, mask, textureAddressingMode );
+
+	const __m512i ix2  = _mm512_and_si512 ( _mm512_add_epi32 ( ix1, _mm512_set1_epi32 ( 1 ) ), wrap );
+	const __m512i iy2  = _mm512_and_si512 ( _mm512_add_epi32 ( iy1, _mm512_set1_epi32 ( 1 ) ), wrap );
+
+	const __m512i c00 = __softrast_fetch_avx512 ( texture, level, mipData, ix1, iy1, mipWidth16, mask, textureAddressingMode );
+	const __m512i c01 = __softrast_fetch_avx512 ( texture, level, mipData, ix2, iy1, mipWidth16, mask, textureAddressingMode );
+	const __m512i c10 = __softrast_fetch_avx512 ( texture, level, mipData, ix1, iy2, mipWidth16, mask, textureAddressingMode );
+	const __m512i c11 = __softrast_fetch_avx512 ( texture, level, mipData, ix2, iy2, mipWidth16, mask, textureAddressingMode );
+
+	//--------------------------------
+	// Blend with Q15 weights, taken from the unwrapped coordinates like the other pixel pipelines
+	//--------------------------------
+	const __m512i fracX = _mm512_cvttps_epi32 ( _mm512_mul_ps ( _mm512_sub_ps ( fx, _mm512_cvtepi32_ps ( tx ) ), _mm512_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	const __m512i fracY = _mm512_cvttps_epi32 ( _mm512_mul_ps ( _mm512_sub_ps ( fy, _mm512_cvtepi32_ps ( ty ) ), _mm512_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	return __softrast_bilinear_avx512 ( c00, c01, c10, c11, fracX, fracY );
+}
+
+// Samples coarse quads, whose lanes all hold the same UV, with one gather for their whole bilinear footprint: lane (r * 2 + c) of a quad
+// fetches texel (c, r), then the texels are blended across the quad, which leaves every lane with the color of the block. u and v are in top
+// level texels
+static __forceinline __m512i __softrast_sample_coarse_avx512 ( const softrast_texture* texture, const uint32_t level[4], __m512 u16, __m512 v16, __mmask16 mask, const int textureAddressingMode, const int textureFilteringMode )
+{
+	if ( textureFilteringMode != TEXTURE_FILTERING_BILINEAR )
+		return __softrast_sample_avx512 ( texture, level, u16, v16, mask, textureAddressingMode, textureFilteringMode );
+
+	const uint32_t* const mipData[4] = { texture->mipData[level[0]], texture->mipData[level[1]], texture->mipData[level[2]], texture->mipData[level[3]] };
+
+	__m512i mipWidth16 = _mm512_setzero_si512 ( );
+	__m512  uvScale16  = _mm512_setzero_ps ( );
+	for ( uint32_t q = 0; q < 4; q++ )
+	{
+		mipWidth16 = _mm512_mask_set1_epi32 ( mipWidth16, QUAD_LANES ( q ), texture->width >> level[q] );
+		uvScale16  = _mm512_mask_mov_ps ( uvScale16, QUAD_LANES ( q ), _mm512_set1_ps ( 1.0f / (1<<level[q]) ) );
+	}
+
+	const __m512 fx = _mm512_mul_ps ( u16, uvScale16 );
+	const __m512 fy = _mm512_mul_ps ( v16, uvScale16 );
+
+	//--------------------------------
+	// Fetch the 2x2 footprint, one texel per lane, wrapping around the edges of the level
+	//--------------------------------
+	const __m512i tx   = _mm512_cvttps_epi32 ( fx );
+	const __m512i ty   = _mm512_cvttps_epi32 ( fy );
+	const __m512i wrap = _mm512_sub_epi32 ( mipWidth16, _mm512_set1_epi32 ( 1 ) );
+	const __m512i ix1  = _mm512_and_si512 ( tx, wrap );
+	const __m512i iy1  = _mm512_and_si512 ( ty, wrap );
+	const __m512i ix   = _mm512_and_si512 ( _mm512_add_epi32 ( ix1, _mm512_broadcast_i32x4 ( _mm_setr_epi32 ( 0, 1, 0, 1 ) ) ), wrap );
+	const __m512i iy   = _mm512_and_si512 ( _mm512_add_epi32 ( iy1, _mm512_broadcast_i32x4 ( _mm_setr_epi32 ( 0, 0, 1, 1 ) ) ), wrap );
+
+	const __m512i texel = __softrast_fetch_avx512 ( texture, level, mipData, ix, iy, mipWidth16, mask, textureAddressingMode );
+
+	//--------------------------------
+	// Hand every lane the whole footprint of its quad, and blend it like __softrast_sample_avx512 does
+	//--------------------------------
+	const __m512i fracX = _mm512_cvttps_epi32 ( _mm512_mul_ps ( _mm512_sub_ps ( fx, _mm512_cvtepi32_ps ( tx ) ), _mm512_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	const __m512i fracY = _mm512_cvttps_epi32 ( _mm512_mul_ps ( _mm512_sub_ps ( fy, _mm512_cvtepi32_ps ( ty ) ), _mm512_set1_ps ( SOFTRAST_WEIGHT_SCALE ) ) );
+	return __softrast_bilinear_avx512 ( _mm512_shuffle_epi32 ( texel, _MM_PERM_AAAA ), _mm512_shuffle_epi32 ( texel, _MM_PERM_BBBB ),
+	                                    _mm512_shuffle_epi32 ( texel, _MM_PERM_CCCC ), _mm512_shuffle_epi32 ( texel, _MM_PERM_DDDD ), fracX, fracY );
+}
+
+// Samples the pixels in sampleMask on their own, and the coarse quads in coarseMask once each
+static __forceinline __m512i __softrast_sample_quads_avx512 ( const softrast_texture* texture, const uint32_t level[4], __m512 u16, __m512 v16, __mmask16 sampleMask, __mmask16 coarseMask, const int textureAddressingMode, const int textureFilteringMode )
+{
+	__m512i color = _mm512_setzero_si512 ( );
+	if ( sampleMask )
+		color = __softrast_sample_avx512 ( texture, level, u16, v16, sampleMask, textureAddressingMode, textureFilteringMode );
+	if ( coarseMask )
+		color = _mm512_mask_mov_epi32 ( color, coarseMask, __softrast_sample_coarse_avx512 ( texture, level, u16, v16, coarseMask, textureAddressingMode, textureFilteringMode ) );
+	return color;
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+// Lane (q * 4 + r * 2 + c) holds pixel (x + c, y + r) of quad q. Coverage and depth test results live in a k-mask,
+// so there are no per-pixel branches, and the masked loads and stores never touch pixels outside of the quads' coverage. Only ever called
+// with constant render settings by the specialized kernels below.
+static __forceinline void __softrast_shade_quads_avx512_generic ( const raster_quad* quads, uint32_t quadCount, const softrast_submesh* submesh, const raster_shade_target* target,
+                                                                  const int renderMode, const int textureAddressingMode, const int textureFilteringMode, const int textureMipmapMode, const int dithering )
+{
+
+	const softrast_texture* texture = submesh->texture;
+	const __m512i iota = _mm512_setr_epi32 ( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 );
+
+	//--------------------------------
+	// Spread the quads over the lanes; missing quads repeat the first one, with their lanes masked off
+	//--------------------------------
+	__mmask16 coverage = 0;
+	float* dbquadptr[4];
+	__m512 z16 = _mm512_setzero_ps ( ), u16 = _mm512_setzero_ps ( ), v16 = _mm512_setzero_ps ( ), d16 = _mm512_setzero_ps ( );
+
+	for ( uint32_t q = 0; q < 4; q++ )
+	{
+		const raster_quad* quad = quads + (q < quadCount ? q : 0);
+		if ( q < quadCount )
+			coverage |= (__mmask16)(quad->coverage << (q * 4));
+
+		dbquadptr[q] = target->depthBuffer + ((uint32_t)quad->y >> 1) * target->depthBufferQuadFloatStride + 4 * ((uint32_t)quad->x >> 1);
+
+		z16 = _mm512_mask_broadcast_f32x4 ( z16, QUAD_LANES ( q ), _mm_setr_ps ( quad->z[0], quad->z[0] + quad->zstep[0], quad->z[1], quad->z[1] + quad->zstep[1] ) );
+		u16 = _mm512_mask_broadcast_f32x4 ( u16, QUAD_LANES ( q ), _mm_setr_ps ( quad->u[0], quad->u[0] + quad->ustep[0], quad->u[1], quad->u[1] + quad->ustep[1] ) );
+		v16 = _mm512_mask_broadcast_f32x4 ( v16, QUAD_LANES ( q ), _mm_setr_ps ( quad->v[0], quad->v[0] + quad->vstep[0], quad->v[1], quad->v[1] + quad->vstep[1] ) );
+		d16 = _mm512_mask_broadcast_f32x4 ( d16, QUAD_LANES ( q ), _mm_load_ps ( dbquadptr[q] ) );
+	}
+
+	//--------------------------------
+	// Depth test
+	//--------------------------------
+	const __mmask16 pixelMask = _mm512_mask_cmp_ps_mask ( coverage, z16, d16, _CMP_GT_OQ ); // if ( covered && pz > *dptr[r][c] )
+	ThreadPixelStats.testedPixels += softrast_bit_count ( coverage );
+	ThreadPixelStats.shadedPixels += softrast_bit_count ( pixelMask );
+	if ( !pixelMask )
+		return;
+
+	for ( uint32_t q = 0; q < quadCount; q++ )
+	{
+		const __m128 quadZ = _mm512_castps512_ps128 ( _mm512_permutexvar_ps ( _mm512_add_epi32 ( iota, _mm512_set1_epi32 ( q * 4 ) ), z16 ) );
+		_mm_mask_store_ps ( dbquadptr[q], (__mmask8)((pixelMask >> (q * 4)) & 0xF), quadZ );
+	}
+
+	//--------------------------------
+	// Perspective divide, and UV for each pixel
+	//--------------------------------
+	const __m512 rz16 = _mm512_div_ps ( _mm512_set1_ps ( 1.0f ), z16 );
+	u16 = _mm512_mul_ps ( u16, rz16 );
+	v16 = _mm512_mul_ps ( v16, rz16 );
+
+	//--------------------------------
+	// Determine mipmap data per quad, from the largest UV delta between neighbouring pixels, scaled up to the shading block for coarse quads
+	//--------------------------------
+	const __m512 width16 = _mm512_set1_ps ( (float)texture->width );
+	mip_selection mip[4];
+
+	if ( textureMipmapMode != TEXTURE_MIPMAP_NONE )
+	{
+		const __m512 dx = _mm512_max_ps ( _mm512_abs_ps ( _mm512_sub_ps ( u16, _mm512_permute_ps ( u16, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) ) ),
+		                                  _mm512_abs_ps ( _mm512_sub_ps ( v16, _mm512_permute_ps ( v16, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) ) ) );
+		const __m512 dy = _mm512_max_ps ( _mm512_abs_ps ( _mm512_sub_ps ( u16, _mm512_permute_ps ( u16, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) ) ),
+		                                  _mm512_abs_ps ( _mm512_sub_ps ( v16, _mm512_permute_ps ( v16, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) ) ) );
+
+		__m512 maxDUV = _mm512_mul_ps ( width16, _mm512_max_ps ( dx, dy ) );
+		maxDUV = _mm512_max_ps ( maxDUV, _mm512_permute_ps ( maxDUV, _MM_SHUFFLE ( 2, 3, 0, 1 ) ) );
+		maxDUV = _mm512_max_ps ( maxDUV, _mm512_permute_ps ( maxDUV, _MM_SHUFFLE ( 1, 0, 3, 2 ) ) );
+
+		for ( uint32_t q = 0; q < 4; q++ )
+		{
+			if ( q < quadCount )
+				softrast_select_mip ( &mip[q], texture, (float)(1 << quads[q].shadingRate) * _mm512_cvtss_f32 ( _mm512_permutexvar_ps ( _mm512_set1_epi32 ( q * 4 ), maxDUV ) ) );
+			else
+				mip[q] = mip[0];
+		}
+	}
+	else
+	{
+		for ( uint32_t q = 0; q < 4; q++ )
+		{
+			mip[q].level = mip[q].level2 = 0;
+			mip[q].t     = 0.0f;
+		}
+	}
+
+	//--------------------------------
+	// Coarse quads shade all of their lanes with the UV at the center of their shading block, in the modes that look at UVs
+	//--------------------------------
+	const uint32_t usesUV = renderMode == RENDER_MODE_UV || renderMode == RENDER_MODE_TEXTURED;
+	__mmask16 coarse = 0;
+
+	for ( uint32_t q = 0; usesUV && q < quadCount; q++ )
+	{
+		if ( quads[q].shadingRate == SOFTRAST_SHADING_RATE_1X1 )
+			continue;
+
+		float cu, cv;
+		softrast_coarse_sample ( quads + q, &cu, &cv );
+		u16     = _mm512_mask_mov_ps ( u16, QUAD_LANES ( q ), _mm512_set1_ps ( cu ) );
+		v16     = _mm512_mask_mov_ps ( v16, QUAD_LANES ( q ), _mm512_set1_ps ( cv ) );
+		coarse |= QUAD_LANES ( q );
+	}
+
+	//--------------------------------
+	// Wrap UV and transform to pixel units
+	//--------------------------------
+	u16 = _mm512_mul_ps ( _mm512_sub_ps ( u16, _mm512_roundscale_ps ( u16, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC ) ), width16 );
+	v16 = _mm512_mul_ps ( _mm512_sub_ps ( v16, _mm512_roundscale_ps ( v16, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC ) ), width16 );
+
+	//--------------------------------
+	// Apply dithering, quads always start on an even pixel so the pattern is the same for each of them
+	//--------------------------------
+	if ( dithering )
+	{
+		u16 = _mm512_mask_add_ps ( u16, (__mmask16)~coarse, u16, _mm512_broadcast_f32x4 ( _mm_setr_ps ( 0.25f, 0.5f, 0.75f, 0.0f ) ) );
+		v16 = _mm512_mask_add_ps ( v16, (__mmask16)~coarse, v16, _mm512_broadcast_f32x4 ( _mm_setr_ps ( 0.0f, 0.75f, 0.5f, 0.25f ) ) );
+	}
+
+	//--------------------------------
+	// Shade
+	//--------------------------------
+	__m512i color16;
+	if ( renderMode == RENDER_MODE_FLAT_COLOR )
+		color16 = _mm512_set1_epi32 ( 0xFFFF0000 );
+	else if ( renderMode == RENDER_MODE_UV )
+	{
+		const __m512i fx = _mm512_cvttps_epi32 ( _mm512_mul_ps ( _mm512_div_ps ( u16, width16 ), _mm512_set1_ps ( 256.0f ) ) );
+		const __m512i fy = _mm512_cvttps_epi32 ( _mm512_mul_ps ( _mm512_div_ps ( v16, _mm512_set1_ps ( (float)texture->height ) ), _mm512_set1_ps ( 256.0f ) ) );
+		color16 = _mm512_or_si512 ( _mm512_slli_epi32 ( fx, 16 ), _mm512_slli_epi32 ( fy, 8 ) );
+	}
+	else if ( renderMode == RENDER_MODE_ZBUFFER )
+		color16 = _mm512_cvttps_epi32 ( _mm512_mul_ps ( _mm512_div_ps ( _mm512_sub_ps ( rz16, _mm512_set1_ps ( target->nearClip ) ), _mm512_set1_ps ( target->farClip - target->nearClip ) ), _mm512_set1_ps ( 255.0f ) ) );
+	else if ( renderMode == RENDER_MODE_MIPMAP )
+	{
+		static const uint32_t mipmapLUT[] = {
+			0xFF0000,
+			0x00FF00,
+			0xFFFF00,
+			0x0000FF,
+			0xFF00FF,
+			0x00FFFF,
+			0xFFFFFF,
+		};
+
+		color16 = _mm512_setzero_si512 ( );
+		for ( uint32_t q = 0; q < 4; q++ )
+		{
+			const uint32_t level = textureMipmapMode == TEXTURE_MIPMAP_LINEAR ? mip[q].level2 : mip[q].level;
+			color16 = _mm512_mask_set1_epi32 ( color16, QUAD_LANES ( q ), mipmapLUT[MIN(level,sizeof(mipmapLUT)/sizeof(mipmapLUT[0])-1)] );
+		}
+	}
+	else if ( renderMode == RENDER_MODE_TEXTURED )
+	{
+		//--------------------------------
+		// Pixels that passed the depth test sample on their own, coarse quads with any of them once for the whole quad
+		//--------------------------------
+		const __mmask16 sampleMask = pixelMask & (__mmask16)~coarse;
+		__mmask16 coarseMask = 0;
+		for ( uint32_t q = 0; q < quadCount; q++ )
+		{
+			if ( coarse & pixelMask & QUAD_LANES ( q ) )
+				coarseMask |= QUAD_LANES ( q );
+		}
+
+		const uint32_t level[4] = { mip[0].level, mip[1].level, mip[2].level, mip[3].level };
+		color16 = __softrast_sample_quads_avx512 ( texture, level, u16, v16, sampleMask, coarseMask, textureAddressingMode, textureFilteringMode );
+
+		if ( textureMipmapMode == TEXTURE_MIPMAP_LINEAR )
+		{
+			const uint32_t level2[4] = { mip[0].level2, mip[1].level2, mip[2].level2, mip[3].level2 };
+			const __m512i color2 = __softrast_sample_quads_avx512 ( texture, level2, u16, v16, sampleMask, coarseMask, textureAddressingMode, textureFilteringMode );
+
+			__m512i t16 = _mm512_setzero_si512 ( );
+			for ( uint32_t q = 0; q < 4; q++ )
+				t16 = _mm512_mask_set1_epi32 ( t16, QUAD_LANES ( q ), (int32_t)(mip[q].t * SOFTRAST_WEIGHT_SCALE) );
+			color16 = __softrast_lerp_texels_avx512 ( color16, color2, t16 );
+		}
+	}
+	else
+		return;
+
+	//--------------------------------
+	// Write each quad's rows with masked stores
+	//--------------------------------
+	for ( uint32_t q = 0; q < quadCount; q++ )
+	{
+		const __m128i  quadColor = _mm512_castsi512_si128 ( _mm512_permutexvar_epi32 ( _mm512_add_epi32 ( iota, _mm512_set1_epi32 ( q * 4 ) ), color16 ) );
+		const uint32_t quadMask  = (pixelMask >> (q * 4)) & 0xF;
+
+		_mm_mask_storeu_epi32 ( quads[q].color[0], (__mmask8)(quadMask & 0x3), quadColor );
+		_mm_mask_storeu_epi32 ( quads[q].color[1], (__mmask8)(quadMask >> 2), _mm_unpackhi_epi64 ( quadColor, quadColor ) );
+	}
+}
+
+#define SOFTRAST_SHADE_QUADS_AVX512(name,renderMode,addressing,filtering,mipmap,dithering) \
+	static void name ( const raster_quad* quads, uint32_t quadCount, const softrast_submesh* submesh, const raster_shade_target* target ) \
+	{ __softrast_shade_quads_avx512_generic ( quads, quadCount, submesh, target, renderMode, addressing, filtering, mipmap, dithering ); }
+
+SOFTRAST_SHADE_KERNELS ( __softrast_shade_quads_avx512, SOFTRAST_SHADE_QUADS_AVX512 )
+
+static const SOFTRAST_SHADE_KERNEL_TABLE_TYPE ( softrast_shade_quads_func ) __softrast_shade_quads_avx512_table = SOFTRAST_SHADE_KERNEL_TABLE ( __softrast_shade_quads_avx512 );
+
+softrast_shade_quads_func softrast_select_shade_quads_avx512 ( const DEBUG_SETTINGS* debug )
+{
+	return SOFTRAST_SELECT_SHADE_KERNEL ( __softrast_shade_quads_avx512_table, debug );
+}
+
+#else
+
+softrast_shade_quads_func softrast_select_shade_quads_avx512 ( const DEBUG_SETTINGS* debug )
+{
+	(void)debug;
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,301 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "softrast.h"
+
+#include <math.h>
+#include <immintrin.h>
+
+// Pixel shading kernels that live in their own translation units, so they can be compiled for instruction sets the rest of the rasterizer can't assume
+
+#define SOFTRAST_MAX_BATCH_QUADS 4
+
+typedef struct
+{
+	int32_t x, y;					// Top left pixel of the quad
+	uint32_t coverage;				// Bit (r * 2 + c) is set when pixel (x + c, y + r) lies inside the polygon
+	float z[2], u[2], v[2];			// 1/w, u/w and v/w at the left pixel of each row
+	float zstep[2], ustep[2], vstep[2];
+	uint32_t* color[2];				// Left pixel of each row
+	float* depth[2];
+	uint32_t shadingRate;			// softrast_shading_rate, also the log2 of the size of the shading block
+} raster_quad;
+
+typedef struct
+{
+	uint32_t level, level2;			// Level to sample, and the next one down for linear mip filtering
+	uint32_t width;					// Width of level
+	float t;						// Blend factor between level and level2
+	float uvScale;					// Scales top level texel coordinates to level texel coordinates
+} mip_selection;
+
+typedef struct
+{
+	float* depthBuffer;				// Quad-swizzled, see softrast_set_render_target
+	uint32_t depthBufferQuadFloatStride;
+	float nearClip, farClip;
+} raster_shade_target;
+
+// Shades up to SOFTRAST_MAX_BATCH_QUADS quads with one of the wide kernels
+typedef void ( *softrast_shade_quads_func ) ( const raster_quad* quads, uint32_t quadCount, const softrast_submesh* submesh, const raster_shade_target* target );
+
+#ifdef _MSC_VER
+	#define SOFTRAST_THREAD_LOCAL __declspec(thread)
+#else
+	#define SOFTRAST_THREAD_LOCAL __thread
+#endif
+
+// Depth test outcomes of the pixels rasterized on the calling thread, handed over to the frame's statistics whenever a job finishes
+typedef struct
+{
+	uint32_t testedPixels;			// Covered pixels that reached the depth test
+	uint32_t shadedPixels;			// Covered pixels that passed it
+} pixel_stats;
+
+extern DEBUG_SETTINGS FrameDebug;	// Debug as it was when the frame being rendered was submitted
+extern SOFTRAST_THREAD_LOCAL pixel_stats ThreadPixelStats;
+
+static __forceinline uint32_t softrast_bit_count ( uint32_t bits )
+{
+	bits = bits - ((bits >> 1) & 0x55555555);
+	bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+	return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+// Coarse shading: perspective-correct UV at the center of the screen-aligned shading block the quad lies in, which all of its pixels shade with.
+// Every quad of a block gets the same UV. The center may lie outside of the triangle, so the UV is wrapped with floor instead of truncation,
+// which also keeps it in [0, 1) for extrapolated negative coordinates.
+static __forceinline void softrast_coarse_sample ( const raster_quad* quad, float* u, float* v )
+{
+	const int32_t size = 1 << quad->shadingRate;
+	const float cx     = (float)(quad->x & ~(size - 1)) + 0.5f * (float)(size - 1) - (float)quad->x;
+	const float cy     = (float)(quad->y & ~(size - 1)) + 0.5f * (float)(size - 1) - (float)quad->y;
+
+	const float dzdy = quad->z[1] - quad->z[0], dudy = quad->u[1] - quad->u[0], dvdy = quad->v[1] - quad->v[0];
+	const float rz   = 1.0f / (quad->z[0] + cx * quad->zstep[0] + cy * dzdy);
+	const float cu   = (quad->u[0] + cx * quad->ustep[0] + cy * dudy) * rz;
+	const float cv   = (quad->v[0] + cx * quad->vstep[0] + cy * dvdy) * rz;
+
+	// NaNs from a degenerate center fail the comparisons and end up at the largest UV below 1 as well
+	const float wrappedU = cu - floorf ( cu ), wrappedV = cv - floorf ( cv );
+	*u = wrappedU < 0.99999994f ? wrappedU : 0.99999994f;
+	*v = wrappedV < 0.99999994f ? wrappedV : 0.99999994f;
+}
+
+//--------------------------------
+// Texel filtering in 16-bit fixed point, shared by all pixel pipelines so they produce the same images. Texels are unpacked to one 16-bit word per
+// channel, and each lerp takes a + round ((b - a) * t) with pmulhrsw, t being a fraction in [0, 1) as Q15 in the low word of each pixel's lane.
+// Alpha is cleared, like texture sampling always has.
+//--------------------------------
+
+// Spreads each pixel's weight over the words of its 4 channels, for the pixels unpacklo and unpackhi take from each 128-bit lane
+static __forceinline void softrast_expand_weights_sse ( __m128i t, __m128i* lo, __m128i* hi )
+{
+	const __m128i t2 = _mm_or_si128 ( t, _mm_slli_epi32 ( t, 16 ) );
+	*lo = _mm_unpacklo_epi32 ( t2, t2 );
+	*hi = _mm_unpackhi_epi32 ( t2, t2 );
+}
+
+static __forceinline __m128i softrast_lerp_unpacked_sse ( __m128i a, __m128i b, __m128i t )
+{
+	return _mm_add_epi16 ( a, _mm_mulhrs_epi16 ( _mm_sub_epi16 ( b, a ), t ) );
+}
+
+static __forceinline __m128i softrast_lerp_texels_sse ( __m128i a, __m128i b, __m128i t )
+{
+	const __m128i zero = _mm_setzero_si128 ( );
+	__m128i tlo, thi;
+	softrast_expand_weights_sse ( t, &tlo, &thi );
+
+	const __m128i lo = softrast_lerp_unpacked_sse ( _mm_unpacklo_epi8 ( a, zero ), _mm_unpacklo_epi8 ( b, zero ), tlo );
+	const __m128i hi = softrast_lerp_unpacked_sse ( _mm_unpackhi_epi8 ( a, zero ), _mm_unpackhi_epi8 ( b, zero ), thi );
+	return _mm_and_si128 ( _mm_packus_epi16 ( lo, hi ), _mm_set1_epi32 ( 0x00FFFFFF ) );
+}
+
+// Blends the 2x2 footprint of each pixel, first along the rows, then between them; the rows stay at 16 bits in between
+static __forceinline __m128i softrast_bilinear_sse ( __m128i c00, __m128i c01, __m128i c10, __m128i c11, __m128i fracX, __m128i fracY )
+{
+	const __m128i zero = _mm_setzero_si128 ( );
+	__m128i xlo, xhi, ylo, yhi;
+	softrast_expand_weights_sse ( fracX, &xlo, &xhi );
+	softrast_expand_weights_sse ( fracY, &ylo, &yhi );
+
+	const __m128i toplo    = softrast_lerp_unpacked_sse ( _mm_unpacklo_epi8 ( c00, zero ), _mm_unpacklo_epi8 ( c01, zero ), xlo );
+	const __m128i tophi    = softrast_lerp_unpacked_sse ( _mm_unpackhi_epi8 ( c00, zero ), _mm_unpackhi_epi8 ( c01, zero ), xhi );
+	const __m128i bottomlo = softrast_lerp_unpacked_sse ( _mm_unpacklo_epi8 ( c10, zero ), _mm_unpacklo_epi8 ( c11, zero ), xlo );
+	const __m128i bottomhi = softrast_lerp_unpacked_sse ( _mm_unpackhi_epi8 ( c10, zero ), _mm_unpackhi_epi8 ( c11, zero ), xhi );
+
+	const __m128i lo = softrast_lerp_unpacked_sse ( toplo, bottomlo, ylo );
+	const __m128i hi = softrast_lerp_unpacked_sse ( tophi, bottomhi, yhi );
+	return _mm_and_si128 ( _mm_packus_epi16 ( lo, hi ), _mm_set1_epi32 ( 0x00FFFFFF ) );
+}
+
+static __forceinline void softrast_expand_weights_avx2 ( __m256i t, __m256i* lo, __m256i* hi )
+{
+	const __m256i t2 = _mm256_or_si256 ( t, _mm256_slli_epi32 ( t, 16 ) );
+	*lo = _mm256_unpacklo_epi32 ( t2, t2 );
+	*hi = _mm256_unpackhi_epi32 ( t2, t2 );
+}
+
+static __forceinline __m256i softrast_lerp_unpacked_avx2 ( __m256i a, __m256i b, __m256i t )
+{
+	return _mm256_add_epi16 ( a, _mm256_mulhrs_epi16 ( _mm256_sub_epi16 ( b, a ), t ) );
+}
+
+static __forceinline __m256i softrast_lerp_texels_avx2 ( __m256i a, __m256i b, __m256i t )
+{
+	const __m256i zero = _mm256_setzero_si256 ( );
+	__m256i tlo, thi;
+	softrast_expand_weights_avx2 ( t, &tlo, &thi );
+
+	const __m256i lo = softrast_lerp_unpacked_avx2 ( _mm256_unpacklo_epi8 ( a, zero ), _mm256_unpacklo_epi8 ( b, zero ), tlo );
+	const __m256i hi = softrast_lerp_unpacked_avx2 ( _mm256_unpackhi_epi8 ( a, zero ), _mm256_unpackhi_epi8 ( b, zero ), thi );
+	return _mm256_and_si256 ( _mm256_packus_epi16 ( lo, hi ), _mm256_set1_epi32 ( 0x00FFFFFF ) );
+}
+
+static __forceinline __m256i softrast_bilinear_avx2 ( __m256i c00, __m256i c01, __m256i c10, __m256i c11, __m256i fracX, __m256i fracY )
+{
+	const __m256i zero = _mm256_setzero_si256 ( );
+	__m256i xlo, xhi, ylo, yhi;
+	softrast_expand_weights_avx2 ( fracX, &xlo, &xhi );
+	softrast_expand_weights_avx2 ( fracY, &ylo, &yhi );
+
+	const __m256i toplo    = softrast_lerp_unpacked_avx2 ( _mm256_unpacklo_epi8 ( c00, zero ), _mm256_unpacklo_epi8 ( c01, zero ), xlo );
+	const __m256i tophi    = softrast_lerp_unpacked_avx2 ( _mm256_unpackhi_epi8 ( c00, zero ), _mm256_unpackhi_epi8 ( c01, zero ), xhi );
+	const __m256i bottomlo = softrast_lerp_unpacked_avx2 ( _mm256_unpacklo_epi8 ( c10, zero ), _mm256_unpacklo_epi8 ( c11, zero ), xlo );
+	const __m256i bottomhi = softrast_lerp_unpacked_avx2 ( _mm256_unpackhi_epi8 ( c10, zero ), _mm256_unpackhi_epi8 ( c11, zero ), xhi );
+
+	const __m256i lo = softrast_lerp_unpacked_avx2 ( toplo, bottomlo, ylo );
+	const __m256i hi = softrast_lerp_unpacked_avx2 ( tophi, bottomhi, yhi );
+	return _mm256_and_si256 ( _mm256_packus_epi16 ( lo, hi ), _mm256_set1_epi32 ( 0x00FFFFFF ) );
+}
+
+// Q15 weight of a fraction in [0, 1)
+#define SOFTRAST_WEIGHT_SCALE 32768.0f
+
+//--------------------------------
+// Block-compressed textures are sampled texel by texel through a direct-mapped cache of decoded 4x4 blocks on every thread. An 8x8 window of
+// blocks fits without conflicts, and the two levels of a trilinear lookup are offset from each other, so neighbouring pixels nearly always hit.
+//--------------------------------
+
+#define SOFTRAST_BLOCK_CACHE_SIZE 64
+
+typedef struct
+{
+	const uint8_t* tags[SOFTRAST_BLOCK_CACHE_SIZE];		// Encoded block each entry was decoded from
+	uint32_t texels[SOFTRAST_BLOCK_CACHE_SIZE][16];
+	uint32_t generation;								// TextureCacheGeneration the tags are valid for
+} block_cache;
+
+extern SOFTRAST_THREAD_LOCAL block_cache ThreadBlockCache;
+extern volatile uint32_t TextureCacheGeneration;		// Bumped whenever texture memory is freed, which may hand cached addresses to other blocks
+
+void softrast_block_cache_fill ( block_cache* cache, uint32_t entry, const uint8_t* block, uint32_t format );
+
+// Texel (x, y) of a level of a compressed texture; coordinates wrap around its edges
+static __forceinline uint32_t softrast_fetch_compressed ( const softrast_texture* texture, uint32_t level, uint32_t x, uint32_t y )
+{
+	block_cache* cache = &ThreadBlockCache;
+
+	const uint32_t mipWidth   = texture->width >> level;
+	const uint32_t blockBytes = texture->format == SOFTRAST_TEXTURE_FORMAT_BC1 ? 8 : 16;
+	x &= mipWidth - 1;
+	y &= mipWidth - 1;
+
+	const uint32_t bx    = x >> 2, by = y >> 2;
+	const uint8_t* block = (const uint8_t*)texture->mipData[level] + (by * ((mipWidth + 3) >> 2) + bx) * blockBytes;
+	const uint32_t entry = ((bx + level * 4) & 7) | (((by + level * 4) & 7) << 3);
+	if ( cache->tags[entry] != block || cache->generation != TextureCacheGeneration )
+		softrast_block_cache_fill ( cache, entry, block, texture->format );
+
+	// Levels smaller than a block repeat across it, so masking with 3 stays inside them
+	return cache->texels[entry][((y & 3) << 2) | (x & 3)];
+}
+
+void softrast_select_mip ( mip_selection* mip, const softrast_texture* texture, float blockMaxDUV );
+
+//--------------------------------
+// Pixel pipelines are specialized on the render settings, so none of them branch on those per quad. SOFTRAST_SHADE_KERNELS (prefix, KERNEL)
+// has KERNEL (name, renderMode, addressing, filtering, mipmap, dithering) define a kernel for every combination that makes a difference:
+// texture settings only matter when texturing (and the mipmap mode when visualizing it), dithering only in the modes that look at UVs. The
+// numeric arguments follow the order of the TEXTURE_* enums. SOFTRAST_SHADE_KERNEL_TABLE (prefix) lists the kernels in a
+// SOFTRAST_SHADE_KERNEL_TABLE_TYPE, which SOFTRAST_SELECT_SHADE_KERNEL picks the one for a frame's settings from.
+//--------------------------------
+#define SOFTRAST_SHADE_KERNELS_DITHERING(prefix,KERNEL,addressing,filtering,mipmap) \
+	KERNEL ( prefix##_textured_##addressing##_##filtering##_##mipmap##_0, RENDER_MODE_TEXTURED, addressing, filtering, mipmap, 0 ) \
+	KERNEL ( prefix##_textured_##addressing##_##filtering##_##mipmap##_1, RENDER_MODE_TEXTURED, addressing, filtering, mipmap, 1 )
+
+#define SOFTRAST_SHADE_KERNELS_MIPS(prefix,KERNEL,addressing,filtering) \
+	SOFTRAST_SHADE_KERNELS_DITHERING ( prefix, KERNEL, addressing, filtering, 0 ) \
+	SOFTRAST_SHADE_KERNELS_DITHERING ( prefix, KERNEL, addressing, filtering, 1 ) \
+	SOFTRAST_SHADE_KERNELS_DITHERING ( prefix, KERNEL, addressing, filtering, 2 )
+
+#define SOFTRAST_SHADE_KERNELS_FILTERS(prefix,KERNEL,addressing) \
+	SOFTRAST_SHADE_KERNELS_MIPS ( prefix, KERNEL, addressing, 0 ) \
+	SOFTRAST_SHADE_KERNELS_MIPS ( prefix, KERNEL, addressing, 1 )
+
+#define SOFTRAST_SHADE_KERNELS(prefix,KERNEL) \
+	SOFTRAST_SHADE_KERNELS_FILTERS ( prefix, KERNEL, 0 ) \
+	SOFTRAST_SHADE_KERNELS_FILTERS ( prefix, KERNEL, 1 ) \
+	SOFTRAST_SHADE_KERNELS_FILTERS ( prefix, KERNEL, 2 ) \
+	KERNEL ( prefix##_flat,     RENDER_MODE_FLAT_COLOR, 0, 0, 0, 0 ) \
+	KERNEL ( prefix##_uv_0,     RENDER_MODE_UV,         0, 0, 0, 0 ) \
+	KERNEL ( prefix##_uv_1,     RENDER_MODE_UV,         0, 0, 0, 1 ) \
+	KERNEL ( prefix##_zbuffer,  RENDER_MODE_ZBUFFER,    0, 0, 0, 0 ) \
+	KERNEL ( prefix##_mipmap_0, RENDER_MODE_MIPMAP,     0, 0, 0, 0 ) \
+	KERNEL ( prefix##_mipmap_1, RENDER_MODE_MIPMAP,     0, 0, 1, 0 ) \
+	KERNEL ( prefix##_mipmap_2, RENDER_MODE_MIPMAP,     0, 0, 2, 0 )
+
+#define SOFTRAST_SHADE_KERNEL_TABLE_TYPE(func) \
+	struct { func flat; func uv[2]; func zbuffer; func mipmap[3]; func textured[3][2][3][2]; }	// textured is indexed by [addressing][filtering][mipmap][dithering]
+
+#define SOFTRAST_SHADE_KERNEL_TABLE_DITHERING(prefix,addressing,filtering,mipmap) \
+	{ prefix##_textured_##addressing##_##filtering##_##mipmap##_0, prefix##_textured_##addressing##_##filtering##_##mipmap##_1 }
+
+#define SOFTRAST_SHADE_KERNEL_TABLE_MIPS(prefix,addressing,filtering) \
+	{ SOFTRAST_SHADE_KERNEL_TABLE_DITHERING ( prefix, addressing, filtering, 0 ), SOFTRAST_SHADE_KERNEL_TABLE_DITHERING ( prefix, addressing, filtering, 1 ), SOFTRAST_SHADE_KERNEL_TABLE_DITHERING ( prefix, addressing, filtering, 2 ) }
+
+#define SOFTRAST_SHADE_KERNEL_TABLE_FILTERS(prefix,addressing) \
+	{ SOFTRAST_SHADE_KERNEL_TABLE_MIPS ( prefix, addressing, 0 ), SOFTRAST_SHADE_KERNEL_TABLE_MIPS ( prefix, addressing, 1 ) }
+
+#define SOFTRAST_SHADE_KERNEL_TABLE(prefix) \
+	{ \
+		prefix##_flat, \
+		{ prefix##_uv_0, prefix##_uv_1 }, \
+		prefix##_zbuffer, \
+		{ prefix##_mipmap_0, prefix##_mipmap_1, prefix##_mipmap_2 }, \
+		{ SOFTRAST_SHADE_KERNEL_TABLE_FILTERS ( prefix, 0 ), SOFTRAST_SHADE_KERNEL_TABLE_FILTERS ( prefix, 1 ), SOFTRAST_SHADE_KERNEL_TABLE_FILTERS ( prefix, 2 ) }, \
+	}
+
+#define SOFTRAST_SELECT_SHADE_KERNEL(table,debug) \
+	( (debug)->renderMode == RENDER_MODE_FLAT_COLOR ? (table).flat \
+	: (debug)->renderMode == RENDER_MODE_UV         ? (table).uv[((debug)->flags & FLAG_TEXTURE_DITHERING) != 0] \
+	: (debug)->renderMode == RENDER_MODE_ZBUFFER    ? (table).zbuffer \
+	: (debug)->renderMode == RENDER_MODE_MIPMAP     ? (table).mipmap[(debug)->textureMipmapMode] \
+	: (table).textured[(debug)->textureAddressingMode][(debug)->textureFilteringMode][(debug)->textureMipmapMode][((debug)->flags & FLAG_TEXTURE_DITHERING) != 0] )
+
+// The AVX-512 kernel specialized for the render settings, which shades quads at any position 16 pixels at a time. NULL when the kernel isn't compiled in.
+softrast_shade_quads_func softrast_select_shade_quads_avx512 ( const DEBUG_SETTINGS* debug );
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,436 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "texture_compression.h"
+#include "softrast_kernels.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+SOFTRAST_THREAD_LOCAL block_cache ThreadBlockCache;
+volatile uint32_t TextureCacheGeneration;
+
+// Interpolation weights of 4-bit BC7 indices, in 64ths
+static const uint32_t __softrast_bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static __forceinline uint32_t __softrast_channel ( uint32_t texel, uint32_t c )
+{
+	return (texel >> (c * 8)) & 0xFF;
+}
+
+static void __softrast_store_bits ( uint8_t* block, uint32_t* pos, uint32_t value, uint32_t count )
+{
+	for ( uint32_t i = 0; i < count; i++, (*pos)++ )
+		block[*pos >> 3] |= (uint8_t)(((value >> i) & 1) << (*pos & 7));
+}
+
+static uint32_t __softrast_load_bits ( const uint8_t* block, uint32_t* pos, uint32_t count )
+{
+	uint32_t value = 0;
+	for ( uint32_t i = 0; i < count; i++, (*pos)++ )
+		value |= ((block[*pos >> 3] >> (*pos & 7)) & 1) << i;
+	return value;
+}
+
+// Index of the palette entry closest to texel, comparing the first channels channels
+static uint32_t __softrast_nearest ( uint32_t texel, const uint32_t* palette, uint32_t count, uint32_t channels )
+{
+	uint32_t best = 0, bestError = 0xFFFFFFFF;
+	for ( uint32_t i = 0; i < count; i++ )
+	{
+		uint32_t error = 0;
+		for ( uint32_t c = 0; c < channels; c++ )
+		{
+			const int32_t d = (int32_t)__softrast_channel ( texel, c ) - (int32_t)__softrast_channel ( palette[i], c );
+			error += (uint32_t)(d * d);
+		}
+		if ( error < bestError )
+			best = i, bestError = error;
+	}
+	return best;
+}
+
+// Finds the texels at both ends of the block's principal axis, estimated with a few power iterations on the covariance of its channels
+static void __softrast_principal_endpoints ( const uint32_t texels[16], uint32_t channels, uint32_t* lo, uint32_t* hi )
+{
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float cov[4][4];
+	memset ( cov, 0, sizeof ( cov ) );
+
+	for ( uint32_t i = 0; i < 16; i++ )
+		for ( uint32_t c = 0; c < channels; c++ )
+			mean[c] += __softrast_channel ( texels[i], c ) * (1.0f / 16.0f);
+
+	for ( uint32_t i = 0; i < 16; i++ )
+	{
+		float d[4];
+		for ( uint32_t c = 0; c < channels; c++ )
+			d[c] = __softrast_channel ( texels[i], c ) - mean[c];
+		for ( uint32_t a = 0; a < channels; a++ )
+			for ( uint32_t b = 0; b < channels; b++ )
+				cov[a][b] += d[a] * d[b];
+	}
+
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for ( uint32_t iteration = 0; iteration < 8; iteration++ )
+	{
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, length = 0.0f;
+		for ( uint32_t a = 0; a < channels; a++ )
+		{
+			for ( uint32_t b = 0; b < channels; b++ )
+				next[a] += cov[a][b] * axis[b];
+			length = fabsf ( next[a] ) > length ? fabsf ( next[a] ) : length;
+		}
+		if ( length == 0.0f )
+			break;	// Flat block, or (1, 1, 1, 1) happened to be orthogonal to it; the luminance axis does fine for either
+		for ( uint32_t c = 0; c < channels; c++ )
+			axis[c] = next[c] / length;
+	}
+
+	float minProj = 1e30f, maxProj = -1e30f;
+	for ( uint32_t i = 0; i < 16; i++ )
+	{
+		float proj = 0.0f;
+		for ( uint32_t c = 0; c < channels; c++ )
+			proj += __softrast_channel ( texels[i], c ) * axis[c];
+		if ( proj < minProj )
+			minProj = proj, *lo = texels[i];
+		if ( proj > maxProj )
+			maxProj = proj, *hi = texels[i];
+	}
+}
+
+//--------------------------------
+// BC1 colors, also used by BC3
+//--------------------------------
+
+static uint32_t __softrast_pack_565 ( uint32_t texel )
+{
+	const uint32_t r = (__softrast_channel ( texel, 0 ) * 31 + 127) / 255;
+	const uint32_t g = (__softrast_channel ( texel, 1 ) * 63 + 127) / 255;
+	const uint32_t b = (__softrast_channel ( texel, 2 ) * 31 + 127) / 255;
+	return (r << 11) | (g << 5) | b;
+}
+
+static uint32_t __softrast_unpack_565 ( uint32_t color )
+{
+	const uint32_t r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+	return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16) | 0xFF000000;
+}
+
+// Four colors when c0 > c1 or fourColors is set (as in BC3), otherwise three and transparent black
+static void __softrast_bc1_palette ( uint32_t c0, uint32_t c1, uint32_t fourColors, uint32_t palette[4] )
+{
+	palette[0] = __softrast_unpack_565 ( c0 );
+	palette[1] = __softrast_unpack_565 ( c1 );
+	palette[2] = palette[3] = 0xFF000000;
+	for ( uint32_t c = 0; c < 3; c++ )
+	{
+		const uint32_t a = __softrast_channel ( palette[0], c ), b = __softrast_channel ( palette[1], c );
+		if ( c0 > c1 || fourColors )
+		{
+			palette[2] |= ((2 * a + b) / 3) << (c * 8);
+			palette[3] |= ((a + 2 * b) / 3) << (c * 8);
+		}
+		else
+			palette[2] |= ((a + b) / 2) << (c * 8);
+	}
+	if ( !(c0 > c1 || fourColors) )
+		palette[3] = 0;
+}
+
+// Always picks four color mode, which BC3 requires as well
+static void __softrast_encode_bc1_colors ( const uint32_t texels[16], uint8_t* block )
+{
+	uint32_t lo, hi;
+	__softrast_principal_endpoints ( texels, 3, &lo, &hi );
+
+	uint32_t c0 = __softrast_pack_565 ( hi ), c1 = __softrast_pack_565 ( lo );
+	if ( c0 < c1 )
+	{
+		const uint32_t t = c0;
+		c0 = c1, c1 = t;
+	}
+
+	uint32_t indices = 0;
+	if ( c0 != c1 )	// Equal endpoints would select three color mode; all indices stay 0 then
+	{
+		uint32_t palette[4];
+		__softrast_bc1_palette ( c0, c1, 1, palette );
+		for ( uint32_t i = 0; i < 16; i++ )
+			indices |= __softrast_nearest ( texels[i], palette, 4, 3 ) << (i * 2);
+	}
+
+	block[0] = (uint8_t)c0, block[1] = (uint8_t)(c0 >> 8);
+	block[2] = (uint8_t)c1, block[3] = (uint8_t)(c1 >> 8);
+	for ( uint32_t i = 0; i < 4; i++ )
+		block[4 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+static void __softrast_decode_bc1_colors ( const uint8_t* block, uint32_t fourColors, uint32_t texels[16] )
+{
+	const uint32_t c0      = block[0] | (block[1] << 8);
+	const uint32_t c1      = block[2] | (block[3] << 8);
+	const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+
+	uint32_t palette[4];
+	__softrast_bc1_palette ( c0, c1, fourColors, palette );
+	for ( uint32_t i = 0; i < 16; i++ )
+		texels[i] = palette[(indices >> (i * 2)) & 3];
+}
+
+//--------------------------------
+// BC3 alpha
+//--------------------------------
+
+static void __softrast_bc3_alpha_palette ( uint32_t a0, uint32_t a1, uint32_t palette[8] )
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	if ( a0 > a1 )
+	{
+		for ( uint32_t i = 1; i < 7; i++ )
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for ( uint32_t i = 1; i < 5; i++ )
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void __softrast_encode_bc3_alpha ( const uint32_t texels[16], uint8_t* block )
+{
+	uint32_t a0 = 0, a1 = 255;
+	for ( uint32_t i = 0; i < 16; i++ )
+	{
+		const uint32_t a = __softrast_channel ( texels[i], 3 );
+		a0 = a > a0 ? a : a0;
+		a1 = a < a1 ? a : a1;
+	}
+
+	uint64_t indices = 0;
+	if ( a0 != a1 )
+	{
+		uint32_t palette[8];
+		__softrast_bc3_alpha_palette ( a0, a1, palette );
+		for ( uint32_t i = 0; i < 16; i++ )
+		{
+			const int32_t a = (int32_t)__softrast_channel ( texels[i], 3 );
+			uint32_t best = 0;
+			for ( uint32_t j = 1; j < 8; j++ )
+				best = abs ( a - (int32_t)palette[j] ) < abs ( a - (int32_t)palette[best] ) ? j : best;
+			indices |= (uint64_t)best << (i * 3);
+		}
+	}
+
+	block[0] = (uint8_t)a0;
+	block[1] = (uint8_t)a1;
+	for ( uint32_t i = 0; i < 6; i++ )
+		block[2 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+static void __softrast_decode_bc3_alpha ( const uint8_t* block, uint32_t texels[16] )
+{
+	uint64_t indices = 0;
+	for ( uint32_t i = 0; i < 6; i++ )
+		indices |= (uint64_t)block[2 + i] << (i * 8);
+
+	uint32_t palette[8];
+	__softrast_bc3_alpha_palette ( block[0], block[1], palette );
+	for ( uint32_t i = 0; i < 16; i++ )
+		texels[i] = (texels[i] & 0x00FFFFFF) | (palette[(indices >> (i * 3)) & 7] << 24);
+}
+
+//--------------------------------
+// BC7 mode 6: one subset of RGBA endpoints at 7 bits plus a shared low bit each, and 4-bit indices
+//--------------------------------
+
+static uint32_t __softrast_bc7_interpolate ( uint32_t e0, uint32_t e1, uint32_t index )
+{
+	const uint32_t w = __softrast_bc7_weights[index];
+	uint32_t texel = 0;
+	for ( uint32_t c = 0; c < 4; c++ )
+		texel |= (((64 - w) * __softrast_channel ( e0, c ) + w * __softrast_channel ( e1, c ) + 32) >> 6) << (c * 8);
+	return texel;
+}
+
+static void __softrast_encode_bc7 ( const uint32_t texels[16], uint8_t* block )
+{
+	uint32_t ends[2];
+	__softrast_principal_endpoints ( texels, 4, &ends[0], &ends[1] );
+
+	//--------------------------------
+	// Quantize the endpoints, trying both values of their low bit
+	//--------------------------------
+	uint32_t quantized[2][4], pbit[2], endpoint[2];
+	for ( uint32_t e = 0; e < 2; e++ )
+	{
+		uint32_t bestError = 0xFFFFFFFF;
+		for ( uint32_t p = 0; p < 2; p++ )
+		{
+			uint32_t q[4], error = 0, texel = 0;
+			for ( uint32_t c = 0; c < 4; c++ )
+			{
+				const uint32_t v = __softrast_channel ( ends[e], c );
+				q[c] = (v + 1 - p) >> 1;
+				q[c] = q[c] > 127 ? 127 : q[c];
+
+				const int32_t d = (int32_t)((q[c] << 1) | p) - (int32_t)v;
+				error += (uint32_t)(d * d);
+				texel |= ((q[c] << 1) | p) << (c * 8);
+			}
+			if ( error < bestError )
+			{
+				bestError = error;
+				memcpy ( quantized[e], q, sizeof ( q ) );
+				pbit[e]     = p;
+				endpoint[e] = texel;
+			}
+		}
+	}
+
+	uint32_t palette[16], indices[16];
+	for ( uint32_t i = 0; i < 16; i++ )
+		palette[i] = __softrast_bc7_interpolate ( endpoint[0], endpoint[1], i );
+	for ( uint32_t i = 0; i < 16; i++ )
+		indices[i] = __softrast_nearest ( texels[i], palette, 16, 4 );
+
+	//--------------------------------
+	// The first texel's index drops its top bit, so it has to be in the lower half; the weights are symmetric, so swapping ends flips them
+	//--------------------------------
+	const uint32_t swap = indices[0] >= 8;
+	if ( swap )
+		for ( uint32_t i = 0; i < 16; i++ )
+			indices[i] = 15 - indices[i];
+
+	uint32_t pos = 0;
+	memset ( block, 0, 16 );
+	__softrast_store_bits ( block, &pos, 1 << 6, 7 );
+	for ( uint32_t c = 0; c < 4; c++ )
+	{
+		__softrast_store_bits ( block, &pos, quantized[swap][c], 7 );
+		__softrast_store_bits ( block, &pos, quantized[!swap][c], 7 );
+	}
+	__softrast_store_bits ( block, &pos, pbit[swap], 1 );
+	__softrast_store_bits ( block, &pos, pbit[!swap], 1 );
+	for ( uint32_t i = 0; i < 16; i++ )
+		__softrast_store_bits ( block, &pos, indices[i], i == 0 ? 3 : 4 );
+}
+
+static void __softrast_decode_bc7 ( const uint8_t* block, uint32_t texels[16] )
+{
+	if ( (block[0] & 0x7F) != (1 << 6) )
+	{
+		for ( uint32_t i = 0; i < 16; i++ )
+			texels[i] = 0xFF00FF;
+		return;
+	}
+
+	uint32_t pos = 7, quantized[2][4];
+	for ( uint32_t c = 0; c < 4; c++ )
+	{
+		quantized[0][c] = __softrast_load_bits ( block, &pos, 7 );
+		quantized[1][c] = __softrast_load_bits ( block, &pos, 7 );
+	}
+
+	uint32_t endpoint[2] = { 0, 0 };
+	for ( uint32_t e = 0; e < 2; e++ )
+	{
+		const uint32_t p = __softrast_load_bits ( block, &pos, 1 );
+		for ( uint32_t c = 0; c < 4; c++ )
+			endpoint[e] |= ((quantized[e][c] << 1) | p) << (c * 8);
+	}
+
+	for ( uint32_t i = 0; i < 16; i++ )
+		texels[i] = __softrast_bc7_interpolate ( endpoint[0], endpoint[1], __softrast_load_bits ( block, &pos, i == 0 ? 3 : 4 ) );
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+uint32_t softrast_texture_block_bytes ( uint32_t format )
+{
+	return format == SOFTRAST_TEXTURE_FORMAT_BC1 ? 8 : 16;
+}
+
+void softrast_texture_compress_level ( uint32_t format, const uint32_t* texels, uint32_t size, void* blocks )
+{
+	const uint32_t blockCount = (size + 3) / 4;
+	const uint32_t blockBytes = softrast_texture_block_bytes ( format );
+	uint8_t* block = (uint8_t*)blocks;
+
+	for ( uint32_t by = 0; by < blockCount; by++ )
+	{
+		for ( uint32_t bx = 0; bx < blockCount; bx++, block += blockBytes )
+		{
+			uint32_t blockTexels[16];
+			for ( uint32_t r = 0; r < 4; r++ )
+				for ( uint32_t c = 0; c < 4; c++ )
+					blockTexels[r * 4 + c] = texels[((by * 4 + r) & (size - 1)) * size + ((bx * 4 + c) & (size - 1))];
+
+			if ( format == SOFTRAST_TEXTURE_FORMAT_BC1 )
+				__softrast_encode_bc1_colors ( blockTexels, block );
+			else if ( format == SOFTRAST_TEXTURE_FORMAT_BC3 )
+			{
+				__softrast_encode_bc3_alpha ( blockTexels, block );
+				__softrast_encode_bc1_colors ( blockTexels, block + 8 );
+			}
+			else
+				__softrast_encode_bc7 ( blockTexels, block );
+		}
+	}
+}
+
+void softrast_texture_decode_block ( uint32_t format, const uint8_t* block, uint32_t texels[16] )
+{
+	if ( format == SOFTRAST_TEXTURE_FORMAT_BC1 )
+		__softrast_decode_bc1_colors ( block, 0, texels );
+	else if ( format == SOFTRAST_TEXTURE_FORMAT_BC3 )
+	{
+		__softrast_decode_bc1_colors ( block + 8, 1, texels );
+		__softrast_decode_bc3_alpha ( block, texels );
+	}
+	else
+		__softrast_decode_bc7 ( block, texels );
+}
+
+void softrast_texture_cache_invalidate ( )
+{
+	TextureCacheGeneration++;
+}
+
+void softrast_block_cache_fill ( block_cache* cache, uint32_t entry, const uint8_t* block, uint32_t format )
+{
+	const uint32_t generation = TextureCacheGeneration;
+	if ( cache->generation != generation )
+	{
+		memset ( (void*)cache->tags, 0, sizeof ( cache->tags ) );
+		cache->generation = generation;
+	}
+
+	softrast_texture_decode_block ( format, block, cache->texels[entry] );
+	cache->tags[entry] = block;
+}
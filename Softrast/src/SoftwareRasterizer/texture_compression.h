@@ -0,0 +1,41 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "softrast.h"
+
+// Block compression of RGBA8 texels (R in the low byte) into BC1, BC3 and BC7. The encoders fit endpoints to each block's principal axis
+// and pick the nearest palette entry per texel; BC7 blocks are all written in mode 6, the only mode the decoder handles.
+
+uint32_t softrast_texture_block_bytes ( uint32_t format );
+
+// Compresses a size by size level into rows of 4x4 blocks. Levels smaller than a block repeat across it, like wrapping would
+void     softrast_texture_compress_level ( uint32_t format, const uint32_t* texels, uint32_t size, void* blocks );
+
+// Decodes a block to 16 texels, row by row; blocks the decoder doesn't support come out as 0xFF00FF
+void     softrast_texture_decode_block ( uint32_t format, const uint8_t* block, uint32_t texels[16] );
+
+// Drops the decoded blocks cached by all threads; needed whenever texture memory is freed
+void     softrast_texture_cache_invalidate ( );
+
+#ifdef __cplusplus
+};
+#endif
@@ -15,6 +15,7 @@
 */
 
 #include "softrast.h"
+#include "texture_compression.h"
 #include "../MemoryMappedFile.h"
 #include <assert.h>
 #include <math.h>
@@ -69,8 +70,19 @@ extern "C" {
 		// Allocate memory for all mips
 		//--------------------------------
 		const uint32_t mipLevels = 1 + (uint32_t)floorf ( 0.5f + log2f ( (float)width ) );
+		const uint32_t format    = (uint32_t)Debug.textureFormat;
 		size_t allocSize;
-		switch ( Debug.textureAddressingMode )
+		if ( format != SOFTRAST_TEXTURE_FORMAT_RGBA8 )
+		{
+			// Compressed mips are rows of 4x4 blocks in any addressing mode, with at least one block per mip
+			allocSize = mipLevels * sizeof ( uint32_t* );
+			for ( uint32_t i = 0; i < mipLevels; i++ )
+			{
+				const size_t blockCount = ((width >> i) + 3) / 4;
+				allocSize += blockCount * blockCount * softrast_texture_block_bytes ( format );
+			}
+		}
+		else switch ( Debug.textureAddressingMode )
 		{
 		case TEXTURE_ADDRESSING_LINEAR:
 			allocSize = mipLevels * sizeof ( uint32_t* )
@@ -108,6 +120,7 @@ extern "C" {
 		//--------------------------------
 		tex->mipData   = (uint32_t**)memory;
 		tex->mipLevels = (uint32_t)mipLevels;
+		tex->format    = format;
 		tex->width     = (uint16_t)width;
 		tex->height    = (uint16_t)height;
 		
@@ -128,7 +141,13 @@ extern "C" {
 			uintptr_t imgaddr = (uintptr_t)imgpixels;
 			tex->mipData[i] = memPtr;
 		
-			if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_LINEAR )
+			if ( format != SOFTRAST_TEXTURE_FORMAT_RGBA8 )
+			{
+				const uint32_t blockCount = (mipSize + 3) / 4;
+				softrast_texture_compress_level ( format, imgpixels, mipSize, memPtr );
+				memPtr += blockCount * blockCount * softrast_texture_block_bytes ( format ) / sizeof ( uint32_t );
+			}
+			else if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_LINEAR )
 			{
 				for ( uint32_t r = 0; r < mipSize; r++, imgaddr += rowPitch, memPtr += mipSize )
 					memcpy ( memPtr, (void*)imgaddr, mipSize * sizeof ( uint32_t ) );
@@ -196,7 +215,7 @@ extern "C" {
 			imgpixels = mipData[i&1];
 		}
 		
-		if ( Debug.textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
+		if ( format == SOFTRAST_TEXTURE_FORMAT_RGBA8 && Debug.textureAddressingMode == TEXTURE_ADDRESSING_SWIZZLED )
 		{
 			*(memPtr++) = 0xFF00FF;
 			*(memPtr++) = 0xFF00FF;
@@ -222,6 +241,7 @@ extern "C" {
 
 	uint32_t softrast_texture_free ( softrast_texture* tex )
 	{
+		softrast_texture_cache_invalidate ( );
 		if ( miltyalloc_buddy_allocator_free ( _softrastAllocator, tex->mipData ) == MILTYALLOC_SUCCESS )
 			return 0;
 		else
@@ -0,0 +1,71 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// Thread, lock and atomic primitives shared by the thread pool and the frame queue
+
+#include <stdint.h>
+
+#ifdef _WIN32
+	#include <Windows.h>
+
+	typedef HANDLE             thread_handle;
+	typedef CRITICAL_SECTION   thread_mutex;
+	typedef CONDITION_VARIABLE thread_cond;
+
+	#define THREAD_FUNC(name)            DWORD WINAPI name ( LPVOID param )
+	#define THREAD_RETURN                return 0
+	#define THREAD_CREATE(t,func,param)  ((*(t) = CreateThread ( NULL, 0, func, param, 0, NULL )) != NULL)
+	#define THREAD_JOIN(t)               (WaitForSingleObject ( t, INFINITE ), CloseHandle ( t ))
+
+	#define MUTEX_INIT(m)    InitializeCriticalSection ( m )
+	#define MUTEX_DESTROY(m) DeleteCriticalSection ( m )
+	#define MUTEX_LOCK(m)    EnterCriticalSection ( m )
+	#define MUTEX_UNLOCK(m)  LeaveCriticalSection ( m )
+
+	#define COND_INIT(c)      InitializeConditionVariable ( c )
+	#define COND_DESTROY(c)
+	#define COND_WAIT(c,m)    SleepConditionVariableCS ( c, m, INFINITE )
+	#define COND_BROADCAST(c) WakeAllConditionVariable ( c )
+
+	#define ATOMIC_INCREMENT(v) InterlockedIncrement ( v )
+	#define ATOMIC_DECREMENT(v) InterlockedDecrement ( v )
+#else
+	#include <pthread.h>
+
+	typedef pthread_t       thread_handle;
+	typedef pthread_mutex_t thread_mutex;
+	typedef pthread_cond_t  thread_cond;
+
+	#define THREAD_FUNC(name)            void* name ( void* param )
+	#define THREAD_RETURN                return NULL
+	#define THREAD_CREATE(t,func,param)  (pthread_create ( t, NULL, func, param ) == 0)
+	#define THREAD_JOIN(t)               pthread_join ( t, NULL )
+
+	#define MUTEX_INIT(m)    pthread_mutex_init ( m, NULL )
+	#define MUTEX_DESTROY(m) pthread_mutex_destroy ( m )
+	#define MUTEX_LOCK(m)    pthread_mutex_lock ( m )
+	#define MUTEX_UNLOCK(m)  pthread_mutex_unlock ( m )
+
+	#define COND_INIT(c)      pthread_cond_init ( c, NULL )
+	#define COND_DESTROY(c)   pthread_cond_destroy ( c )
+	#define COND_WAIT(c,m)    pthread_cond_wait ( c, m )
+	#define COND_BROADCAST(c) pthread_cond_broadcast ( c )
+
+	#define ATOMIC_INCREMENT(v) __sync_add_and_fetch ( v, 1 )
+	#define ATOMIC_DECREMENT(v) __sync_sub_and_fetch ( v, 1 )
+#endif
@@ -0,0 +1,278 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "thread_pool.h"
+#include "thread_platform.h"
+
+#include <stddef.h>
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+	static uint32_t __softrast_thread_pool_processor_count ( )
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo ( &info );
+		return (uint32_t)info.dwNumberOfProcessors;
+	}
+#else
+	#include <unistd.h>
+
+	static uint32_t __softrast_thread_pool_processor_count ( )
+	{
+		long count = sysconf ( _SC_NPROCESSORS_ONLN );
+		return count > 0 ? (uint32_t)count : 1;
+	}
+#endif
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static struct
+{
+	thread_handle threads[SOFTRAST_MAX_THREADS];
+	uint32_t threadCount;
+	uint32_t shutdown;
+
+	thread_mutex lock;
+	thread_cond workAvailable;
+	thread_cond batchDone;
+
+	softrast_job_batch* head;
+	softrast_job_batch* tail;
+
+	// Batch each worker is currently pulling jobs from, so waiters know when a batch is no longer referenced
+	softrast_job_batch* userBatch[SOFTRAST_MAX_THREADS];
+} pool;
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static uint32_t __softrast_thread_pool_batch_in_use ( const softrast_job_batch* batch )
+{
+	// Lock must be held
+	for ( uint32_t i = 1; i < pool.threadCount; i++ )
+	{
+		if ( pool.userBatch[i] == batch )
+			return 1;
+	}
+	return 0;
+}
+
+static void __softrast_thread_pool_unlink ( softrast_job_batch* batch )
+{
+	// Lock must be held
+	softrast_job_batch* prev = NULL;
+	for ( softrast_job_batch* cur = pool.head; cur; prev = cur, cur = cur->next )
+	{
+		if ( cur == batch )
+		{
+			if ( prev )
+				prev->next = cur->next;
+			else
+				pool.head = cur->next;
+			if ( pool.tail == cur )
+				pool.tail = prev;
+			return;
+		}
+	}
+}
+
+static uint32_t __softrast_thread_pool_execute_one ( softrast_job_batch* batch, uint32_t threadIndex )
+{
+	long job = ATOMIC_INCREMENT ( &batch->nextJob ) - 1;
+	if ( job >= (long)batch->jobCount )
+		return 0;
+
+	batch->func ( batch->userData, (uint32_t)job, threadIndex );
+	ATOMIC_DECREMENT ( &batch->remainingJobs );
+	return 1;
+}
+
+static THREAD_FUNC ( __softrast_thread_pool_worker )
+{
+	const uint32_t threadIndex = (uint32_t)(uintptr_t)param;
+
+	MUTEX_LOCK ( &pool.lock );
+	for ( ;; )
+	{
+		//--------------------------------
+		// Sleep until there is work (or we are told to quit)
+		//--------------------------------
+		while ( !pool.shutdown && pool.head == NULL )
+			COND_WAIT ( &pool.workAvailable, &pool.lock );
+
+		if ( pool.shutdown )
+			break;
+
+		//--------------------------------
+		// Retire batches that have handed out all of their jobs
+		//--------------------------------
+		softrast_job_batch* batch = pool.head;
+		if ( batch->nextJob >= (long)batch->jobCount )
+		{
+			__softrast_thread_pool_unlink ( batch );
+			continue;
+		}
+
+		//--------------------------------
+		// Claim the batch, and run jobs from it until it runs dry
+		//--------------------------------
+		pool.userBatch[threadIndex] = batch;
+		MUTEX_UNLOCK ( &pool.lock );
+
+		while ( __softrast_thread_pool_execute_one ( batch, threadIndex ) )
+			;
+
+		MUTEX_LOCK ( &pool.lock );
+		pool.userBatch[threadIndex] = NULL;
+		if ( batch->remainingJobs == 0 )
+			COND_BROADCAST ( &pool.batchDone );
+	}
+	MUTEX_UNLOCK ( &pool.lock );
+
+	THREAD_RETURN;
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+uint32_t softrast_thread_pool_initialize ( uint32_t threadCount )
+{
+	if ( pool.threadCount )
+		return -1;	// Already initialized
+
+	if ( threadCount == 0 )
+		threadCount = __softrast_thread_pool_processor_count ( );
+	if ( threadCount > SOFTRAST_MAX_THREADS )
+		threadCount = SOFTRAST_MAX_THREADS;
+
+	MUTEX_INIT ( &pool.lock );
+	COND_INIT ( &pool.workAvailable );
+	COND_INIT ( &pool.batchDone );
+	pool.head = pool.tail = NULL;
+	pool.shutdown = 0;
+
+	//--------------------------------
+	// Thread 0 is whoever submits and waits, so only spawn the remainder
+	//--------------------------------
+	pool.threadCount = 1;
+	for ( uint32_t i = 1; i < threadCount; i++ )
+	{
+		pool.userBatch[i] = NULL;
+		if ( !THREAD_CREATE ( &pool.threads[i], __softrast_thread_pool_worker, (void*)(uintptr_t)i ) )
+			break;
+		pool.threadCount++;
+	}
+
+	return 0;
+}
+
+void softrast_thread_pool_shutdown ( )
+{
+	if ( !pool.threadCount )
+		return;
+
+	MUTEX_LOCK ( &pool.lock );
+	pool.shutdown = 1;
+	COND_BROADCAST ( &pool.workAvailable );
+	MUTEX_UNLOCK ( &pool.lock );
+
+	for ( uint32_t i = 1; i < pool.threadCount; i++ )
+		THREAD_JOIN ( pool.threads[i] );
+
+	COND_DESTROY ( &pool.batchDone );
+	COND_DESTROY ( &pool.workAvailable );
+	MUTEX_DESTROY ( &pool.lock );
+	pool.threadCount = 0;
+}
+
+uint32_t softrast_thread_pool_thread_count ( )
+{
+	return pool.threadCount ? pool.threadCount : 1;
+}
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+void softrast_thread_pool_submit ( softrast_job_batch* batch, softrast_job_func func, void* userData, uint32_t jobCount )
+{
+	batch->func          = func;
+	batch->userData      = userData;
+	batch->jobCount      = jobCount;
+	batch->nextJob       = 0;
+	batch->remainingJobs = (long)jobCount;
+	batch->next          = NULL;
+
+	//--------------------------------
+	// Without workers, jobs are executed when the batch is waited on
+	//--------------------------------
+	if ( pool.threadCount <= 1 || jobCount == 0 )
+		return;
+
+	MUTEX_LOCK ( &pool.lock );
+	if ( pool.tail )
+		pool.tail->next = batch;
+	else
+		pool.head = batch;
+	pool.tail = batch;
+	COND_BROADCAST ( &pool.workAvailable );
+	MUTEX_UNLOCK ( &pool.lock );
+}
+
+uint32_t softrast_thread_pool_is_done ( const softrast_job_batch* batch )
+{
+	return batch->remainingJobs == 0;
+}
+
+void softrast_thread_pool_wait ( softrast_job_batch* batch )
+{
+	//--------------------------------
+	// Help out with our own batch
+	//--------------------------------
+	while ( __softrast_thread_pool_execute_one ( batch, 0 ) )
+		;
+
+	if ( pool.threadCount <= 1 || batch->jobCount == 0 )
+		return;
+
+	//--------------------------------
+	// Wait for the stragglers, and make sure no worker still references the batch before handing it back
+	//--------------------------------
+	MUTEX_LOCK ( &pool.lock );
+	while ( batch->remainingJobs != 0 || __softrast_thread_pool_batch_in_use ( batch ) )
+		COND_WAIT ( &pool.batchDone, &pool.lock );
+	__softrast_thread_pool_unlink ( batch );
+	MUTEX_UNLOCK ( &pool.lock );
+}
+
+void softrast_thread_pool_run ( softrast_job_func func, void* userData, uint32_t jobCount )
+{
+	softrast_job_batch batch;
+	softrast_thread_pool_submit ( &batch, func, userData, jobCount );
+	softrast_thread_pool_wait ( &batch );
+}
+
+uint32_t softrast_thread_pool_help ( softrast_job_batch* batch )
+{
+	return __softrast_thread_pool_execute_one ( batch, 0 );
+}
+
+long softrast_thread_pool_atomic_decrement ( volatile long* value )
+{
+	return ATOMIC_DECREMENT ( value );
+}
@@ -0,0 +1,57 @@
+/*
+	SoftRast software rasterizer, by Rick van Miltenburg
+
+	Software rasterizer created for fun and educational purposes.
+
+	---
+
+	Copyright (c) 2015 Rick van Miltenburg
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define SOFTRAST_MAX_THREADS 64
+
+// Job callback; threadIndex is 0 for the thread that submitted/waits, 1..N-1 for the workers
+typedef void ( *softrast_job_func ) ( void* userData, uint32_t jobIndex, uint32_t threadIndex );
+
+// A batch of jobCount jobs that all run the same function. Owned by the caller, and must stay alive until waited on.
+typedef struct softrast_job_batch
+{
+	softrast_job_func func;
+	void* userData;
+	uint32_t jobCount;
+
+	volatile long nextJob;
+	volatile long remainingJobs;
+	struct softrast_job_batch* next;
+} softrast_job_batch;
+
+uint32_t softrast_thread_pool_initialize ( uint32_t threadCount );
+void     softrast_thread_pool_shutdown ( );
+uint32_t softrast_thread_pool_thread_count ( );
+
+void     softrast_thread_pool_submit ( softrast_job_batch* batch, softrast_job_func func, void* userData, uint32_t jobCount );
+uint32_t softrast_thread_pool_is_done ( const softrast_job_batch* batch );
+void     softrast_thread_pool_wait ( softrast_job_batch* batch );
+void     softrast_thread_pool_run ( softrast_job_func func, void* userData, uint32_t jobCount );
+
+// Runs one job of the batch that hasn't been handed out yet on the calling thread, for threads waiting on part of a batch. Returns 0 once all of them have been
+uint32_t softrast_thread_pool_help ( softrast_job_batch* batch );
+long     softrast_thread_pool_atomic_decrement ( volatile long* value );
+
+#ifdef __cplusplus
+};
+#endif
@@ -19,20 +19,39 @@
 #include <stdint.h>
 #include "BarebonesMath/include/bbm.h"
 
+// Block-compressed formats store every mip as rows of 4x4 texel blocks; levels smaller than a block take up one whole block
+typedef enum
+{
+	SOFTRAST_TEXTURE_FORMAT_RGBA8,
+	SOFTRAST_TEXTURE_FORMAT_BC1,		// 8 bytes per block, RGB only
+	SOFTRAST_TEXTURE_FORMAT_BC3,		// 16 bytes per block, BC1 colors with interpolated alpha
+	SOFTRAST_TEXTURE_FORMAT_BC7,		// 16 bytes per block
+} softrast_texture_format;
+
 typedef struct
 {
 	uint32_t** mipData;
 	const char* path;
 	uint32_t mipLevels;
+	uint32_t format;				// softrast_texture_format
 	uint16_t width;
 	uint16_t height;
 } softrast_texture;
 
+// Coarse shading textures every pixel of a block with the color at the block's center; depth is still tested per pixel
+typedef enum
+{
+	SOFTRAST_SHADING_RATE_1X1,
+	SOFTRAST_SHADING_RATE_2X2,
+	SOFTRAST_SHADING_RATE_4X4,
+} softrast_shading_rate;
+
 typedef struct
 {
 	softrast_texture* texture;
 	uint32_t* indices;
 	uint32_t indexCount;
+	uint32_t shadingRate;			// softrast_shading_rate; the coarsest of this, the frame's and the rate image's is used
 } softrast_submesh;
 
 typedef struct
@@ -53,4 +72,47 @@ typedef struct
 	softrast_mesh* meshes;
 	uint32_t textureCount;
 	uint32_t meshCount;
-} softrast_model;
\ No newline at end of file
+} softrast_model;
+
+// Identifies a submitted frame; fences count up in submission order, so a frame's fence completing means all earlier ones have as well
+typedef uint64_t softrast_fence;
+
+// Pixels rejected by the depth test (testedPixels - shadedPixels) are overdraw that was never shaded; drawing front to back raises their share
+typedef struct
+{
+	uint64_t testedPixels;			// Covered pixels that reached the per-pixel depth test
+	uint64_t shadedPixels;			// Of those, the pixels that passed it and were written
+	uint32_t drawCount;
+	float renderScale;				// Fraction of the render target's width and height the frame was rasterized at
+	float milliseconds;				// Time the frame took to render, from its first clear to its upscale
+} softrast_frame_stats;
+
+typedef enum
+{
+	SOFTRAST_COMMAND_SET_VIEW_MATRIX,
+	SOFTRAST_COMMAND_SET_PROJECTION_MATRIX,
+	SOFTRAST_COMMAND_DRAW_MESH,
+	SOFTRAST_COMMAND_DRAW_SUBMESH,
+} softrast_command_type;
+
+typedef struct
+{
+	softrast_command_type type;
+	union
+	{
+		bbm_aos_mat4 matrix;
+		struct
+		{
+			softrast_mesh* mesh;
+			softrast_submesh* submesh;
+		} draw;
+	};
+} softrast_command;
+
+// Commands are recorded into storage owned by the caller. Lists share nothing, so each can be recorded on a thread of its own
+typedef struct
+{
+	softrast_command* commands;
+	uint32_t capacity;
+	uint32_t count;
+} softrast_command_list;